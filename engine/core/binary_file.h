@@ -54,7 +54,7 @@ namespace deadrop
         void Write(std::vector<T>& vec)
         {
             size_t size = vec.size();
-            if (size < 0) return;
+            if (size == 0) return;
 
             stream.write(reinterpret_cast<char*>(&vec[0]), size * sizeof(T));
         }
@@ -66,17 +66,15 @@ namespace deadrop
             stream.read(reinterpret_cast<char*>(&t), sizeof(t));
         }
 
-        // reads a vector from the file, does not check if the file is open
+        // reads 'size' elements from the file and appends them to the vector, does not check if the file is open
+        // NOTE: the elements are read with a single read, so large buffers like encoded meshes load quickly
         template<typename T>
         void Read(std::vector<T>& vec, int size)
         {
-            T temp;
-            if (size < 0) return;
-            for (int i = 0; i < size; i++)
-            {
-                stream.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-                vec.push_back(temp);
-            }
+            if (size <= 0) return;
+            const size_t offset = vec.size();
+            vec.resize(offset + static_cast<size_t>(size));
+            stream.read(reinterpret_cast<char*>(&vec[offset]), static_cast<std::streamsize>(size) * sizeof(T));
         }
 
         // moves the reading postion 'pos' times from the specified direction ios_base::beg, cur, end
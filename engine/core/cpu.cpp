@@ -0,0 +1,87 @@
+#include "cpu.h"
+using namespace deadrop;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace
+{
+    // executes the cpuid instruction and stores eax, ebx, ecx, edx in that order
+    void cpuid(u32 regs[4], u32 leaf, u32 subleaf)
+    {
+#ifdef _MSC_VER
+        int temp[4];
+        __cpuidex(temp, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; i++)
+        {
+            regs[i] = static_cast<u32>(temp[i]);
+        }
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    // returns the extended control register that says which registers the os saves
+    u64 readXCR0()
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        u32 eax = 0, edx = 0;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<u64>(edx) << 32) | eax;
+#endif
+    }
+
+    CpuFeatures detectFeatures()
+    {
+        CpuFeatures features{};
+
+        u32 regs[4] = { 0, 0, 0, 0 };
+        cpuid(regs, 0, 0);
+        const u32 max_leaf = regs[0];
+        if (max_leaf < 1)
+        {
+            // error, the cpu does not report its features
+            return features;
+        }
+
+        // leaf 1: edx and ecx contain the sse family and avx flags
+        cpuid(regs, 1, 0);
+        const u32 ecx = regs[2];
+        const u32 edx = regs[3];
+        features.sse2 = (edx & (1u << 26)) != 0;
+        features.sse3 = (ecx & (1u << 0)) != 0;
+        features.ssse3 = (ecx & (1u << 9)) != 0;
+        features.sse41 = (ecx & (1u << 19)) != 0;
+        features.sse42 = (ecx & (1u << 20)) != 0;
+
+        // the ymm registers can only be used when the os saves them on a context switch,
+        // which is reported by OSXSAVE and bits 1 (xmm) and 2 (ymm) of XCR0
+        const bool osxsave = (ecx & (1u << 27)) != 0;
+        const bool cpu_avx = (ecx & (1u << 28)) != 0;
+        const bool os_ymm = osxsave && ((readXCR0() & 0x6) == 0x6);
+        features.avx = cpu_avx && os_ymm;
+        features.fma = features.avx && (ecx & (1u << 12)) != 0;
+        features.f16c = features.avx && (ecx & (1u << 29)) != 0;
+
+        // leaf 7: ebx contains the avx2 flag
+        if (max_leaf >= 7)
+        {
+            cpuid(regs, 7, 0);
+            features.avx2 = features.avx && (regs[1] & (1u << 5)) != 0;
+        }
+
+        return features;
+    }
+}
+
+const CpuFeatures& deadrop::GetCpuFeatures()
+{
+    // detect the features once, on the first call
+    static const CpuFeatures s_features = detectFeatures();
+    return s_features;
+}
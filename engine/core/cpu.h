@@ -0,0 +1,27 @@
+#pragma once
+#include "types.h"
+
+namespace deadrop
+{
+    // the instruction set extensions supported by the cpu,
+    // used to select the fastest implementation of a function at runtime
+    struct CpuFeatures
+    {
+        bool sse2 = false;
+        bool sse3 = false;
+        bool ssse3 = false;
+        bool sse41 = false;
+        bool sse42 = false;
+        // NOTE: avx and everything built on top of it is only reported
+        // when the operating system also saves the ymm registers
+        bool avx = false;
+        bool avx2 = false;
+        bool fma = false;
+        bool f16c = false;
+    };
+
+    // returns the features of the cpu that the engine is running on
+    // NOTE: the detection is done once on the first call, later calls are cheap
+    [[nodiscard]]
+    const CpuFeatures& GetCpuFeatures();
+}
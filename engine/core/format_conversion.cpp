@@ -0,0 +1,513 @@
+#include "format_conversion.h"
+#include "cpu.h"
+#include "simd.h"
+using namespace deadrop;
+
+// each kernel converts as many values as it can in full registers and returns
+// how many it converted, the rest is converted by the single value functions
+namespace
+{
+    // sse2 kernels
+
+    // the same steps as FloatToHalf(), for 4 floats
+    inline __m128i floatToHalf4SSE2(__m128 value)
+    {
+        const __m128i bits_with_sign = _mm_castps_si128(value);
+        const __m128i bits = _mm_and_si128(bits_with_sign, _mm_set1_epi32(0x7FFFFFFF));
+        const __m128i sign = _mm_xor_si128(bits_with_sign, bits);
+
+        // infinity, nan, or too big to be represented
+        const __m128i is_inf_nan = _mm_cmpgt_epi32(bits, _mm_set1_epi32(((127 + 16) << 23) - 1));
+        const __m128i is_nan = _mm_cmpgt_epi32(bits, _mm_set1_epi32(0x7F800000));
+        const __m128i inf_nan = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(is_nan, _mm_set1_epi32(0x0200)));
+
+        // denormals and zero
+        const __m128i is_denormal = _mm_cmplt_epi32(bits, _mm_set1_epi32((127 - 14) << 23));
+        const __m128i magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), _mm_castsi128_ps(magic))), magic);
+
+        // normals
+        const __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(static_cast<int>((15u - 127u) << 23) + 0xFFF));
+        normal = _mm_srli_epi32(_mm_add_epi32(normal, odd), 13);
+
+        __m128i half = _mm_or_si128(_mm_and_si128(is_denormal, denormal), _mm_andnot_si128(is_denormal, normal));
+        half = _mm_or_si128(_mm_and_si128(is_inf_nan, inf_nan), _mm_andnot_si128(is_inf_nan, half));
+        return _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+    }
+
+    // packs the low 16 bits of the 32-bit lanes of 'a' and 'b' into 8 16-bit values
+    // NOTE: sse2 only has a pack with signed saturation, so the values are sign extended first
+    inline __m128i packLow16SSE2(__m128i a, __m128i b)
+    {
+        a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+        b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+        return _mm_packs_epi32(a, b);
+    }
+
+    size_t floatToHalfSSE2(const float* src, u16* dst, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i low = floatToHalf4SSE2(_mm_loadu_ps(src + i));
+            const __m128i high = floatToHalf4SSE2(_mm_loadu_ps(src + i + 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packLow16SSE2(low, high));
+        }
+        return i;
+    }
+
+    // the same steps as HalfToFloat(), for 4 halfs that are zero extended to 32 bits
+    inline __m128 halfToFloat4SSE2(__m128i value)
+    {
+        const __m128i exponent_mantissa = _mm_and_si128(value, _mm_set1_epi32(0x7FFF));
+        const __m128i sign = _mm_slli_epi32(_mm_xor_si128(value, exponent_mantissa), 16);
+        const __m128 shifted = _mm_mul_ps(
+            _mm_castsi128_ps(_mm_slli_epi32(exponent_mantissa, 13)),
+            _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+        const __m128i is_inf_nan = _mm_cmpgt_epi32(exponent_mantissa, _mm_set1_epi32(0x7BFF));
+        const __m128i inf_nan_exponent = _mm_and_si128(is_inf_nan, _mm_set1_epi32(255 << 23));
+        return _mm_or_ps(shifted, _mm_castsi128_ps(_mm_or_si128(sign, inf_nan_exponent)));
+    }
+
+    size_t halfToFloatSSE2(const u16* src, float* dst, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i halfs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_ps(dst + i, halfToFloat4SSE2(_mm_unpacklo_epi16(halfs, zero)));
+            _mm_storeu_ps(dst + i + 4, halfToFloat4SSE2(_mm_unpackhi_epi16(halfs, zero)));
+        }
+        return i;
+    }
+
+    // clamps to [0, 1] and scales to [0, 'scale'], nans become zero
+    inline __m128i unormRound4SSE2(__m128 value, __m128 scale)
+    {
+        // NOTE: max returns its second operand when the first is a nan
+        value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+    }
+
+    // clamps to [-1, 1] and scales to [-'scale', 'scale'], nans become zero
+    inline __m128i snormRound4SSE2(__m128 value, __m128 scale)
+    {
+        value = _mm_and_ps(value, _mm_cmpord_ps(value, value));
+        value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+    }
+
+    size_t floatToUnorm8SSE2(const float* src, u8* dst, size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(255.0f);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i a = unormRound4SSE2(_mm_loadu_ps(src + i), scale);
+            const __m128i b = unormRound4SSE2(_mm_loadu_ps(src + i + 4), scale);
+            const __m128i c = unormRound4SSE2(_mm_loadu_ps(src + i + 8), scale);
+            const __m128i d = unormRound4SSE2(_mm_loadu_ps(src + i + 12), scale);
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+        }
+        return i;
+    }
+
+    size_t unorm8ToFloatSSE2(const u8* src, float* dst, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 scale = _mm_set1_ps(255.0f);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+            _mm_storeu_ps(dst + i + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+            _mm_storeu_ps(dst + i + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+        }
+        return i;
+    }
+
+    size_t floatToUnorm16SSE2(const float* src, u16* dst, size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(65535.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i a = unormRound4SSE2(_mm_loadu_ps(src + i), scale);
+            const __m128i b = unormRound4SSE2(_mm_loadu_ps(src + i + 4), scale);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packLow16SSE2(a, b));
+        }
+        return i;
+    }
+
+    size_t unorm16ToFloatSSE2(const u16* src, float* dst, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 scale = _mm_set1_ps(65535.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(values, zero)), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(values, zero)), scale));
+        }
+        return i;
+    }
+
+    size_t floatToSnorm8SSE2(const float* src, i8* dst, size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(127.0f);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i a = snormRound4SSE2(_mm_loadu_ps(src + i), scale);
+            const __m128i b = snormRound4SSE2(_mm_loadu_ps(src + i + 4), scale);
+            const __m128i c = snormRound4SSE2(_mm_loadu_ps(src + i + 8), scale);
+            const __m128i d = snormRound4SSE2(_mm_loadu_ps(src + i + 12), scale);
+            const __m128i packed = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+        }
+        return i;
+    }
+
+    // converts 4 signed 32-bit values to floats in [-1, 1]
+    inline __m128 snormToFloat4SSE2(__m128i value, __m128 scale)
+    {
+        return _mm_max_ps(_mm_div_ps(_mm_cvtepi32_ps(value), scale), _mm_set1_ps(-1.0f));
+    }
+
+    size_t snorm8ToFloatSSE2(const i8* src, float* dst, size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(127.0f);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            // the bytes are sign extended by moving them to the top of each lane and shifting them back down
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i low = _mm_unpacklo_epi8(bytes, bytes);
+            const __m128i high = _mm_unpackhi_epi8(bytes, bytes);
+            _mm_storeu_ps(dst + i, snormToFloat4SSE2(_mm_srai_epi32(_mm_unpacklo_epi16(low, low), 24), scale));
+            _mm_storeu_ps(dst + i + 4, snormToFloat4SSE2(_mm_srai_epi32(_mm_unpackhi_epi16(low, low), 24), scale));
+            _mm_storeu_ps(dst + i + 8, snormToFloat4SSE2(_mm_srai_epi32(_mm_unpacklo_epi16(high, high), 24), scale));
+            _mm_storeu_ps(dst + i + 12, snormToFloat4SSE2(_mm_srai_epi32(_mm_unpackhi_epi16(high, high), 24), scale));
+        }
+        return i;
+    }
+
+    size_t floatToSnorm16SSE2(const float* src, i16* dst, size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i a = snormRound4SSE2(_mm_loadu_ps(src + i), scale);
+            const __m128i b = snormRound4SSE2(_mm_loadu_ps(src + i + 4), scale);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(a, b));
+        }
+        return i;
+    }
+
+    size_t snorm16ToFloatSSE2(const i16* src, float* dst, size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_ps(dst + i, snormToFloat4SSE2(_mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16), scale));
+            _mm_storeu_ps(dst + i + 4, snormToFloat4SSE2(_mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16), scale));
+        }
+        return i;
+    }
+
+    // f16c kernels, the cpu converts 8 values with a single instruction
+    // NOTE: F16C keeps part of the payload of a nan and quiets the signaling ones, so the groups of 8 values
+    // that contain a nan use the single value functions to give the same results, nans are rare enough that
+    // this costs nothing in practice
+
+    SIMD_TARGET_F16C
+    size_t floatToHalfF16C(const float* src, u16* dst, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 values = _mm256_loadu_ps(src + i);
+            if (_mm256_movemask_ps(_mm256_cmp_ps(values, values, _CMP_UNORD_Q)) != 0)
+            {
+                for (size_t j = i; j < i + 8; j++)
+                {
+                    dst[j] = FloatToHalf(src[j]);
+                }
+                continue;
+            }
+            const __m128i halfs = _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), halfs);
+        }
+        return i;
+    }
+
+    SIMD_TARGET_F16C
+    size_t halfToFloatF16C(const u16* src, float* dst, size_t count)
+    {
+        const __m128i abs_mask = _mm_set1_epi16(0x7FFF);
+        const __m128i infinity = _mm_set1_epi16(0x7C00);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i halfs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            if (_mm_movemask_epi8(_mm_cmpgt_epi16(_mm_and_si128(halfs, abs_mask), infinity)) != 0)
+            {
+                for (size_t j = i; j < i + 8; j++)
+                {
+                    dst[j] = HalfToFloat(src[j]);
+                }
+                continue;
+            }
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(halfs));
+        }
+        return i;
+    }
+
+    // avx2 kernels, the 256-bit packs work on each 128-bit lane separately,
+    // so the packed values are permuted back into order before storing them
+
+    SIMD_TARGET_AVX2 inline __m256i unormRound8AVX2(__m256 value, __m256 scale)
+    {
+        value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+        return _mm256_cvtps_epi32(_mm256_mul_ps(value, scale));
+    }
+
+    SIMD_TARGET_AVX2 inline __m256i snormRound8AVX2(__m256 value, __m256 scale)
+    {
+        value = _mm256_and_ps(value, _mm256_cmp_ps(value, value, _CMP_ORD_Q));
+        value = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+        return _mm256_cvtps_epi32(_mm256_mul_ps(value, scale));
+    }
+
+    SIMD_TARGET_AVX2 inline __m256 snormToFloat8AVX2(__m256i value, __m256 scale)
+    {
+        return _mm256_max_ps(_mm256_div_ps(_mm256_cvtepi32_ps(value), scale), _mm256_set1_ps(-1.0f));
+    }
+
+    SIMD_TARGET_AVX2
+    size_t floatToUnorm8AVX2(const float* src, u8* dst, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(255.0f);
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        size_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            const __m256i a = unormRound8AVX2(_mm256_loadu_ps(src + i), scale);
+            const __m256i b = unormRound8AVX2(_mm256_loadu_ps(src + i + 8), scale);
+            const __m256i c = unormRound8AVX2(_mm256_loadu_ps(src + i + 16), scale);
+            const __m256i d = unormRound8AVX2(_mm256_loadu_ps(src + i + 24), scale);
+            const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permutevar8x32_epi32(packed, order));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2
+    size_t unorm8ToFloatAVX2(const u8* src, float* dst, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(255.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_ps(dst + i, _mm256_div_ps(_mm256_cvtepi32_ps(values), scale));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2
+    size_t floatToUnorm16AVX2(const float* src, u16* dst, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(65535.0f);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m256i a = unormRound8AVX2(_mm256_loadu_ps(src + i), scale);
+            const __m256i b = unormRound8AVX2(_mm256_loadu_ps(src + i + 8), scale);
+            const __m256i packed = _mm256_packus_epi32(a, b);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2
+    size_t unorm16ToFloatAVX2(const u16* src, float* dst, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(65535.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i values = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_ps(dst + i, _mm256_div_ps(_mm256_cvtepi32_ps(values), scale));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2
+    size_t floatToSnorm8AVX2(const float* src, i8* dst, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(127.0f);
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        size_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            const __m256i a = snormRound8AVX2(_mm256_loadu_ps(src + i), scale);
+            const __m256i b = snormRound8AVX2(_mm256_loadu_ps(src + i + 8), scale);
+            const __m256i c = snormRound8AVX2(_mm256_loadu_ps(src + i + 16), scale);
+            const __m256i d = snormRound8AVX2(_mm256_loadu_ps(src + i + 24), scale);
+            const __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permutevar8x32_epi32(packed, order));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2
+    size_t snorm8ToFloatAVX2(const i8* src, float* dst, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(127.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i values = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_ps(dst + i, snormToFloat8AVX2(values, scale));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2
+    size_t floatToSnorm16AVX2(const float* src, i16* dst, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(32767.0f);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m256i a = snormRound8AVX2(_mm256_loadu_ps(src + i), scale);
+            const __m256i b = snormRound8AVX2(_mm256_loadu_ps(src + i + 8), scale);
+            const __m256i packed = _mm256_packs_epi32(a, b);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2
+    size_t snorm16ToFloatAVX2(const i16* src, float* dst, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(32767.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i values = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_ps(dst + i, snormToFloat8AVX2(values, scale));
+        }
+        return i;
+    }
+}
+
+void deadrop::FloatToHalfMany(const float* src, u16* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().f16c ? floatToHalfF16C(src, dst, count) : floatToHalfSSE2(src, dst, count);
+    for (; i < count; i++)
+    {
+        dst[i] = FloatToHalf(src[i]);
+    }
+}
+
+void deadrop::HalfToFloatMany(const u16* src, float* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().f16c ? halfToFloatF16C(src, dst, count) : halfToFloatSSE2(src, dst, count);
+    for (; i < count; i++)
+    {
+        dst[i] = HalfToFloat(src[i]);
+    }
+}
+
+void deadrop::FloatToUnorm8Many(const float* src, u8* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().avx2 ? floatToUnorm8AVX2(src, dst, count) : 0;
+    i += floatToUnorm8SSE2(src + i, dst + i, count - i);
+    for (; i < count; i++)
+    {
+        dst[i] = FloatToUnorm8(src[i]);
+    }
+}
+
+void deadrop::Unorm8ToFloatMany(const u8* src, float* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().avx2 ? unorm8ToFloatAVX2(src, dst, count) : 0;
+    i += unorm8ToFloatSSE2(src + i, dst + i, count - i);
+    for (; i < count; i++)
+    {
+        dst[i] = Unorm8ToFloat(src[i]);
+    }
+}
+
+void deadrop::FloatToUnorm16Many(const float* src, u16* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().avx2 ? floatToUnorm16AVX2(src, dst, count) : 0;
+    i += floatToUnorm16SSE2(src + i, dst + i, count - i);
+    for (; i < count; i++)
+    {
+        dst[i] = FloatToUnorm16(src[i]);
+    }
+}
+
+void deadrop::Unorm16ToFloatMany(const u16* src, float* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().avx2 ? unorm16ToFloatAVX2(src, dst, count) : 0;
+    i += unorm16ToFloatSSE2(src + i, dst + i, count - i);
+    for (; i < count; i++)
+    {
+        dst[i] = Unorm16ToFloat(src[i]);
+    }
+}
+
+void deadrop::FloatToSnorm8Many(const float* src, i8* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().avx2 ? floatToSnorm8AVX2(src, dst, count) : 0;
+    i += floatToSnorm8SSE2(src + i, dst + i, count - i);
+    for (; i < count; i++)
+    {
+        dst[i] = FloatToSnorm8(src[i]);
+    }
+}
+
+void deadrop::Snorm8ToFloatMany(const i8* src, float* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().avx2 ? snorm8ToFloatAVX2(src, dst, count) : 0;
+    i += snorm8ToFloatSSE2(src + i, dst + i, count - i);
+    for (; i < count; i++)
+    {
+        dst[i] = Snorm8ToFloat(src[i]);
+    }
+}
+
+void deadrop::FloatToSnorm16Many(const float* src, i16* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().avx2 ? floatToSnorm16AVX2(src, dst, count) : 0;
+    i += floatToSnorm16SSE2(src + i, dst + i, count - i);
+    for (; i < count; i++)
+    {
+        dst[i] = FloatToSnorm16(src[i]);
+    }
+}
+
+void deadrop::Snorm16ToFloatMany(const i16* src, float* dst, size_t count)
+{
+    size_t i = GetCpuFeatures().avx2 ? snorm16ToFloatAVX2(src, dst, count) : 0;
+    i += snorm16ToFloatSSE2(src + i, dst + i, count - i);
+    for (; i < count; i++)
+    {
+        dst[i] = Snorm16ToFloat(src[i]);
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include "types.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// conversions between 32-bit floats and the smaller formats that textures and vertex streams
+// can be stored in on the gpu (the *_16F, *_16UN, *_8SN... formats)
+// NOTE: the rules are the ones d3d uses, unorm values are clamped to [0, 1] and snorm values to [-1, 1],
+// nans become zero and the results are rounded to the nearest value (ties to even)
+namespace deadrop
+{
+    // converts a float to a half (ieee 754 binary16), values too big for a half become infinity
+    // NOTE: nans stay nans but their payload is not kept
+    inline u16 FloatToHalf(float value)
+    {
+        u32 bits;
+        memcpy(&bits, &value, sizeof(u32));
+        const u32 sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        u32 half;
+        if (bits >= (127u + 16u) << 23)
+        {
+            // infinity, nan, or too big to be represented
+            half = bits > 0x7F800000u ? 0x7E00u : 0x7C00u;
+        }
+        else if (bits < (127u - 14u) << 23)
+        {
+            // the result is a denormal or zero, adding the magic number aligns the 10 bits of the
+            // mantissa at the bottom of the float and the float addition does the rounding
+            const u32 magic_bits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+            float magic;
+            memcpy(&magic, &magic_bits, sizeof(float));
+            float f;
+            memcpy(&f, &bits, sizeof(float));
+            f += magic;
+            memcpy(&half, &f, sizeof(u32));
+            half -= magic_bits;
+        }
+        else
+        {
+            // rebias the exponent and round the mantissa to nearest even
+            const u32 odd = (bits >> 13) & 1u;
+            half = (bits + (static_cast<u32>(15 - 127) << 23) + 0xFFFu + odd) >> 13;
+        }
+        return static_cast<u16>(half | (sign >> 16));
+    }
+
+    // converts a half (ieee 754 binary16) to a float, the conversion is exact
+    inline float HalfToFloat(u16 value)
+    {
+        // shift the exponent and mantissa into place and let a float multiplication rebias the
+        // exponent, which also normalizes the denormals
+        const u32 exponent_mantissa = value & 0x7FFFu;
+        const u32 shifted_bits = exponent_mantissa << 13;
+        const u32 magic_bits = (254u - 15u) << 23;
+        float shifted, magic;
+        memcpy(&shifted, &shifted_bits, sizeof(float));
+        memcpy(&magic, &magic_bits, sizeof(float));
+        shifted *= magic;
+
+        u32 bits;
+        memcpy(&bits, &shifted, sizeof(u32));
+        if (exponent_mantissa > 0x7BFFu)
+        {
+            // infinity or nan
+            bits |= 255u << 23;
+        }
+        bits |= static_cast<u32>(value & 0x8000u) << 16;
+
+        float result;
+        memcpy(&result, &bits, sizeof(float));
+        return result;
+    }
+
+    // converts a float in the range [0, 1] to an 8-bit unsigned normalized value
+    inline u8 FloatToUnorm8(float value)
+    {
+        // NOTE: the comparisons are written so nans become zero
+        value = value > 0.0f ? value : 0.0f;
+        value = value < 1.0f ? value : 1.0f;
+        return static_cast<u8>(std::lrint(value * 255.0f));
+    }
+
+    // converts an 8-bit unsigned normalized value to a float in the range [0, 1]
+    inline float Unorm8ToFloat(u8 value)
+    {
+        return static_cast<float>(value) / 255.0f;
+    }
+
+    // converts a float in the range [0, 1] to a 16-bit unsigned normalized value
+    inline u16 FloatToUnorm16(float value)
+    {
+        value = value > 0.0f ? value : 0.0f;
+        value = value < 1.0f ? value : 1.0f;
+        return static_cast<u16>(std::lrint(value * 65535.0f));
+    }
+
+    // converts a 16-bit unsigned normalized value to a float in the range [0, 1]
+    inline float Unorm16ToFloat(u16 value)
+    {
+        return static_cast<float>(value) / 65535.0f;
+    }
+
+    // converts a float in the range [-1, 1] to an 8-bit signed normalized value
+    // NOTE: -128 is never produced, -1 maps to -127 so that zero stays exactly representable
+    inline i8 FloatToSnorm8(float value)
+    {
+        value = value == value ? value : 0.0f;
+        value = value > -1.0f ? value : -1.0f;
+        value = value < 1.0f ? value : 1.0f;
+        return static_cast<i8>(std::lrint(value * 127.0f));
+    }
+
+    // converts an 8-bit signed normalized value to a float in the range [-1, 1], -128 also maps to -1
+    inline float Snorm8ToFloat(i8 value)
+    {
+        const float result = static_cast<float>(value) / 127.0f;
+        return result > -1.0f ? result : -1.0f;
+    }
+
+    // converts a float in the range [-1, 1] to a 16-bit signed normalized value
+    // NOTE: -32768 is never produced, -1 maps to -32767 so that zero stays exactly representable
+    inline i16 FloatToSnorm16(float value)
+    {
+        value = value == value ? value : 0.0f;
+        value = value > -1.0f ? value : -1.0f;
+        value = value < 1.0f ? value : 1.0f;
+        return static_cast<i16>(std::lrint(value * 32767.0f));
+    }
+
+    // converts a 16-bit signed normalized value to a float in the range [-1, 1], -32768 also maps to -1
+    inline float Snorm16ToFloat(i16 value)
+    {
+        const float result = static_cast<float>(value) / 32767.0f;
+        return result > -1.0f ? result : -1.0f;
+    }
+
+    // the functions below convert whole arrays of 'count' values, using F16C, AVX2 or SSE2 when the cpu
+    // supports them, the results are exactly the same as calling the single value functions above
+    // NOTE: 'src' and 'dst' must not overlap and do not have to be aligned
+
+    void FloatToHalfMany(const float* src, u16* dst, size_t count);
+    void HalfToFloatMany(const u16* src, float* dst, size_t count);
+
+    void FloatToUnorm8Many(const float* src, u8* dst, size_t count);
+    void Unorm8ToFloatMany(const u8* src, float* dst, size_t count);
+
+    void FloatToUnorm16Many(const float* src, u16* dst, size_t count);
+    void Unorm16ToFloatMany(const u16* src, float* dst, size_t count);
+
+    void FloatToSnorm8Many(const float* src, i8* dst, size_t count);
+    void Snorm8ToFloatMany(const i8* src, float* dst, size_t count);
+
+    void FloatToSnorm16Many(const float* src, i16* dst, size_t count);
+    void Snorm16ToFloatMany(const i16* src, float* dst, size_t count);
+}
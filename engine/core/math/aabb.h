@@ -5,23 +5,80 @@ namespace deadrop
 {
     namespace math
     {
+        // NOTE: the layout is the min corner followed by the max corner (6 floats),
+        // the simd culling functions rely on it to load arrays of boxes directly
         class AABB
         {
         public:
             // default constructor
-            AABB() : m_min(vec3f(0.0f)), m_max(vec3f(0.0f)) {}
+            constexpr AABB() : m_min(vec3f(0.0f)), m_max(vec3f(0.0f)) {}
             // constructors
-            AABB(const vec3f& min, const vec3f& max) : m_min(min), m_max(max) {}
+            constexpr AABB(const vec3f& min, const vec3f& max) : m_min(min), m_max(max) {}
 
-            // returns whether this AABB intersects with a specific AABB
-            inline bool intersects(const AABB& aabb) const;
+            // returns the corners of the AABB
+            constexpr const vec3f& getMin() const { return m_min; }
+            constexpr const vec3f& getMax() const { return m_max; }
+
+            // returns the center point of the AABB
+            constexpr vec3f getCenter() const;
+
+            // returns the half size of the AABB on each axis
+            constexpr vec3f getExtents() const;
+
+            // returns the area of the six faces of the AABB
+            constexpr float getSurfaceArea() const;
+
+            // returns whether this AABB intersects (overlaps) with a specific AABB,
+            // touching boxes are considered to be intersecting
+            constexpr bool intersects(const AABB& aabb) const;
+
+            // returns whether this AABB fully contains a specific AABB
+            constexpr bool contains(const AABB& aabb) const;
 
         private:
             vec3f m_min;
             vec3f m_max;
         };
 
-        bool AABB::intersects(const AABB& aabb) const
+        static_assert(sizeof(AABB) == sizeof(float) * 6, "AABB must be tightly packed");
+
+        constexpr vec3f AABB::getCenter() const
+        {
+            return vec3f
+            {
+                (m_min.x + m_max.x) * 0.5f,
+                (m_min.y + m_max.y) * 0.5f,
+                (m_min.z + m_max.z) * 0.5f
+            };
+        }
+
+        constexpr vec3f AABB::getExtents() const
+        {
+            return vec3f
+            {
+                (m_max.x - m_min.x) * 0.5f,
+                (m_max.y - m_min.y) * 0.5f,
+                (m_max.z - m_min.z) * 0.5f
+            };
+        }
+
+        constexpr float AABB::getSurfaceArea() const
+        {
+            const float dx = m_max.x - m_min.x;
+            const float dy = m_max.y - m_min.y;
+            const float dz = m_max.z - m_min.z;
+            return 2.0f * (dx * dy + dy * dz + dz * dx);
+        }
+
+        constexpr bool AABB::intersects(const AABB& aabb) const
+        {
+            // the boxes overlap only when their ranges overlap on all three axes
+            return (m_min.x <= aabb.m_max.x) && (m_max.x >= aabb.m_min.x) &&
+                (m_min.y <= aabb.m_max.y) && (m_max.y >= aabb.m_min.y) &&
+                (m_min.z <= aabb.m_max.z) && (m_max.z >= aabb.m_min.z);
+        }
+
+        constexpr bool AABB::contains(const AABB& aabb) const
         {
             if ((m_min.x <= aabb.m_min.x) && (m_max.x >= aabb.m_max.x) &&
                 (m_min.y <= aabb.m_min.y) && (m_max.y >= aabb.m_max.y) &&
@@ -34,5 +91,19 @@ namespace deadrop
                 return false;
             }
         }
+
+        // returns the smallest AABB that contains both AABBs
+        constexpr AABB Union(const AABB& aabb1, const AABB& aabb2)
+        {
+            const vec3f& min1 = aabb1.getMin();
+            const vec3f& min2 = aabb2.getMin();
+            const vec3f& max1 = aabb1.getMax();
+            const vec3f& max2 = aabb2.getMax();
+            return AABB
+            {
+                vec3f{ min1.x < min2.x ? min1.x : min2.x, min1.y < min2.y ? min1.y : min2.y, min1.z < min2.z ? min1.z : min2.z },
+                vec3f{ max1.x > max2.x ? max1.x : max2.x, max1.y > max2.y ? max1.y : max2.y, max1.z > max2.z ? max1.z : max2.z }
+            };
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,354 @@
+#include "animation_clip.h"
+#include "engine/core/simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+using namespace deadrop;
+using namespace deadrop::math;
+
+namespace
+{
+    enum Channel : u32
+    {
+        CHANNEL_TRANSLATION = 0,
+        CHANNEL_ROTATION,
+        CHANNEL_SCALE,
+        CHANNEL_COUNT
+    };
+
+    // the number of components of each channel and where they start in a pose
+    constexpr u32 CHANNEL_COMPONENTS[CHANNEL_COUNT] = { 3, 4, 3 };
+    constexpr u32 CHANNEL_OFFSETS[CHANNEL_COUNT] = { 0, 3, 7 };
+    constexpr u32 POSE_COMPONENTS = 10;
+
+    // the number of bones that Sample() interpolates together, their keys are gathered on the stack
+    constexpr u32 BLOCK_SIZE = 64;
+
+    constexpr float QUANTIZED_MAX = 65535.0f;
+
+    // interpolates between two keys the same way Sample() does, rotations take the shortest path
+    // and are normalized
+    void interpolate(const float* key0, const float* key1, float alpha, u32 components, float* result)
+    {
+        if (components == 4)
+        {
+            const float dot = key0[0] * key1[0] + key0[1] * key1[1] + key0[2] * key1[2] + key0[3] * key1[3];
+            const float sign = dot < 0.0f ? -1.0f : 1.0f;
+            float length_sq = 0.0f;
+            for (u32 c = 0; c < 4; c++)
+            {
+                result[c] = key0[c] + (key1[c] * sign - key0[c]) * alpha;
+                length_sq += result[c] * result[c];
+            }
+            const float inv_length = 1.0f / std::sqrt(length_sq);
+            for (u32 c = 0; c < 4; c++)
+            {
+                result[c] *= inv_length;
+            }
+        }
+        else
+        {
+            for (u32 c = 0; c < components; c++)
+            {
+                result[c] = key0[c] + (key1[c] - key0[c]) * alpha;
+            }
+        }
+    }
+
+    // returns the distance between two translations or scales, or the angle between two unit rotations
+    float measureError(const float* a, const float* b, u32 components)
+    {
+        // NOTE: the angle is computed from the distance between the rotations (which is 2 * sin(angle / 4))
+        // instead of the acos of their dot product, which is not precise enough for small angles
+        const float sign = components == 4 && (a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]) < 0.0f ? -1.0f : 1.0f;
+        float distance_sq = 0.0f;
+        for (u32 c = 0; c < components; c++)
+        {
+            distance_sq += (a[c] - b[c] * sign) * (a[c] - b[c] * sign);
+        }
+        const float distance = std::sqrt(distance_sq);
+        return components == 4 ? 4.0f * std::asin(std::min(distance * 0.5f, 1.0f)) : distance;
+    }
+
+    // returns true when interpolating the keys at frames 'first' and 'last' reproduces every frame between
+    // them within the tolerance, 'values' are the raw values and 'keys' the quantized ones
+    bool segmentFits(const std::vector<float>& values, const std::vector<float>& keys, u32 components, u32 first, u32 last, float tolerance)
+    {
+        float result[4];
+        for (u32 frame = first; frame <= last; frame++)
+        {
+            const float alpha = static_cast<float>(frame - first) / static_cast<float>(last - first);
+            interpolate(&keys[first * components], &keys[last * components], alpha, components, result);
+            if (measureError(result, &values[frame * components], components) > tolerance)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool AnimationClip::Compress(const RawAnimationClip& raw, const AnimationCompressionSettings& settings)
+{
+    const size_t element_count = static_cast<size_t>(raw.bone_count) * raw.frame_count;
+
+    // error, the frames are stored in 16 bits
+    if (raw.frame_count == 0 || raw.frame_count > 65536)
+    {
+        return false;
+    }
+
+    // error, a transform is missing
+    if (raw.translations.size() != element_count || raw.rotations.size() != element_count || raw.scales.size() != element_count)
+    {
+        return false;
+    }
+
+    // error, the clip can not be sampled
+    if (!(raw.sample_rate > 0.0f))
+    {
+        return false;
+    }
+
+    m_bone_count = raw.bone_count;
+    m_frame_count = raw.frame_count;
+    m_sample_rate = raw.sample_rate;
+    m_tracks.resize(static_cast<size_t>(raw.bone_count) * CHANNEL_COUNT);
+    m_key_frames.clear();
+    m_key_values.clear();
+
+    const float tolerances[CHANNEL_COUNT] = { settings.translation_tolerance, settings.rotation_tolerance, settings.scale_tolerance };
+    std::vector<float> values;
+    std::vector<float> keys;
+    std::vector<u16> quantized;
+    for (u32 bone = 0; bone < raw.bone_count; bone++)
+    {
+        for (u32 channel = 0; channel < CHANNEL_COUNT; channel++)
+        {
+            const u32 components = CHANNEL_COMPONENTS[channel];
+            const float tolerance = tolerances[channel];
+
+            // copy the values of the track, the rotations are normalized and kept in the same hemisphere
+            // as the previous frame so the track is continuous and its range small
+            values.resize(static_cast<size_t>(raw.frame_count) * components);
+            for (u32 frame = 0; frame < raw.frame_count; frame++)
+            {
+                const size_t element = static_cast<size_t>(frame) * raw.bone_count + bone;
+                float* value = &values[static_cast<size_t>(frame) * components];
+                if (channel == CHANNEL_TRANSLATION)
+                {
+                    memcpy(value, &raw.translations[element], sizeof(float) * 3);
+                }
+                else if (channel == CHANNEL_SCALE)
+                {
+                    memcpy(value, &raw.scales[element], sizeof(float) * 3);
+                }
+                else
+                {
+                    quatf q = Normalize(raw.rotations[element]);
+                    if (frame > 0 && (q.x * value[-4] + q.y * value[-3] + q.z * value[-2] + q.w * value[-1]) < 0.0f)
+                    {
+                        q = q * -1.0f;
+                    }
+                    memcpy(value, &q, sizeof(float) * 4);
+                }
+            }
+
+            Track& track = m_tracks[static_cast<size_t>(bone) * CHANNEL_COUNT + channel];
+            track.first_key = static_cast<u32>(m_key_frames.size());
+            track.first_value = static_cast<u32>(m_key_values.size());
+            track.key_count = 0;
+            memset(track.min, 0, sizeof(track.min));
+            memset(track.step, 0, sizeof(track.step));
+
+            // a track that stays within the tolerance of its first value is stored as that value
+            bool constant = true;
+            for (u32 frame = 1; frame < raw.frame_count && constant; frame++)
+            {
+                constant = measureError(&values[0], &values[static_cast<size_t>(frame) * components], components) <= tolerance;
+            }
+            if (constant)
+            {
+                memcpy(track.min, &values[0], sizeof(float) * components);
+                continue;
+            }
+
+            // quantize every frame within the range of the track
+            float max[4];
+            memcpy(track.min, &values[0], sizeof(float) * components);
+            memcpy(max, &values[0], sizeof(float) * components);
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                track.min[i % components] = std::min(track.min[i % components], values[i]);
+                max[i % components] = std::max(max[i % components], values[i]);
+            }
+            for (u32 c = 0; c < components; c++)
+            {
+                track.step[c] = (max[c] - track.min[c]) / QUANTIZED_MAX;
+            }
+            quantized.resize(values.size());
+            keys.resize(values.size());
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                const u32 c = static_cast<u32>(i % components);
+                const float q = track.step[c] > 0.0f ? (values[i] - track.min[c]) / track.step[c] : 0.0f;
+                quantized[i] = static_cast<u16>(std::lrint(std::min(std::max(q, 0.0f), QUANTIZED_MAX)));
+                keys[i] = track.min[c] + quantized[i] * track.step[c];
+            }
+
+            // keep the first frame and greedily make each segment as long as the tolerance allows
+            const u32 last_frame = raw.frame_count - 1;
+            u32 key = 0;
+            while (true)
+            {
+                m_key_frames.push_back(static_cast<u16>(key));
+                m_key_values.insert(m_key_values.end(), &quantized[static_cast<size_t>(key) * components], &quantized[static_cast<size_t>(key) * components] + components);
+                track.key_count++;
+                if (key == last_frame)
+                {
+                    break;
+                }
+
+                u32 next = key + 1;
+                while (next < last_frame && segmentFits(values, keys, components, key, next + 1, tolerance))
+                {
+                    next++;
+                }
+                key = next;
+            }
+        }
+    }
+    return true;
+}
+
+void AnimationClip::gatherKeys(float frame, u32 bone, u32 channel, float* key0, float* key1, size_t key_stride, float& alpha) const
+{
+    const Track& track = m_tracks[static_cast<size_t>(bone) * CHANNEL_COUNT + channel];
+    const u32 components = CHANNEL_COMPONENTS[channel];
+    if (track.key_count == 0)
+    {
+        for (u32 c = 0; c < components; c++)
+        {
+            key0[c * key_stride] = track.min[c];
+            key1[c * key_stride] = track.min[c];
+        }
+        alpha = 0.0f;
+        return;
+    }
+
+    // find the keys around the frame, a track that changes has keys at the first and the last frame
+    const u16* frames = &m_key_frames[track.first_key];
+    const u32 key = static_cast<u32>(std::upper_bound(frames + 1, frames + track.key_count - 1, frame) - frames) - 1;
+    const float frame0 = frames[key];
+    const float frame1 = frames[key + 1];
+    alpha = std::min((frame - frame0) / (frame1 - frame0), 1.0f);
+
+    const u16* values = &m_key_values[track.first_value + static_cast<size_t>(key) * components];
+    for (u32 c = 0; c < components; c++)
+    {
+        key0[c * key_stride] = track.min[c] + values[c] * track.step[c];
+        key1[c * key_stride] = track.min[c] + values[c + components] * track.step[c];
+    }
+}
+
+void AnimationClip::Sample(float time, const PoseArrays& pose) const
+{
+    float* const outputs[POSE_COMPONENTS] = { pose.tx, pose.ty, pose.tz, pose.rx, pose.ry, pose.rz, pose.rw, pose.sx, pose.sy, pose.sz };
+    const float frame = std::min(std::max(time * m_sample_rate, 0.0f), static_cast<float>(m_frame_count - 1));
+
+    alignas(16) float key0[POSE_COMPONENTS][BLOCK_SIZE];
+    alignas(16) float key1[POSE_COMPONENTS][BLOCK_SIZE];
+    alignas(16) float alpha[CHANNEL_COUNT][BLOCK_SIZE];
+    for (u32 first = 0; first < m_bone_count; first += BLOCK_SIZE)
+    {
+        // gather the keys of a block of bones, the padding lanes repeat the last bone
+        const u32 count = std::min(BLOCK_SIZE, m_bone_count - first);
+        const u32 padded_count = (count + 3) & ~3u;
+        for (u32 i = 0; i < padded_count; i++)
+        {
+            const u32 bone = first + std::min(i, count - 1);
+            for (u32 channel = 0; channel < CHANNEL_COUNT; channel++)
+            {
+                const u32 offset = CHANNEL_OFFSETS[channel];
+                gatherKeys(frame, bone, channel, &key0[offset][i], &key1[offset][i], BLOCK_SIZE, alpha[channel][i]);
+            }
+        }
+
+        // interpolate 4 bones at a time, the results replace the first keys
+        for (u32 i = 0; i < padded_count; i += 4)
+        {
+            const __m128 alpha_translation = _mm_load_ps(&alpha[CHANNEL_TRANSLATION][i]);
+            const __m128 alpha_scale = _mm_load_ps(&alpha[CHANNEL_SCALE][i]);
+            for (u32 c = 0; c < 3; c++)
+            {
+                const __m128 t0 = _mm_load_ps(&key0[c][i]);
+                const __m128 t1 = _mm_load_ps(&key1[c][i]);
+                _mm_store_ps(&key0[c][i], _mm_add_ps(t0, _mm_mul_ps(_mm_sub_ps(t1, t0), alpha_translation)));
+                const __m128 s0 = _mm_load_ps(&key0[7 + c][i]);
+                const __m128 s1 = _mm_load_ps(&key1[7 + c][i]);
+                _mm_store_ps(&key0[7 + c][i], _mm_add_ps(s0, _mm_mul_ps(_mm_sub_ps(s1, s0), alpha_scale)));
+            }
+
+            // the rotations take the shortest path and are normalized, like interpolate() does
+            __m128 r0[4];
+            __m128 r1[4];
+            for (u32 c = 0; c < 4; c++)
+            {
+                r0[c] = _mm_load_ps(&key0[3 + c][i]);
+                r1[c] = _mm_load_ps(&key1[3 + c][i]);
+            }
+            const __m128 dot = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(r0[0], r1[0]), _mm_mul_ps(r0[1], r1[1])),
+                _mm_add_ps(_mm_mul_ps(r0[2], r1[2]), _mm_mul_ps(r0[3], r1[3])));
+            const __m128 sign = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+            const __m128 alpha_rotation = _mm_load_ps(&alpha[CHANNEL_ROTATION][i]);
+            __m128 length_sq = _mm_setzero_ps();
+            for (u32 c = 0; c < 4; c++)
+            {
+                r0[c] = _mm_add_ps(r0[c], _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(r1[c], sign), r0[c]), alpha_rotation));
+                length_sq = _mm_add_ps(length_sq, _mm_mul_ps(r0[c], r0[c]));
+            }
+            const __m128 inv_length = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_sq));
+            for (u32 c = 0; c < 4; c++)
+            {
+                _mm_store_ps(&key0[3 + c][i], _mm_mul_ps(r0[c], inv_length));
+            }
+        }
+
+        for (u32 c = 0; c < POSE_COMPONENTS; c++)
+        {
+            memcpy(outputs[c] + first, key0[c], sizeof(float) * count);
+        }
+    }
+}
+
+void AnimationClip::SampleBone(float time, u32 bone, vec3f& translation, quatf& rotation, vec3f& scale) const
+{
+    const float frame = std::min(std::max(time * m_sample_rate, 0.0f), static_cast<float>(m_frame_count - 1));
+    float key0[POSE_COMPONENTS];
+    float key1[POSE_COMPONENTS];
+    float result[POSE_COMPONENTS];
+    for (u32 channel = 0; channel < CHANNEL_COUNT; channel++)
+    {
+        const u32 offset = CHANNEL_OFFSETS[channel];
+        float alpha;
+        gatherKeys(frame, bone, channel, &key0[offset], &key1[offset], 1, alpha);
+        interpolate(&key0[offset], &key1[offset], alpha, CHANNEL_COMPONENTS[channel], &result[offset]);
+    }
+    translation = vec3f{ result[0], result[1], result[2] };
+    rotation = quatf{ result[3], result[4], result[5], result[6] };
+    scale = vec3f{ result[7], result[8], result[9] };
+}
+
+float AnimationClip::GetDuration() const
+{
+    return m_frame_count > 1 ? static_cast<float>(m_frame_count - 1) / m_sample_rate : 0.0f;
+}
+
+size_t AnimationClip::GetSize() const
+{
+    return sizeof(AnimationClip) +
+        m_tracks.size() * sizeof(Track) +
+        m_key_frames.size() * sizeof(u16) +
+        m_key_values.size() * sizeof(u16);
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "engine/core/types.h"
+#include "matrix_helper.h"
+#include "vec3.h"
+#include "quat.h"
+#include <vector>
+
+namespace deadrop::math
+{
+    // an uncompressed animation, the local transform of every bone at every frame
+    // NOTE: the arrays have 'frame_count' * 'bone_count' elements, frame by frame,
+    // so the transform of a bone at a frame is at [frame * bone_count + bone]
+    struct RawAnimationClip
+    {
+        u32 bone_count = 0;
+        u32 frame_count = 0;
+        // the number of frames per second
+        float sample_rate = 30.0f;
+        std::vector<vec3f> translations;
+        std::vector<quatf> rotations;
+        std::vector<vec3f> scales;
+    };
+
+    // how far the compressed animation is allowed to be from the raw one at every frame
+    struct AnimationCompressionSettings
+    {
+        // the distance between the translations, in world units
+        float translation_tolerance = 0.001f;
+        // the angle between the rotations, in radians
+        float rotation_tolerance = 0.001f;
+        // the distance between the scales
+        float scale_tolerance = 0.001f;
+    };
+
+    // the local transforms of the bones of a skeleton stored as a structure of arrays,
+    // each pointer points to an array of 'bone_count' floats
+    struct PoseArrays
+    {
+        float* tx;
+        float* ty;
+        float* tz;
+        float* rx;
+        float* ry;
+        float* rz;
+        float* rw;
+        float* sx;
+        float* sy;
+        float* sz;
+
+        // returns a read only view of the pose that ComposeTRSMany() takes
+        TRSArrays GetTRSArrays() const { return TRSArrays{ tx, ty, tz, rx, ry, rz, rw, sx, sy, sz }; }
+    };
+
+    // a compressed animation clip, each bone has a translation, rotation and scale track and every
+    // track keeps only the keys that are needed to stay within the tolerance of the raw animation
+    // when the keys in between are linearly interpolated, the kept keys are quantized to 16 bits
+    // per component within the range of the track and tracks that do not change store a single value
+    // NOTE: the rotations are interpolated with a normalized lerp
+    class AnimationClip
+    {
+    public:
+        // compresses a raw animation, returns false when the raw animation is invalid
+        // NOTE: the tolerance is checked at the frames of the raw animation, the animation is assumed to be
+        // linear in between, a track whose range is too big for 16 bits keeps all of its keys
+        bool Compress(const RawAnimationClip& raw, const AnimationCompressionSettings& settings = AnimationCompressionSettings());
+
+        // samples the local transforms of all the bones at 'time' seconds into 'pose'
+        // NOTE: the time is clamped to the duration of the clip, the bones are interpolated 4 at a time
+        void Sample(float time, const PoseArrays& pose) const;
+
+        // samples the local transform of a single bone at 'time' seconds
+        void SampleBone(float time, u32 bone, vec3f& translation, quatf& rotation, vec3f& scale) const;
+
+        // returns the length of the clip in seconds
+        float GetDuration() const;
+
+        // returns the number of bones
+        u32 GetBoneCount() const { return m_bone_count; }
+
+        // returns the number of bytes that the compressed animation takes
+        size_t GetSize() const;
+
+    private:
+        // a sequence of keys of one of the transforms of a bone
+        struct Track
+        {
+            // the position of the first key in m_key_frames, and of its first component in m_key_values
+            u32 first_key;
+            u32 first_value;
+            // zero for tracks that do not change, their value is 'min'
+            u32 key_count;
+            // the quantized components are dequantized as min + value * step
+            float min[4];
+            float step[4];
+        };
+
+        void gatherKeys(float frame, u32 bone, u32 channel, float* key0, float* key1, size_t key_stride, float& alpha) const;
+
+        u32 m_bone_count = 0;
+        u32 m_frame_count = 0;
+        float m_sample_rate = 0.0f;
+        // the translation, rotation and scale tracks of each bone
+        std::vector<Track> m_tracks;
+        // the frame of each key
+        std::vector<u16> m_key_frames;
+        // the quantized components of each key, 3 for translations and scales and 4 for rotations
+        std::vector<u16> m_key_values;
+    };
+}
@@ -0,0 +1,1063 @@
+#include "bvh.h"
+#include "scalar.h"
+#include "vec3_wide.h"
+#include "engine/core/parallel.h"
+#include "engine/core/simd.h"
+#include <algorithm>
+#include <limits>
+using namespace deadrop;
+using namespace deadrop::math;
+
+namespace
+{
+    // the children of a node are stored as:
+    // - inner node: the index of the node, bit 31 is clear
+    // - leaf: bit 31 is set, bits 28-30 hold (count - 1) and bits 0-27 hold the index of the first primitive
+    // - empty slot: all the bits are set
+    constexpr u32 LEAF_FLAG = 0x80000000u;
+    constexpr u32 EMPTY_CHILD = 0xFFFFFFFFu;
+    constexpr u32 MAX_LEAF_SIZE = 8;
+    constexpr u32 MAX_PRIMITIVES = (1u << 28) - MAX_LEAF_SIZE;
+
+    // the number of bins that the centroids are sorted into to evaluate the SAH
+    constexpr u32 BIN_COUNT = 16;
+    // the cost of visiting a node relative to testing a primitive
+    constexpr float TRAVERSAL_COST = 1.0f;
+    // nodes deeper than this in the binary tree are split in half, which bounds the traversal stack
+    constexpr u32 MAX_DEPTH = 60;
+    constexpr u32 STACK_SIZE = 256;
+
+    // ranges of primitives that are bigger than this are processed on the worker threads
+    constexpr size_t PARALLEL_MIN_COUNT = 64 * 1024;
+    constexpr size_t PARALLEL_RANGE_SIZE = 16 * 1024;
+
+    inline bool isLeaf(u32 child)
+    {
+        return (child & LEAF_FLAG) != 0;
+    }
+
+    inline u32 leafFirst(u32 child)
+    {
+        return child & 0x0FFFFFFFu;
+    }
+
+    inline u32 leafCount(u32 child)
+    {
+        return ((child >> 28) & 0x7u) + 1;
+    }
+
+    inline u32 makeLeaf(u32 first, u32 count)
+    {
+        return LEAF_FLAG | ((count - 1) << 28) | first;
+    }
+
+    // a box that can grow, starts empty
+    struct Bounds
+    {
+        vec3f min{ std::numeric_limits<float>::max() };
+        vec3f max{ -std::numeric_limits<float>::max() };
+
+        void grow(const vec3f& point)
+        {
+            min = vec3f{ std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z) };
+            max = vec3f{ std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z) };
+        }
+
+        void grow(const Bounds& bounds)
+        {
+            // NOTE: an empty box would pull in its inverted min and max and cover the whole float range
+            if (bounds.min.x > bounds.max.x)
+            {
+                return;
+            }
+            grow(bounds.min);
+            grow(bounds.max);
+        }
+
+        // returns the surface area, zero for an empty box
+        float area() const
+        {
+            if (max.x < min.x)
+            {
+                return 0.0f;
+            }
+            const float dx = max.x - min.x;
+            const float dy = max.y - min.y;
+            const float dz = max.z - min.z;
+            return 2.0f * (dx * dy + dy * dz + dz * dx);
+        }
+    };
+
+    // returns the component of a vector by axis index
+    inline float axisOf(const vec3f& vec, u32 axis)
+    {
+        return axis == 0 ? vec.x : (axis == 1 ? vec.y : vec.z);
+    }
+
+    // converts 4 packed u8 values into 4 floats
+    inline __m128 u8x4ToFloat(const u8* values)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i v = _mm_cvtsi32_si128(static_cast<int>(values[0] | (values[1] << 8) | (values[2] << 16) | (static_cast<u32>(values[3]) << 24)));
+        v = _mm_unpacklo_epi8(v, zero);
+        v = _mm_unpacklo_epi16(v, zero);
+        return _mm_cvtepi32_ps(v);
+    }
+
+    // returns 1 / x, tiny values are pushed away from zero so that the slab tests never multiply 0 by infinity
+    inline float safeReciprocal(float x)
+    {
+        const float epsilon = 1e-20f;
+        if (fabsf(x) < epsilon)
+        {
+            x = x < 0.0f ? -epsilon : epsilon;
+        }
+        return 1.0f / x;
+    }
+
+    // a ray with its reciprocal direction, in scalar and splatted form
+    struct RayData
+    {
+        explicit RayData(const Ray& ray)
+        {
+            origin = ray.origin;
+            inv_direction = vec3f{ safeReciprocal(ray.direction.x), safeReciprocal(ray.direction.y), safeReciprocal(ray.direction.z) };
+            ox = _mm_set1_ps(origin.x);
+            oy = _mm_set1_ps(origin.y);
+            oz = _mm_set1_ps(origin.z);
+            ix = _mm_set1_ps(inv_direction.x);
+            iy = _mm_set1_ps(inv_direction.y);
+            iz = _mm_set1_ps(inv_direction.z);
+        }
+
+        vec3f origin;
+        vec3f inv_direction;
+        __m128 ox, oy, oz;
+        __m128 ix, iy, iz;
+    };
+
+    // slab test of one ray against one box, 't' is set to the entry distance (zero when the ray starts inside)
+    inline bool rayBox(const RayData& ray, const AABB& box, float max_t, float& t)
+    {
+        const float t0x = (box.getMin().x - ray.origin.x) * ray.inv_direction.x;
+        const float t1x = (box.getMax().x - ray.origin.x) * ray.inv_direction.x;
+        const float t0y = (box.getMin().y - ray.origin.y) * ray.inv_direction.y;
+        const float t1y = (box.getMax().y - ray.origin.y) * ray.inv_direction.y;
+        const float t0z = (box.getMin().z - ray.origin.z) * ray.inv_direction.z;
+        const float t1z = (box.getMax().z - ray.origin.z) * ray.inv_direction.z;
+        const float tmin = std::max(std::max(std::min(t0x, t1x), std::min(t0y, t1y)), std::max(std::min(t0z, t1z), 0.0f));
+        const float tmax = std::min(std::min(std::max(t0x, t1x), std::max(t0y, t1y)), std::min(std::max(t0z, t1z), max_t));
+        t = tmin;
+        return tmin <= tmax;
+    }
+
+    // slab test of 4 rays (or one splatted ray) against 4 boxes (or one splatted box),
+    // returns the mask of the lanes that hit and stores the entry distances in 't_near'
+    inline __m128 rayBox4(
+        __m128 ox, __m128 oy, __m128 oz, __m128 ix, __m128 iy, __m128 iz,
+        const vec3x4& bmin, const vec3x4& bmax, __m128 max_t, __m128& t_near)
+    {
+        const __m128 t0x = _mm_mul_ps(_mm_sub_ps(bmin.x, ox), ix);
+        const __m128 t1x = _mm_mul_ps(_mm_sub_ps(bmax.x, ox), ix);
+        const __m128 t0y = _mm_mul_ps(_mm_sub_ps(bmin.y, oy), iy);
+        const __m128 t1y = _mm_mul_ps(_mm_sub_ps(bmax.y, oy), iy);
+        const __m128 t0z = _mm_mul_ps(_mm_sub_ps(bmin.z, oz), iz);
+        const __m128 t1z = _mm_mul_ps(_mm_sub_ps(bmax.z, oz), iz);
+        const __m128 tmin = _mm_max_ps(
+            _mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)),
+            _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_setzero_ps()));
+        const __m128 tmax = _mm_min_ps(
+            _mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)),
+            _mm_min_ps(_mm_max_ps(t0z, t1z), max_t));
+        t_near = tmin;
+        return _mm_cmple_ps(tmin, tmax);
+    }
+
+    // the grid of one axis of a node, the last grid line is nudged up until it reaches 'max'
+    // so that rounding can never make the grid smaller than the node
+    inline void quantizeGrid(float min, float max, float& origin, float& scale)
+    {
+        origin = min;
+        scale = (max - min) / 255.0f;
+        while (origin + 255.0f * scale < max)
+        {
+            scale = nextafterf(scale, std::numeric_limits<float>::max());
+        }
+    }
+
+    // returns the grid line at or below 'value'
+    inline u8 quantizeDown(float value, float origin, float scale)
+    {
+        if (scale <= 0.0f)
+        {
+            return 0;
+        }
+        int q = static_cast<int>(floorf((value - origin) / scale));
+        q = std::min(std::max(q, 0), 255);
+        while (q > 0 && origin + static_cast<float>(q) * scale > value)
+        {
+            q--;
+        }
+        return static_cast<u8>(q);
+    }
+
+    // returns the grid line at or above 'value'
+    inline u8 quantizeUp(float value, float origin, float scale)
+    {
+        if (scale <= 0.0f)
+        {
+            return 0;
+        }
+        int q = static_cast<int>(ceilf((value - origin) / scale));
+        q = std::min(std::max(q, 0), 255);
+        while (q < 255 && origin + static_cast<float>(q) * scale < value)
+        {
+            q++;
+        }
+        return static_cast<u8>(q);
+    }
+}
+
+struct BVH::Builder
+{
+    static_assert(sizeof(Node) == 64, "a BVH node must fit in a cache line");
+
+    // a node of the intermediate binary tree, a leaf when 'count' is not zero
+    struct BuildNode
+    {
+        Bounds bounds;
+        u32 first = 0;
+        u32 count = 0;
+        u32 left = 0;
+        u32 right = 0;
+    };
+
+    // a range of primitives that still has to be turned into a subtree rooted at 'node'
+    struct Task
+    {
+        u32 node;
+        u32 first;
+        u32 count;
+        u32 depth;
+    };
+
+    // the bounds and primitive counts of the bins of all three axes
+    struct Bins
+    {
+        Bounds bounds[3][BIN_COUNT];
+        u32 counts[3][BIN_COUNT] = {};
+
+        void merge(const Bins& bins)
+        {
+            for (u32 axis = 0; axis < 3; axis++)
+            {
+                for (u32 b = 0; b < BIN_COUNT; b++)
+                {
+                    bounds[axis][b].grow(bins.bounds[axis][b]);
+                    counts[axis][b] += bins.counts[axis][b];
+                }
+            }
+        }
+    };
+
+    Builder(const AABB* _aabbs, size_t count) : aabbs(_aabbs), centroids(count), indices(count)
+    {
+        ParallelFor(count, PARALLEL_RANGE_SIZE, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                centroids[i] = aabbs[i].getCenter();
+                indices[i] = static_cast<u32>(i);
+            }
+        });
+    }
+
+    // computes the bounds of the primitives and of their centroids in a range of 'indices'
+    void computeBounds(u32 first, u32 count, Bounds& bounds, Bounds& centroid_bounds) const
+    {
+        auto compute = [this](size_t begin, size_t end, Bounds& b, Bounds& cb)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                const u32 primitive = indices[i];
+                b.grow(aabbs[primitive].getMin());
+                b.grow(aabbs[primitive].getMax());
+                cb.grow(centroids[primitive]);
+            }
+        };
+
+        if (count < PARALLEL_MIN_COUNT)
+        {
+            compute(first, first + count, bounds, centroid_bounds);
+            return;
+        }
+
+        // each range computes its own bounds which are merged at the end
+        std::vector<Bounds> partial((count + PARALLEL_RANGE_SIZE - 1) / PARALLEL_RANGE_SIZE * 2);
+        ParallelFor(count, PARALLEL_RANGE_SIZE, [&](size_t begin, size_t end)
+        {
+            const size_t range = begin / PARALLEL_RANGE_SIZE;
+            compute(first + begin, first + end, partial[range * 2], partial[range * 2 + 1]);
+        });
+        for (size_t range = 0; range < partial.size(); range += 2)
+        {
+            bounds.grow(partial[range]);
+            centroid_bounds.grow(partial[range + 1]);
+        }
+    }
+
+    // returns the bin of a centroid on one axis
+    static u32 binOf(float centroid, float min, float inv_extent)
+    {
+        const u32 bin = static_cast<u32>((centroid - min) * inv_extent);
+        return bin < BIN_COUNT ? bin : BIN_COUNT - 1;
+    }
+
+    // sorts the centroids of a range of 'indices' into the bins of all three axes
+    void computeBins(u32 first, u32 count, const vec3f& min, const vec3f& inv_extent, Bins& bins) const
+    {
+        auto compute = [&](size_t begin, size_t end, Bins& b)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                const u32 primitive = indices[i];
+                const vec3f& c = centroids[primitive];
+                const u32 bx = binOf(c.x, min.x, inv_extent.x);
+                const u32 by = binOf(c.y, min.y, inv_extent.y);
+                const u32 bz = binOf(c.z, min.z, inv_extent.z);
+                b.counts[0][bx]++;
+                b.counts[1][by]++;
+                b.counts[2][bz]++;
+                b.bounds[0][bx].grow(aabbs[primitive].getMin());
+                b.bounds[0][bx].grow(aabbs[primitive].getMax());
+                b.bounds[1][by].grow(aabbs[primitive].getMin());
+                b.bounds[1][by].grow(aabbs[primitive].getMax());
+                b.bounds[2][bz].grow(aabbs[primitive].getMin());
+                b.bounds[2][bz].grow(aabbs[primitive].getMax());
+            }
+        };
+
+        if (count < PARALLEL_MIN_COUNT)
+        {
+            compute(first, first + count, bins);
+            return;
+        }
+
+        std::vector<Bins> partial((count + PARALLEL_RANGE_SIZE - 1) / PARALLEL_RANGE_SIZE);
+        ParallelFor(count, PARALLEL_RANGE_SIZE, [&](size_t begin, size_t end)
+        {
+            compute(first + begin, first + end, partial[begin / PARALLEL_RANGE_SIZE]);
+        });
+        for (const Bins& b : partial)
+        {
+            bins.merge(b);
+        }
+    }
+
+    // splits a range of 'indices' in two and stores the bounds of the range,
+    // returns the number of primitives in the first half or zero when the range should be a leaf
+    u32 split(u32 first, u32 count, u32 depth, Bounds& bounds)
+    {
+        Bounds centroid_bounds;
+        computeBounds(first, count, bounds, centroid_bounds);
+        if (count == 1)
+        {
+            return 0;
+        }
+
+        const vec3f extent = centroid_bounds.max - centroid_bounds.min;
+        const vec3f inv_extent
+        {
+            extent.x > 0.0f ? static_cast<float>(BIN_COUNT) / extent.x : 0.0f,
+            extent.y > 0.0f ? static_cast<float>(BIN_COUNT) / extent.y : 0.0f,
+            extent.z > 0.0f ? static_cast<float>(BIN_COUNT) / extent.z : 0.0f
+        };
+
+        // find the split between two bins with the lowest surface area heuristic cost
+        float best_cost = std::numeric_limits<float>::max();
+        u32 best_axis = 0;
+        u32 best_bin = 0;
+        if (depth < MAX_DEPTH && (extent.x > 0.0f || extent.y > 0.0f || extent.z > 0.0f))
+        {
+            Bins bins;
+            computeBins(first, count, centroid_bounds.min, inv_extent, bins);
+            for (u32 axis = 0; axis < 3; axis++)
+            {
+                if (axisOf(extent, axis) <= 0.0f)
+                {
+                    continue;
+                }
+
+                // sweep from the right to get the cost of the right side of every split
+                float right_cost[BIN_COUNT];
+                Bounds right;
+                u32 right_count = 0;
+                for (u32 b = BIN_COUNT - 1; b > 0; b--)
+                {
+                    right.grow(bins.bounds[axis][b]);
+                    right_count += bins.counts[axis][b];
+                    right_cost[b - 1] = right.area() * static_cast<float>(right_count);
+                }
+
+                Bounds left;
+                u32 left_count = 0;
+                for (u32 b = 0; b < BIN_COUNT - 1; b++)
+                {
+                    left.grow(bins.bounds[axis][b]);
+                    left_count += bins.counts[axis][b];
+                    const float cost = left.area() * static_cast<float>(left_count) + right_cost[b];
+                    if (left_count > 0 && left_count < count && cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_bin = b;
+                    }
+                }
+            }
+        }
+
+        const bool found_split = best_cost < std::numeric_limits<float>::max();
+        if (count <= MAX_LEAF_SIZE)
+        {
+            const float leaf_cost = bounds.area() * static_cast<float>(count);
+            const float split_cost = bounds.area() * TRAVERSAL_COST + best_cost;
+            if (!found_split || leaf_cost <= split_cost)
+            {
+                return 0;
+            }
+        }
+
+        u32* begin = indices.data() + first;
+        u32* end = begin + count;
+        if (found_split)
+        {
+            const float min = axisOf(centroid_bounds.min, best_axis);
+            const float inv = axisOf(inv_extent, best_axis);
+            u32* middle = std::partition(begin, end, [&](u32 primitive)
+            {
+                return binOf(axisOf(centroids[primitive], best_axis), min, inv) <= best_bin;
+            });
+            return static_cast<u32>(middle - begin);
+        }
+
+        // NOTE: either all the centroids are at the same point or the tree is too deep,
+        // split the range in half along the longest axis
+        const u32 axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const u32 half = count / 2;
+        std::nth_element(begin, begin + half, end, [&](u32 a, u32 b)
+        {
+            return axisOf(centroids[a], axis) < axisOf(centroids[b], axis);
+        });
+        return half;
+    }
+
+    // builds the subtree of a task into 'nodes', the root of the subtree is nodes[root]
+    void buildSubtree(const Task& task, std::vector<BuildNode>& nodes, u32 root)
+    {
+        std::vector<Task> stack;
+        stack.push_back(Task{ root, task.first, task.count, task.depth });
+        while (!stack.empty())
+        {
+            const Task current = stack.back();
+            stack.pop_back();
+            processTask(current, nodes, stack);
+        }
+    }
+
+    // splits the range of a task and pushes the tasks of its two children, or makes it a leaf
+    void processTask(const Task& task, std::vector<BuildNode>& nodes, std::vector<Task>& stack)
+    {
+        Bounds bounds;
+        const u32 left_count = split(task.first, task.count, task.depth, bounds);
+        nodes[task.node].bounds = bounds;
+        if (left_count == 0)
+        {
+            nodes[task.node].first = task.first;
+            nodes[task.node].count = task.count;
+            return;
+        }
+
+        const u32 left = static_cast<u32>(nodes.size());
+        nodes.emplace_back();
+        nodes.emplace_back();
+        nodes[task.node].left = left;
+        nodes[task.node].right = left + 1;
+        stack.push_back(Task{ left, task.first, left_count, task.depth + 1 });
+        stack.push_back(Task{ left + 1, task.first + left_count, task.count - left_count, task.depth + 1 });
+    }
+
+    // builds the binary tree, the top levels are split on the calling thread (using the workers for
+    // the binning) until the ranges are small enough, then the subtrees are built on the workers
+    std::vector<BuildNode> buildTree()
+    {
+        const size_t count = indices.size();
+        const size_t task_size = std::max(static_cast<size_t>(4096), count / (static_cast<size_t>(GetParallelThreadCount()) * 4));
+
+        std::vector<BuildNode> nodes(1);
+        std::vector<Task> stack{ Task{ 0, 0, static_cast<u32>(count), 0 } };
+        std::vector<Task> deferred;
+        while (!stack.empty())
+        {
+            const Task task = stack.back();
+            stack.pop_back();
+            if (task.count <= task_size)
+            {
+                deferred.push_back(task);
+                continue;
+            }
+            processTask(task, nodes, stack);
+        }
+
+        // each subtree is built into its own array and later appended to the tree
+        std::vector<std::vector<BuildNode>> subtrees(deferred.size());
+        ParallelFor(deferred.size(), 1, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                subtrees[i].emplace_back();
+                buildSubtree(deferred[i], subtrees[i], 0);
+            }
+        });
+
+        for (size_t i = 0; i < deferred.size(); i++)
+        {
+            // the local root replaces the node of the task, the rest are appended
+            const u32 base = static_cast<u32>(nodes.size());
+            const u32 root = deferred[i].node;
+            auto remap = [&](u32 local) { return local == 0 ? root : base + local - 1; };
+            for (size_t local = 0; local < subtrees[i].size(); local++)
+            {
+                BuildNode node = subtrees[i][local];
+                if (node.count == 0)
+                {
+                    node.left = remap(node.left);
+                    node.right = remap(node.right);
+                }
+                if (local == 0)
+                {
+                    nodes[root] = node;
+                }
+                else
+                {
+                    nodes.push_back(node);
+                }
+            }
+        }
+        return nodes;
+    }
+
+    // converts the binary subtree at 'index' into 4-wide nodes, returns the index of the 4-wide node
+    static u32 convert(BVH& bvh, const std::vector<BuildNode>& nodes, u32 index)
+    {
+        // collapse the binary tree by pulling up the children of the largest inner children
+        u32 children[4];
+        u32 child_count = 0;
+        const BuildNode& node = nodes[index];
+        if (node.count != 0)
+        {
+            // only happens for a root that is a leaf
+            children[child_count++] = index;
+        }
+        else
+        {
+            children[child_count++] = node.left;
+            children[child_count++] = node.right;
+            while (child_count < 4)
+            {
+                u32 largest = child_count;
+                float largest_area = -1.0f;
+                for (u32 c = 0; c < child_count; c++)
+                {
+                    const BuildNode& child = nodes[children[c]];
+                    if (child.count == 0 && child.bounds.area() > largest_area)
+                    {
+                        largest = c;
+                        largest_area = child.bounds.area();
+                    }
+                }
+                if (largest == child_count)
+                {
+                    break;
+                }
+                const BuildNode& child = nodes[children[largest]];
+                children[largest] = child.left;
+                children[child_count++] = child.right;
+            }
+        }
+
+        // NOTE: the node is filled locally since the recursion reallocates the array
+        const u32 wide_index = static_cast<u32>(bvh.m_nodes.size());
+        bvh.m_nodes.emplace_back();
+        Node wide{};
+        quantizeGrid(node.bounds.min.x, node.bounds.max.x, wide.origin[0], wide.scale[0]);
+        quantizeGrid(node.bounds.min.y, node.bounds.max.y, wide.origin[1], wide.scale[1]);
+        quantizeGrid(node.bounds.min.z, node.bounds.max.z, wide.origin[2], wide.scale[2]);
+        for (u32 c = 0; c < 4; c++)
+        {
+            if (c >= child_count)
+            {
+                wide.children[c] = EMPTY_CHILD;
+                continue;
+            }
+
+            const BuildNode& child = nodes[children[c]];
+            wide.min_x[c] = quantizeDown(child.bounds.min.x, wide.origin[0], wide.scale[0]);
+            wide.min_y[c] = quantizeDown(child.bounds.min.y, wide.origin[1], wide.scale[1]);
+            wide.min_z[c] = quantizeDown(child.bounds.min.z, wide.origin[2], wide.scale[2]);
+            wide.max_x[c] = quantizeUp(child.bounds.max.x, wide.origin[0], wide.scale[0]);
+            wide.max_y[c] = quantizeUp(child.bounds.max.y, wide.origin[1], wide.scale[1]);
+            wide.max_z[c] = quantizeUp(child.bounds.max.z, wide.origin[2], wide.scale[2]);
+            wide.children[c] = child.count != 0 ? makeLeaf(child.first, child.count) : convert(bvh, nodes, children[c]);
+        }
+        bvh.m_nodes[wide_index] = wide;
+        return wide_index;
+    }
+
+    const AABB* aabbs;
+    std::vector<vec3f> centroids;
+    std::vector<u32> indices;
+};
+
+struct BVH::Traversal
+{
+    // a stack entry, 't' is the entry distance of the ray (or of each ray of a packet)
+    struct Entry
+    {
+        u32 child;
+        float t;
+    };
+
+    struct PacketEntry
+    {
+        __m128 t;
+        u32 child;
+    };
+
+    // dequantizes the bounds of the 4 children of a node
+    static void loadChildBounds(const Node& node, vec3x4& bmin, vec3x4& bmax)
+    {
+        const __m128 ox = _mm_set1_ps(node.origin[0]);
+        const __m128 oy = _mm_set1_ps(node.origin[1]);
+        const __m128 oz = _mm_set1_ps(node.origin[2]);
+        const __m128 sx = _mm_set1_ps(node.scale[0]);
+        const __m128 sy = _mm_set1_ps(node.scale[1]);
+        const __m128 sz = _mm_set1_ps(node.scale[2]);
+        bmin.x = _mm_add_ps(ox, _mm_mul_ps(u8x4ToFloat(node.min_x), sx));
+        bmin.y = _mm_add_ps(oy, _mm_mul_ps(u8x4ToFloat(node.min_y), sy));
+        bmin.z = _mm_add_ps(oz, _mm_mul_ps(u8x4ToFloat(node.min_z), sz));
+        bmax.x = _mm_add_ps(ox, _mm_mul_ps(u8x4ToFloat(node.max_x), sx));
+        bmax.y = _mm_add_ps(oy, _mm_mul_ps(u8x4ToFloat(node.max_y), sy));
+        bmax.z = _mm_add_ps(oz, _mm_mul_ps(u8x4ToFloat(node.max_z), sz));
+    }
+
+    // returns the mask of the non-empty children of a node
+    static u32 validChildren(const Node& node)
+    {
+        u32 mask = 0;
+        for (u32 c = 0; c < 4; c++)
+        {
+            mask |= (node.children[c] != EMPTY_CHILD ? 1u : 0u) << c;
+        }
+        return mask;
+    }
+
+    // traverses a packet of 4 rays, the closest hit of each ray is stored in 'hits'
+    static void castPacket(const BVH& bvh, const Ray* rays, float max_distance, RayHit* hits, const RayPrimitiveFunc& func)
+    {
+        alignas(16) float best[4] = { max_distance, max_distance, max_distance, max_distance };
+        u32 best_primitive[4] = { INVALID_PRIMITIVE, INVALID_PRIMITIVE, INVALID_PRIMITIVE, INVALID_PRIMITIVE };
+
+        // the packet in structure-of-arrays form
+        alignas(16) float values[6][4];
+        for (u32 lane = 0; lane < 4; lane++)
+        {
+            values[0][lane] = rays[lane].origin.x;
+            values[1][lane] = rays[lane].origin.y;
+            values[2][lane] = rays[lane].origin.z;
+            values[3][lane] = safeReciprocal(rays[lane].direction.x);
+            values[4][lane] = safeReciprocal(rays[lane].direction.y);
+            values[5][lane] = safeReciprocal(rays[lane].direction.z);
+        }
+        const __m128 ox = _mm_load_ps(values[0]);
+        const __m128 oy = _mm_load_ps(values[1]);
+        const __m128 oz = _mm_load_ps(values[2]);
+        const __m128 ix = _mm_load_ps(values[3]);
+        const __m128 iy = _mm_load_ps(values[4]);
+        const __m128 iz = _mm_load_ps(values[5]);
+
+        PacketEntry stack[STACK_SIZE];
+        u32 stack_size = 0;
+        stack[stack_size++] = PacketEntry{ _mm_setzero_ps(), 0 };
+        while (stack_size > 0)
+        {
+            const PacketEntry entry = stack[--stack_size];
+            __m128 best_t = _mm_load_ps(best);
+            const u32 active = static_cast<u32>(_mm_movemask_ps(_mm_cmple_ps(entry.t, best_t)));
+            if (active == 0)
+            {
+                continue;
+            }
+
+            if (isLeaf(entry.child))
+            {
+                const u32 first = leafFirst(entry.child);
+                const u32 last = first + leafCount(entry.child);
+                for (u32 k = first; k < last; k++)
+                {
+                    const AABB& box = bvh.m_leaf_aabbs[k];
+                    const vec3x4 bmin{ box.getMin() };
+                    const vec3x4 bmax{ box.getMax() };
+                    __m128 t_near;
+                    const u32 mask = static_cast<u32>(_mm_movemask_ps(rayBox4(ox, oy, oz, ix, iy, iz, bmin, bmax, _mm_load_ps(best), t_near)));
+                    if (mask == 0)
+                    {
+                        continue;
+                    }
+
+                    alignas(16) float t[4];
+                    _mm_store_ps(t, t_near);
+                    for (u32 lane = 0; lane < 4; lane++)
+                    {
+                        if ((mask & (1u << lane)) == 0)
+                        {
+                            continue;
+                        }
+                        if (func)
+                        {
+                            if (func(bvh.m_primitives[k], rays[lane], best[lane]))
+                            {
+                                best_primitive[lane] = bvh.m_primitives[k];
+                            }
+                        }
+                        else
+                        {
+                            best[lane] = t[lane];
+                            best_primitive[lane] = bvh.m_primitives[k];
+                        }
+                    }
+                }
+                continue;
+            }
+
+            const Node& node = bvh.m_nodes[entry.child];
+            vec3x4 child_min, child_max;
+            loadChildBounds(node, child_min, child_max);
+            alignas(16) float bounds[6][4];
+            _mm_store_ps(bounds[0], child_min.x);
+            _mm_store_ps(bounds[1], child_min.y);
+            _mm_store_ps(bounds[2], child_min.z);
+            _mm_store_ps(bounds[3], child_max.x);
+            _mm_store_ps(bounds[4], child_max.y);
+            _mm_store_ps(bounds[5], child_max.z);
+
+            // test every child against the whole packet, the children are ordered by
+            // the closest entry distance of any ray so that the closest is visited first
+            PacketEntry hit_children[4];
+            float hit_order[4];
+            u32 hit_count = 0;
+            const u32 valid = validChildren(node);
+            for (u32 c = 0; c < 4; c++)
+            {
+                if ((valid & (1u << c)) == 0)
+                {
+                    continue;
+                }
+                const vec3x4 bmin{ _mm_set1_ps(bounds[0][c]), _mm_set1_ps(bounds[1][c]), _mm_set1_ps(bounds[2][c]) };
+                const vec3x4 bmax{ _mm_set1_ps(bounds[3][c]), _mm_set1_ps(bounds[4][c]), _mm_set1_ps(bounds[5][c]) };
+                __m128 t_near;
+                const __m128 hit = rayBox4(ox, oy, oz, ix, iy, iz, bmin, bmax, best_t, t_near);
+                if (_mm_movemask_ps(hit) == 0)
+                {
+                    continue;
+                }
+
+                // lanes that miss get an infinite distance so they are culled when popped
+                const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+                const __m128 t = _mm_or_ps(_mm_and_ps(hit, t_near), _mm_andnot_ps(hit, infinity));
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, t);
+                const float closest = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+
+                // insert sorted by decreasing distance so the closest child is pushed last
+                u32 position = hit_count++;
+                while (position > 0 && hit_order[position - 1] < closest)
+                {
+                    hit_children[position] = hit_children[position - 1];
+                    hit_order[position] = hit_order[position - 1];
+                    position--;
+                }
+                hit_children[position] = PacketEntry{ t, node.children[c] };
+                hit_order[position] = closest;
+            }
+            for (u32 h = 0; h < hit_count; h++)
+            {
+                stack[stack_size++] = hit_children[h];
+            }
+        }
+
+        for (u32 lane = 0; lane < 4; lane++)
+        {
+            hits[lane] = RayHit{ best_primitive[lane], best[lane] };
+        }
+    }
+};
+
+void BVH::Build(const AABB* aabbs, size_t count)
+{
+    m_nodes.clear();
+    m_primitives.clear();
+    m_leaf_aabbs.clear();
+    m_bounds = AABB();
+    if (count == 0)
+    {
+        return;
+    }
+    if (count > MAX_PRIMITIVES)
+    {
+        // error, the leaves cannot address that many primitives
+        return;
+    }
+
+    Builder builder(aabbs, count);
+    const std::vector<Builder::BuildNode> nodes = builder.buildTree();
+    m_bounds = AABB(nodes[0].bounds.min, nodes[0].bounds.max);
+
+    // the binary tree has at most 2 * count nodes and every 4-wide node replaces at least two of them
+    m_nodes.reserve(count);
+    Builder::convert(*this, nodes, 0);
+
+    // the leaves keep their own copy of the boxes, in leaf order, to avoid jumping around in memory
+    m_primitives = std::move(builder.indices);
+    m_leaf_aabbs.resize(count);
+    ParallelFor(count, PARALLEL_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            m_leaf_aabbs[i] = aabbs[m_primitives[i]];
+        }
+    });
+}
+
+bool BVH::RayCastAny(const Ray& ray, float max_distance, const RayPrimitiveFunc& func) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    const RayData data(ray);
+    const __m128 max_t = _mm_set1_ps(max_distance);
+    u32 stack[STACK_SIZE];
+    u32 stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        const u32 child = stack[--stack_size];
+        if (isLeaf(child))
+        {
+            const u32 first = leafFirst(child);
+            const u32 last = first + leafCount(child);
+            for (u32 k = first; k < last; k++)
+            {
+                float t;
+                if (!rayBox(data, m_leaf_aabbs[k], max_distance, t))
+                {
+                    continue;
+                }
+                float distance = max_distance;
+                if (!func || func(m_primitives[k], ray, distance))
+                {
+                    return true;
+                }
+            }
+            continue;
+        }
+
+        const Node& node = m_nodes[child];
+        vec3x4 bmin, bmax;
+        Traversal::loadChildBounds(node, bmin, bmax);
+        __m128 t_near;
+        u32 mask = static_cast<u32>(_mm_movemask_ps(rayBox4(data.ox, data.oy, data.oz, data.ix, data.iy, data.iz, bmin, bmax, max_t, t_near)));
+        mask &= Traversal::validChildren(node);
+        for (u32 c = 0; c < 4; c++)
+        {
+            if (mask & (1u << c))
+            {
+                stack[stack_size++] = node.children[c];
+            }
+        }
+    }
+    return false;
+}
+
+bool BVH::RayCastNearest(const Ray& ray, float max_distance, RayHit& hit, const RayPrimitiveFunc& func) const
+{
+    hit = RayHit{ INVALID_PRIMITIVE, max_distance };
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    const RayData data(ray);
+    Traversal::Entry stack[STACK_SIZE];
+    u32 stack_size = 0;
+    stack[stack_size++] = Traversal::Entry{ 0, 0.0f };
+    while (stack_size > 0)
+    {
+        const Traversal::Entry entry = stack[--stack_size];
+        if (entry.t > hit.distance)
+        {
+            continue;
+        }
+
+        if (isLeaf(entry.child))
+        {
+            const u32 first = leafFirst(entry.child);
+            const u32 last = first + leafCount(entry.child);
+            for (u32 k = first; k < last; k++)
+            {
+                float t;
+                if (!rayBox(data, m_leaf_aabbs[k], hit.distance, t))
+                {
+                    continue;
+                }
+                if (func)
+                {
+                    if (func(m_primitives[k], ray, hit.distance))
+                    {
+                        hit.primitive = m_primitives[k];
+                    }
+                }
+                else
+                {
+                    hit.distance = t;
+                    hit.primitive = m_primitives[k];
+                }
+            }
+            continue;
+        }
+
+        const Node& node = m_nodes[entry.child];
+        vec3x4 bmin, bmax;
+        Traversal::loadChildBounds(node, bmin, bmax);
+        __m128 t_near;
+        u32 mask = static_cast<u32>(_mm_movemask_ps(rayBox4(data.ox, data.oy, data.oz, data.ix, data.iy, data.iz, bmin, bmax, _mm_set1_ps(hit.distance), t_near)));
+        mask &= Traversal::validChildren(node);
+        if (mask == 0)
+        {
+            continue;
+        }
+
+        // push the children that were hit sorted by decreasing distance, so the closest is visited first
+        alignas(16) float t[4];
+        _mm_store_ps(t, t_near);
+        u32 order[4];
+        u32 order_count = 0;
+        for (u32 c = 0; c < 4; c++)
+        {
+            if ((mask & (1u << c)) == 0)
+            {
+                continue;
+            }
+            u32 position = order_count++;
+            while (position > 0 && t[order[position - 1]] < t[c])
+            {
+                order[position] = order[position - 1];
+                position--;
+            }
+            order[position] = c;
+        }
+        for (u32 o = 0; o < order_count; o++)
+        {
+            stack[stack_size++] = Traversal::Entry{ node.children[order[o]], t[order[o]] };
+        }
+    }
+    return hit.primitive != INVALID_PRIMITIVE;
+}
+
+void BVH::RayCastNearestMany(const Ray* rays, size_t count, float max_distance, RayHit* hits, const RayPrimitiveFunc& func) const
+{
+    if (m_nodes.empty())
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            hits[i] = RayHit{ INVALID_PRIMITIVE, max_distance };
+        }
+        return;
+    }
+
+    const size_t packet_count = (count + 3) / 4;
+    ParallelFor(packet_count, 64, [&](size_t begin, size_t end)
+    {
+        for (size_t packet = begin; packet < end; packet++)
+        {
+            const size_t first = packet * 4;
+            if (first + 4 <= count)
+            {
+                Traversal::castPacket(*this, rays + first, max_distance, hits + first, func);
+                continue;
+            }
+
+            // the last packet is filled up with copies of its first ray
+            Ray packet_rays[4];
+            RayHit packet_hits[4];
+            for (size_t lane = 0; lane < 4; lane++)
+            {
+                packet_rays[lane] = rays[first + lane < count ? first + lane : first];
+            }
+            Traversal::castPacket(*this, packet_rays, max_distance, packet_hits, func);
+            for (size_t lane = 0; first + lane < count; lane++)
+            {
+                hits[first + lane] = packet_hits[lane];
+            }
+        }
+    });
+}
+
+size_t BVH::QueryOverlap(const AABB& aabb, std::vector<u32>& primitives) const
+{
+    if (m_nodes.empty())
+    {
+        return 0;
+    }
+
+    const size_t initial_size = primitives.size();
+    const vec3x4 query_min{ aabb.getMin() };
+    const vec3x4 query_max{ aabb.getMax() };
+    u32 stack[STACK_SIZE];
+    u32 stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        const u32 child = stack[--stack_size];
+        if (isLeaf(child))
+        {
+            const u32 first = leafFirst(child);
+            const u32 last = first + leafCount(child);
+            for (u32 k = first; k < last; k++)
+            {
+                if (m_leaf_aabbs[k].intersects(aabb))
+                {
+                    primitives.push_back(m_primitives[k]);
+                }
+            }
+            continue;
+        }
+
+        const Node& node = m_nodes[child];
+        vec3x4 bmin, bmax;
+        Traversal::loadChildBounds(node, bmin, bmax);
+        __m128 overlap = _mm_and_ps(_mm_cmple_ps(bmin.x, query_max.x), _mm_cmpge_ps(bmax.x, query_min.x));
+        overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(bmin.y, query_max.y), _mm_cmpge_ps(bmax.y, query_min.y)));
+        overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(bmin.z, query_max.z), _mm_cmpge_ps(bmax.z, query_min.z)));
+        const u32 mask = static_cast<u32>(_mm_movemask_ps(overlap)) & Traversal::validChildren(node);
+        for (u32 c = 0; c < 4; c++)
+        {
+            if (mask & (1u << c))
+            {
+                stack[stack_size++] = node.children[c];
+            }
+        }
+    }
+    return primitives.size() - initial_size;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "engine/core/types.h"
+#include "aabb.h"
+#include "ray.h"
+#include <functional>
+#include <vector>
+
+namespace deadrop::math
+{
+    // the result of a ray query against a BVH
+    struct RayHit
+    {
+        // the index of the primitive that was hit, BVH::INVALID_PRIMITIVE when nothing was hit
+        u32 primitive;
+        // the distance along the ray to the hit, in units of the ray direction
+        float distance;
+    };
+
+    // tests a ray against the real shape of a primitive (like the triangles of a mesh), returns true
+    // and updates 'distance' only when the primitive is hit closer than the value 'distance' holds
+    // NOTE: without this function the queries test the boxes of the primitives
+    using RayPrimitiveFunc = std::function<bool(u32 primitive, const Ray& ray, float& distance)>;
+
+    // a static bounding volume hierarchy over an array of boxes, each box is a primitive
+    // that is identified by its index in the array passed to Build()
+    // NOTE: the tree is built with binned SAH and stored as 4-wide nodes that fit in a cache line each
+    class BVH
+    {
+    public:
+        static constexpr u32 INVALID_PRIMITIVE = 0xFFFFFFFF;
+
+        // builds the hierarchy over 'count' boxes, replacing the previous one
+        // NOTE: large inputs are built on the worker threads, see ParallelFor()
+        void Build(const AABB* aabbs, size_t count);
+
+        // returns true when the ray hits any primitive closer than 'max_distance', this is cheaper
+        // than RayCastNearest() since it stops at the first hit, use it for line-of-sight checks
+        bool RayCastAny(const Ray& ray, float max_distance, const RayPrimitiveFunc& func = nullptr) const;
+
+        // returns true when the ray hits a primitive closer than 'max_distance' and stores the closest one in 'hit'
+        bool RayCastNearest(const Ray& ray, float max_distance, RayHit& hit, const RayPrimitiveFunc& func = nullptr) const;
+
+        // finds the closest hit of 'count' rays and stores them in 'hits', the rays are traversed in packets of 4
+        // and the packets are split between the worker threads
+        // NOTE: packets of rays that start close to each other and point in similar directions (like the
+        // pixels of a camera) are much faster than random rays
+        void RayCastNearestMany(const Ray* rays, size_t count, float max_distance, RayHit* hits, const RayPrimitiveFunc& func = nullptr) const;
+
+        // appends the primitives whose boxes overlap 'aabb' to 'primitives', returns how many were appended
+        size_t QueryOverlap(const AABB& aabb, std::vector<u32>& primitives) const;
+
+        // returns the box that contains all the primitives
+        const AABB& GetBounds() const { return m_bounds; }
+
+        // returns the number of nodes in the hierarchy
+        size_t GetNodeCount() const { return m_nodes.size(); }
+
+    private:
+        // a 4-wide node, the bounds of the children are quantized to 8 bits
+        // on a grid that covers the bounds of the node: origin + q * scale
+        struct alignas(64) Node
+        {
+            float origin[3];
+            float scale[3];
+            u8 min_x[4];
+            u8 min_y[4];
+            u8 min_z[4];
+            u8 max_x[4];
+            u8 max_y[4];
+            u8 max_z[4];
+            // see bvh.cpp for the encoding of inner nodes, leaves and empty slots
+            u32 children[4];
+        };
+
+        struct Builder;
+        struct Traversal;
+
+        // nodes[0] is the root
+        std::vector<Node> m_nodes;
+        // the leaves reference ranges of this array which holds the primitive indices
+        std::vector<u32> m_primitives;
+        // the boxes of the primitives in the same order as 'm_primitives'
+        std::vector<AABB> m_leaf_aabbs;
+        AABB m_bounds;
+    };
+}
@@ -0,0 +1,377 @@
+#include "dynamic_aabb_tree.h"
+#include <algorithm>
+using namespace deadrop;
+using namespace deadrop::math;
+
+namespace
+{
+    // the tree is balanced, so even millions of proxies need a small stack
+    constexpr u32 STACK_SIZE = 256;
+
+    // how much of the displacement is added to the fat AABB in the direction of movement
+    constexpr float DISPLACEMENT_MULTIPLIER = 2.0f;
+}
+
+DynamicAABBTree::DynamicAABBTree(float margin) : m_margin(margin)
+{
+}
+
+u32 DynamicAABBTree::allocateNode()
+{
+    if (m_free_list == NULL_PROXY)
+    {
+        m_nodes.emplace_back();
+        m_nodes.back().height = 0;
+        return static_cast<u32>(m_nodes.size() - 1);
+    }
+
+    const u32 node = m_free_list;
+    m_free_list = m_nodes[node].parent;
+    m_nodes[node] = Node{};
+    m_nodes[node].height = 0;
+    return node;
+}
+
+void DynamicAABBTree::freeNode(u32 node)
+{
+    m_nodes[node].parent = m_free_list;
+    m_nodes[node].height = -1;
+    m_free_list = node;
+}
+
+AABB DynamicAABBTree::fatten(const AABB& aabb, const vec3f& displacement) const
+{
+    const vec3f min = aabb.getMin() - m_margin;
+    const vec3f max = aabb.getMax() + m_margin;
+
+    // predict the movement of the next frames by stretching the box along the displacement
+    const vec3f d = displacement * DISPLACEMENT_MULTIPLIER;
+    return AABB(
+        vec3f{ min.x + std::min(d.x, 0.0f), min.y + std::min(d.y, 0.0f), min.z + std::min(d.z, 0.0f) },
+        vec3f{ max.x + std::max(d.x, 0.0f), max.y + std::max(d.y, 0.0f), max.z + std::max(d.z, 0.0f) });
+}
+
+u32 DynamicAABBTree::Insert(const AABB& aabb, u32 user_data)
+{
+    const u32 proxy = allocateNode();
+    m_nodes[proxy].aabb = fatten(aabb, vec3f(0.0f));
+    m_nodes[proxy].user_data = user_data;
+    m_nodes[proxy].moved = true;
+    insertLeaf(proxy);
+    m_moved.push_back(proxy);
+    m_proxy_count++;
+    return proxy;
+}
+
+void DynamicAABBTree::Remove(u32 proxy)
+{
+    if (proxy >= m_nodes.size() || !m_nodes[proxy].isLeaf() || m_nodes[proxy].height != 0)
+    {
+        // error, the proxy does not exist
+        return;
+    }
+
+    if (m_nodes[proxy].moved)
+    {
+        // NOTE: the id can be reused by the next Insert(), so it must not stay in the moved list
+        m_moved.erase(std::find(m_moved.begin(), m_moved.end(), proxy));
+    }
+    removeLeaf(proxy);
+    freeNode(proxy);
+    m_proxy_count--;
+}
+
+bool DynamicAABBTree::Move(u32 proxy, const AABB& aabb, const vec3f& displacement)
+{
+    if (m_nodes[proxy].aabb.contains(aabb))
+    {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    m_nodes[proxy].aabb = fatten(aabb, displacement);
+    insertLeaf(proxy);
+    if (!m_nodes[proxy].moved)
+    {
+        m_nodes[proxy].moved = true;
+        m_moved.push_back(proxy);
+    }
+    return true;
+}
+
+const AABB& DynamicAABBTree::GetFatAABB(u32 proxy) const
+{
+    return m_nodes[proxy].aabb;
+}
+
+u32 DynamicAABBTree::GetUserData(u32 proxy) const
+{
+    return m_nodes[proxy].user_data;
+}
+
+void DynamicAABBTree::insertLeaf(u32 leaf)
+{
+    if (m_root == NULL_PROXY)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_PROXY;
+        return;
+    }
+
+    // walk down to the best sibling, at each node the cost of making the leaf a sibling of the node
+    // is compared to the cost of going down into one of its children, where the cost is the
+    // surface area that the new node adds plus the area that all the ancestors grow by
+    const AABB leaf_aabb = m_nodes[leaf].aabb;
+    u32 index = m_root;
+    while (!m_nodes[index].isLeaf())
+    {
+        const Node& node = m_nodes[index];
+        const float area = node.aabb.getSurfaceArea();
+        const float combined_area = Union(node.aabb, leaf_aabb).getSurfaceArea();
+
+        // the cost of creating a new parent for this node and the new leaf
+        const float cost = 2.0f * combined_area;
+        // the minimum cost of pushing the leaf further down the tree
+        const float inheritance_cost = 2.0f * (combined_area - area);
+
+        auto childCost = [&](u32 child)
+        {
+            const AABB aabb = Union(leaf_aabb, m_nodes[child].aabb);
+            if (m_nodes[child].isLeaf())
+            {
+                return aabb.getSurfaceArea() + inheritance_cost;
+            }
+            return aabb.getSurfaceArea() - m_nodes[child].aabb.getSurfaceArea() + inheritance_cost;
+        };
+        const float cost1 = childCost(node.child1);
+        const float cost2 = childCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+        {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+    const u32 sibling = index;
+
+    // create a new parent for the sibling and the leaf
+    const u32 old_parent = m_nodes[sibling].parent;
+    const u32 new_parent = allocateNode();
+    m_nodes[new_parent].parent = old_parent;
+    m_nodes[new_parent].aabb = Union(leaf_aabb, m_nodes[sibling].aabb);
+    m_nodes[new_parent].height = m_nodes[sibling].height + 1;
+    m_nodes[new_parent].child1 = sibling;
+    m_nodes[new_parent].child2 = leaf;
+    m_nodes[sibling].parent = new_parent;
+    m_nodes[leaf].parent = new_parent;
+    if (old_parent == NULL_PROXY)
+    {
+        m_root = new_parent;
+    }
+    else if (m_nodes[old_parent].child1 == sibling)
+    {
+        m_nodes[old_parent].child1 = new_parent;
+    }
+    else
+    {
+        m_nodes[old_parent].child2 = new_parent;
+    }
+
+    // walk back up fixing the heights and the boxes, and rebalance on the way
+    index = m_nodes[leaf].parent;
+    while (index != NULL_PROXY)
+    {
+        index = balance(index);
+        Node& node = m_nodes[index];
+        node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+        node.aabb = Union(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+        index = node.parent;
+    }
+}
+
+void DynamicAABBTree::removeLeaf(u32 leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NULL_PROXY;
+        return;
+    }
+
+    // the sibling takes the place of the parent which is destroyed
+    const u32 parent = m_nodes[leaf].parent;
+    const u32 grand_parent = m_nodes[parent].parent;
+    const u32 sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+    if (grand_parent == NULL_PROXY)
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_PROXY;
+        freeNode(parent);
+        return;
+    }
+
+    if (m_nodes[grand_parent].child1 == parent)
+    {
+        m_nodes[grand_parent].child1 = sibling;
+    }
+    else
+    {
+        m_nodes[grand_parent].child2 = sibling;
+    }
+    m_nodes[sibling].parent = grand_parent;
+    freeNode(parent);
+
+    u32 index = grand_parent;
+    while (index != NULL_PROXY)
+    {
+        index = balance(index);
+        Node& node = m_nodes[index];
+        node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+        node.aabb = Union(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+        index = node.parent;
+    }
+}
+
+u32 DynamicAABBTree::balance(u32 a)
+{
+    // rotates the taller child of 'a' up when the heights of the children differ by more than one,
+    // returns the node that took the place of 'a'
+    Node& node_a = m_nodes[a];
+    if (node_a.isLeaf() || node_a.height < 2)
+    {
+        return a;
+    }
+
+    const u32 b = node_a.child1;
+    const u32 c = node_a.child2;
+    const i32 difference = m_nodes[c].height - m_nodes[b].height;
+    if (difference >= -1 && difference <= 1)
+    {
+        return a;
+    }
+
+    // 'up' is the taller child that becomes the parent of 'a', 'down' is the other one
+    const u32 up = difference > 1 ? c : b;
+    Node& node_up = m_nodes[up];
+    const u32 f = node_up.child1;
+    const u32 g = node_up.child2;
+
+    // 'up' takes the place of 'a'
+    node_up.child1 = a;
+    node_up.parent = node_a.parent;
+    node_a.parent = up;
+    if (node_up.parent == NULL_PROXY)
+    {
+        m_root = up;
+    }
+    else if (m_nodes[node_up.parent].child1 == a)
+    {
+        m_nodes[node_up.parent].child1 = up;
+    }
+    else
+    {
+        m_nodes[node_up.parent].child2 = up;
+    }
+
+    // the taller grandchild stays under 'up' and the shorter one moves under 'a'
+    const u32 keep = m_nodes[f].height > m_nodes[g].height ? f : g;
+    const u32 give = keep == f ? g : f;
+    node_up.child2 = keep;
+    if (up == c)
+    {
+        node_a.child2 = give;
+    }
+    else
+    {
+        node_a.child1 = give;
+    }
+    m_nodes[give].parent = a;
+
+    const u32 down = up == c ? b : c;
+    node_a.aabb = Union(m_nodes[down].aabb, m_nodes[give].aabb);
+    node_a.height = 1 + std::max(m_nodes[down].height, m_nodes[give].height);
+    node_up.aabb = Union(node_a.aabb, m_nodes[keep].aabb);
+    node_up.height = 1 + std::max(node_a.height, m_nodes[keep].height);
+    return up;
+}
+
+size_t DynamicAABBTree::QueryOverlap(const AABB& aabb, std::vector<u32>& proxies) const
+{
+    if (m_root == NULL_PROXY)
+    {
+        return 0;
+    }
+
+    const size_t initial_size = proxies.size();
+    u32 stack[STACK_SIZE];
+    u32 stack_size = 0;
+    stack[stack_size++] = m_root;
+    while (stack_size > 0)
+    {
+        const Node& node = m_nodes[stack[--stack_size]];
+        if (!node.aabb.intersects(aabb))
+        {
+            continue;
+        }
+        if (node.isLeaf())
+        {
+            proxies.push_back(static_cast<u32>(&node - m_nodes.data()));
+            continue;
+        }
+        stack[stack_size++] = node.child1;
+        stack[stack_size++] = node.child2;
+    }
+    return proxies.size() - initial_size;
+}
+
+size_t DynamicAABBTree::FindPairs(ProxyPair* pairs, size_t max_pairs) const
+{
+    size_t pair_count = 0;
+    u32 stack[STACK_SIZE];
+    for (const u32 proxy : m_moved)
+    {
+        const AABB& aabb = m_nodes[proxy].aabb;
+        u32 stack_size = 0;
+        stack[stack_size++] = m_root;
+        while (stack_size > 0)
+        {
+            const u32 index = stack[--stack_size];
+            const Node& node = m_nodes[index];
+            if (!node.aabb.intersects(aabb))
+            {
+                continue;
+            }
+            if (!node.isLeaf())
+            {
+                stack[stack_size++] = node.child1;
+                stack[stack_size++] = node.child2;
+                continue;
+            }
+
+            // when both proxies moved the pair is found twice, only the query of the smaller id reports it
+            if (index == proxy || (node.moved && index < proxy))
+            {
+                continue;
+            }
+            if (pair_count < max_pairs)
+            {
+                pairs[pair_count] = ProxyPair{ std::min(proxy, index), std::max(proxy, index) };
+            }
+            pair_count++;
+        }
+    }
+    return pair_count;
+}
+
+void DynamicAABBTree::ClearMoved()
+{
+    for (const u32 proxy : m_moved)
+    {
+        m_nodes[proxy].moved = false;
+    }
+    m_moved.clear();
+}
+
+u32 DynamicAABBTree::GetHeight() const
+{
+    return m_root == NULL_PROXY ? 0 : static_cast<u32>(m_nodes[m_root].height);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "engine/core/types.h"
+#include "aabb.h"
+#include <vector>
+
+namespace deadrop::math
+{
+    // a pair of proxies whose fat AABBs overlap, 'proxy1' is always smaller than 'proxy2'
+    struct ProxyPair
+    {
+        u32 proxy1;
+        u32 proxy2;
+    };
+
+    // a bounding volume tree for objects that move, the objects (proxies) are stored with fat AABBs
+    // that are bigger than the real ones, so small movements do not change the tree at all
+    // NOTE: the tree is kept balanced with rotations, so its height stays logarithmic
+    class DynamicAABBTree
+    {
+    public:
+        static constexpr u32 NULL_PROXY = 0xFFFFFFFF;
+
+        // 'margin' is how much the AABBs are enlarged on each side when they are inserted or moved
+        explicit DynamicAABBTree(float margin = 0.1f);
+
+        // inserts a proxy and returns its id, 'user_data' is stored with the proxy, like the index of an entity
+        // NOTE: a new proxy counts as moved for FindPairs()
+        u32 Insert(const AABB& aabb, u32 user_data);
+
+        // removes a proxy, its id can be returned by a later Insert()
+        void Remove(u32 proxy);
+
+        // updates the AABB of a proxy, 'displacement' is how far the object moved this frame and is used
+        // to enlarge the fat AABB in the direction of movement, returns true when the proxy was reinserted
+        // NOTE: nothing changes when the new AABB is still inside the fat AABB
+        bool Move(u32 proxy, const AABB& aabb, const vec3f& displacement = vec3f(0.0f));
+
+        // returns the fat AABB of a proxy
+        const AABB& GetFatAABB(u32 proxy) const;
+
+        // returns the user data of a proxy
+        u32 GetUserData(u32 proxy) const;
+
+        // appends the proxies whose fat AABBs overlap 'aabb' to 'proxies', returns how many were appended
+        size_t QueryOverlap(const AABB& aabb, std::vector<u32>& proxies) const;
+
+        // finds the overlapping pairs that have at least one proxy that was inserted or moved (reinserted)
+        // since the last call to ClearMoved(), each pair is reported once
+        // returns the number of pairs found, only the first 'max_pairs' are written to 'pairs',
+        // so when the result is bigger than 'max_pairs' the buffer was too small
+        size_t FindPairs(ProxyPair* pairs, size_t max_pairs) const;
+
+        // forgets which proxies moved, call it after the pairs of a frame were handled
+        void ClearMoved();
+
+        // returns the height of the tree, zero for a tree with a single proxy
+        u32 GetHeight() const;
+
+        // returns the number of proxies in the tree
+        u32 GetProxyCount() const { return m_proxy_count; }
+
+    private:
+        struct Node
+        {
+            // the fat AABB for leaves and the union of the children for inner nodes
+            AABB aabb;
+            // the parent node, or the next free node when the node is not used
+            u32 parent = NULL_PROXY;
+            u32 child1 = NULL_PROXY;
+            u32 child2 = NULL_PROXY;
+            // zero for leaves, -1 for free nodes
+            i32 height = -1;
+            u32 user_data = 0;
+            bool moved = false;
+
+            bool isLeaf() const { return child1 == NULL_PROXY; }
+        };
+
+        u32 allocateNode();
+        void freeNode(u32 node);
+        void insertLeaf(u32 leaf);
+        void removeLeaf(u32 leaf);
+        u32 balance(u32 node);
+        AABB fatten(const AABB& aabb, const vec3f& displacement) const;
+
+        std::vector<Node> m_nodes;
+        u32 m_root = NULL_PROXY;
+        u32 m_free_list = NULL_PROXY;
+        u32 m_proxy_count = 0;
+        float m_margin;
+
+        // the proxies that were inserted or reinserted since the last ClearMoved()
+        std::vector<u32> m_moved;
+    };
+}
@@ -0,0 +1,287 @@
+#include "frustum.h"
+#include "scalar.h"
+#include "vec3_wide.h"
+#include "engine/core/cpu.h"
+#include "engine/core/parallel.h"
+#include "engine/core/simd.h"
+#include <cstring>
+#include <vector>
+using namespace deadrop;
+using namespace deadrop::math;
+
+namespace
+{
+    // returns the plane scaled so that its normal is unit length
+    vec4f normalizePlane(vec4f plane)
+    {
+        const float length = Sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length < 0.000001f)
+        {
+            // NOTE: the far plane of an infinite projection has no normal (0, 0, 0, nearZ),
+            // replace it with a plane that accepts every point
+            return vec4f{ 0.0f, 0.0f, 0.0f, 1.0f };
+        }
+        return plane / length;
+    }
+
+    // the planes splatted into registers, the absolute normals are used to project the box extents
+    struct PlanesSSE2
+    {
+        __m128 x[Frustum::PLANE_COUNT];
+        __m128 y[Frustum::PLANE_COUNT];
+        __m128 z[Frustum::PLANE_COUNT];
+        __m128 w[Frustum::PLANE_COUNT];
+        __m128 abs_x[Frustum::PLANE_COUNT];
+        __m128 abs_y[Frustum::PLANE_COUNT];
+        __m128 abs_z[Frustum::PLANE_COUNT];
+    };
+
+    // loads the center and extents of 4 boxes starting at 'aabbs'
+    inline void loadBoxes4(const AABB* aabbs, vec3x4& center, vec3x4& extents)
+    {
+        // an array of boxes is an array of vec3f pairs (min, max), so 8 vectors hold 4 boxes,
+        // the even lanes are the mins and the odd lanes are the maxs
+        const vec3f* corners = &aabbs[0].getMin();
+        const vec3x4 a = LoadVec3x4(corners);
+        const vec3x4 b = LoadVec3x4(corners + 4);
+        const vec3x4 min
+        {
+            _mm_shuffle_ps(a.x, b.x, _MM_SHUFFLE(2, 0, 2, 0)),
+            _mm_shuffle_ps(a.y, b.y, _MM_SHUFFLE(2, 0, 2, 0)),
+            _mm_shuffle_ps(a.z, b.z, _MM_SHUFFLE(2, 0, 2, 0))
+        };
+        const vec3x4 max
+        {
+            _mm_shuffle_ps(a.x, b.x, _MM_SHUFFLE(3, 1, 3, 1)),
+            _mm_shuffle_ps(a.y, b.y, _MM_SHUFFLE(3, 1, 3, 1)),
+            _mm_shuffle_ps(a.z, b.z, _MM_SHUFFLE(3, 1, 3, 1))
+        };
+        center = (max + min) * 0.5f;
+        extents = (max - min) * 0.5f;
+    }
+
+    // returns a bit mask of the boxes that are visible, one bit per lane
+    inline u32 testBoxes4SSE2(const PlanesSSE2& planes, const AABB* aabbs)
+    {
+        vec3x4 center, extents;
+        loadBoxes4(aabbs, center, extents);
+
+        // a box is outside when it is fully behind any of the planes:
+        // dot(normal, center) + dot(abs(normal), extents) + distance < 0
+        const __m128 zero = _mm_setzero_ps();
+        __m128 outside = zero;
+        for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_mul_ps(planes.x[p], center.x), planes.w[p]);
+            d = _mm_add_ps(d, _mm_mul_ps(planes.y[p], center.y));
+            d = _mm_add_ps(d, _mm_mul_ps(planes.z[p], center.z));
+            d = _mm_add_ps(d, _mm_mul_ps(planes.abs_x[p], extents.x));
+            d = _mm_add_ps(d, _mm_mul_ps(planes.abs_y[p], extents.y));
+            d = _mm_add_ps(d, _mm_mul_ps(planes.abs_z[p], extents.z));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, zero));
+        }
+        return ~static_cast<u32>(_mm_movemask_ps(outside)) & 0xF;
+    }
+
+    size_t cullScalar(const Frustum& frustum, const AABB* aabbs, size_t begin, size_t end, u32* visible_indices)
+    {
+        size_t visible = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            visible_indices[visible] = static_cast<u32>(i);
+            visible += frustum.Intersects(aabbs[i]) ? 1 : 0;
+        }
+        return visible;
+    }
+
+    size_t cullSSE2(const Frustum& frustum, const AABB* aabbs, size_t begin, size_t end, u32* visible_indices)
+    {
+        PlanesSSE2 planes;
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            const vec4f& plane = frustum.GetPlane(static_cast<Frustum::Plane>(p));
+            planes.x[p] = _mm_set1_ps(plane.x);
+            planes.y[p] = _mm_set1_ps(plane.y);
+            planes.z[p] = _mm_set1_ps(plane.z);
+            planes.w[p] = _mm_set1_ps(plane.w);
+            planes.abs_x[p] = _mm_and_ps(planes.x[p], abs_mask);
+            planes.abs_y[p] = _mm_and_ps(planes.y[p], abs_mask);
+            planes.abs_z[p] = _mm_and_ps(planes.z[p], abs_mask);
+        }
+
+        // 8 boxes per iteration, as two groups of 4
+        size_t visible = 0;
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            const u32 mask = testBoxes4SSE2(planes, aabbs + i) | (testBoxes4SSE2(planes, aabbs + i + 4) << 4);
+            visible += simd::CompactIndices(mask, 8, static_cast<u32>(i), visible_indices + visible);
+        }
+        return visible + cullScalar(frustum, aabbs, i, end, visible_indices + visible);
+    }
+
+    struct PlanesAVX
+    {
+        __m256 x[Frustum::PLANE_COUNT];
+        __m256 y[Frustum::PLANE_COUNT];
+        __m256 z[Frustum::PLANE_COUNT];
+        __m256 w[Frustum::PLANE_COUNT];
+        __m256 abs_x[Frustum::PLANE_COUNT];
+        __m256 abs_y[Frustum::PLANE_COUNT];
+        __m256 abs_z[Frustum::PLANE_COUNT];
+    };
+
+    SIMD_TARGET_AVX
+    inline u32 testBoxes8AVX(const PlanesAVX& planes, const AABB* aabbs)
+    {
+        vec3x4 center_lo, extents_lo, center_hi, extents_hi;
+        loadBoxes4(aabbs, center_lo, extents_lo);
+        loadBoxes4(aabbs + 4, center_hi, extents_hi);
+        const vec3x8 center
+        {
+            _mm256_insertf128_ps(_mm256_castps128_ps256(center_lo.x), center_hi.x, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(center_lo.y), center_hi.y, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(center_lo.z), center_hi.z, 1)
+        };
+        const vec3x8 extents
+        {
+            _mm256_insertf128_ps(_mm256_castps128_ps256(extents_lo.x), extents_hi.x, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(extents_lo.y), extents_hi.y, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(extents_lo.z), extents_hi.z, 1)
+        };
+
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 outside = zero;
+        for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(planes.x[p], center.x), planes.w[p]);
+            d = _mm256_add_ps(d, _mm256_mul_ps(planes.y[p], center.y));
+            d = _mm256_add_ps(d, _mm256_mul_ps(planes.z[p], center.z));
+            d = _mm256_add_ps(d, _mm256_mul_ps(planes.abs_x[p], extents.x));
+            d = _mm256_add_ps(d, _mm256_mul_ps(planes.abs_y[p], extents.y));
+            d = _mm256_add_ps(d, _mm256_mul_ps(planes.abs_z[p], extents.z));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, zero, _CMP_LT_OQ));
+        }
+        return ~static_cast<u32>(_mm256_movemask_ps(outside)) & 0xFF;
+    }
+
+    SIMD_TARGET_AVX
+    size_t cullAVX(const Frustum& frustum, const AABB* aabbs, size_t begin, size_t end, u32* visible_indices)
+    {
+        PlanesAVX planes;
+        const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            const vec4f& plane = frustum.GetPlane(static_cast<Frustum::Plane>(p));
+            planes.x[p] = _mm256_set1_ps(plane.x);
+            planes.y[p] = _mm256_set1_ps(plane.y);
+            planes.z[p] = _mm256_set1_ps(plane.z);
+            planes.w[p] = _mm256_set1_ps(plane.w);
+            planes.abs_x[p] = _mm256_and_ps(planes.x[p], abs_mask);
+            planes.abs_y[p] = _mm256_and_ps(planes.y[p], abs_mask);
+            planes.abs_z[p] = _mm256_and_ps(planes.z[p], abs_mask);
+        }
+
+        size_t visible = 0;
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            const u32 mask = testBoxes8AVX(planes, aabbs + i);
+            visible += simd::CompactIndices(mask, 8, static_cast<u32>(i), visible_indices + visible);
+        }
+        return visible + cullScalar(frustum, aabbs, i, end, visible_indices + visible);
+    }
+
+    // culls the boxes in [begin, end) and writes the visible indices starting at 'visible_indices'
+    size_t cullRange(const Frustum& frustum, const AABB* aabbs, size_t begin, size_t end, u32* visible_indices)
+    {
+        if (GetCpuFeatures().avx)
+        {
+            return cullAVX(frustum, aabbs, begin, end, visible_indices);
+        }
+        return cullSSE2(frustum, aabbs, begin, end, visible_indices);
+    }
+}
+
+Frustum::Frustum()
+{
+    for (u32 p = 0; p < PLANE_COUNT; p++)
+    {
+        m_planes[p] = vec4f{ 0.0f, 0.0f, 0.0f, 1.0f };
+    }
+}
+
+Frustum::Frustum(const mat4f& view_projection)
+{
+    // a point is transformed as the row vector [x, y, z, 1] * M, so each clip space component is the dot
+    // product of the point with one column of M, and the clip tests -w <= x <= w, -w <= y <= w
+    // and 0 <= z <= w become plane equations made of sums and differences of the columns
+    const mat4f& m = view_projection;
+    const vec4f col0{ m(0, 0), m(1, 0), m(2, 0), m(3, 0) };
+    const vec4f col1{ m(0, 1), m(1, 1), m(2, 1), m(3, 1) };
+    const vec4f col2{ m(0, 2), m(1, 2), m(2, 2), m(3, 2) };
+    const vec4f col3{ m(0, 3), m(1, 3), m(2, 3), m(3, 3) };
+
+    m_planes[PLANE_LEFT] = normalizePlane(col3 + col0);
+    m_planes[PLANE_RIGHT] = normalizePlane(col3 - col0);
+    m_planes[PLANE_BOTTOM] = normalizePlane(col3 + col1);
+    m_planes[PLANE_TOP] = normalizePlane(col3 - col1);
+    m_planes[PLANE_NEAR] = normalizePlane(col2);
+    m_planes[PLANE_FAR] = normalizePlane(col3 - col2);
+}
+
+const vec4f& Frustum::GetPlane(Plane plane) const
+{
+    return m_planes[plane];
+}
+
+bool Frustum::Intersects(const AABB& aabb) const
+{
+    const vec3f center = aabb.getCenter();
+    const vec3f extents = aabb.getExtents();
+    for (u32 p = 0; p < PLANE_COUNT; p++)
+    {
+        const vec4f& plane = m_planes[p];
+        const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        const float radius = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+        if (distance + radius < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t deadrop::math::CullAABBs(const Frustum& frustum, const AABB* aabbs, size_t count, u32* visible_indices)
+{
+    return cullRange(frustum, aabbs, 0, count, visible_indices);
+}
+
+size_t deadrop::math::CullAABBsParallel(const Frustum& frustum, const AABB* aabbs, size_t count, u32* visible_indices)
+{
+    // NOTE: the range size is a multiple of 8 so only the last range has a scalar tail
+    const size_t range_size = 16 * 1024;
+    const size_t range_count = (count + range_size - 1) / range_size;
+    if (range_count < 2)
+    {
+        return CullAABBs(frustum, aabbs, count, visible_indices);
+    }
+
+    // each range writes its indices to the start of its own part of the output,
+    // which has room since a range never has more visible boxes than its size
+    std::vector<size_t> range_visible(range_count, 0);
+    ParallelFor(count, range_size, [&](size_t begin, size_t end)
+    {
+        range_visible[begin / range_size] = cullRange(frustum, aabbs, begin, end, visible_indices + begin);
+    });
+
+    // move the ranges next to each other, the first range is already in place
+    size_t visible = range_visible[0];
+    for (size_t r = 1; r < range_count; r++)
+    {
+        memmove(visible_indices + visible, visible_indices + r * range_size, range_visible[r] * sizeof(u32));
+        visible += range_visible[r];
+    }
+    return visible;
+}
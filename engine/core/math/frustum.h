@@ -0,0 +1,55 @@
+#pragma once
+#include "engine/core/types.h"
+#include "vec4.h"
+#include "aabb.h"
+#include "matrix4x4.h"
+
+namespace deadrop::math
+{
+    // a view frustum made of six planes, each plane is stored as (normal.x, normal.y, normal.z, distance)
+    // with a normalized normal that points to the inside of the frustum
+    class Frustum
+    {
+    public:
+        enum Plane : u32
+        {
+            PLANE_LEFT = 0,
+            PLANE_RIGHT,
+            PLANE_BOTTOM,
+            PLANE_TOP,
+            PLANE_NEAR,
+            PLANE_FAR,
+            PLANE_COUNT
+        };
+
+        // default constructor
+        // all the planes accept every point
+        Frustum();
+
+        // extracts the planes from a view-projection matrix (view * projection), the planes are in world space,
+        // passing only a projection matrix gives the planes in view space
+        // NOTE: works with the D3D [0, 1] depth range of ComposeProjectionFovLH/ComposeOrthoLH,
+        // for ComposeInfiniteProjectionFovLH the far plane accepts every point
+        explicit Frustum(const mat4f& view_projection);
+
+        // returns one of the planes
+        const vec4f& GetPlane(Plane plane) const;
+
+        // returns whether the box is inside or intersects the frustum
+        // NOTE: this is conservative, boxes near the corners of the frustum can be reported as visible
+        bool Intersects(const AABB& aabb) const;
+
+    private:
+        vec4f m_planes[PLANE_COUNT];
+    };
+
+    // tests 'count' boxes against the frustum and writes the indices of the visible ones to 'visible_indices',
+    // in increasing order, returns the number of visible boxes
+    // NOTE: 'visible_indices' must have room for 'count' indices
+    // NOTE: the boxes are tested 8 at a time using simd instructions
+    size_t CullAABBs(const Frustum& frustum, const AABB* aabbs, size_t count, u32* visible_indices);
+
+    // the same as CullAABBs() but the boxes are split into ranges that are culled on the worker threads,
+    // worth it for scenes of around 100k boxes and more, the result is identical
+    size_t CullAABBsParallel(const Frustum& frustum, const AABB* aabbs, size_t count, u32* visible_indices);
+}
@@ -5,5 +5,9 @@
 #include "vec2.h"
 #include "vec3.h"
 #include "vec4.h"
+#include "vec3_wide.h"
+#include "vec4_wide.h"
+#include "quat.h"
 #include "aabb.h"
+#include "frustum.h"
 #include "matrix4x4.h"
\ No newline at end of file
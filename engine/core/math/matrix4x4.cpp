@@ -1,96 +1,528 @@
 #include "matrix4x4.h"
+#include "engine/core/cpu.h"
+#include "engine/core/simd.h"
+using namespace deadrop;
 using namespace deadrop::math;
 
-Matrix4x4::Matrix4x4()
+// the matrix kernels below work on pointers to 16 row-major floats,
+// and are selected once at startup based on the cpu features
+namespace
 {
-    // first row
-    mat[0][0] = 0.0f; mat[0][1] = 0.0f; mat[0][2] = 0.0f; mat[0][3] = 0.0f;
-    // second row
-    mat[1][0] = 0.0f; mat[1][1] = 0.0f; mat[1][2] = 0.0f; mat[1][3] = 0.0f;
-    // third row
-    mat[2][0] = 0.0f; mat[2][1] = 0.0f; mat[2][2] = 0.0f; mat[2][3] = 0.0f;
-    // fourth row
-    mat[3][0] = 0.0f; mat[3][1] = 0.0f; mat[3][2] = 0.0f; mat[3][3] = 0.0f;
+    using MultiplyKernel = void(*)(const float* a, const float* b, float* out);
+    using MultiplyManyKernel = void(*)(const float* a, const float* b, float* out, size_t count);
+    using AddKernel = void(*)(const float* a, const float* b, float* out);
+    using TransposeKernel = void(*)(const float* m, float* out);
+    using InverseKernel = float(*)(const float* m, float* out);
+    using InverseManyKernel = void(*)(const float* m, float* out, size_t count);
+
+    // scalar kernels, used when no simd instruction set is available
+    void multiplyScalar(const float* a, const float* b, float* out)
+    {
+        // NOTE: compute into a temporary so 'out' can alias 'a' or 'b'
+        float temp[16];
+        for (size_t i = 0; i < 4; i++)
+        {
+            for (size_t j = 0; j < 4; j++)
+            {
+                temp[i * 4 + j] =
+                    a[i * 4 + 0] * b[0 * 4 + j] +
+                    a[i * 4 + 1] * b[1 * 4 + j] +
+                    a[i * 4 + 2] * b[2 * 4 + j] +
+                    a[i * 4 + 3] * b[3 * 4 + j];
+            }
+        }
+        for (size_t i = 0; i < 16; i++)
+        {
+            out[i] = temp[i];
+        }
+    }
+
+    void multiplyManyScalar(const float* a, const float* b, float* out, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            multiplyScalar(a + n * 16, b + n * 16, out + n * 16);
+        }
+    }
+
+    void addScalar(const float* a, const float* b, float* out)
+    {
+        for (size_t i = 0; i < 16; i++)
+        {
+            out[i] = a[i] + b[i];
+        }
+    }
+
+    void transposeScalar(const float* m, float* out)
+    {
+        float temp[16];
+        for (size_t i = 0; i < 4; i++)
+        {
+            for (size_t j = 0; j < 4; j++)
+            {
+                temp[i * 4 + j] = m[j * 4 + i];
+            }
+        }
+        for (size_t i = 0; i < 16; i++)
+        {
+            out[i] = temp[i];
+        }
+    }
+
+    // general inverse using the cofactors of the matrix, returns the determinant
+    // NOTE: works the same for row-major and column-major storage since inv(transpose(M)) = transpose(inv(M))
+    float inverseScalar(const float* m, float* out)
+    {
+        float inv[16];
+        inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+        inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+        inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+        inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+        inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+        inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+        inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+        inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+        inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+        inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+        inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+        inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+        inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+        inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+        inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+        inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+        const float determinant = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+        const float inv_determinant = 1.0f / determinant;
+        for (size_t i = 0; i < 16; i++)
+        {
+            out[i] = inv[i] * inv_determinant;
+        }
+        return determinant;
+    }
+
+    // affine inverse, the upper 3x3 part is inverted using cross products
+    // and the translation row is transformed by it, returns the determinant
+    float affineInverseScalar(const float* m, float* out)
+    {
+        // rows of the 3x3 part
+        const float r0[3] = { m[0], m[1], m[2] };
+        const float r1[3] = { m[4], m[5], m[6] };
+        const float r2[3] = { m[8], m[9], m[10] };
+        const float t[3] = { m[12], m[13], m[14] };
+
+        // the columns of the inverse are the cross products of the rows divided by the determinant
+        const float c0[3] = { r1[1] * r2[2] - r1[2] * r2[1], r1[2] * r2[0] - r1[0] * r2[2], r1[0] * r2[1] - r1[1] * r2[0] };
+        const float c1[3] = { r2[1] * r0[2] - r2[2] * r0[1], r2[2] * r0[0] - r2[0] * r0[2], r2[0] * r0[1] - r2[1] * r0[0] };
+        const float c2[3] = { r0[1] * r1[2] - r0[2] * r1[1], r0[2] * r1[0] - r0[0] * r1[2], r0[0] * r1[1] - r0[1] * r1[0] };
+        const float determinant = r0[0] * c0[0] + r0[1] * c0[1] + r0[2] * c0[2];
+        const float inv_determinant = 1.0f / determinant;
+
+        float inv[16];
+        for (size_t k = 0; k < 3; k++)
+        {
+            inv[k * 4 + 0] = c0[k] * inv_determinant;
+            inv[k * 4 + 1] = c1[k] * inv_determinant;
+            inv[k * 4 + 2] = c2[k] * inv_determinant;
+            inv[k * 4 + 3] = 0.0f;
+        }
+        for (size_t j = 0; j < 3; j++)
+        {
+            inv[12 + j] = -(t[0] * inv[0 + j] + t[1] * inv[4 + j] + t[2] * inv[8 + j]);
+        }
+        inv[15] = 1.0f;
+
+        for (size_t i = 0; i < 16; i++)
+        {
+            out[i] = inv[i];
+        }
+        return determinant;
+    }
+
+    void inverseManyScalar(const float* m, float* out, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            inverseScalar(m + n * 16, out + n * 16);
+        }
+    }
+
+    void affineInverseManyScalar(const float* m, float* out, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            affineInverseScalar(m + n * 16, out + n * 16);
+        }
+    }
+
+    // sse2 kernels, each row of the result is a linear combination of the rows of 'b'
+    // weighted by the elements of the same row in 'a'
+    inline void multiplySSE2Inline(const float* a, const float* b, float* out)
+    {
+        // NOTE: all of 'b' is loaded before writing and each row of 'a' is read
+        // before its output row is written, so 'out' can alias 'a' or 'b'
+        const __m128 b0 = _mm_load_ps(b + 0);
+        const __m128 b1 = _mm_load_ps(b + 4);
+        const __m128 b2 = _mm_load_ps(b + 8);
+        const __m128 b3 = _mm_load_ps(b + 12);
+        for (size_t i = 0; i < 4; i++)
+        {
+            const __m128 row = _mm_load_ps(a + i * 4);
+            __m128 result = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+            _mm_store_ps(out + i * 4, result);
+        }
+    }
+
+    void multiplySSE2(const float* a, const float* b, float* out)
+    {
+        multiplySSE2Inline(a, b, out);
+    }
+
+    void multiplyManySSE2(const float* a, const float* b, float* out, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            multiplySSE2Inline(a + n * 16, b + n * 16, out + n * 16);
+        }
+    }
+
+    void addSSE2(const float* a, const float* b, float* out)
+    {
+        for (size_t i = 0; i < 16; i += 4)
+        {
+            _mm_store_ps(out + i, _mm_add_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)));
+        }
+    }
+
+    void transposeSSE2(const float* m, float* out)
+    {
+        __m128 r0 = _mm_load_ps(m + 0);
+        __m128 r1 = _mm_load_ps(m + 4);
+        __m128 r2 = _mm_load_ps(m + 8);
+        __m128 r3 = _mm_load_ps(m + 12);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_store_ps(out + 0, r0);
+        _mm_store_ps(out + 4, r1);
+        _mm_store_ps(out + 8, r2);
+        _mm_store_ps(out + 12, r3);
+    }
+
+    // helpers for the sse2 inverse, a 2x2 matrix is stored in one register as (m00, m01, m10, m11)
+    inline __m128 mat2Mul(__m128 a, __m128 b)
+    {
+        // a * b
+        return _mm_add_ps(
+            _mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+            _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+    }
+
+    inline __m128 mat2AdjMul(__m128 a, __m128 b)
+    {
+        // adjugate(a) * b
+        return _mm_sub_ps(
+            _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+            _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+
+    inline __m128 mat2MulAdj(__m128 a, __m128 b)
+    {
+        // a * adjugate(b)
+        return _mm_sub_ps(
+            _mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+            _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+    }
+
+    // general inverse using the block matrix method, the matrix is split into four 2x2 matrices
+    // | A B |
+    // | C D | and the inverse is built from their adjugates and determinants
+    inline float inverseSSE2Inline(const float* m, float* out)
+    {
+        const __m128 row0 = _mm_load_ps(m + 0);
+        const __m128 row1 = _mm_load_ps(m + 4);
+        const __m128 row2 = _mm_load_ps(m + 8);
+        const __m128 row3 = _mm_load_ps(m + 12);
+
+        // sub matrices
+        const __m128 A = _mm_movelh_ps(row0, row1);
+        const __m128 B = _mm_movehl_ps(row1, row0);
+        const __m128 C = _mm_movelh_ps(row2, row3);
+        const __m128 D = _mm_movehl_ps(row3, row2);
+
+        // determinants of the sub matrices as (|A|, |B|, |C|, |D|)
+        const __m128 det_sub = _mm_sub_ps(
+            _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3, 1, 3, 1))),
+            _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2, 0, 2, 0))));
+        const __m128 det_A = _mm_shuffle_ps(det_sub, det_sub, _MM_SHUFFLE(0, 0, 0, 0));
+        const __m128 det_B = _mm_shuffle_ps(det_sub, det_sub, _MM_SHUFFLE(1, 1, 1, 1));
+        const __m128 det_C = _mm_shuffle_ps(det_sub, det_sub, _MM_SHUFFLE(2, 2, 2, 2));
+        const __m128 det_D = _mm_shuffle_ps(det_sub, det_sub, _MM_SHUFFLE(3, 3, 3, 3));
+
+        // adjugate(D) * C and adjugate(A) * B
+        const __m128 D_C = mat2AdjMul(D, C);
+        const __m128 A_B = mat2AdjMul(A, B);
+
+        // the adjugates of the four blocks of the inverse
+        __m128 X = _mm_sub_ps(_mm_mul_ps(det_D, A), mat2Mul(B, D_C));
+        __m128 W = _mm_sub_ps(_mm_mul_ps(det_A, D), mat2Mul(C, A_B));
+        __m128 Y = _mm_sub_ps(_mm_mul_ps(det_B, C), mat2MulAdj(D, A_B));
+        __m128 Z = _mm_sub_ps(_mm_mul_ps(det_C, B), mat2MulAdj(A, D_C));
+
+        // |M| = |A|*|D| + |B|*|C| - trace(adjugate(A)B * adjugate(D)C)
+        __m128 det_M = _mm_add_ps(_mm_mul_ps(det_A, det_D), _mm_mul_ps(det_B, det_C));
+        __m128 trace = _mm_mul_ps(A_B, _mm_shuffle_ps(D_C, D_C, _MM_SHUFFLE(3, 1, 2, 0)));
+        trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(2, 3, 0, 1)));
+        trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(1, 0, 3, 2)));
+        det_M = _mm_sub_ps(det_M, trace);
+
+        // (1/|M|, -1/|M|, -1/|M|, 1/|M|) applies the sign pattern of the adjugate
+        const __m128 inv_det_M = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_M);
+        X = _mm_mul_ps(X, inv_det_M);
+        Y = _mm_mul_ps(Y, inv_det_M);
+        Z = _mm_mul_ps(Z, inv_det_M);
+        W = _mm_mul_ps(W, inv_det_M);
+
+        // apply the adjugate shuffle and store the rows
+        _mm_store_ps(out + 0, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1, 3, 1, 3)));
+        _mm_store_ps(out + 4, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0, 2, 0, 2)));
+        _mm_store_ps(out + 8, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1, 3, 1, 3)));
+        _mm_store_ps(out + 12, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0, 2, 0, 2)));
+
+        return _mm_cvtss_f32(det_M);
+    }
+
+    // returns the cross product of the xyz components, w is zero when both inputs have w set to zero
+    inline __m128 cross3SSE2(__m128 a, __m128 b)
+    {
+        const __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    inline float affineInverseSSE2Inline(const float* m, float* out)
+    {
+        // clear the w of the 3x3 rows so the cross products have w = 0
+        const __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 r0 = _mm_and_ps(_mm_load_ps(m + 0), xyz_mask);
+        const __m128 r1 = _mm_and_ps(_mm_load_ps(m + 4), xyz_mask);
+        const __m128 r2 = _mm_and_ps(_mm_load_ps(m + 8), xyz_mask);
+        const __m128 t = _mm_load_ps(m + 12);
+
+        // the columns of the inverse of the 3x3 part (before dividing by the determinant)
+        __m128 c0 = cross3SSE2(r1, r2);
+        __m128 c1 = cross3SSE2(r2, r0);
+        __m128 c2 = cross3SSE2(r0, r1);
+
+        // determinant = dot(r0, c0)
+        __m128 det = _mm_mul_ps(r0, c0);
+        det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+        det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+        const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        c0 = _mm_mul_ps(c0, inv_det);
+        c1 = _mm_mul_ps(c1, inv_det);
+        c2 = _mm_mul_ps(c2, inv_det);
+
+        // transpose the columns into rows, the fourth row becomes the translation
+        __m128 c3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+        // translation = -(t.x * row0 + t.y * row1 + t.z * row2)
+        __m128 translation = _mm_mul_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)), c0);
+        translation = _mm_add_ps(translation, _mm_mul_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)), c1));
+        translation = _mm_add_ps(translation, _mm_mul_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2)), c2));
+        translation = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), translation);
+
+        _mm_store_ps(out + 0, c0);
+        _mm_store_ps(out + 4, c1);
+        _mm_store_ps(out + 8, c2);
+        _mm_store_ps(out + 12, translation);
+
+        return _mm_cvtss_f32(det);
+    }
+
+    float inverseSSE2(const float* m, float* out)
+    {
+        return inverseSSE2Inline(m, out);
+    }
+
+    float affineInverseSSE2(const float* m, float* out)
+    {
+        return affineInverseSSE2Inline(m, out);
+    }
+
+    void inverseManySSE2(const float* m, float* out, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            inverseSSE2Inline(m + n * 16, out + n * 16);
+        }
+    }
+
+    void affineInverseManySSE2(const float* m, float* out, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            affineInverseSSE2Inline(m + n * 16, out + n * 16);
+        }
+    }
+
+    // avx2 kernels, two rows of the result are computed at once, the rows of 'b'
+    // are duplicated in both 128-bit lanes and the elements of two rows of 'a' are
+    // broadcast within their own lane
+    SIMD_TARGET_AVX2 inline void multiplyAVX2Inline(const float* a, const float* b, float* out)
+    {
+        const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 0));
+        const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 4));
+        const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 8));
+        const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 12));
+
+        const __m256 a01 = _mm256_loadu_ps(a + 0);
+        const __m256 a23 = _mm256_loadu_ps(a + 8);
+
+        __m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        __m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(1, 1, 1, 1)), b1, r01);
+        r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(1, 1, 1, 1)), b1, r23);
+        r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(2, 2, 2, 2)), b2, r01);
+        r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(2, 2, 2, 2)), b2, r23);
+        r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(3, 3, 3, 3)), b3, r01);
+        r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(3, 3, 3, 3)), b3, r23);
+
+        _mm256_storeu_ps(out + 0, r01);
+        _mm256_storeu_ps(out + 8, r23);
+    }
+
+    SIMD_TARGET_AVX2 void multiplyAVX2(const float* a, const float* b, float* out)
+    {
+        multiplyAVX2Inline(a, b, out);
+    }
+
+    SIMD_TARGET_AVX2 void multiplyManyAVX2(const float* a, const float* b, float* out, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            multiplyAVX2Inline(a + n * 16, b + n * 16, out + n * 16);
+        }
+    }
+
+    SIMD_TARGET_AVX2 void addAVX2(const float* a, const float* b, float* out)
+    {
+        _mm256_storeu_ps(out + 0, _mm256_add_ps(_mm256_loadu_ps(a + 0), _mm256_loadu_ps(b + 0)));
+        _mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(a + 8), _mm256_loadu_ps(b + 8)));
+    }
+
+    // the currently selected kernels
+    // NOTE: this starts with the scalar kernels (constant-initialized) so matrices
+    // that are used during static initialization of other files still work
+    struct MatrixKernels
+    {
+        MultiplyKernel multiply;
+        MultiplyManyKernel multiply_many;
+        AddKernel add;
+        TransposeKernel transpose;
+        InverseKernel inverse;
+        InverseManyKernel inverse_many;
+        InverseKernel affine_inverse;
+        InverseManyKernel affine_inverse_many;
+    };
+    MatrixKernels s_kernels =
+    {
+        &multiplyScalar, &multiplyManyScalar, &addScalar, &transposeScalar,
+        &inverseScalar, &inverseManyScalar, &affineInverseScalar, &affineInverseManyScalar
+    };
+
+    // selects the fastest kernels that the cpu supports
+    bool selectKernels()
+    {
+        const CpuFeatures& features = GetCpuFeatures();
+        if (features.sse2)
+        {
+            s_kernels =
+            {
+                &multiplySSE2, &multiplyManySSE2, &addSSE2, &transposeSSE2,
+                &inverseSSE2, &inverseManySSE2, &affineInverseSSE2, &affineInverseManySSE2
+            };
+        }
+        if (features.avx2 && features.fma)
+        {
+            // NOTE: the transpose and inverses stay on sse2 since they are shuffle-bound
+            // and have no benefit from wider registers
+            s_kernels.multiply = &multiplyAVX2;
+            s_kernels.multiply_many = &multiplyManyAVX2;
+            s_kernels.add = &addAVX2;
+        }
+        return true;
+    }
+
+    // runs the selection once at startup
+    const bool s_kernels_selected = selectKernels();
 }
 
-Matrix4x4::Matrix4x4(
-    float m00, float m01, float m02, float m03,
-    float m10, float m11, float m12, float m13,
-    float m20, float m21, float m22, float m23,
-    float m30, float m31, float m32, float m33)
+void Matrix4x4::transposeKernel(const float* m, float* out)
 {
-    // first row
-    mat[0][0] = m00; mat[0][1] = m01; mat[0][2] = m02; mat[0][3] = m03;
-    // second row
-    mat[1][0] = m10; mat[1][1] = m11; mat[1][2] = m12; mat[1][3] = m13;
-    // third row
-    mat[2][0] = m20; mat[2][1] = m21; mat[2][2] = m22; mat[2][3] = m23;
-    // fourth row
-    mat[3][0] = m30; mat[3][1] = m31; mat[3][2] = m32; mat[3][3] = m33;
+    s_kernels.transpose(m, out);
 }
 
-Matrix4x4::Matrix4x4(float m00, float m11, float m22, float m33)
+void Matrix4x4::multiplyKernel(const float* a, const float* b, float* out)
 {
-    // first row
-    mat[0][0] = m00;  mat[0][1] = 0.0f; mat[0][2] = 0.0f; mat[0][3] = 0.0f;
-    // second row
-    mat[1][0] = 0.0f; mat[1][1] = m11; mat[1][2] = 0.0f; mat[1][3] = 0.0f;
-    // third row
-    mat[2][0] = 0.0f; mat[2][1] = 0.0f; mat[2][2] = m22; mat[2][3] = 0.0f;
-    // fourth row
-    mat[3][0] = 0.0f; mat[3][1] = 0.0f; mat[3][2] = 0.0f; mat[3][3] = m33;
+    s_kernels.multiply(a, b, out);
 }
 
-Matrix4x4 Matrix4x4::GetTranspose() const
+void Matrix4x4::addKernel(const float* a, const float* b, float* out)
+{
+    s_kernels.add(a, b, out);
+}
+
+Matrix4x4 Matrix4x4::GetInverse(float* determinant) const
 {
     Matrix4x4 temp = {};
-    for (size_t i = 0; i < 4; i++)
+    float det = s_kernels.inverse(&mat[0][0], &temp.mat[0][0]);
+    if (determinant)
     {
-        for (size_t j = 0; j < 4; j++)
-        {
-            temp.mat[i][j] = mat[j][i];
-        }
+        *determinant = det;
     }
     return temp;
 }
 
-Matrix4x4 Matrix4x4::operator *(const Matrix4x4& param)
+Matrix4x4 Matrix4x4::GetAffineInverse(float* determinant) const
 {
     Matrix4x4 temp = {};
-    for (size_t i = 0; i < 4; i++)
+    float det = s_kernels.affine_inverse(&mat[0][0], &temp.mat[0][0]);
+    if (determinant)
     {
-        for (size_t j = 0; j < 4; j++)
-        {
-            temp.mat[i][j] =
-                mat[i][0] * param.mat[0][j] +
-                mat[i][1] * param.mat[1][j] +
-                mat[i][2] * param.mat[2][j] +
-                mat[i][3] * param.mat[3][j];
-        }
+        *determinant = det;
     }
     return temp;
 }
 
-Matrix4x4 Matrix4x4::operator +(const Matrix4x4& param)
+void deadrop::math::MultiplyMany(const mat4f* a, const mat4f* b, mat4f* out, size_t count)
 {
-    Matrix4x4 temp = {};
-    for (size_t i = 0; i < 4; i++)
+    // NOTE: the matrices are tightly packed (64 bytes each) so the arrays
+    // can be processed as one contiguous array of floats
+    static_assert(sizeof(mat4f) == sizeof(float) * 16, "mat4f must be tightly packed!");
+    if (count == 0)
     {
-        for (size_t j = 0; j < 4; j++)
-        {
-            temp.mat[i][j] = mat[i][j] + param.mat[i][j];
-        }
+        return;
     }
-    return temp;
+    s_kernels.multiply_many(&a->mat[0][0], &b->mat[0][0], &out->mat[0][0], count);
 }
 
-float& Matrix4x4::operator ()(size_t i, size_t j)
+void deadrop::math::InverseMany(const mat4f* m, mat4f* out, size_t count)
 {
-    // TODO: assert here to make sure we do not access out of bounds
-    return mat[i][j];
+    if (count == 0)
+    {
+        return;
+    }
+    s_kernels.inverse_many(&m->mat[0][0], &out->mat[0][0], count);
 }
 
-Matrix4x4 Matrix4x4::Identity()
+void deadrop::math::AffineInverseMany(const mat4f* m, mat4f* out, size_t count)
 {
-    return Matrix4x4(1.0f, 1.0f, 1.0f, 1.0f);
+    if (count == 0)
+    {
+        return;
+    }
+    s_kernels.affine_inverse_many(&m->mat[0][0], &out->mat[0][0], count);
 }
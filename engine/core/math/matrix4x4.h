@@ -1,43 +1,158 @@
 #pragma once
+#include <cstddef>
 
 namespace deadrop::math
 {
-    class Matrix4x4
+    // NOTE: the matrix is 16-byte aligned so the simd kernels can use aligned loads and stores,
+    // it is still 64 bytes in size so arrays of matrices stay tightly packed
+    class alignas(16) Matrix4x4
     {
     public:
         // default constructor
         // all elements are zeroed
-        Matrix4x4();
+        constexpr Matrix4x4() : mat{} {}
 
         // constructs a matrix by specifying
         // all its elements (rows and columns)
-        Matrix4x4(
+        constexpr Matrix4x4(
             float m00, float m01, float m02, float m03,
             float m10, float m11, float m12, float m13,
             float m20, float m21, float m22, float m23,
-            float m30, float m31, float m32, float m33);
+            float m30, float m31, float m32, float m33) :
+            mat{
+                { m00, m01, m02, m03 },
+                { m10, m11, m12, m13 },
+                { m20, m21, m22, m23 },
+                { m30, m31, m32, m33 } }
+        {
+        }
 
         // constructs a matrix by specifying the diagnal values only, the rest is zeroed
-        Matrix4x4(float m00, float m11, float m22, float m33);
+        constexpr Matrix4x4(float m00, float m11, float m22, float m33) :
+            mat{
+                { m00, 0.0f, 0.0f, 0.0f },
+                { 0.0f, m11, 0.0f, 0.0f },
+                { 0.0f, 0.0f, m22, 0.0f },
+                { 0.0f, 0.0f, 0.0f, m33 } }
+        {
+        }
 
         // returns the transpose of the matrix
-        Matrix4x4 GetTranspose() const;
+        constexpr Matrix4x4 GetTranspose() const;
+
+        // returns the inverse of the matrix, and optionally stores its determinant
+        // NOTE: the result is invalid when the determinant is zero (the matrix is singular)
+        Matrix4x4 GetInverse(float* determinant = nullptr) const;
+
+        // returns the inverse of an affine matrix, one whose last column is [0, 0, 0, 1]
+        // like the ones returned by Transform::MatrixTranslate/MatrixRotate*/MatrixScale and ComposeLookAtLH
+        // NOTE: this is a lot cheaper than GetInverse() but gives wrong results for projection matrices
+        // NOTE: the determinant stored is the one of the upper 3x3 part which is the same as the full matrix
+        Matrix4x4 GetAffineInverse(float* determinant = nullptr) const;
 
         // operators
-        Matrix4x4 operator*(const Matrix4x4& param);
-        Matrix4x4 operator+(const Matrix4x4& param);
+        // NOTE: these are plain loops when evaluated at compile time and use the simd kernels
+        // at runtime, use MultiplyMany() for arrays of matrices
+        constexpr Matrix4x4 operator*(const Matrix4x4& param) const;
+        constexpr Matrix4x4 operator+(const Matrix4x4& param) const;
 
         // returns a reference to a single element
         // in the matrix at a specific location
-        float& operator ()(size_t i, size_t j);
+        constexpr float& operator ()(size_t i, size_t j) { return mat[i][j]; }
+        constexpr float operator ()(size_t i, size_t j) const { return mat[i][j]; }
 
         // returns the identity matrix
-        static Matrix4x4 Identity();
+        static constexpr Matrix4x4 Identity() { return Matrix4x4(1.0f, 1.0f, 1.0f, 1.0f); }
 
     private:
+        // returns true when the call is evaluated at compile time
+        // NOTE: the builtin is available before C++20 on gcc 9, clang 9 and msvc 16.5 and up
+        static constexpr bool isConstantEvaluated() { return __builtin_is_constant_evaluated(); }
+
+        // the runtime paths of GetTranspose(), operator* and operator+, they call the simd kernels
+        // that were selected for the cpu
+        static void transposeKernel(const float* m, float* out);
+        static void multiplyKernel(const float* a, const float* b, float* out);
+        static void addKernel(const float* a, const float* b, float* out);
+
         float mat[4][4];
+
+        friend void MultiplyMany(const Matrix4x4* a, const Matrix4x4* b, Matrix4x4* out, size_t count);
+        friend void InverseMany(const Matrix4x4* m, Matrix4x4* out, size_t count);
+        friend void AffineInverseMany(const Matrix4x4* m, Matrix4x4* out, size_t count);
     };
 
+    constexpr Matrix4x4 Matrix4x4::GetTranspose() const
+    {
+        Matrix4x4 temp;
+        if (!isConstantEvaluated())
+        {
+            transposeKernel(&mat[0][0], &temp.mat[0][0]);
+            return temp;
+        }
+        for (size_t i = 0; i < 4; i++)
+        {
+            for (size_t j = 0; j < 4; j++)
+            {
+                temp.mat[i][j] = mat[j][i];
+            }
+        }
+        return temp;
+    }
+
+    constexpr Matrix4x4 Matrix4x4::operator *(const Matrix4x4& param) const
+    {
+        Matrix4x4 temp;
+        if (!isConstantEvaluated())
+        {
+            multiplyKernel(&mat[0][0], &param.mat[0][0], &temp.mat[0][0]);
+            return temp;
+        }
+        for (size_t i = 0; i < 4; i++)
+        {
+            for (size_t j = 0; j < 4; j++)
+            {
+                temp.mat[i][j] =
+                    mat[i][0] * param.mat[0][j] +
+                    mat[i][1] * param.mat[1][j] +
+                    mat[i][2] * param.mat[2][j] +
+                    mat[i][3] * param.mat[3][j];
+            }
+        }
+        return temp;
+    }
+
+    constexpr Matrix4x4 Matrix4x4::operator +(const Matrix4x4& param) const
+    {
+        Matrix4x4 temp;
+        if (!isConstantEvaluated())
+        {
+            addKernel(&mat[0][0], &param.mat[0][0], &temp.mat[0][0]);
+            return temp;
+        }
+        for (size_t i = 0; i < 4; i++)
+        {
+            for (size_t j = 0; j < 4; j++)
+            {
+                temp.mat[i][j] = mat[i][j] + param.mat[i][j];
+            }
+        }
+        return temp;
+    }
+
     // alias
     using mat4f = Matrix4x4;
+
+    // multiplies 'count' pairs of matrices, out[i] = a[i] * b[i]
+    // NOTE: this is much faster than calling operator* in a loop for large arrays
+    // NOTE: 'out' is allowed to be the same array as 'a' or 'b'
+    void MultiplyMany(const mat4f* a, const mat4f* b, mat4f* out, size_t count);
+
+    // inverts 'count' matrices, out[i] = inverse(m[i])
+    // NOTE: 'out' is allowed to be the same array as 'm'
+    void InverseMany(const mat4f* m, mat4f* out, size_t count);
+
+    // inverts 'count' affine matrices, out[i] = affine_inverse(m[i]), see Matrix4x4::GetAffineInverse()
+    // NOTE: 'out' is allowed to be the same array as 'm'
+    void AffineInverseMany(const mat4f* m, mat4f* out, size_t count);
 }
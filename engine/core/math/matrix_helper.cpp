@@ -1,37 +1,11 @@
 #include "matrix_helper.h"
 #include "scalar.h"
+#include "scalar_wide.h"
+#include "engine/core/cpu.h"
+#include "engine/core/simd.h"
+using namespace deadrop;
 using namespace deadrop::math;
 
-mat4f deadrop::math::ComposeOrthoOffCenterLH(
-    float left, float right,
-    float bottom, float top,
-    float nearZ, float farZ)
-{
-    mat4f orthoLH =
-    {
-        2.0f / (right - left), 0.0f, 0.0f, 0.0f,
-        0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
-        0.0, 0.0, 1.0f / (nearZ - farZ), 0.0f,
-        (left + right) / (left - right), (top + bottom) / (bottom - top), nearZ / (nearZ - farZ), 1.0f
-    };
-    return orthoLH;
-}
-
-mat4f deadrop::math::ComposeOrthoLH(
-    float viewWidth, float viewHeight,
-    float nearZ, float farZ)
-{
-    float fRange = 1.0f / (farZ / nearZ);
-    mat4f orthoLH =
-    {
-        2.0f / viewWidth, 0.0f, 0.0f, 0.0f,
-        0.0f, 2.0f / viewHeight, 0.0f, 0.0f,
-        0.0f, 0.0f, fRange, 0.0f,
-        0.0f, 0.0f, -fRange * nearZ, 1.0f
-    };
-    return orthoLH;
-}
-
 mat4f deadrop::math::ComposeLookAtLH(vec3f eye, vec3f at, vec3f up)
 {
     vec3f zaxis = Normalize(at - eye);
@@ -48,45 +22,122 @@ mat4f deadrop::math::ComposeLookAtLH(vec3f eye, vec3f at, vec3f up)
     };
 }
 
-mat4f deadrop::math::ComposeProjectionFovLH(
-    float fovAngleY,
-    float aspectRatio,
-    float nearZ, float farZ)
+namespace
 {
-    float sinFov = Sin(0.5f * fovAngleY);
-    float cosFov = Cos(0.5f * fovAngleY);
+    // composes four matrices starting at 'i', each register holds one element of four matrices
+    // and the results are transposed back into rows before storing them
+    inline void composeTRS4SSE2(const TRSArrays& trs, size_t i, mat4f* out)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+
+        const __m128 x = _mm_loadu_ps(trs.rx + i);
+        const __m128 y = _mm_loadu_ps(trs.ry + i);
+        const __m128 z = _mm_loadu_ps(trs.rz + i);
+        const __m128 w = _mm_loadu_ps(trs.rw + i);
+        const __m128 sx = _mm_loadu_ps(trs.sx + i);
+        const __m128 sy = _mm_loadu_ps(trs.sy + i);
+        const __m128 sz = _mm_loadu_ps(trs.sz + i);
 
-    float height = cosFov / sinFov;
-    float width = height / aspectRatio;
-    float range = farZ / (farZ - nearZ);
+        const __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+        const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+        const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
 
-    mat4f projectionFovLH =
+        // rows of the rotation matrices scaled by the scale components
+        __m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+        __m128 m01 = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+        __m128 m02 = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+        __m128 m10 = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+        __m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+        __m128 m12 = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+        __m128 m20 = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+        __m128 m21 = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+        __m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+        __m128 m30 = _mm_loadu_ps(trs.tx + i);
+        __m128 m31 = _mm_loadu_ps(trs.ty + i);
+        __m128 m32 = _mm_loadu_ps(trs.tz + i);
+
+        // the last column is (0, 0, 0, 1)
+        __m128 zero0 = _mm_setzero_ps(), zero1 = _mm_setzero_ps(), zero2 = _mm_setzero_ps();
+        __m128 one3 = one;
+
+        // after the transpose, each register holds the row of a single matrix
+        _MM_TRANSPOSE4_PS(m00, m01, m02, zero0);
+        _MM_TRANSPOSE4_PS(m10, m11, m12, zero1);
+        _MM_TRANSPOSE4_PS(m20, m21, m22, zero2);
+        _MM_TRANSPOSE4_PS(m30, m31, m32, one3);
+
+        const __m128 rows[4][4] =
+        {
+            { m00, m10, m20, m30 },
+            { m01, m11, m21, m31 },
+            { m02, m12, m22, m32 },
+            { zero0, zero1, zero2, one3 },
+        };
+        for (size_t k = 0; k < 4; k++)
+        {
+            float* dst = &out[i + k](0, 0);
+            _mm_store_ps(dst + 0, rows[k][0]);
+            _mm_store_ps(dst + 4, rows[k][1]);
+            _mm_store_ps(dst + 8, rows[k][2]);
+            _mm_store_ps(dst + 12, rows[k][3]);
+        }
+    }
+}
+
+void deadrop::math::ComposeTRSMany(const TRSArrays& trs, mat4f* out, size_t count)
+{
+    size_t i = 0;
+    if (GetCpuFeatures().sse2)
     {
-        width, 0.0f, 0.0f, 0.0f,
-        0.0f, height, 0.0f, 0.0f,
-        0.0f, 0.0f, range, 1.0f,
-        0.0f, 0.0f, -range * nearZ, 0.0f
-    };
-    return projectionFovLH;
+        for (; i + 4 <= count; i += 4)
+        {
+            composeTRS4SSE2(trs, i, out);
+        }
+    }
+
+    // compose the remaining matrices one by one
+    for (; i < count; i++)
+    {
+        out[i] = ComposeTRS(
+            vec3f{ trs.tx[i], trs.ty[i], trs.tz[i] },
+            quatf{ trs.rx[i], trs.ry[i], trs.rz[i], trs.rw[i] },
+            vec3f{ trs.sx[i], trs.sy[i], trs.sz[i] });
+    }
 }
 
-mat4f deadrop::math::ComposeInfiniteProjectionFovLH(
-    float fovAngleY,
-    float aspectRatio,
-    float nearZ)
+void deadrop::math::QuatFromEulerMany(
+    const float* pitch, const float* yaw, const float* roll,
+    float* rx, float* ry, float* rz, float* rw, size_t count)
 {
-    float sinFov = Sin(0.5f * fovAngleY);
-    float cosFov = Cos(0.5f * fovAngleY);
+    size_t i = 0;
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 sp, cp, sy, cy, sr, cr;
+        SinCos(_mm_mul_ps(_mm_loadu_ps(pitch + i), half), sp, cp);
+        SinCos(_mm_mul_ps(_mm_loadu_ps(yaw + i), half), sy, cy);
+        SinCos(_mm_mul_ps(_mm_loadu_ps(roll + i), half), sr, cr);
 
-    float height = cosFov / sinFov;
-    float width = height / aspectRatio;
+        // the same expanded product as QuatFromEuler()
+        const __m128 cy_cp = _mm_mul_ps(cy, cp);
+        const __m128 sy_sp = _mm_mul_ps(sy, sp);
+        const __m128 cy_sp = _mm_mul_ps(cy, sp);
+        const __m128 sy_cp = _mm_mul_ps(sy, cp);
+        _mm_storeu_ps(rx + i, _mm_add_ps(_mm_mul_ps(cy_sp, cr), _mm_mul_ps(sy_cp, sr)));
+        _mm_storeu_ps(ry + i, _mm_sub_ps(_mm_mul_ps(sy_cp, cr), _mm_mul_ps(cy_sp, sr)));
+        _mm_storeu_ps(rz + i, _mm_sub_ps(_mm_mul_ps(cy_cp, sr), _mm_mul_ps(sy_sp, cr)));
+        _mm_storeu_ps(rw + i, _mm_add_ps(_mm_mul_ps(cy_cp, cr), _mm_mul_ps(sy_sp, sr)));
+    }
 
-    mat4f infProjectionFovLH =
+    // the remainder
+    for (; i < count; i++)
     {
-        width, 0.0f, 0.0f, 0.0f,
-        0.0f, height, 0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f, 1.0f,
-        0.0f, 0.0f, -nearZ, 0.0f
-    };
-    return infProjectionFovLH;
+        const quatf q = QuatFromEuler(pitch[i], yaw[i], roll[i]);
+        rx[i] = q.x;
+        ry[i] = q.y;
+        rz[i] = q.z;
+        rw[i] = q.w;
+    }
 }
@@ -3,14 +3,17 @@
 
 namespace deadrop::math
 {
+    // NOTE: the projection builders are constexpr so fixed projections, like the one of the ui,
+    // can be built at compile time, see SinCos() for the range of fov angles that is constexpr
+
     // returns an ortographic projection matrix that is off center
-    mat4f ComposeOrthoOffCenterLH(
+    constexpr mat4f ComposeOrthoOffCenterLH(
         float left, float right,
         float bottom, float top,
         float nearZ, float farZ);
 
     // returns an ortographic projection matrix
-    mat4f ComposeOrthoLH(
+    constexpr mat4f ComposeOrthoLH(
         float viewWidth, float viewHeight,
         float nearZ, float farZ);
 
@@ -19,12 +22,134 @@ namespace deadrop::math
 
     // returns a left-handed projection matrix
     // based on the field-of-view and near and far clipping planes
-    mat4f ComposeProjectionFovLH(
+    constexpr mat4f ComposeProjectionFovLH(
         float fovAngleY, float aspectRatio,
         float nearZ, float farZ);
 
     // returns a left-handed infinite projection matrix
     // based on the field-of-view and just a near clipping plane
-    mat4f ComposeInfiniteProjectionFovLH(
+    constexpr mat4f ComposeInfiniteProjectionFovLH(
         float fovAngleY, float aspectRatio, float nearZ);
+
+    // returns a world matrix composed from translation, rotation and scale,
+    // the same as MatrixScale(s) * rotation matrix * MatrixTranslate(t) but without the multiplications
+    // NOTE: the rotation must be a unit quaternion
+    // NOTE: the returned matrix is row-major
+    constexpr mat4f ComposeTRS(vec3f translation, quatf rotation, vec3f scale);
+
+    // a view over translation, rotation and scale stored as a structure of arrays,
+    // each pointer points to an array of 'count' floats, used by ComposeTRSMany()
+    struct TRSArrays
+    {
+        const float* tx;
+        const float* ty;
+        const float* tz;
+        const float* rx;
+        const float* ry;
+        const float* rz;
+        const float* rw;
+        const float* sx;
+        const float* sy;
+        const float* sz;
+    };
+
+    // composes 'count' world matrices, out[i] = ComposeTRS(t[i], r[i], s[i])
+    // NOTE: the arrays are processed four at a time using simd instructions
+    void ComposeTRSMany(const TRSArrays& trs, mat4f* out, size_t count);
+
+    // computes 'count' rotations from euler angles in radians, (rx[i], ry[i], rz[i], rw[i]) =
+    // QuatFromEuler(pitch[i], yaw[i], roll[i]), the output can be used as the rotation of TRSArrays
+    // NOTE: the sines and cosines are computed four at a time with SinCos(__m128), see scalar_wide.h for the error
+    void QuatFromEulerMany(
+        const float* pitch, const float* yaw, const float* roll,
+        float* rx, float* ry, float* rz, float* rw, size_t count);
+
+    constexpr mat4f ComposeOrthoOffCenterLH(
+        float left, float right,
+        float bottom, float top,
+        float nearZ, float farZ)
+    {
+        mat4f orthoLH =
+        {
+            2.0f / (right - left), 0.0f, 0.0f, 0.0f,
+            0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
+            0.0, 0.0, 1.0f / (nearZ - farZ), 0.0f,
+            (left + right) / (left - right), (top + bottom) / (bottom - top), nearZ / (nearZ - farZ), 1.0f
+        };
+        return orthoLH;
+    }
+
+    constexpr mat4f ComposeOrthoLH(
+        float viewWidth, float viewHeight,
+        float nearZ, float farZ)
+    {
+        float fRange = 1.0f / (farZ / nearZ);
+        mat4f orthoLH =
+        {
+            2.0f / viewWidth, 0.0f, 0.0f, 0.0f,
+            0.0f, 2.0f / viewHeight, 0.0f, 0.0f,
+            0.0f, 0.0f, fRange, 0.0f,
+            0.0f, 0.0f, -fRange * nearZ, 1.0f
+        };
+        return orthoLH;
+    }
+
+    constexpr mat4f ComposeProjectionFovLH(
+        float fovAngleY,
+        float aspectRatio,
+        float nearZ, float farZ)
+    {
+        float sinFov = 0.0f, cosFov = 0.0f;
+        SinCos(0.5f * fovAngleY, sinFov, cosFov);
+
+        float height = cosFov / sinFov;
+        float width = height / aspectRatio;
+        float range = farZ / (farZ - nearZ);
+
+        mat4f projectionFovLH =
+        {
+            width, 0.0f, 0.0f, 0.0f,
+            0.0f, height, 0.0f, 0.0f,
+            0.0f, 0.0f, range, 1.0f,
+            0.0f, 0.0f, -range * nearZ, 0.0f
+        };
+        return projectionFovLH;
+    }
+
+    constexpr mat4f ComposeInfiniteProjectionFovLH(
+        float fovAngleY,
+        float aspectRatio,
+        float nearZ)
+    {
+        float sinFov = 0.0f, cosFov = 0.0f;
+        SinCos(0.5f * fovAngleY, sinFov, cosFov);
+
+        float height = cosFov / sinFov;
+        float width = height / aspectRatio;
+
+        mat4f infProjectionFovLH =
+        {
+            width, 0.0f, 0.0f, 0.0f,
+            0.0f, height, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 1.0f,
+            0.0f, 0.0f, -nearZ, 0.0f
+        };
+        return infProjectionFovLH;
+    }
+
+    constexpr mat4f ComposeTRS(vec3f translation, quatf rotation, vec3f scale)
+    {
+        const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+        const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+        const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+        // each row is a rotated axis scaled by its scale component
+        return mat4f
+        {
+            (1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f,
+            2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f,
+            2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f,
+            translation.x, translation.y, translation.z, 1.0f
+        };
+    }
 }
@@ -0,0 +1,263 @@
+#pragma once
+#include "engine/core/types.h"
+#include "scalar.h"
+#include "vec3.h"
+
+namespace deadrop::math
+{
+    // a quaternion that represents a rotation, (x, y, z) is the vector part and w is the scalar part
+    // NOTE: only unit quaternions represent rotations, use Normalize() after accumulating many operations
+    template<typename T>
+    class quat
+    {
+    public:
+        // constructors
+        quat() = default;
+        constexpr quat(T _x, T _y, T _z, T _w) : x(_x), y(_y), z(_z), w(_w) {}
+
+        // public vars
+        T x;
+        T y;
+        T z;
+        T w;
+
+        // returns the quaternion that represents no rotation
+        static constexpr quat Identity()
+        {
+            return quat{ 0, 0, 0, 1 };
+        }
+
+        // operators
+        // NOTE: (a * b) rotates by 'a' first then by 'b', which is the same order
+        // as multiplying the row-major matrices of the rotations
+        constexpr quat operator*(quat q) const
+        {
+            // hamilton product (q * this)
+            return quat
+            {
+                q.w * x + q.x * w + q.y * z - q.z * y,
+                q.w * y - q.x * z + q.y * w + q.z * x,
+                q.w * z + q.x * y - q.y * x + q.z * w,
+                q.w * w - q.x * x - q.y * y - q.z * z
+            };
+        }
+
+        constexpr quat operator*(T scalar) const
+        {
+            return quat
+            {
+                x * scalar,
+                y * scalar,
+                z * scalar,
+                w * scalar
+            };
+        }
+
+        constexpr quat operator+(quat q) const
+        {
+            return quat
+            {
+                x + q.x,
+                y + q.y,
+                z + q.z,
+                w + q.w
+            };
+        }
+
+        constexpr quat operator-(quat q) const
+        {
+            return quat
+            {
+                x - q.x,
+                y - q.y,
+                z - q.z,
+                w - q.w
+            };
+        }
+    };
+
+    // returns the dot product of two quaternions
+    // NOTE: for unit quaternions this is the cosine of half the angle between the rotations
+    template<class T>
+    constexpr T Dot(quat<T> q1, quat<T> q2)
+    {
+        return (q1.x * q2.x) + (q1.y * q2.y) + (q1.z * q2.z) + (q1.w * q2.w);
+    }
+
+    // returns the quaternion scaled to unit length
+    template<class T>
+    inline quat<T> Normalize(quat<T> q)
+    {
+        const T inv_length = static_cast<T>(1) / Sqrt(Dot(q, q));
+        return quat<T>
+        {
+            q.x * inv_length,
+            q.y * inv_length,
+            q.z * inv_length,
+            q.w * inv_length
+        };
+    }
+
+    // returns the conjugate of the quaternion, which is the inverse rotation of a unit quaternion
+    template<class T>
+    constexpr quat<T> Conjugate(quat<T> q)
+    {
+        return quat<T>
+        {
+            -q.x,
+            -q.y,
+            -q.z,
+            q.w
+        };
+    }
+
+    // returns the vector rotated by the quaternion
+    template<class T>
+    constexpr vec3<T> Rotate(vec3<T> vec, quat<T> q)
+    {
+        // v' = v + 2w(u x v) + 2u x (u x v), where u is the vector part of the quaternion
+        const vec3<T> u{ q.x, q.y, q.z };
+        const vec3<T> uv = Cross(u, vec);
+        const vec3<T> uuv = Cross(u, uv);
+        return vec3<T>
+        {
+            vec.x + static_cast<T>(2) * (q.w * uv.x + uuv.x),
+            vec.y + static_cast<T>(2) * (q.w * uv.y + uuv.y),
+            vec.z + static_cast<T>(2) * (q.w * uv.z + uuv.z)
+        };
+    }
+
+    // returns the normalized linear interpolation between two rotations, t is in the range [0, 1]
+    // NOTE: this is a lot cheaper than Slerp() and is accurate enough when the rotations are close,
+    // like the keys of an animation, but the angular speed is not constant
+    template<class T>
+    inline quat<T> Nlerp(quat<T> q1, quat<T> q2, T t)
+    {
+        // interpolate along the shortest path
+        const T sign = Dot(q1, q2) < static_cast<T>(0) ? static_cast<T>(-1) : static_cast<T>(1);
+        const T t1 = static_cast<T>(1) - t;
+        const T t2 = t * sign;
+        return Normalize(quat<T>
+        {
+            q1.x * t1 + q2.x * t2,
+            q1.y * t1 + q2.y * t2,
+            q1.z * t1 + q2.z * t2,
+            q1.w * t1 + q2.w * t2
+        });
+    }
+
+    // returns the spherical linear interpolation between two rotations, t is in the range [0, 1]
+    // NOTE: the angular speed is constant over t
+    template<class T>
+    inline quat<T> Slerp(quat<T> q1, quat<T> q2, T t)
+    {
+        // interpolate along the shortest path
+        T cos_theta = Dot(q1, q2);
+        T sign = static_cast<T>(1);
+        if (cos_theta < static_cast<T>(0))
+        {
+            cos_theta = -cos_theta;
+            sign = static_cast<T>(-1);
+        }
+
+        // NOTE: when the rotations are very close, sin(theta) approaches zero,
+        // so fall back to nlerp which gives the same result there
+        if (cos_theta > static_cast<T>(0.9995))
+        {
+            return Nlerp(q1, q2, t);
+        }
+
+        const T theta = ACos(cos_theta);
+        const T inv_sin_theta = static_cast<T>(1) / Sin(theta);
+        const T t1 = Sin((static_cast<T>(1) - t) * theta) * inv_sin_theta;
+        const T t2 = Sin(t * theta) * inv_sin_theta * sign;
+        return quat<T>
+        {
+            q1.x * t1 + q2.x * t2,
+            q1.y * t1 + q2.y * t2,
+            q1.z * t1 + q2.z * t2,
+            q1.w * t1 + q2.w * t2
+        };
+    }
+
+    // returns a quaternion that rotates around the axis, angle is in radians
+    // NOTE: the axis must be normalized
+    template<class T>
+    constexpr quat<T> QuatFromAxisAngle(vec3<T> axis, T angle)
+    {
+        T s{}, c{};
+        SinCos(static_cast<T>(0.5) * angle, s, c);
+        return quat<T>
+        {
+            axis.x * s,
+            axis.y * s,
+            axis.z * s,
+            c
+        };
+    }
+
+    // decomposes a unit quaternion into an axis and an angle in radians
+    // NOTE: when there is no rotation the axis is set to the x-axis
+    template<class T>
+    inline void QuatToAxisAngle(quat<T> q, vec3<T>& axis, T& angle)
+    {
+        // NOTE: atan2 of the vector length and w is more precise than acos(w) for small angles
+        const T s = Sqrt(q.x * q.x + q.y * q.y + q.z * q.z);
+        angle = static_cast<T>(2) * ATan2(s, q.w);
+        if (s < static_cast<T>(0.000001))
+        {
+            axis = vec3<T>{ 1, 0, 0 };
+            return;
+        }
+        axis = vec3<T>{ q.x / s, q.y / s, q.z / s };
+    }
+
+    // returns a quaternion from euler angles in radians, pitch is around the x-axis,
+    // yaw is around the y-axis and roll is around the z-axis
+    // NOTE: the rotations are applied in the order roll, pitch and then yaw, which is the same as
+    // Transform::MatrixRotateZ(roll) * Transform::MatrixRotateX(pitch) * Transform::MatrixRotateY(yaw)
+    template<class T>
+    constexpr quat<T> QuatFromEuler(T pitch, T yaw, T roll)
+    {
+        const T half = static_cast<T>(0.5);
+        T sp{}, cp{}, sy{}, cy{}, sr{}, cr{};
+        SinCos(pitch * half, sp, cp);
+        SinCos(yaw * half, sy, cy);
+        SinCos(roll * half, sr, cr);
+
+        // the expanded product of the three axis rotations
+        return quat<T>
+        {
+            cy * sp * cr + sy * cp * sr,
+            sy * cp * cr - cy * sp * sr,
+            cy * cp * sr - sy * sp * cr,
+            cy * cp * cr + sy * sp * sr
+        };
+    }
+
+    // returns the euler angles in radians of a unit quaternion as (pitch, yaw, roll),
+    // which are the rotations around the x, y and z axes, see QuatFromEuler() for the order
+    // NOTE: when the pitch is close to +/- 90 degrees, roll and yaw rotate around the same axis
+    // (gimbal lock), so roll is set to zero and all the rotation is given to yaw
+    template<class T>
+    inline vec3<T> QuatToEuler(quat<T> q)
+    {
+        const T one = static_cast<T>(1);
+        const T two = static_cast<T>(2);
+        const T sin_pitch = Clamp(two * (q.w * q.x - q.y * q.z), -one, one);
+        const T pitch = ASin(sin_pitch);
+
+        if (sin_pitch > static_cast<T>(0.99999) || sin_pitch < static_cast<T>(-0.99999))
+        {
+            const T yaw = ATan2(two * (q.w * q.y - q.x * q.z), one - two * (q.y * q.y + q.z * q.z));
+            return vec3<T>{ pitch, yaw, 0 };
+        }
+
+        const T yaw = ATan2(two * (q.x * q.z + q.w * q.y), one - two * (q.x * q.x + q.y * q.y));
+        const T roll = ATan2(two * (q.x * q.y + q.w * q.z), one - two * (q.x * q.x + q.z * q.z));
+        return vec3<T>{ pitch, yaw, roll };
+    }
+
+    // aliases
+    using quatf = math::quat<float>;
+}
@@ -0,0 +1,32 @@
+#include "ray.h"
+#include "scalar.h"
+using namespace deadrop::math;
+
+namespace
+{
+    // transforms the point [x, y, z, 1] by the matrix and divides by w
+    vec3f transformPoint(float x, float y, float z, const mat4f& m)
+    {
+        const float rx = x * m(0, 0) + y * m(1, 0) + z * m(2, 0) + m(3, 0);
+        const float ry = x * m(0, 1) + y * m(1, 1) + z * m(2, 1) + m(3, 1);
+        const float rz = x * m(0, 2) + y * m(1, 2) + z * m(2, 2) + m(3, 2);
+        const float rw = x * m(0, 3) + y * m(1, 3) + z * m(2, 3) + m(3, 3);
+        return vec3f{ rx / rw, ry / rw, rz / rw };
+    }
+}
+
+Ray deadrop::math::ComputePickRay(vec2f screen_position, vec2f screen_size, const mat4f& view_projection)
+{
+    // screen pixels to normalized device coordinates, the y-axis points up in ndc
+    const float ndc_x = (2.0f * screen_position.x / screen_size.x) - 1.0f;
+    const float ndc_y = 1.0f - (2.0f * screen_position.y / screen_size.y);
+
+    // unproject a point on the near plane and one further away along the same pixel
+    // NOTE: the second point is at half the depth range instead of the far plane since the
+    // far plane of an infinite projection (ComposeInfiniteProjectionFovLH) is at infinity
+    const mat4f inverse = view_projection.GetInverse();
+    const vec3f near_point = transformPoint(ndc_x, ndc_y, 0.0f, inverse);
+    vec3f far_point = transformPoint(ndc_x, ndc_y, 0.5f, inverse);
+
+    return Ray{ near_point, Normalize(far_point - near_point) };
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "vec2.h"
+#include "vec3.h"
+#include "matrix4x4.h"
+
+namespace deadrop::math
+{
+    // a ray that starts at 'origin' and goes along 'direction',
+    // the points on the ray are origin + direction * distance where distance >= 0
+    struct Ray
+    {
+        vec3f origin;
+        vec3f direction;
+    };
+
+    // returns the world space ray that goes through a point on the screen, like the mouse position returned by
+    // InputSystem::GetMousePosition(), the ray starts on the near plane and its direction is normalized
+    // NOTE: 'screen_position' is in pixels with (0, 0) at the top-left corner, 'screen_size' is the size of
+    // the viewport in pixels and 'view_projection' is the matrix that the scene is rendered with
+    Ray ComputePickRay(vec2f screen_position, vec2f screen_size, const mat4f& view_projection);
+}
@@ -0,0 +1,409 @@
+#include "ray_triangle.h"
+#include "engine/core/cpu.h"
+#include "engine/core/parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+using namespace deadrop;
+using namespace deadrop::math;
+
+namespace
+{
+    // the number of triangles that a single ray is tested against on one thread
+    constexpr u32 RANGE_SIZE = 16 * 1024;
+
+    // the number of ray packets that a worker claims at a time in RayCastTrianglesMany()
+    constexpr size_t PACKETS_PER_BATCH = 4;
+
+    // reads the vertex indices of a triangle
+    inline void loadIndices(const TriangleMeshView& mesh, u32 triangle, u32 (&indices)[3])
+    {
+        if (!mesh.indices)
+        {
+            indices[0] = triangle * 3;
+            indices[1] = triangle * 3 + 1;
+            indices[2] = triangle * 3 + 2;
+        }
+        else if (mesh.index_stride == sizeof(u16))
+        {
+            const u16* src = static_cast<const u16*>(mesh.indices) + triangle * 3;
+            indices[0] = src[0];
+            indices[1] = src[1];
+            indices[2] = src[2];
+        }
+        else
+        {
+            const u32* src = static_cast<const u32*>(mesh.indices) + triangle * 3;
+            indices[0] = src[0];
+            indices[1] = src[1];
+            indices[2] = src[2];
+        }
+    }
+
+    // returns the position of a vertex
+    inline const u8* getPosition(const TriangleMeshView& mesh, u32 vertex)
+    {
+        return static_cast<const u8*>(mesh.vertices) + mesh.position_offset + static_cast<size_t>(vertex) * mesh.vertex_stride;
+    }
+
+    // reads the corners of a triangle from the mesh
+    inline void loadTriangle(const TriangleMeshView& mesh, u32 triangle, vec3f& v0, vec3f& v1, vec3f& v2)
+    {
+        // NOTE: the positions are copied since the stride does not guarantee any alignment
+        u32 indices[3];
+        loadIndices(mesh, triangle, indices);
+        memcpy(&v0, getPosition(mesh, indices[0]), sizeof(vec3f));
+        memcpy(&v1, getPosition(mesh, indices[1]), sizeof(vec3f));
+        memcpy(&v2, getPosition(mesh, indices[2]), sizeof(vec3f));
+    }
+
+    // loads a position as (x, y, z, 0), without reading past the 12 bytes of the position
+    inline __m128 loadPosition(const u8* position)
+    {
+        const __m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(position)));
+        const __m128 z = _mm_load_ss(reinterpret_cast<const float*>(position + 8));
+        return _mm_movelh_ps(xy, z);
+    }
+
+    // loads the corners of 4 triangles into the lanes of the wide vectors
+    // NOTE: the caller repeats the last triangle of the range to fill a packet, the copies are
+    // hit at the same distance as the original so they do not change the result
+    inline void loadTriangles4(const TriangleMeshView& mesh, const u32 (&triangles)[4], vec3x4 (&corners)[3])
+    {
+        u32 indices[4][3];
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            loadIndices(mesh, triangles[lane], indices[lane]);
+        }
+
+        // transpose the positions into structure-of-arrays form, the fourth row is the unused w
+        for (size_t c = 0; c < 3; c++)
+        {
+            __m128 p0 = loadPosition(getPosition(mesh, indices[0][c]));
+            __m128 p1 = loadPosition(getPosition(mesh, indices[1][c]));
+            __m128 p2 = loadPosition(getPosition(mesh, indices[2][c]));
+            __m128 p3 = loadPosition(getPosition(mesh, indices[3][c]));
+            _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+            corners[c] = vec3x4{ p0, p1, p2 };
+        }
+    }
+
+    // the 8-wide version of loadTriangles4()
+    // NOTE: this is a separate function instead of two calls to loadTriangles4() since calling
+    // sse code from avx code that is not inlined is very slow on some cpus (avx-sse transitions)
+    SIMD_TARGET_AVX inline void loadTriangles8(const TriangleMeshView& mesh, const u32 (&triangles)[8], vec3x8 (&corners)[3])
+    {
+        u32 indices[8][3];
+        for (size_t lane = 0; lane < 8; lane++)
+        {
+            loadIndices(mesh, triangles[lane], indices[lane]);
+        }
+
+        for (size_t c = 0; c < 3; c++)
+        {
+            __m128 p0 = loadPosition(getPosition(mesh, indices[0][c]));
+            __m128 p1 = loadPosition(getPosition(mesh, indices[1][c]));
+            __m128 p2 = loadPosition(getPosition(mesh, indices[2][c]));
+            __m128 p3 = loadPosition(getPosition(mesh, indices[3][c]));
+            __m128 p4 = loadPosition(getPosition(mesh, indices[4][c]));
+            __m128 p5 = loadPosition(getPosition(mesh, indices[5][c]));
+            __m128 p6 = loadPosition(getPosition(mesh, indices[6][c]));
+            __m128 p7 = loadPosition(getPosition(mesh, indices[7][c]));
+            _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+            _MM_TRANSPOSE4_PS(p4, p5, p6, p7);
+            corners[c] = vec3x8
+            {
+                _mm256_insertf128_ps(_mm256_castps128_ps256(p0), p4, 1),
+                _mm256_insertf128_ps(_mm256_castps128_ps256(p1), p5, 1),
+                _mm256_insertf128_ps(_mm256_castps128_ps256(p2), p6, 1)
+            };
+        }
+    }
+
+    // returns true when 'hit' is closer than 'best', equal distances keep the smaller triangle index
+    // so the result does not depend on how the triangles were split between lanes and threads
+    inline bool isCloser(const TriangleHit& hit, const TriangleHit& best)
+    {
+        return hit.distance < best.distance || (hit.distance == best.distance && hit.triangle < best.triangle);
+    }
+
+    // picks the closest of the hits that are stored in the lanes
+    template<size_t N>
+    TriangleHit reduceLanes(const float* distance, const float* u, const float* v, const u32* triangle, float max_distance)
+    {
+        TriangleHit best{ TriangleHit::INVALID_TRIANGLE, max_distance, 0.0f, 0.0f };
+        for (size_t lane = 0; lane < N; lane++)
+        {
+            const TriangleHit hit{ triangle[lane], distance[lane], u[lane], v[lane] };
+            if (hit.triangle != TriangleHit::INVALID_TRIANGLE && isCloser(hit, best))
+            {
+                best = hit;
+            }
+        }
+        return best;
+    }
+
+    // tests one ray against the triangles in [begin, end), 4 triangles at a time
+    TriangleHit rayCastRangeSSE2(const Ray& ray, const TriangleMeshView& mesh, u32 begin, u32 end, float max_distance)
+    {
+        const vec3x4 origin(ray.origin);
+        const vec3x4 direction(ray.direction);
+        __m128 distance = _mm_set1_ps(max_distance);
+        __m128 u = _mm_setzero_ps();
+        __m128 v = _mm_setzero_ps();
+        __m128i triangle = _mm_set1_epi32(-1);
+
+        for (u32 first = begin; first < end; first += 4)
+        {
+            u32 triangles[4];
+            for (u32 lane = 0; lane < 4; lane++)
+            {
+                triangles[lane] = std::min(first + lane, end - 1);
+            }
+            vec3x4 corners[3];
+            loadTriangles4(mesh, triangles, corners);
+            const vec3x4& v0 = corners[0];
+            const vec3x4 edge1 = corners[1] - v0;
+            const vec3x4 edge2 = corners[2] - v0;
+
+            const __m128i mask = _mm_castps_si128(IntersectRayTriangle(origin, direction, v0, edge1, edge2, distance, u, v));
+            const __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(triangles));
+            triangle = _mm_or_si128(_mm_and_si128(mask, indices), _mm_andnot_si128(mask, triangle));
+        }
+
+        alignas(16) float lane_distance[4], lane_u[4], lane_v[4];
+        alignas(16) u32 lane_triangle[4];
+        _mm_store_ps(lane_distance, distance);
+        _mm_store_ps(lane_u, u);
+        _mm_store_ps(lane_v, v);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lane_triangle), triangle);
+        return reduceLanes<4>(lane_distance, lane_u, lane_v, lane_triangle, max_distance);
+    }
+
+    // tests one ray against the triangles in [begin, end), 8 triangles at a time
+    SIMD_TARGET_AVX
+    TriangleHit rayCastRangeAVX(const Ray& ray, const TriangleMeshView& mesh, u32 begin, u32 end, float max_distance)
+    {
+        const vec3x8 origin(ray.origin);
+        const vec3x8 direction(ray.direction);
+        __m256 distance = _mm256_set1_ps(max_distance);
+        __m256 u = _mm256_setzero_ps();
+        __m256 v = _mm256_setzero_ps();
+        __m256 triangle = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (u32 first = begin; first < end; first += 8)
+        {
+            u32 triangles[8];
+            for (u32 lane = 0; lane < 8; lane++)
+            {
+                triangles[lane] = std::min(first + lane, end - 1);
+            }
+            vec3x8 corners[3];
+            loadTriangles8(mesh, triangles, corners);
+            const vec3x8& v0 = corners[0];
+            const vec3x8 edge1 = corners[1] - v0;
+            const vec3x8 edge2 = corners[2] - v0;
+
+            // NOTE: the indices are blended as floats since AVX has no 256-bit integer operations
+            const __m256 mask = IntersectRayTriangle(origin, direction, v0, edge1, edge2, distance, u, v);
+            const __m256 indices = _mm256_loadu_ps(reinterpret_cast<const float*>(triangles));
+            triangle = _mm256_blendv_ps(triangle, indices, mask);
+        }
+
+        alignas(32) float lane_distance[8], lane_u[8], lane_v[8];
+        alignas(32) u32 lane_triangle[8];
+        _mm256_store_ps(lane_distance, distance);
+        _mm256_store_ps(lane_u, u);
+        _mm256_store_ps(lane_v, v);
+        _mm256_store_ps(reinterpret_cast<float*>(lane_triangle), triangle);
+        return reduceLanes<8>(lane_distance, lane_u, lane_v, lane_triangle, max_distance);
+    }
+
+    TriangleHit rayCastRange(const Ray& ray, const TriangleMeshView& mesh, u32 begin, u32 end, float max_distance)
+    {
+        if (GetCpuFeatures().avx)
+        {
+            return rayCastRangeAVX(ray, mesh, begin, end, max_distance);
+        }
+        return rayCastRangeSSE2(ray, mesh, begin, end, max_distance);
+    }
+
+    // tests a packet of up to 4 rays starting at 'first' against all the triangles, one triangle at a time
+    void rayCastPacketSSE2(const Ray* rays, size_t first, size_t count, const TriangleMeshView& mesh, float max_distance, TriangleHit* hits)
+    {
+        // the lanes past the end repeat the last ray, their results are not stored
+        alignas(16) float ray_data[6][4];
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            const Ray& ray = rays[first + std::min(lane, count - 1)];
+            ray_data[0][lane] = ray.origin.x; ray_data[1][lane] = ray.origin.y; ray_data[2][lane] = ray.origin.z;
+            ray_data[3][lane] = ray.direction.x; ray_data[4][lane] = ray.direction.y; ray_data[5][lane] = ray.direction.z;
+        }
+        const vec3x4 origin{ _mm_load_ps(ray_data[0]), _mm_load_ps(ray_data[1]), _mm_load_ps(ray_data[2]) };
+        const vec3x4 direction{ _mm_load_ps(ray_data[3]), _mm_load_ps(ray_data[4]), _mm_load_ps(ray_data[5]) };
+
+        __m128 distance = _mm_set1_ps(max_distance);
+        __m128 u = _mm_setzero_ps();
+        __m128 v = _mm_setzero_ps();
+        __m128i triangle = _mm_set1_epi32(-1);
+
+        const u32 triangle_count = mesh.GetTriangleCount();
+        for (u32 t = 0; t < triangle_count; t++)
+        {
+            vec3f p0, p1, p2;
+            loadTriangle(mesh, t, p0, p1, p2);
+            const __m128i mask = _mm_castps_si128(IntersectRayTriangle(
+                origin, direction, vec3x4(p0), vec3x4(p1 - p0), vec3x4(p2 - p0), distance, u, v));
+            triangle = _mm_or_si128(_mm_and_si128(mask, _mm_set1_epi32(static_cast<int>(t))), _mm_andnot_si128(mask, triangle));
+        }
+
+        alignas(16) float lane_distance[4], lane_u[4], lane_v[4];
+        alignas(16) u32 lane_triangle[4];
+        _mm_store_ps(lane_distance, distance);
+        _mm_store_ps(lane_u, u);
+        _mm_store_ps(lane_v, v);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lane_triangle), triangle);
+        for (size_t lane = 0; lane < count; lane++)
+        {
+            hits[first + lane] = TriangleHit{ lane_triangle[lane], lane_distance[lane], lane_u[lane], lane_v[lane] };
+        }
+    }
+
+    // tests a packet of up to 8 rays starting at 'first' against all the triangles, one triangle at a time
+    SIMD_TARGET_AVX
+    void rayCastPacketAVX(const Ray* rays, size_t first, size_t count, const TriangleMeshView& mesh, float max_distance, TriangleHit* hits)
+    {
+        alignas(32) float ray_data[6][8];
+        for (size_t lane = 0; lane < 8; lane++)
+        {
+            const Ray& ray = rays[first + std::min(lane, count - 1)];
+            ray_data[0][lane] = ray.origin.x; ray_data[1][lane] = ray.origin.y; ray_data[2][lane] = ray.origin.z;
+            ray_data[3][lane] = ray.direction.x; ray_data[4][lane] = ray.direction.y; ray_data[5][lane] = ray.direction.z;
+        }
+        const vec3x8 origin{ _mm256_load_ps(ray_data[0]), _mm256_load_ps(ray_data[1]), _mm256_load_ps(ray_data[2]) };
+        const vec3x8 direction{ _mm256_load_ps(ray_data[3]), _mm256_load_ps(ray_data[4]), _mm256_load_ps(ray_data[5]) };
+
+        __m256 distance = _mm256_set1_ps(max_distance);
+        __m256 u = _mm256_setzero_ps();
+        __m256 v = _mm256_setzero_ps();
+        __m256 triangle = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        const u32 triangle_count = mesh.GetTriangleCount();
+        for (u32 t = 0; t < triangle_count; t++)
+        {
+            vec3f p0, p1, p2;
+            loadTriangle(mesh, t, p0, p1, p2);
+            const __m256 mask = IntersectRayTriangle(
+                origin, direction, vec3x8(p0), vec3x8(p1 - p0), vec3x8(p2 - p0), distance, u, v);
+            triangle = _mm256_blendv_ps(triangle, _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(t))), mask);
+        }
+
+        alignas(32) float lane_distance[8], lane_u[8], lane_v[8];
+        alignas(32) u32 lane_triangle[8];
+        _mm256_store_ps(lane_distance, distance);
+        _mm256_store_ps(lane_u, u);
+        _mm256_store_ps(lane_v, v);
+        _mm256_store_ps(reinterpret_cast<float*>(lane_triangle), triangle);
+        for (size_t lane = 0; lane < count; lane++)
+        {
+            hits[first + lane] = TriangleHit{ lane_triangle[lane], lane_distance[lane], lane_u[lane], lane_v[lane] };
+        }
+    }
+}
+
+bool deadrop::math::IntersectRayTriangle(const Ray& ray, const vec3f& v0, const vec3f& v1, const vec3f& v2, float& distance, float& u, float& v)
+{
+    // NOTE: the operations are in the same order as the simd versions so all of them give the same results
+    const vec3f edge1 = v1 - v0;
+    const vec3f edge2 = v2 - v0;
+
+    // the determinant is zero when the ray is parallel to the plane of the triangle
+    const vec3f p = Cross(ray.direction, edge2);
+    const float det = Dot(edge1, p);
+    if (det == 0.0f)
+    {
+        return false;
+    }
+    const float inv_det = 1.0f / det;
+
+    // NOTE: the tests are written so that nans fail them, the same as the simd comparisons
+    const vec3f s = ray.origin - v0;
+    const float hit_u = Dot(s, p) * inv_det;
+    if (!(hit_u >= 0.0f))
+    {
+        return false;
+    }
+    const vec3f q = Cross(s, edge1);
+    const float hit_v = Dot(ray.direction, q) * inv_det;
+    if (!(hit_v >= 0.0f && hit_u + hit_v <= 1.0f))
+    {
+        return false;
+    }
+    const float hit_distance = Dot(edge2, q) * inv_det;
+    if (!(hit_distance >= 0.0f && hit_distance < distance))
+    {
+        return false;
+    }
+
+    distance = hit_distance;
+    u = hit_u;
+    v = hit_v;
+    return true;
+}
+
+bool deadrop::math::IntersectRayTriangle(const Ray& ray, const TriangleMeshView& mesh, u32 triangle, float& distance, float& u, float& v)
+{
+    vec3f v0, v1, v2;
+    loadTriangle(mesh, triangle, v0, v1, v2);
+    return IntersectRayTriangle(ray, v0, v1, v2, distance, u, v);
+}
+
+bool deadrop::math::RayCastTriangles(const Ray& ray, const TriangleMeshView& mesh, float max_distance, TriangleHit& hit)
+{
+    const u32 triangle_count = mesh.GetTriangleCount();
+    if (triangle_count <= RANGE_SIZE)
+    {
+        hit = rayCastRange(ray, mesh, 0, triangle_count, max_distance);
+        return hit.triangle != TriangleHit::INVALID_TRIANGLE;
+    }
+
+    // each range finds its own closest hit, then the closest of them is picked
+    const size_t range_count = (triangle_count + RANGE_SIZE - 1) / RANGE_SIZE;
+    std::vector<TriangleHit> range_hits(range_count);
+    ParallelFor(triangle_count, RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        range_hits[begin / RANGE_SIZE] = rayCastRange(ray, mesh, static_cast<u32>(begin), static_cast<u32>(end), max_distance);
+    });
+
+    hit = TriangleHit{ TriangleHit::INVALID_TRIANGLE, max_distance, 0.0f, 0.0f };
+    for (const TriangleHit& range_hit : range_hits)
+    {
+        if (range_hit.triangle != TriangleHit::INVALID_TRIANGLE && isCloser(range_hit, hit))
+        {
+            hit = range_hit;
+        }
+    }
+    return hit.triangle != TriangleHit::INVALID_TRIANGLE;
+}
+
+void deadrop::math::RayCastTrianglesMany(const Ray* rays, size_t count, const TriangleMeshView& mesh, float max_distance, TriangleHit* hits)
+{
+    const size_t packet_size = GetCpuFeatures().avx ? 8 : 4;
+    const size_t packet_count = (count + packet_size - 1) / packet_size;
+    ParallelFor(packet_count, PACKETS_PER_BATCH, [&](size_t begin, size_t end)
+    {
+        for (size_t packet = begin; packet < end; packet++)
+        {
+            const size_t first = packet * packet_size;
+            const size_t packet_rays = std::min(packet_size, count - first);
+            if (packet_size == 8)
+            {
+                rayCastPacketAVX(rays, first, packet_rays, mesh, max_distance, hits);
+            }
+            else
+            {
+                rayCastPacketSSE2(rays, first, packet_rays, mesh, max_distance, hits);
+            }
+        }
+    });
+}
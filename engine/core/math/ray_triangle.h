@@ -0,0 +1,132 @@
+#pragma once
+#include "engine/core/types.h"
+#include "engine/core/simd.h"
+#include "ray.h"
+#include "vec3_wide.h"
+
+namespace deadrop::math
+{
+    // the closest hit of a ray against a set of triangles
+    struct TriangleHit
+    {
+        static constexpr u32 INVALID_TRIANGLE = 0xFFFFFFFF;
+
+        // the index of the triangle that was hit, INVALID_TRIANGLE when nothing was hit
+        u32 triangle;
+        // the distance along the ray to the hit, in units of the ray direction
+        float distance;
+        // the barycentric coordinates of the hit, the point is v0 * (1 - u - v) + v1 * u + v2 * v
+        float u;
+        float v;
+    };
+
+    // a view over the triangles of a mesh that is stored the same way as a vertex buffer and an optional
+    // index buffer, 'count' elements of 'stride' bytes each like render::BufferDesc describes them
+    // NOTE: the position of a vertex is 3 floats at 'position_offset' bytes from the start of the vertex,
+    // the indices are either 16 or 32-bit and when 'indices' is null each 3 vertices make a triangle
+    // NOTE: the indices are not validated, they must all be smaller than 'vertex_count'
+    struct TriangleMeshView
+    {
+        const void* vertices = nullptr;
+        u32 vertex_count = 0;
+        u32 vertex_stride = sizeof(vec3f);
+        u32 position_offset = 0;
+        const void* indices = nullptr;
+        u32 index_count = 0;
+        u32 index_stride = sizeof(u32);
+
+        // returns the number of triangles in the mesh
+        u32 GetTriangleCount() const { return (indices ? index_count : vertex_count) / 3; }
+    };
+
+    // tests a ray against a triangle using the moller-trumbore algorithm, both sides of the triangle are hit,
+    // returns true and updates 'distance', 'u' and 'v' only when the triangle is hit closer than the value
+    // 'distance' holds, see TriangleHit for the meaning of 'u' and 'v'
+    // NOTE: the test is not watertight, a ray that goes exactly through a shared edge can miss both triangles
+    bool IntersectRayTriangle(const Ray& ray, const vec3f& v0, const vec3f& v1, const vec3f& v2, float& distance, float& u, float& v);
+
+    // the same as above for a triangle of a mesh, it can be used to implement a RayPrimitiveFunc
+    // for a BVH that was built over the boxes of the triangles
+    bool IntersectRayTriangle(const Ray& ray, const TriangleMeshView& mesh, u32 triangle, float& distance, float& u, float& v);
+
+    // tests 4 rays against 4 triangles, lane by lane, 'edge1' is v1 - v0 and 'edge2' is v2 - v0,
+    // lanes are updated like IntersectRayTriangle() does and the returned mask has the lanes that were updated
+    // NOTE: set all the lanes of the ray to the same ray to test one ray against 4 triangles,
+    // or all the lanes of the triangle to the same triangle to test a packet of rays against one triangle
+    inline __m128 IntersectRayTriangle(
+        const vec3x4& origin, const vec3x4& direction,
+        const vec3x4& v0, const vec3x4& edge1, const vec3x4& edge2,
+        __m128& distance, __m128& u, __m128& v)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        // the determinant is zero when the ray is parallel to the plane of the triangle
+        const vec3x4 p = Cross(direction, edge2);
+        const __m128 det = Dot(edge1, p);
+        const __m128 inv_det = _mm_div_ps(one, det);
+
+        const vec3x4 s = origin - v0;
+        const __m128 hit_u = _mm_mul_ps(Dot(s, p), inv_det);
+        const vec3x4 q = Cross(s, edge1);
+        const __m128 hit_v = _mm_mul_ps(Dot(direction, q), inv_det);
+        const __m128 hit_distance = _mm_mul_ps(Dot(edge2, q), inv_det);
+
+        __m128 mask = _mm_cmpneq_ps(det, zero);
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(hit_u, zero));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(hit_v, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(hit_u, hit_v), one));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(hit_distance, zero));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(hit_distance, distance));
+
+        distance = _mm_or_ps(_mm_and_ps(mask, hit_distance), _mm_andnot_ps(mask, distance));
+        u = _mm_or_ps(_mm_and_ps(mask, hit_u), _mm_andnot_ps(mask, u));
+        v = _mm_or_ps(_mm_and_ps(mask, hit_v), _mm_andnot_ps(mask, v));
+        return mask;
+    }
+
+    // the 8-wide version of IntersectRayTriangle(vec3x4), see it for the details
+    // NOTE: this needs AVX, the caller must be marked with SIMD_TARGET_AVX and check GetCpuFeatures().avx
+    SIMD_TARGET_AVX inline __m256 IntersectRayTriangle(
+        const vec3x8& origin, const vec3x8& direction,
+        const vec3x8& v0, const vec3x8& edge1, const vec3x8& edge2,
+        __m256& distance, __m256& u, __m256& v)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        const vec3x8 p = Cross(direction, edge2);
+        const __m256 det = Dot(edge1, p);
+        const __m256 inv_det = _mm256_div_ps(one, det);
+
+        const vec3x8 s = origin - v0;
+        const __m256 hit_u = _mm256_mul_ps(Dot(s, p), inv_det);
+        const vec3x8 q = Cross(s, edge1);
+        const __m256 hit_v = _mm256_mul_ps(Dot(direction, q), inv_det);
+        const __m256 hit_distance = _mm256_mul_ps(Dot(edge2, q), inv_det);
+
+        __m256 mask = _mm256_cmp_ps(det, zero, _CMP_NEQ_UQ);
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(hit_u, zero, _CMP_GE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(hit_v, zero, _CMP_GE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(hit_u, hit_v), one, _CMP_LE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(hit_distance, zero, _CMP_GE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(hit_distance, distance, _CMP_LT_OQ));
+
+        distance = _mm256_blendv_ps(distance, hit_distance, mask);
+        u = _mm256_blendv_ps(u, hit_u, mask);
+        v = _mm256_blendv_ps(v, hit_v, mask);
+        return mask;
+    }
+
+    // finds the closest triangle of a mesh that the ray hits closer than 'max_distance', returns true
+    // and stores it in 'hit' when there is one, the triangles are tested 8 or 4 at a time
+    // NOTE: large meshes are split between the worker threads, see ParallelFor()
+    bool RayCastTriangles(const Ray& ray, const TriangleMeshView& mesh, float max_distance, TriangleHit& hit);
+
+    // finds the closest hit of 'count' rays against all the triangles of a mesh and stores them in 'hits',
+    // each triangle is tested against a packet of 8 or 4 rays at a time and the packets are split between
+    // the worker threads, rays that hit nothing get TriangleHit::INVALID_TRIANGLE
+    // NOTE: every ray is tested against every triangle, for large meshes build a BVH over the triangles
+    // and use IntersectRayTriangle() as its RayPrimitiveFunc instead
+    void RayCastTrianglesMany(const Ray* rays, size_t count, const TriangleMeshView& mesh, float max_distance, TriangleHit* hits);
+}
@@ -65,4 +65,123 @@ namespace deadrop::math
     {
         return tanf(x);
     }
+
+    // computes the sine and the cosine of x at the same time
+    template<class T>
+    inline void SinCos(T x, T& sin_x, T& cos_x)
+    {
+        sin_x = Sin(x);
+        cos_x = Cos(x);
+    }
+
+    // computes the sine and the cosine of x at the same time
+    // NOTE: this is a float type specialization that evaluates a polynomial approximation for both
+    // instead of calling libm twice, the max absolute error is 1e-7 for |x| <= 8192, larger
+    // angles fall back to libm, see scalar_wide.h for the 4-wide and 8-wide versions
+    // NOTE: it is constexpr for |x| <= 8192, so rotations and projections can be built at compile time
+    template<>
+    constexpr void SinCos(float x, float& sin_x, float& cos_x)
+    {
+        const float abs_x = x < 0.0f ? -x : x;
+        if (abs_x > 8192.0f)
+        {
+            sin_x = sinf(x);
+            cos_x = cosf(x);
+            return;
+        }
+
+        // reduce the angle to [-PI/4, PI/4] around the closest even multiple 'j' of PI/4,
+        // PI/4 is split in three parts so the reduction is exact enough in float
+        int j = static_cast<int>(abs_x * 1.27323954473516f);
+        j = (j + 1) & ~1;
+        const float y = static_cast<float>(j);
+        const float r = ((abs_x - y * 0.78515625f) - y * 2.4187564849853515625e-4f) - y * 3.77489497744594108e-8f;
+
+        // minimax polynomials of cos and sin on [-PI/4, PI/4]
+        const float z = r * r;
+        const float cos_r = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+        const float sin_r = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+
+        // the octant selects which polynomial is the sine and which is the cosine and their signs
+        const bool swap = (j & 2) != 0;
+        float s = swap ? cos_r : sin_r;
+        float c = swap ? sin_r : cos_r;
+        if (((j & 4) != 0) != (x < 0.0f))
+        {
+            s = -s;
+        }
+        if (((j - 2) & 4) == 0)
+        {
+            c = -c;
+        }
+        sin_x = s;
+        cos_x = c;
+    }
+
+    // returns the arc sine of x, in radians
+    template<class T>
+    inline T ASin(T x)
+    {
+        return static_cast<T>(asin(x));
+    }
+
+    // returns the arc sine of x, in radians
+    // NOTE: this is a float type specialization
+    template<>
+    inline float ASin(float x)
+    {
+        return asinf(x);
+    }
+
+    // returns the arc cosine of x, in radians
+    template<class T>
+    inline T ACos(T x)
+    {
+        return static_cast<T>(acos(x));
+    }
+
+    // returns the arc cosine of x, in radians
+    // NOTE: this is a float type specialization
+    template<>
+    inline float ACos(float x)
+    {
+        return acosf(x);
+    }
+
+    // returns the arc tangent of y/x, in radians, using the signs of both to determine the quadrant
+    template<class T>
+    inline T ATan2(T y, T x)
+    {
+        return static_cast<T>(atan2(y, x));
+    }
+
+    // returns the arc tangent of y/x, in radians, using the signs of both to determine the quadrant
+    // NOTE: this is a float type specialization
+    template<>
+    inline float ATan2(float y, float x)
+    {
+        return atan2f(y, x);
+    }
+
+    // returns the square root of x
+    template<class T>
+    inline T Sqrt(T x)
+    {
+        return static_cast<T>(sqrt(x));
+    }
+
+    // returns the square root of x
+    // NOTE: this is a float type specialization
+    template<>
+    inline float Sqrt(float x)
+    {
+        return sqrtf(x);
+    }
+
+    // returns x limited to the range [min, max]
+    template<class T>
+    constexpr T Clamp(T x, T min, T max)
+    {
+        return x < min ? min : (x > max ? max : x);
+    }
 }
@@ -0,0 +1,50 @@
+#include "scalar_wide.h"
+#include "engine/core/cpu.h"
+using namespace deadrop;
+using namespace deadrop::math;
+
+namespace
+{
+    size_t sinCosManySSE2(const float* x, float* sin_x, float* cos_x, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 s, c;
+            SinCos(_mm_loadu_ps(x + i), s, c);
+            _mm_storeu_ps(sin_x + i, s);
+            _mm_storeu_ps(cos_x + i, c);
+        }
+        return i;
+    }
+
+    SIMD_TARGET_AVX2
+    size_t sinCosManyAVX2(const float* x, float* sin_x, float* cos_x, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 s, c;
+            SinCos(_mm256_loadu_ps(x + i), s, c);
+            _mm256_storeu_ps(sin_x + i, s);
+            _mm256_storeu_ps(cos_x + i, c);
+        }
+        return i;
+    }
+}
+
+void deadrop::math::SinCosMany(const float* x, float* sin_x, float* cos_x, size_t count)
+{
+    size_t i = 0;
+    if (GetCpuFeatures().avx2)
+    {
+        i = sinCosManyAVX2(x, sin_x, cos_x, count);
+    }
+    i += sinCosManySSE2(x + i, sin_x + i, cos_x + i, count - i);
+
+    // the remainder
+    for (; i < count; i++)
+    {
+        SinCos(x[i], sin_x[i], cos_x[i]);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "engine/core/simd.h"
+#include "scalar.h"
+
+namespace deadrop::math
+{
+    // computes the sine and the cosine of 4 angles at the same time
+    // NOTE: this uses the same polynomial approximation as SinCos(float), the max absolute error
+    // is 1e-7 for |x| <= 8192, unlike the scalar version there is no fallback for larger angles
+    inline void SinCos(__m128 x, __m128& sin_x, __m128& cos_x)
+    {
+        const __m128 sign_mask = _mm_set1_ps(-0.0f);
+        const __m128 abs_x = _mm_andnot_ps(sign_mask, x);
+
+        // reduce the angle to [-PI/4, PI/4] around the closest even multiple 'j' of PI/4
+        __m128i j = _mm_cvttps_epi32(_mm_mul_ps(abs_x, _mm_set1_ps(1.27323954473516f)));
+        j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+        const __m128 y = _mm_cvtepi32_ps(j);
+        __m128 r = _mm_sub_ps(abs_x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+        r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+        r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+
+        // minimax polynomials of cos and sin on [-PI/4, PI/4]
+        const __m128 z = _mm_mul_ps(r, r);
+        __m128 cos_r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z), _mm_set1_ps(-1.388731625493765e-3f));
+        cos_r = _mm_add_ps(_mm_mul_ps(cos_r, z), _mm_set1_ps(4.166664568298827e-2f));
+        cos_r = _mm_mul_ps(_mm_mul_ps(cos_r, z), z);
+        cos_r = _mm_add_ps(_mm_sub_ps(cos_r, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+        __m128 sin_r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z), _mm_set1_ps(8.3321608736e-3f));
+        sin_r = _mm_add_ps(_mm_mul_ps(sin_r, z), _mm_set1_ps(-1.6666654611e-1f));
+        sin_r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sin_r, z), r), r);
+
+        // the octant selects which polynomial is the sine and which is the cosine and their signs
+        const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+        const __m128 s = _mm_or_ps(_mm_and_ps(swap, cos_r), _mm_andnot_ps(swap, sin_r));
+        const __m128 c = _mm_or_ps(_mm_and_ps(swap, sin_r), _mm_andnot_ps(swap, cos_r));
+        const __m128 sin_sign = _mm_xor_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)), _mm_and_ps(x, sign_mask));
+        const __m128 cos_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+        sin_x = _mm_xor_ps(s, sin_sign);
+        cos_x = _mm_xor_ps(c, cos_sign);
+    }
+
+    // returns the sine of 4 angles, see SinCos(__m128)
+    inline __m128 Sin(__m128 x)
+    {
+        __m128 sin_x, cos_x;
+        SinCos(x, sin_x, cos_x);
+        return sin_x;
+    }
+
+    // returns the cosine of 4 angles, see SinCos(__m128)
+    inline __m128 Cos(__m128 x)
+    {
+        __m128 sin_x, cos_x;
+        SinCos(x, sin_x, cos_x);
+        return cos_x;
+    }
+
+    // computes the sine and the cosine of 8 angles at the same time, see SinCos(__m128) for the error
+    // NOTE: this needs AVX2, the caller must be marked with SIMD_TARGET_AVX2 and check GetCpuFeatures().avx2
+    SIMD_TARGET_AVX2 inline void SinCos(__m256 x, __m256& sin_x, __m256& cos_x)
+    {
+        const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+        const __m256 abs_x = _mm256_andnot_ps(sign_mask, x);
+
+        __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(abs_x, _mm256_set1_ps(1.27323954473516f)));
+        j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+        const __m256 y = _mm256_cvtepi32_ps(j);
+        __m256 r = _mm256_sub_ps(abs_x, _mm256_mul_ps(y, _mm256_set1_ps(0.78515625f)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(y, _mm256_set1_ps(2.4187564849853515625e-4f)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(y, _mm256_set1_ps(3.77489497744594108e-8f)));
+
+        const __m256 z = _mm256_mul_ps(r, r);
+        __m256 cos_r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(2.443315711809948e-5f), z), _mm256_set1_ps(-1.388731625493765e-3f));
+        cos_r = _mm256_add_ps(_mm256_mul_ps(cos_r, z), _mm256_set1_ps(4.166664568298827e-2f));
+        cos_r = _mm256_mul_ps(_mm256_mul_ps(cos_r, z), z);
+        cos_r = _mm256_add_ps(_mm256_sub_ps(cos_r, _mm256_mul_ps(_mm256_set1_ps(0.5f), z)), _mm256_set1_ps(1.0f));
+        __m256 sin_r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-1.9515295891e-4f), z), _mm256_set1_ps(8.3321608736e-3f));
+        sin_r = _mm256_add_ps(_mm256_mul_ps(sin_r, z), _mm256_set1_ps(-1.6666654611e-1f));
+        sin_r = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sin_r, z), r), r);
+
+        const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+        const __m256 s = _mm256_blendv_ps(sin_r, cos_r, swap);
+        const __m256 c = _mm256_blendv_ps(cos_r, sin_r, swap);
+        const __m256 sin_sign = _mm256_xor_ps(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29)), _mm256_and_ps(x, sign_mask));
+        const __m256 cos_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+        sin_x = _mm256_xor_ps(s, sin_sign);
+        cos_x = _mm256_xor_ps(c, cos_sign);
+    }
+
+    // computes the sine and the cosine of 'count' angles, sin_x[i] and cos_x[i] of x[i]
+    // NOTE: uses the widest SinCos() that the cpu supports, the max absolute error is the same as SinCos(float)
+    // for |x| <= 8192 but the last bit can differ since the 8-wide version may use fused multiply-adds
+    void SinCosMany(const float* x, float* sin_x, float* cos_x, size_t count);
+}
@@ -0,0 +1,279 @@
+#include "skinning.h"
+#include "vec3_wide.h"
+#include "engine/core/parallel.h"
+#include "engine/core/simd.h"
+#include <algorithm>
+using namespace deadrop;
+using namespace deadrop::math;
+
+namespace
+{
+    // the number of vertices that a worker thread skins at a time
+    constexpr size_t PARALLEL_RANGE_SIZE = 2048;
+
+    // loads 3 floats into the first 3 lanes, the last lane is zero
+    // NOTE: this never reads past the 12 bytes, the element can be the last one of a buffer
+    inline __m128 loadVec3(const void* src)
+    {
+        const u8* bytes = static_cast<const u8*>(src);
+        const __m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(bytes)));
+        const __m128 z = _mm_load_ss(reinterpret_cast<const float*>(bytes + 8));
+        return _mm_movelh_ps(xy, z);
+    }
+
+    // stores the first 3 lanes
+    inline void storeVec3(void* dst, __m128 value)
+    {
+        u8* bytes = static_cast<u8*>(dst);
+        _mm_storel_pi(reinterpret_cast<__m64*>(bytes), value);
+        _mm_store_ss(reinterpret_cast<float*>(bytes + 8), _mm_movehl_ps(value, value));
+    }
+
+    inline const void* getElement(const void* stream, u32 stride, size_t i)
+    {
+        return static_cast<const u8*>(stream) + i * stride;
+    }
+
+    inline void* getElement(void* stream, u32 stride, size_t i)
+    {
+        return static_cast<u8*>(stream) + i * stride;
+    }
+
+    // reads the bone indices and the weights of a vertex
+    inline __m128 loadInfluences(const SkinningStreams& streams, size_t i, u32 (&bones)[4])
+    {
+        const void* indices = getElement(streams.bone_indices, streams.bone_index_stride, i);
+        if (streams.bone_index_size == sizeof(u16))
+        {
+            const u16* src = static_cast<const u16*>(indices);
+            bones[0] = src[0];
+            bones[1] = src[1];
+            bones[2] = src[2];
+            bones[3] = src[3];
+        }
+        else
+        {
+            const u8* src = static_cast<const u8*>(indices);
+            bones[0] = src[0];
+            bones[1] = src[1];
+            bones[2] = src[2];
+            bones[3] = src[3];
+        }
+        return _mm_loadu_ps(static_cast<const float*>(getElement(streams.bone_weights, streams.bone_weight_stride, i)));
+    }
+
+    // returns the vector scaled to unit length, the last lane must be zero
+    inline __m128 normalize3(__m128 value)
+    {
+        __m128 length_sq = _mm_mul_ps(value, value);
+        length_sq = _mm_add_ps(length_sq, _mm_shuffle_ps(length_sq, length_sq, _MM_SHUFFLE(2, 3, 0, 1)));
+        length_sq = _mm_add_ps(length_sq, _mm_shuffle_ps(length_sq, length_sq, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_div_ps(value, _mm_sqrt_ps(length_sq));
+    }
+
+    // returns the 16 elements of a matrix, row by row
+    // NOTE: the elements are the only member of the matrix, so they start at its address
+    inline const float* getElements(const mat4f& matrix)
+    {
+        return reinterpret_cast<const float*>(&matrix);
+    }
+
+    // adds the first 'ROWS' rows of a bone matrix scaled by 'weight' to 'rows'
+    template <u32 ROWS>
+    inline void accumulateRows(__m128 (&rows)[ROWS], const float* matrix, __m128 weight)
+    {
+        for (u32 row = 0; row < ROWS; row++)
+        {
+            rows[row] = _mm_add_ps(rows[row], _mm_mul_ps(weight, _mm_loadu_ps(matrix + row * 4)));
+        }
+    }
+
+    void skinLinearBlendRange(const SkinningStreams& streams, const mat4f* palette, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            u32 bones[4];
+            const __m128 weights = loadInfluences(streams, i, bones);
+
+            // blend the rows of the matrices of the 4 bones, the rows of an affine matrix
+            // end with zero except for the translation which ends with the sum of the weights
+            __m128 rows[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+            accumulateRows<4>(rows, getElements(palette[bones[0]]), _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+            accumulateRows<4>(rows, getElements(palette[bones[1]]), _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1)));
+            accumulateRows<4>(rows, getElements(palette[bones[2]]), _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2)));
+            accumulateRows<4>(rows, getElements(palette[bones[3]]), _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3)));
+            const __m128 row0 = rows[0];
+            const __m128 row1 = rows[1];
+            const __m128 row2 = rows[2];
+            const __m128 row3 = rows[3];
+
+            const __m128 p = loadVec3(getElement(streams.positions, streams.position_stride, i));
+            __m128 skinned = _mm_add_ps(row3, _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0)), row0));
+            skinned = _mm_add_ps(skinned, _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+            skinned = _mm_add_ps(skinned, _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+            storeVec3(getElement(streams.skinned_positions, streams.skinned_position_stride, i), skinned);
+
+            if (streams.normals)
+            {
+                const __m128 n = loadVec3(getElement(streams.normals, streams.normal_stride, i));
+                __m128 normal = _mm_mul_ps(_mm_shuffle_ps(n, n, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+                normal = _mm_add_ps(normal, _mm_mul_ps(_mm_shuffle_ps(n, n, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+                normal = _mm_add_ps(normal, _mm_mul_ps(_mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+                storeVec3(getElement(streams.skinned_normals, streams.skinned_normal_stride, i), normalize3(normal));
+            }
+        }
+    }
+
+    // returns the 3 dot products of the rows with 'vec' in the first 3 lanes and zero in the last
+    inline __m128 transform3x4(__m128 row0, __m128 row1, __m128 row2, __m128 vec)
+    {
+        __m128 x = _mm_mul_ps(row0, vec);
+        __m128 y = _mm_mul_ps(row1, vec);
+        __m128 z = _mm_mul_ps(row2, vec);
+        __m128 w = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        return _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w));
+    }
+
+    void skinLinearBlendRange(const SkinningStreams& streams, const BoneMatrix3x4* palette, size_t begin, size_t end)
+    {
+        const __m128 one_w = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+        for (size_t i = begin; i < end; i++)
+        {
+            u32 bones[4];
+            const __m128 weights = loadInfluences(streams, i, bones);
+
+            __m128 rows[3] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+            accumulateRows<3>(rows, &palette[bones[0]].rows[0].x, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+            accumulateRows<3>(rows, &palette[bones[1]].rows[0].x, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1)));
+            accumulateRows<3>(rows, &palette[bones[2]].rows[0].x, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2)));
+            accumulateRows<3>(rows, &palette[bones[3]].rows[0].x, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3)));
+            const __m128 row0 = rows[0];
+            const __m128 row1 = rows[1];
+            const __m128 row2 = rows[2];
+
+            // the position has a w of one so the translation in the last column is added
+            const __m128 p = _mm_or_ps(loadVec3(getElement(streams.positions, streams.position_stride, i)), one_w);
+            storeVec3(getElement(streams.skinned_positions, streams.skinned_position_stride, i), transform3x4(row0, row1, row2, p));
+
+            if (streams.normals)
+            {
+                const __m128 n = loadVec3(getElement(streams.normals, streams.normal_stride, i));
+                const __m128 normal = transform3x4(row0, row1, row2, n);
+                storeVec3(getElement(streams.skinned_normals, streams.skinned_normal_stride, i), normalize3(normal));
+            }
+        }
+    }
+
+    // loads the vec3s of 4 vertices starting at 'first' into the lanes of a wide vector,
+    // the lanes past 'end' repeat the last vertex
+    inline vec3x4 loadVec3x4(const void* stream, u32 stride, size_t first, size_t end)
+    {
+        __m128 v0 = loadVec3(getElement(stream, stride, first));
+        __m128 v1 = loadVec3(getElement(stream, stride, std::min(first + 1, end - 1)));
+        __m128 v2 = loadVec3(getElement(stream, stride, std::min(first + 2, end - 1)));
+        __m128 v3 = loadVec3(getElement(stream, stride, std::min(first + 3, end - 1)));
+        _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+        return vec3x4{ v0, v1, v2 };
+    }
+
+    // stores the first 'count' lanes of a wide vector as vec3s starting at 'first'
+    inline void storeVec3x4(void* stream, u32 stride, size_t first, size_t count, const vec3x4& vec)
+    {
+        __m128 v0 = vec.x;
+        __m128 v1 = vec.y;
+        __m128 v2 = vec.z;
+        __m128 v3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+        const __m128 lanes[4] = { v0, v1, v2, v3 };
+        for (size_t lane = 0; lane < count; lane++)
+        {
+            storeVec3(getElement(stream, stride, first + lane), lanes[lane]);
+        }
+    }
+
+    void skinDualQuatRange(const SkinningStreams& streams, const DualQuat* palette, size_t begin, size_t end)
+    {
+        for (size_t first = begin; first < end; first += 4)
+        {
+            const size_t count = std::min<size_t>(4, end - first);
+
+            // blend the dual quaternions of each vertex, the ones on the other side of the hypersphere
+            // from the first bone are negated so the blend takes the shortest path
+            __m128 real[4];
+            __m128 dual[4];
+            for (size_t lane = 0; lane < 4; lane++)
+            {
+                u32 bones[4];
+                alignas(16) float weights[4];
+                _mm_store_ps(weights, loadInfluences(streams, std::min(first + lane, end - 1), bones));
+
+                const quatf& pivot = palette[bones[0]].real;
+                real[lane] = _mm_setzero_ps();
+                dual[lane] = _mm_setzero_ps();
+                for (u32 k = 0; k < 4; k++)
+                {
+                    const DualQuat& dq = palette[bones[k]];
+                    const __m128 weight = _mm_set1_ps(Dot(dq.real, pivot) < 0.0f ? -weights[k] : weights[k]);
+                    real[lane] = _mm_add_ps(real[lane], _mm_mul_ps(weight, _mm_loadu_ps(&dq.real.x)));
+                    dual[lane] = _mm_add_ps(dual[lane], _mm_mul_ps(weight, _mm_loadu_ps(&dq.dual.x)));
+                }
+            }
+
+            // continue with the 4 vertices in the lanes
+            _MM_TRANSPOSE4_PS(real[0], real[1], real[2], real[3]);
+            _MM_TRANSPOSE4_PS(dual[0], dual[1], dual[2], dual[3]);
+            const __m128 length_sq = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(real[0], real[0]), _mm_mul_ps(real[1], real[1])),
+                _mm_add_ps(_mm_mul_ps(real[2], real[2]), _mm_mul_ps(real[3], real[3])));
+            const __m128 inv_length = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_sq));
+            const vec3x4 u = vec3x4{ real[0], real[1], real[2] } * inv_length;
+            const __m128 w = _mm_mul_ps(real[3], inv_length);
+            const vec3x4 dual_u = vec3x4{ dual[0], dual[1], dual[2] } * inv_length;
+            const __m128 dual_w = _mm_mul_ps(dual[3], inv_length);
+
+            // the translation is 2 * (w * dual_u - dual_w * u + u x dual_u)
+            const __m128 two = _mm_set1_ps(2.0f);
+            const vec3x4 translation = (dual_u * w - u * dual_w + Cross(u, dual_u)) * two;
+
+            // rotate like Rotate(vec3, quat) does, v' = v + 2w(u x v) + 2u x (u x v)
+            const vec3x4 p = loadVec3x4(streams.positions, streams.position_stride, first, end);
+            const vec3x4 up = Cross(u, p);
+            const vec3x4 skinned = p + (up * w + Cross(u, up)) * two + translation;
+            storeVec3x4(streams.skinned_positions, streams.skinned_position_stride, first, count, skinned);
+
+            if (streams.normals)
+            {
+                // the rotation keeps the length of the normal
+                const vec3x4 n = loadVec3x4(streams.normals, streams.normal_stride, first, end);
+                const vec3x4 un = Cross(u, n);
+                const vec3x4 normal = n + (un * w + Cross(u, un)) * two;
+                storeVec3x4(streams.skinned_normals, streams.skinned_normal_stride, first, count, normal);
+            }
+        }
+    }
+}
+
+void deadrop::math::SkinLinearBlend(const SkinningStreams& streams, const mat4f* palette)
+{
+    ParallelFor(streams.vertex_count, PARALLEL_RANGE_SIZE, [&streams, palette](size_t begin, size_t end)
+    {
+        skinLinearBlendRange(streams, palette, begin, end);
+    });
+}
+
+void deadrop::math::SkinLinearBlend(const SkinningStreams& streams, const BoneMatrix3x4* palette)
+{
+    ParallelFor(streams.vertex_count, PARALLEL_RANGE_SIZE, [&streams, palette](size_t begin, size_t end)
+    {
+        skinLinearBlendRange(streams, palette, begin, end);
+    });
+}
+
+void deadrop::math::SkinDualQuat(const SkinningStreams& streams, const DualQuat* palette)
+{
+    ParallelFor(streams.vertex_count, PARALLEL_RANGE_SIZE, [&streams, palette](size_t begin, size_t end)
+    {
+        skinDualQuatRange(streams, palette, begin, end);
+    });
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "engine/core/types.h"
+#include "matrix4x4.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "quat.h"
+
+namespace deadrop::math
+{
+    // the compact form of an affine bone matrix, each row is a column of the row-major mat4f
+    // (the last column is always 0, 0, 0, 1 and is not stored), this is the layout shaders usually expect
+    struct BoneMatrix3x4
+    {
+        vec4f rows[3];
+    };
+
+    // returns the compact form of an affine matrix
+    constexpr BoneMatrix3x4 ToBoneMatrix3x4(const mat4f& m)
+    {
+        return BoneMatrix3x4
+        {
+            vec4f{ m(0, 0), m(1, 0), m(2, 0), m(3, 0) },
+            vec4f{ m(0, 1), m(1, 1), m(2, 1), m(3, 1) },
+            vec4f{ m(0, 2), m(1, 2), m(2, 2), m(3, 2) }
+        };
+    }
+
+    // a rigid transform stored as a unit dual quaternion, 'real' is the rotation and 'dual' encodes the
+    // translation, blending them keeps the volume of joints that twist, unlike blending matrices
+    struct DualQuat
+    {
+        quatf real;
+        quatf dual;
+    };
+
+    // returns the dual quaternion that rotates by 'rotation' and then translates by 'translation'
+    // NOTE: the rotation must be a unit quaternion, dual quaternions can not represent scale
+    constexpr DualQuat ToDualQuat(const quatf& rotation, const vec3f& translation)
+    {
+        // dual = 0.5 * (translation, 0) * rotation, as a hamilton product
+        const quatf& r = rotation;
+        const vec3f& t = translation;
+        return DualQuat
+        {
+            r,
+            quatf
+            {
+                0.5f * (t.x * r.w + t.y * r.z - t.z * r.y),
+                0.5f * (-t.x * r.z + t.y * r.w + t.z * r.x),
+                0.5f * (t.x * r.y - t.y * r.x + t.z * r.w),
+                0.5f * (-t.x * r.x - t.y * r.y - t.z * r.z)
+            }
+        };
+    }
+
+    // the vertex streams that are skinned, each stream is 'vertex_count' elements of 'stride' bytes
+    // like render::BufferDesc describes them, so they can point into interleaved vertex data
+    // NOTE: positions and normals are 3 floats, each vertex has 4 bone indices (u8 or u16, see 'bone_index_size')
+    // and 4 float weights that should add up to one, unused influences have a weight of zero
+    // NOTE: 'normals' and 'skinned_normals' are optional, the skinned streams must not overlap the others
+    struct SkinningStreams
+    {
+        u32 vertex_count = 0;
+        const void* positions = nullptr;
+        u32 position_stride = sizeof(vec3f);
+        const void* normals = nullptr;
+        u32 normal_stride = sizeof(vec3f);
+        const void* bone_indices = nullptr;
+        u32 bone_index_stride = 4 * sizeof(u8);
+        u32 bone_index_size = sizeof(u8);
+        const void* bone_weights = nullptr;
+        u32 bone_weight_stride = sizeof(vec4f);
+
+        void* skinned_positions = nullptr;
+        u32 skinned_position_stride = sizeof(vec3f);
+        void* skinned_normals = nullptr;
+        u32 skinned_normal_stride = sizeof(vec3f);
+    };
+
+    // linear blend skinning, each vertex is transformed by the weighted sum of the matrices of its bones,
+    // the palette has a matrix for each bone that goes from the bind pose to the current pose
+    // (the inverse bind matrix times the world matrix of the bone)
+    // NOTE: the normals are transformed by the blended 3x3 matrix and normalized, which is only correct
+    // for uniform scale
+    // NOTE: large meshes are split between the worker threads by vertex ranges, to skin many small meshes
+    // call these from a ParallelFor() over the meshes instead, the nested calls then run on the calling thread
+    void SkinLinearBlend(const SkinningStreams& streams, const mat4f* palette);
+    void SkinLinearBlend(const SkinningStreams& streams, const BoneMatrix3x4* palette);
+
+    // dual quaternion skinning, each vertex is transformed by the normalized weighted sum of the dual
+    // quaternions of its bones, see SkinLinearBlend() for the palette and the threading
+    void SkinDualQuat(const SkinningStreams& streams, const DualQuat* palette);
+}
@@ -3,27 +3,108 @@
 
 namespace deadrop::math
 {
+    // NOTE: all the matrices are constexpr so constant transforms can be built at compile time,
+    // the rotations need the angle to be within the range of the constexpr SinCos() (|angle| <= 8192)
     class Transform
     {
     public:
         // returns a translation matrix
         // NOTE: the returned matrix is row-major
-        static mat4f MatrixTranslate(vec3f translation_vec);
+        static constexpr mat4f MatrixTranslate(vec3f translation_vec);
 
         // returns a scale matrix
         // NOTE: the returned matrix is row-major
-        static mat4f MatrixScale(vec3f scale_vec);
+        static constexpr mat4f MatrixScale(vec3f scale_vec);
 
         // returns a rotation matrix around the x-axis, angle is in radians
         // NOTE: the returned matrix is row-major
-        static mat4f MatrixRotateX(float angle);
+        static constexpr mat4f MatrixRotateX(float angle);
 
         // returns a rotation matrix around the y-axis, angle is in radians
         // NOTE: the returned matrix is row-major
-        static mat4f MatrixRotateY(float angle);
+        static constexpr mat4f MatrixRotateY(float angle);
 
         // returns a rotation matrix around the z-axis, angle is in radians
         // NOTE: the returned matrix is row-major
-        static mat4f MatrixRotateZ(float angle);
+        static constexpr mat4f MatrixRotateZ(float angle);
     };
+
+    constexpr mat4f Transform::MatrixTranslate(vec3f translation_vec)
+    {
+        // compose a translation matrix
+        mat4f translation_matrix =
+        {
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            translation_vec.x, translation_vec.y, translation_vec.z, 1.0f
+        };
+
+        return translation_matrix;
+    }
+
+    constexpr mat4f Transform::MatrixScale(vec3f scale_vec)
+    {
+        // compose a scale matrix
+        mat4f scale_matrix =
+        {
+            scale_vec.x, 0.0f, 0.0f, 0.0f,
+            0.0f, scale_vec.y, 0.0f, 0.0f,
+            0.0f, 0.0f, scale_vec.z, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+
+        return scale_matrix;
+    }
+
+    constexpr mat4f Transform::MatrixRotateX(float angle)
+    {
+        float sinAngle = 0.0f, cosAngle = 0.0f;
+        math::SinCos(angle, sinAngle, cosAngle);
+
+        // compose a rotation matrix
+        mat4f rotation_x_matrix =
+        {
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, cosAngle, sinAngle, 0.0f,
+            0.0f, -sinAngle, cosAngle, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+
+        return rotation_x_matrix;
+    }
+
+    constexpr mat4f Transform::MatrixRotateY(float angle)
+    {
+        float sinAngle = 0.0f, cosAngle = 0.0f;
+        math::SinCos(angle, sinAngle, cosAngle);
+
+        // compose a rotation matrix
+        mat4f rotation_y_matrix =
+        {
+            cosAngle, 0.0f, -sinAngle, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            sinAngle, 0.0f, cosAngle, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+
+        return rotation_y_matrix;
+    }
+
+    constexpr mat4f Transform::MatrixRotateZ(float angle)
+    {
+        float sinAngle = 0.0f, cosAngle = 0.0f;
+        math::SinCos(angle, sinAngle, cosAngle);
+
+        // compose a 2d rotation matrix
+        mat4f rotation_z_matrix =
+        {
+            cosAngle, sinAngle, 0.0f, 0.0f,
+            -sinAngle, cosAngle, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+
+        return rotation_z_matrix;
+    }
 }
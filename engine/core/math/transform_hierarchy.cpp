@@ -0,0 +1,366 @@
+#include "transform_hierarchy.h"
+#include "engine/core/parallel.h"
+#include <algorithm>
+#include <cstring>
+using namespace deadrop;
+using namespace deadrop::math;
+
+namespace
+{
+    // the number of nodes of a level that a worker thread updates at a time
+    constexpr size_t PARALLEL_RANGE_SIZE = 1024;
+
+    // the number of consecutive dirty nodes whose matrices are computed together
+    constexpr size_t BATCH_SIZE = 64;
+
+    // reorders 'values' so that values[i] = old values[order[i]]
+    template <typename T>
+    void permute(std::vector<T>& values, const std::vector<u32>& order)
+    {
+        std::vector<T> sorted(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            sorted[i] = values[order[i]];
+        }
+        values.swap(sorted);
+    }
+}
+
+u32 TransformHierarchy::allocateSlot(u32 parent)
+{
+    m_tx.push_back(0.0f);
+    m_ty.push_back(0.0f);
+    m_tz.push_back(0.0f);
+    m_rx.push_back(0.0f);
+    m_ry.push_back(0.0f);
+    m_rz.push_back(0.0f);
+    m_rw.push_back(1.0f);
+    m_sx.push_back(1.0f);
+    m_sy.push_back(1.0f);
+    m_sz.push_back(1.0f);
+    m_world.push_back(mat4f::Identity());
+    m_parent.push_back(parent);
+    m_flags.push_back(0);
+    m_ids.push_back(NULL_NODE);
+    return static_cast<u32>(m_ids.size() - 1);
+}
+
+void TransformHierarchy::markDirty(u32 position)
+{
+    m_flags[position] |= FLAG_DIRTY;
+    m_first_dirty = std::min(m_first_dirty, position);
+}
+
+u32 TransformHierarchy::CreateNode(u32 parent)
+{
+    u32 node;
+    if (m_free_ids.empty())
+    {
+        node = static_cast<u32>(m_positions.size());
+        m_positions.push_back(NULL_NODE);
+    }
+    else
+    {
+        node = m_free_ids.back();
+        m_free_ids.pop_back();
+    }
+
+    // the node is appended and moved to its level by the next sort
+    const u32 position = allocateSlot(parent == NULL_NODE ? NULL_NODE : m_positions[parent]);
+    m_ids[position] = node;
+    m_positions[node] = position;
+    markDirty(position);
+    m_needs_sort = true;
+    m_node_count++;
+    return node;
+}
+
+void TransformHierarchy::DestroyNode(u32 node)
+{
+    // once sorted the descendants are all stored after the node and every parent comes before its children,
+    // so a single pass finds the whole subtree
+    if (m_needs_sort)
+    {
+        sortNodes();
+    }
+
+    const u32 position = m_positions[node];
+    const auto destroy = [this](size_t i)
+    {
+        m_positions[m_ids[i]] = NULL_NODE;
+        m_free_ids.push_back(m_ids[i]);
+        m_ids[i] = NULL_NODE;
+        m_node_count--;
+    };
+
+    destroy(position);
+    for (size_t i = position + 1; i < m_ids.size(); i++)
+    {
+        if (m_parent[i] != NULL_NODE && m_ids[m_parent[i]] == NULL_NODE)
+        {
+            destroy(i);
+        }
+    }
+
+    // the destroyed positions are removed by the next sort
+    m_needs_sort = true;
+}
+
+bool TransformHierarchy::SetParent(u32 node, u32 parent)
+{
+    const u32 position = m_positions[node];
+    const u32 parent_position = parent == NULL_NODE ? NULL_NODE : m_positions[parent];
+
+    // error, the node would become its own ancestor
+    for (u32 ancestor = parent_position; ancestor != NULL_NODE; ancestor = m_parent[ancestor])
+    {
+        if (ancestor == position)
+        {
+            return false;
+        }
+    }
+
+    m_parent[position] = parent_position;
+    markDirty(position);
+    m_needs_sort = true;
+    return true;
+}
+
+u32 TransformHierarchy::GetParent(u32 node) const
+{
+    const u32 parent_position = m_parent[m_positions[node]];
+    return parent_position == NULL_NODE ? NULL_NODE : m_ids[parent_position];
+}
+
+void TransformHierarchy::SetLocalTranslation(u32 node, const vec3f& translation)
+{
+    const u32 position = m_positions[node];
+    m_tx[position] = translation.x;
+    m_ty[position] = translation.y;
+    m_tz[position] = translation.z;
+    markDirty(position);
+}
+
+void TransformHierarchy::SetLocalRotation(u32 node, const quatf& rotation)
+{
+    const u32 position = m_positions[node];
+    m_rx[position] = rotation.x;
+    m_ry[position] = rotation.y;
+    m_rz[position] = rotation.z;
+    m_rw[position] = rotation.w;
+    markDirty(position);
+}
+
+void TransformHierarchy::SetLocalScale(u32 node, const vec3f& scale)
+{
+    const u32 position = m_positions[node];
+    m_sx[position] = scale.x;
+    m_sy[position] = scale.y;
+    m_sz[position] = scale.z;
+    markDirty(position);
+}
+
+void TransformHierarchy::SetLocalTransform(u32 node, const vec3f& translation, const quatf& rotation, const vec3f& scale)
+{
+    SetLocalTranslation(node, translation);
+    SetLocalRotation(node, rotation);
+    SetLocalScale(node, scale);
+}
+
+vec3f TransformHierarchy::GetLocalTranslation(u32 node) const
+{
+    const u32 position = m_positions[node];
+    return vec3f{ m_tx[position], m_ty[position], m_tz[position] };
+}
+
+quatf TransformHierarchy::GetLocalRotation(u32 node) const
+{
+    const u32 position = m_positions[node];
+    return quatf{ m_rx[position], m_ry[position], m_rz[position], m_rw[position] };
+}
+
+vec3f TransformHierarchy::GetLocalScale(u32 node) const
+{
+    const u32 position = m_positions[node];
+    return vec3f{ m_sx[position], m_sy[position], m_sz[position] };
+}
+
+const mat4f& TransformHierarchy::GetWorldMatrix(u32 node) const
+{
+    return m_world[m_positions[node]];
+}
+
+TRSArrays TransformHierarchy::getTRSArrays(size_t offset) const
+{
+    return TRSArrays{
+        m_tx.data() + offset, m_ty.data() + offset, m_tz.data() + offset,
+        m_rx.data() + offset, m_ry.data() + offset, m_rz.data() + offset, m_rw.data() + offset,
+        m_sx.data() + offset, m_sy.data() + offset, m_sz.data() + offset };
+}
+
+void TransformHierarchy::sortNodes()
+{
+    const size_t slot_count = m_ids.size();
+
+    // the children of each position, stored contiguously
+    std::vector<u32> child_offsets(slot_count + 1, 0);
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (m_ids[i] != NULL_NODE && m_parent[i] != NULL_NODE)
+        {
+            child_offsets[m_parent[i] + 1]++;
+        }
+    }
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        child_offsets[i + 1] += child_offsets[i];
+    }
+    std::vector<u32> children(child_offsets[slot_count]);
+    std::vector<u32> cursors(child_offsets.begin(), child_offsets.end() - 1);
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (m_ids[i] != NULL_NODE && m_parent[i] != NULL_NODE)
+        {
+            children[cursors[m_parent[i]]++] = static_cast<u32>(i);
+        }
+    }
+
+    // breadth first, starting with the roots, so each level is contiguous and the children of a node are
+    // next to each other, the destroyed positions are not reachable and get dropped
+    std::vector<u32> order;
+    order.reserve(m_node_count);
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (m_ids[i] != NULL_NODE && m_parent[i] == NULL_NODE)
+        {
+            order.push_back(static_cast<u32>(i));
+        }
+    }
+    m_level_offsets.clear();
+    m_level_offsets.push_back(0);
+    for (size_t level_begin = 0; level_begin < order.size();)
+    {
+        const size_t level_end = order.size();
+        m_level_offsets.push_back(static_cast<u32>(level_end));
+        for (size_t i = level_begin; i < level_end; i++)
+        {
+            const u32 position = order[i];
+            order.insert(order.end(), children.begin() + child_offsets[position], children.begin() + child_offsets[position + 1]);
+        }
+        level_begin = level_end;
+    }
+
+    permute(m_tx, order);
+    permute(m_ty, order);
+    permute(m_tz, order);
+    permute(m_rx, order);
+    permute(m_ry, order);
+    permute(m_rz, order);
+    permute(m_rw, order);
+    permute(m_sx, order);
+    permute(m_sy, order);
+    permute(m_sz, order);
+    permute(m_world, order);
+    permute(m_parent, order);
+    permute(m_flags, order);
+    permute(m_ids, order);
+
+    // the parents are still old positions, map them to the new ones
+    std::vector<u32> new_positions(slot_count, NULL_NODE);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        new_positions[order[i]] = static_cast<u32>(i);
+    }
+    m_first_dirty = NULL_NODE;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        if (m_parent[i] != NULL_NODE)
+        {
+            m_parent[i] = new_positions[m_parent[i]];
+        }
+        m_positions[m_ids[i]] = static_cast<u32>(i);
+        if (m_flags[i] & FLAG_DIRTY)
+        {
+            m_first_dirty = std::min(m_first_dirty, static_cast<u32>(i));
+        }
+    }
+    m_needs_sort = false;
+}
+
+void TransformHierarchy::updateRange(size_t begin, size_t end, bool roots)
+{
+    // a node is dirty when it changed or when its parent was updated,
+    // the parents are in the previous level which is already done
+    const auto isDirty = [this, roots](size_t i)
+    {
+        if (!roots && (m_flags[m_parent[i]] & FLAG_DIRTY))
+        {
+            m_flags[i] |= FLAG_DIRTY;
+        }
+        return (m_flags[i] & FLAG_DIRTY) != 0;
+    };
+
+    mat4f locals[BATCH_SIZE];
+    mat4f parents[BATCH_SIZE];
+    for (size_t i = begin; i < end;)
+    {
+        if (!isDirty(i))
+        {
+            i++;
+            continue;
+        }
+
+        // find the run of dirty nodes that starts here and compute their matrices together
+        size_t run_end = i + 1;
+        while (run_end < end && run_end - i < BATCH_SIZE && isDirty(run_end))
+        {
+            run_end++;
+        }
+        const size_t count = run_end - i;
+
+        if (roots)
+        {
+            ComposeTRSMany(getTRSArrays(i), &m_world[i], count);
+        }
+        else
+        {
+            ComposeTRSMany(getTRSArrays(i), locals, count);
+            for (size_t j = 0; j < count; j++)
+            {
+                parents[j] = m_world[m_parent[i + j]];
+            }
+            MultiplyMany(locals, parents, &m_world[i], count);
+        }
+        i = run_end;
+    }
+}
+
+void TransformHierarchy::Update()
+{
+    if (m_needs_sort)
+    {
+        sortNodes();
+    }
+    if (m_first_dirty == NULL_NODE)
+    {
+        return;
+    }
+
+    // the levels before the first dirty node have nothing to update, neither do the nodes
+    // of its level that are stored before it
+    const u32 level_count = GetLevelCount();
+    u32 level = static_cast<u32>(std::upper_bound(m_level_offsets.begin(), m_level_offsets.end(), m_first_dirty) - m_level_offsets.begin()) - 1;
+    for (; level < level_count; level++)
+    {
+        const size_t begin = std::max(m_level_offsets[level], m_first_dirty);
+        const size_t end = m_level_offsets[level + 1];
+        const bool roots = level == 0;
+        ParallelFor(end - begin, PARALLEL_RANGE_SIZE, [this, begin, roots](size_t range_begin, size_t range_end)
+        {
+            updateRange(begin + range_begin, begin + range_end, roots);
+        });
+    }
+
+    memset(m_flags.data() + m_first_dirty, 0, m_flags.size() - m_first_dirty);
+    m_first_dirty = NULL_NODE;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "engine/core/types.h"
+#include "matrix4x4.h"
+#include "matrix_helper.h"
+#include "vec3.h"
+#include "quat.h"
+#include <vector>
+
+namespace deadrop::math
+{
+    // a hierarchy of transforms, each node has a local translation, rotation and scale relative to its parent
+    // and a world matrix that Update() computes as local * parent world
+    // NOTE: the nodes are stored as a structure of arrays sorted by depth, so every parent is stored before its
+    // children and each depth (level) is a contiguous range, Update() processes the levels in order and the
+    // nodes of a level in parallel, only nodes that changed and their subtrees are recomputed
+    // NOTE: nodes are referred to by ids which do not change when the nodes are sorted
+    class TransformHierarchy
+    {
+    public:
+        static constexpr u32 NULL_NODE = 0xFFFFFFFF;
+
+        // creates a node with an identity local transform as a child of 'parent' and returns its id,
+        // NULL_NODE creates a root node
+        u32 CreateNode(u32 parent = NULL_NODE);
+
+        // destroys a node and all of its descendants, their ids can be returned by later CreateNode() calls
+        // NOTE: this visits all the nodes stored after the node, it is not meant to be called every frame
+        void DestroyNode(u32 node);
+
+        // moves a node with its subtree under 'parent', NULL_NODE makes it a root node, the local transform
+        // is kept so the world transform changes, returns false when 'parent' is the node itself or one of its
+        // descendants
+        bool SetParent(u32 node, u32 parent);
+
+        // returns the parent of a node, NULL_NODE for root nodes
+        u32 GetParent(u32 node) const;
+
+        // the local transform of a node, relative to its parent
+        // NOTE: the rotation must be a unit quaternion
+        void SetLocalTranslation(u32 node, const vec3f& translation);
+        void SetLocalRotation(u32 node, const quatf& rotation);
+        void SetLocalScale(u32 node, const vec3f& scale);
+        void SetLocalTransform(u32 node, const vec3f& translation, const quatf& rotation, const vec3f& scale);
+        vec3f GetLocalTranslation(u32 node) const;
+        quatf GetLocalRotation(u32 node) const;
+        vec3f GetLocalScale(u32 node) const;
+
+        // returns the world matrix of a node as computed by the last Update()
+        const mat4f& GetWorldMatrix(u32 node) const;
+
+        // sorts the nodes if the hierarchy changed and recomputes the world matrices of the nodes whose local
+        // transform changed and of all their descendants
+        void Update();
+
+        // returns the number of nodes
+        u32 GetNodeCount() const { return m_node_count; }
+
+        // returns the number of levels of the hierarchy as of the last Update()
+        u32 GetLevelCount() const { return static_cast<u32>(m_level_offsets.empty() ? 0 : m_level_offsets.size() - 1); }
+
+    private:
+        // bits of m_flags
+        static constexpr u8 FLAG_DIRTY = 1;
+
+        u32 allocateSlot(u32 parent);
+        void markDirty(u32 index);
+        void sortNodes();
+        void updateRange(size_t begin, size_t end, bool roots);
+        TRSArrays getTRSArrays(size_t offset) const;
+
+        // the local transforms, indexed by the position of the node in the sorted order
+        std::vector<float> m_tx, m_ty, m_tz;
+        std::vector<float> m_rx, m_ry, m_rz, m_rw;
+        std::vector<float> m_sx, m_sy, m_sz;
+        std::vector<mat4f> m_world;
+        // the position of the parent, NULL_NODE for roots
+        std::vector<u32> m_parent;
+        std::vector<u8> m_flags;
+        // the id of the node at each position, NULL_NODE for positions of destroyed nodes
+        std::vector<u32> m_ids;
+
+        // the position of each id, NULL_NODE for ids that are not used
+        std::vector<u32> m_positions;
+        std::vector<u32> m_free_ids;
+
+        // the first position of each level and the number of positions at the end
+        std::vector<u32> m_level_offsets;
+        // the smallest position that is dirty, NULL_NODE when nothing is
+        u32 m_first_dirty = NULL_NODE;
+        u32 m_node_count = 0;
+        // true when nodes were created, destroyed or moved to another parent since the last sort
+        bool m_needs_sort = false;
+    };
+}
@@ -17,7 +17,7 @@ namespace deadrop::math
         T y;
 
         // operators
-        vec2 operator*(T scalar)
+        constexpr vec2 operator*(T scalar) const
         {
             return vec2
             {
@@ -26,7 +26,7 @@ namespace deadrop::math
             };
         }
 
-        vec2 operator*(vec2 vec)
+        constexpr vec2 operator*(vec2 vec) const
         {
             return vec2
             {
@@ -35,7 +35,7 @@ namespace deadrop::math
             };
         }
 
-        vec2 operator/(T scalar)
+        constexpr vec2 operator/(T scalar) const
         {
             return vec2
             {
@@ -44,7 +44,7 @@ namespace deadrop::math
             };
         }
 
-        vec2 operator/(vec2 vec)
+        constexpr vec2 operator/(vec2 vec) const
         {
             return vec2
             {
@@ -53,7 +53,7 @@ namespace deadrop::math
             };
         }
 
-        vec2 operator+(T scalar)
+        constexpr vec2 operator+(T scalar) const
         {
             return vec2
             {
@@ -62,7 +62,7 @@ namespace deadrop::math
             };
         }
 
-        vec2 operator+(vec2 vec)
+        constexpr vec2 operator+(vec2 vec) const
         {
             return vec2
             {
@@ -71,7 +71,7 @@ namespace deadrop::math
             };
         }
 
-        vec2 operator-(T scalar)
+        constexpr vec2 operator-(T scalar) const
         {
             return vec2
             {
@@ -80,7 +80,7 @@ namespace deadrop::math
             };
         }
 
-        vec2 operator-(vec2 vec)
+        constexpr vec2 operator-(vec2 vec) const
         {
             return vec2
             {
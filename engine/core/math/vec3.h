@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/core/types.h"
+#include "scalar.h"
 
 namespace deadrop::math
 {
@@ -18,7 +19,7 @@ namespace deadrop::math
         T z;
 
         // operators
-        vec3 operator*(T scalar)
+        constexpr vec3 operator*(T scalar) const
         {
             return vec3
             {
@@ -28,7 +29,7 @@ namespace deadrop::math
             };
         }
 
-        vec3 operator*(vec3 vec)
+        constexpr vec3 operator*(vec3 vec) const
         {
             return vec3
             {
@@ -38,7 +39,7 @@ namespace deadrop::math
             };
         }
 
-        vec3 operator/(T scalar)
+        constexpr vec3 operator/(T scalar) const
         {
             return vec3
             {
@@ -48,7 +49,7 @@ namespace deadrop::math
             };
         }
 
-        vec3 operator/(vec3 vec)
+        constexpr vec3 operator/(vec3 vec) const
         {
             return vec3
             {
@@ -58,7 +59,7 @@ namespace deadrop::math
             };
         }
 
-        vec3 operator+(T scalar)
+        constexpr vec3 operator+(T scalar) const
         {
             return vec3
             {
@@ -68,7 +69,7 @@ namespace deadrop::math
             };
         }
 
-        vec3 operator+(vec3 vec)
+        constexpr vec3 operator+(vec3 vec) const
         {
             return vec3
             {
@@ -78,7 +79,7 @@ namespace deadrop::math
             };
         }
 
-        vec3 operator-(T scalar)
+        constexpr vec3 operator-(T scalar) const
         {
             return vec3
             {
@@ -88,7 +89,7 @@ namespace deadrop::math
             };
         }
 
-        vec3 operator-(vec3 vec)
+        constexpr vec3 operator-(vec3 vec) const
         {
             return vec3
             {
@@ -0,0 +1,314 @@
+#pragma once
+#include "engine/core/simd.h"
+#include "vec3.h"
+
+namespace deadrop::math
+{
+    // 4 float vec3s stored in structure-of-arrays form, each member holds one component of all 4 lanes
+    // NOTE: wide vectors are passed by const reference since 32-bit MSVC cannot pass
+    // over-aligned types by value
+    class vec3x4
+    {
+    public:
+        // constructors
+        vec3x4() = default;
+        vec3x4(__m128 _x, __m128 _y, __m128 _z) : x(_x), y(_y), z(_z) {}
+        // sets all 4 lanes to the same vector
+        explicit vec3x4(vec3f vec) : x(_mm_set1_ps(vec.x)), y(_mm_set1_ps(vec.y)), z(_mm_set1_ps(vec.z)) {}
+
+        // public vars
+        __m128 x;
+        __m128 y;
+        __m128 z;
+
+        // operators
+        vec3x4 operator*(float scalar) const
+        {
+            const __m128 s = _mm_set1_ps(scalar);
+            return vec3x4
+            {
+                _mm_mul_ps(x, s),
+                _mm_mul_ps(y, s),
+                _mm_mul_ps(z, s)
+            };
+        }
+
+        // multiplies each lane by its own scalar
+        vec3x4 operator*(__m128 scalar) const
+        {
+            return vec3x4
+            {
+                _mm_mul_ps(x, scalar),
+                _mm_mul_ps(y, scalar),
+                _mm_mul_ps(z, scalar)
+            };
+        }
+
+        vec3x4 operator*(const vec3x4& vec) const
+        {
+            return vec3x4
+            {
+                _mm_mul_ps(x, vec.x),
+                _mm_mul_ps(y, vec.y),
+                _mm_mul_ps(z, vec.z)
+            };
+        }
+
+        vec3x4 operator+(const vec3x4& vec) const
+        {
+            return vec3x4
+            {
+                _mm_add_ps(x, vec.x),
+                _mm_add_ps(y, vec.y),
+                _mm_add_ps(z, vec.z)
+            };
+        }
+
+        vec3x4 operator-(const vec3x4& vec) const
+        {
+            return vec3x4
+            {
+                _mm_sub_ps(x, vec.x),
+                _mm_sub_ps(y, vec.y),
+                _mm_sub_ps(z, vec.z)
+            };
+        }
+    };
+
+    // loads 4 consecutive vectors into the lanes of a wide vector
+    // NOTE: 'src' must point to at least 4 vectors, it does not have to be aligned
+    inline vec3x4 LoadVec3x4(const vec3f* src)
+    {
+        // the 12 floats of the array are read as 3 registers:
+        // p0 = x0 y0 z0 x1, p1 = y1 z1 x2 y2, p2 = z2 x3 y3 z3
+        const float* f = &src[0].x;
+        const __m128 p0 = _mm_loadu_ps(f);
+        const __m128 p1 = _mm_loadu_ps(f + 4);
+        const __m128 p2 = _mm_loadu_ps(f + 8);
+
+        // xy = x2 y2 x3 y3, yz = y0 z0 y1 z1
+        const __m128 xy = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 1, 3, 2));
+        const __m128 yz = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1, 0, 2, 1));
+        return vec3x4
+        {
+            _mm_shuffle_ps(p0, xy, _MM_SHUFFLE(2, 0, 3, 0)),
+            _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)),
+            _mm_shuffle_ps(yz, p2, _MM_SHUFFLE(3, 0, 3, 1))
+        };
+    }
+
+    // stores the 4 lanes of a wide vector into 4 consecutive vectors
+    // NOTE: 'dst' must point to at least 4 vectors, it does not have to be aligned
+    inline void StoreVec3x4(const vec3x4& vec, vec3f* dst)
+    {
+        // t0 = x0 y0 x1 y1, t1 = x2 y2 x3 y3
+        const __m128 t0 = _mm_unpacklo_ps(vec.x, vec.y);
+        const __m128 t1 = _mm_unpackhi_ps(vec.x, vec.y);
+
+        // p0 = x0 y0 z0 x1
+        const __m128 zx = _mm_shuffle_ps(vec.z, t0, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 p0 = _mm_shuffle_ps(t0, zx, _MM_SHUFFLE(2, 0, 1, 0));
+        // p1 = y1 z1 x2 y2
+        const __m128 yz = _mm_shuffle_ps(t0, vec.z, _MM_SHUFFLE(1, 1, 3, 3));
+        const __m128 p1 = _mm_shuffle_ps(yz, t1, _MM_SHUFFLE(1, 0, 2, 0));
+        // p2 = z2 x3 y3 z3
+        const __m128 zx3 = _mm_shuffle_ps(vec.z, t1, _MM_SHUFFLE(2, 2, 2, 2));
+        const __m128 yz3 = _mm_shuffle_ps(t1, vec.z, _MM_SHUFFLE(3, 3, 3, 3));
+        const __m128 p2 = _mm_shuffle_ps(zx3, yz3, _MM_SHUFFLE(2, 0, 2, 0));
+
+        float* f = &dst[0].x;
+        _mm_storeu_ps(f, p0);
+        _mm_storeu_ps(f + 4, p1);
+        _mm_storeu_ps(f + 8, p2);
+    }
+
+    // returns the dot products of the 4 lanes
+    inline __m128 Dot(const vec3x4& vec1, const vec3x4& vec2)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(vec1.x, vec2.x), _mm_mul_ps(vec1.y, vec2.y)), _mm_mul_ps(vec1.z, vec2.z));
+    }
+
+    // returns the cross products of the 4 lanes, see Cross(vec3, vec3)
+    inline vec3x4 Cross(const vec3x4& vec1, const vec3x4& vec2)
+    {
+        return vec3x4
+        {
+            _mm_sub_ps(_mm_mul_ps(vec1.y, vec2.z), _mm_mul_ps(vec1.z, vec2.y)),
+            _mm_sub_ps(_mm_mul_ps(vec1.z, vec2.x), _mm_mul_ps(vec1.x, vec2.z)),
+            _mm_sub_ps(_mm_mul_ps(vec1.x, vec2.y), _mm_mul_ps(vec1.y, vec2.x))
+        };
+    }
+
+    // returns the normalized vectors of the 4 lanes
+    // NOTE: like Normalize(vec3), zero length vectors produce nans
+    inline vec3x4 Normalize(const vec3x4& vec)
+    {
+        const __m128 length = _mm_sqrt_ps(Dot(vec, vec));
+        return vec3x4
+        {
+            _mm_div_ps(vec.x, length),
+            _mm_div_ps(vec.y, length),
+            _mm_div_ps(vec.z, length)
+        };
+    }
+
+    // returns the 4 lanes with all the components negated
+    inline vec3x4 Negate(const vec3x4& vec)
+    {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        return vec3x4
+        {
+            _mm_xor_ps(vec.x, sign),
+            _mm_xor_ps(vec.y, sign),
+            _mm_xor_ps(vec.z, sign)
+        };
+    }
+
+    // 8 float vec3s stored in structure-of-arrays form, each member holds one component of all 8 lanes
+    // NOTE: this type needs AVX, every function that uses it must be marked with SIMD_TARGET_AVX (or above)
+    // and must only run after checking GetCpuFeatures().avx
+    class vec3x8
+    {
+    public:
+        // constructors
+        vec3x8() = default;
+        SIMD_TARGET_AVX vec3x8(__m256 _x, __m256 _y, __m256 _z) : x(_x), y(_y), z(_z) {}
+        // sets all 8 lanes to the same vector
+        SIMD_TARGET_AVX explicit vec3x8(vec3f vec) : x(_mm256_set1_ps(vec.x)), y(_mm256_set1_ps(vec.y)), z(_mm256_set1_ps(vec.z)) {}
+
+        // public vars
+        __m256 x;
+        __m256 y;
+        __m256 z;
+
+        // operators
+        SIMD_TARGET_AVX vec3x8 operator*(float scalar) const
+        {
+            const __m256 s = _mm256_set1_ps(scalar);
+            return vec3x8
+            {
+                _mm256_mul_ps(x, s),
+                _mm256_mul_ps(y, s),
+                _mm256_mul_ps(z, s)
+            };
+        }
+
+        // multiplies each lane by its own scalar
+        SIMD_TARGET_AVX vec3x8 operator*(__m256 scalar) const
+        {
+            return vec3x8
+            {
+                _mm256_mul_ps(x, scalar),
+                _mm256_mul_ps(y, scalar),
+                _mm256_mul_ps(z, scalar)
+            };
+        }
+
+        SIMD_TARGET_AVX vec3x8 operator*(const vec3x8& vec) const
+        {
+            return vec3x8
+            {
+                _mm256_mul_ps(x, vec.x),
+                _mm256_mul_ps(y, vec.y),
+                _mm256_mul_ps(z, vec.z)
+            };
+        }
+
+        SIMD_TARGET_AVX vec3x8 operator+(const vec3x8& vec) const
+        {
+            return vec3x8
+            {
+                _mm256_add_ps(x, vec.x),
+                _mm256_add_ps(y, vec.y),
+                _mm256_add_ps(z, vec.z)
+            };
+        }
+
+        SIMD_TARGET_AVX vec3x8 operator-(const vec3x8& vec) const
+        {
+            return vec3x8
+            {
+                _mm256_sub_ps(x, vec.x),
+                _mm256_sub_ps(y, vec.y),
+                _mm256_sub_ps(z, vec.z)
+            };
+        }
+    };
+
+    // loads 8 consecutive vectors into the lanes of a wide vector
+    // NOTE: 'src' must point to at least 8 vectors, it does not have to be aligned
+    SIMD_TARGET_AVX inline vec3x8 LoadVec3x8(const vec3f* src)
+    {
+        // the low and high 128-bit halves hold vectors 0-3 and 4-7
+        const vec3x4 lo = LoadVec3x4(src);
+        const vec3x4 hi = LoadVec3x4(src + 4);
+        return vec3x8
+        {
+            _mm256_insertf128_ps(_mm256_castps128_ps256(lo.x), hi.x, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(lo.y), hi.y, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(lo.z), hi.z, 1)
+        };
+    }
+
+    // stores the 8 lanes of a wide vector into 8 consecutive vectors
+    // NOTE: 'dst' must point to at least 8 vectors, it does not have to be aligned
+    SIMD_TARGET_AVX inline void StoreVec3x8(const vec3x8& vec, vec3f* dst)
+    {
+        const vec3x4 lo
+        {
+            _mm256_castps256_ps128(vec.x),
+            _mm256_castps256_ps128(vec.y),
+            _mm256_castps256_ps128(vec.z)
+        };
+        const vec3x4 hi
+        {
+            _mm256_extractf128_ps(vec.x, 1),
+            _mm256_extractf128_ps(vec.y, 1),
+            _mm256_extractf128_ps(vec.z, 1)
+        };
+        StoreVec3x4(lo, dst);
+        StoreVec3x4(hi, dst + 4);
+    }
+
+    // returns the dot products of the 8 lanes
+    SIMD_TARGET_AVX inline __m256 Dot(const vec3x8& vec1, const vec3x8& vec2)
+    {
+        return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vec1.x, vec2.x), _mm256_mul_ps(vec1.y, vec2.y)), _mm256_mul_ps(vec1.z, vec2.z));
+    }
+
+    // returns the cross products of the 8 lanes, see Cross(vec3, vec3)
+    SIMD_TARGET_AVX inline vec3x8 Cross(const vec3x8& vec1, const vec3x8& vec2)
+    {
+        return vec3x8
+        {
+            _mm256_sub_ps(_mm256_mul_ps(vec1.y, vec2.z), _mm256_mul_ps(vec1.z, vec2.y)),
+            _mm256_sub_ps(_mm256_mul_ps(vec1.z, vec2.x), _mm256_mul_ps(vec1.x, vec2.z)),
+            _mm256_sub_ps(_mm256_mul_ps(vec1.x, vec2.y), _mm256_mul_ps(vec1.y, vec2.x))
+        };
+    }
+
+    // returns the normalized vectors of the 8 lanes
+    // NOTE: like Normalize(vec3), zero length vectors produce nans
+    SIMD_TARGET_AVX inline vec3x8 Normalize(const vec3x8& vec)
+    {
+        const __m256 length = _mm256_sqrt_ps(Dot(vec, vec));
+        return vec3x8
+        {
+            _mm256_div_ps(vec.x, length),
+            _mm256_div_ps(vec.y, length),
+            _mm256_div_ps(vec.z, length)
+        };
+    }
+
+    // returns the 8 lanes with all the components negated
+    SIMD_TARGET_AVX inline vec3x8 Negate(const vec3x8& vec)
+    {
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        return vec3x8
+        {
+            _mm256_xor_ps(vec.x, sign),
+            _mm256_xor_ps(vec.y, sign),
+            _mm256_xor_ps(vec.z, sign)
+        };
+    }
+}
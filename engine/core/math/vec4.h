@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/core/types.h"
+#include "scalar.h"
 
 namespace deadrop::math
 {
@@ -19,7 +20,7 @@ namespace deadrop::math
         T w;
 
         // operators
-        vec4 operator*(T scalar)
+        constexpr vec4 operator*(T scalar) const
         {
             return vec4
             {
@@ -30,7 +31,7 @@ namespace deadrop::math
             };
         }
 
-        vec4 operator*(vec4 vec)
+        constexpr vec4 operator*(vec4 vec) const
         {
             return vec4
             {
@@ -41,7 +42,7 @@ namespace deadrop::math
             };
         }
 
-        vec4 operator/(T scalar)
+        constexpr vec4 operator/(T scalar) const
         {
             return vec4
             {
@@ -52,7 +53,7 @@ namespace deadrop::math
             };
         }
 
-        vec4 operator/(vec4 vec)
+        constexpr vec4 operator/(vec4 vec) const
         {
             return vec4
             {
@@ -63,7 +64,7 @@ namespace deadrop::math
             };
         }
 
-        vec4 operator+(T scalar)
+        constexpr vec4 operator+(T scalar) const
         {
             return vec4
             {
@@ -74,7 +75,7 @@ namespace deadrop::math
             };
         }
 
-        vec4 operator+(vec4 vec)
+        constexpr vec4 operator+(vec4 vec) const
         {
             return vec4
             {
@@ -85,7 +86,7 @@ namespace deadrop::math
             };
         }
 
-        vec4 operator-(T scalar)
+        constexpr vec4 operator-(T scalar) const
         {
             return vec4
             {
@@ -96,7 +97,7 @@ namespace deadrop::math
             };
         }
 
-        vec4 operator-(vec4 vec)
+        constexpr vec4 operator-(vec4 vec) const
         {
             return vec4
             {
@@ -108,6 +109,40 @@ namespace deadrop::math
         }
     };
 
+    // returns the normalized vector of the passed vector parameter
+    template<class T>
+    constexpr vec4<T> Normalize(vec4<T> vec)
+    {
+        const T length = static_cast<T>(sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z + vec.w * vec.w));
+        return vec4<T>
+        {
+            vec.x / length,
+            vec.y / length,
+            vec.z / length,
+            vec.w / length
+        };
+    }
+
+    // returns the dot product of two vectors
+    template<class T>
+    constexpr T Dot(vec4<T> vec1, vec4<T> vec2)
+    {
+        return (vec1.x * vec2.x) + (vec1.y * vec2.y) + (vec1.z * vec2.z) + (vec1.w * vec2.w);
+    }
+
+    // returns the same vector but with all the components being negative
+    template<class T>
+    constexpr vec4<T> Negate(vec4<T> vec)
+    {
+        return vec4<T>
+        {
+            -vec.x,
+            -vec.y,
+            -vec.z,
+            -vec.w
+        };
+    }
+
     // aliases
     using vec4f = math::vec4<float>;
     using vec4i = math::vec4<i32>;
@@ -0,0 +1,301 @@
+#pragma once
+#include "engine/core/simd.h"
+#include "vec4.h"
+
+namespace deadrop::math
+{
+    // 4 float vec4s stored in structure-of-arrays form, each member holds one component of all 4 lanes
+    // NOTE: wide vectors are passed by const reference since 32-bit MSVC cannot pass
+    // over-aligned types by value
+    class vec4x4
+    {
+    public:
+        // constructors
+        vec4x4() = default;
+        vec4x4(__m128 _x, __m128 _y, __m128 _z, __m128 _w) : x(_x), y(_y), z(_z), w(_w) {}
+        // sets all 4 lanes to the same vector
+        explicit vec4x4(vec4f vec) : x(_mm_set1_ps(vec.x)), y(_mm_set1_ps(vec.y)), z(_mm_set1_ps(vec.z)), w(_mm_set1_ps(vec.w)) {}
+
+        // public vars
+        __m128 x;
+        __m128 y;
+        __m128 z;
+        __m128 w;
+
+        // operators
+        vec4x4 operator*(float scalar) const
+        {
+            const __m128 s = _mm_set1_ps(scalar);
+            return vec4x4
+            {
+                _mm_mul_ps(x, s),
+                _mm_mul_ps(y, s),
+                _mm_mul_ps(z, s),
+                _mm_mul_ps(w, s)
+            };
+        }
+
+        // multiplies each lane by its own scalar
+        vec4x4 operator*(__m128 scalar) const
+        {
+            return vec4x4
+            {
+                _mm_mul_ps(x, scalar),
+                _mm_mul_ps(y, scalar),
+                _mm_mul_ps(z, scalar),
+                _mm_mul_ps(w, scalar)
+            };
+        }
+
+        vec4x4 operator*(const vec4x4& vec) const
+        {
+            return vec4x4
+            {
+                _mm_mul_ps(x, vec.x),
+                _mm_mul_ps(y, vec.y),
+                _mm_mul_ps(z, vec.z),
+                _mm_mul_ps(w, vec.w)
+            };
+        }
+
+        vec4x4 operator+(const vec4x4& vec) const
+        {
+            return vec4x4
+            {
+                _mm_add_ps(x, vec.x),
+                _mm_add_ps(y, vec.y),
+                _mm_add_ps(z, vec.z),
+                _mm_add_ps(w, vec.w)
+            };
+        }
+
+        vec4x4 operator-(const vec4x4& vec) const
+        {
+            return vec4x4
+            {
+                _mm_sub_ps(x, vec.x),
+                _mm_sub_ps(y, vec.y),
+                _mm_sub_ps(z, vec.z),
+                _mm_sub_ps(w, vec.w)
+            };
+        }
+    };
+
+    // loads 4 consecutive vectors into the lanes of a wide vector
+    // NOTE: 'src' must point to at least 4 vectors, it does not have to be aligned
+    inline vec4x4 LoadVec4x4(const vec4f* src)
+    {
+        const float* f = &src[0].x;
+        vec4x4 result
+        {
+            _mm_loadu_ps(f),
+            _mm_loadu_ps(f + 4),
+            _mm_loadu_ps(f + 8),
+            _mm_loadu_ps(f + 12)
+        };
+        _MM_TRANSPOSE4_PS(result.x, result.y, result.z, result.w);
+        return result;
+    }
+
+    // stores the 4 lanes of a wide vector into 4 consecutive vectors
+    // NOTE: 'dst' must point to at least 4 vectors, it does not have to be aligned
+    inline void StoreVec4x4(const vec4x4& vec, vec4f* dst)
+    {
+        __m128 r0 = vec.x;
+        __m128 r1 = vec.y;
+        __m128 r2 = vec.z;
+        __m128 r3 = vec.w;
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        float* f = &dst[0].x;
+        _mm_storeu_ps(f, r0);
+        _mm_storeu_ps(f + 4, r1);
+        _mm_storeu_ps(f + 8, r2);
+        _mm_storeu_ps(f + 12, r3);
+    }
+
+    // returns the dot products of the 4 lanes
+    inline __m128 Dot(const vec4x4& vec1, const vec4x4& vec2)
+    {
+        const __m128 xy = _mm_add_ps(_mm_mul_ps(vec1.x, vec2.x), _mm_mul_ps(vec1.y, vec2.y));
+        const __m128 zw = _mm_add_ps(_mm_mul_ps(vec1.z, vec2.z), _mm_mul_ps(vec1.w, vec2.w));
+        return _mm_add_ps(xy, zw);
+    }
+
+    // returns the normalized vectors of the 4 lanes
+    // NOTE: like Normalize(vec4), zero length vectors produce nans
+    inline vec4x4 Normalize(const vec4x4& vec)
+    {
+        const __m128 length = _mm_sqrt_ps(Dot(vec, vec));
+        return vec4x4
+        {
+            _mm_div_ps(vec.x, length),
+            _mm_div_ps(vec.y, length),
+            _mm_div_ps(vec.z, length),
+            _mm_div_ps(vec.w, length)
+        };
+    }
+
+    // returns the 4 lanes with all the components negated
+    inline vec4x4 Negate(const vec4x4& vec)
+    {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        return vec4x4
+        {
+            _mm_xor_ps(vec.x, sign),
+            _mm_xor_ps(vec.y, sign),
+            _mm_xor_ps(vec.z, sign),
+            _mm_xor_ps(vec.w, sign)
+        };
+    }
+
+    // 8 float vec4s stored in structure-of-arrays form, each member holds one component of all 8 lanes
+    // NOTE: this type needs AVX, every function that uses it must be marked with SIMD_TARGET_AVX (or above)
+    // and must only run after checking GetCpuFeatures().avx
+    class vec4x8
+    {
+    public:
+        // constructors
+        vec4x8() = default;
+        SIMD_TARGET_AVX vec4x8(__m256 _x, __m256 _y, __m256 _z, __m256 _w) : x(_x), y(_y), z(_z), w(_w) {}
+        // sets all 8 lanes to the same vector
+        SIMD_TARGET_AVX explicit vec4x8(vec4f vec) : x(_mm256_set1_ps(vec.x)), y(_mm256_set1_ps(vec.y)), z(_mm256_set1_ps(vec.z)), w(_mm256_set1_ps(vec.w)) {}
+
+        // public vars
+        __m256 x;
+        __m256 y;
+        __m256 z;
+        __m256 w;
+
+        // operators
+        SIMD_TARGET_AVX vec4x8 operator*(float scalar) const
+        {
+            const __m256 s = _mm256_set1_ps(scalar);
+            return vec4x8
+            {
+                _mm256_mul_ps(x, s),
+                _mm256_mul_ps(y, s),
+                _mm256_mul_ps(z, s),
+                _mm256_mul_ps(w, s)
+            };
+        }
+
+        // multiplies each lane by its own scalar
+        SIMD_TARGET_AVX vec4x8 operator*(__m256 scalar) const
+        {
+            return vec4x8
+            {
+                _mm256_mul_ps(x, scalar),
+                _mm256_mul_ps(y, scalar),
+                _mm256_mul_ps(z, scalar),
+                _mm256_mul_ps(w, scalar)
+            };
+        }
+
+        SIMD_TARGET_AVX vec4x8 operator*(const vec4x8& vec) const
+        {
+            return vec4x8
+            {
+                _mm256_mul_ps(x, vec.x),
+                _mm256_mul_ps(y, vec.y),
+                _mm256_mul_ps(z, vec.z),
+                _mm256_mul_ps(w, vec.w)
+            };
+        }
+
+        SIMD_TARGET_AVX vec4x8 operator+(const vec4x8& vec) const
+        {
+            return vec4x8
+            {
+                _mm256_add_ps(x, vec.x),
+                _mm256_add_ps(y, vec.y),
+                _mm256_add_ps(z, vec.z),
+                _mm256_add_ps(w, vec.w)
+            };
+        }
+
+        SIMD_TARGET_AVX vec4x8 operator-(const vec4x8& vec) const
+        {
+            return vec4x8
+            {
+                _mm256_sub_ps(x, vec.x),
+                _mm256_sub_ps(y, vec.y),
+                _mm256_sub_ps(z, vec.z),
+                _mm256_sub_ps(w, vec.w)
+            };
+        }
+    };
+
+    // loads 8 consecutive vectors into the lanes of a wide vector
+    // NOTE: 'src' must point to at least 8 vectors, it does not have to be aligned
+    SIMD_TARGET_AVX inline vec4x8 LoadVec4x8(const vec4f* src)
+    {
+        // the low and high 128-bit halves hold vectors 0-3 and 4-7
+        const vec4x4 lo = LoadVec4x4(src);
+        const vec4x4 hi = LoadVec4x4(src + 4);
+        return vec4x8
+        {
+            _mm256_insertf128_ps(_mm256_castps128_ps256(lo.x), hi.x, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(lo.y), hi.y, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(lo.z), hi.z, 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(lo.w), hi.w, 1)
+        };
+    }
+
+    // stores the 8 lanes of a wide vector into 8 consecutive vectors
+    // NOTE: 'dst' must point to at least 8 vectors, it does not have to be aligned
+    SIMD_TARGET_AVX inline void StoreVec4x8(const vec4x8& vec, vec4f* dst)
+    {
+        const vec4x4 lo
+        {
+            _mm256_castps256_ps128(vec.x),
+            _mm256_castps256_ps128(vec.y),
+            _mm256_castps256_ps128(vec.z),
+            _mm256_castps256_ps128(vec.w)
+        };
+        const vec4x4 hi
+        {
+            _mm256_extractf128_ps(vec.x, 1),
+            _mm256_extractf128_ps(vec.y, 1),
+            _mm256_extractf128_ps(vec.z, 1),
+            _mm256_extractf128_ps(vec.w, 1)
+        };
+        StoreVec4x4(lo, dst);
+        StoreVec4x4(hi, dst + 4);
+    }
+
+    // returns the dot products of the 8 lanes
+    SIMD_TARGET_AVX inline __m256 Dot(const vec4x8& vec1, const vec4x8& vec2)
+    {
+        const __m256 xy = _mm256_add_ps(_mm256_mul_ps(vec1.x, vec2.x), _mm256_mul_ps(vec1.y, vec2.y));
+        const __m256 zw = _mm256_add_ps(_mm256_mul_ps(vec1.z, vec2.z), _mm256_mul_ps(vec1.w, vec2.w));
+        return _mm256_add_ps(xy, zw);
+    }
+
+    // returns the normalized vectors of the 8 lanes
+    // NOTE: like Normalize(vec4), zero length vectors produce nans
+    SIMD_TARGET_AVX inline vec4x8 Normalize(const vec4x8& vec)
+    {
+        const __m256 length = _mm256_sqrt_ps(Dot(vec, vec));
+        return vec4x8
+        {
+            _mm256_div_ps(vec.x, length),
+            _mm256_div_ps(vec.y, length),
+            _mm256_div_ps(vec.z, length),
+            _mm256_div_ps(vec.w, length)
+        };
+    }
+
+    // returns the 8 lanes with all the components negated
+    SIMD_TARGET_AVX inline vec4x8 Negate(const vec4x8& vec)
+    {
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        return vec4x8
+        {
+            _mm256_xor_ps(vec.x, sign),
+            _mm256_xor_ps(vec.y, sign),
+            _mm256_xor_ps(vec.z, sign),
+            _mm256_xor_ps(vec.w, sign)
+        };
+    }
+}
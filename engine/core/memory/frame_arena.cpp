@@ -0,0 +1,163 @@
+#include "frame_arena.h"
+#include "engine/core/parallel.h"
+using namespace deadrop;
+using namespace deadrop::memory;
+
+namespace
+{
+    // the alignment of the regions, a cache line
+    constexpr size_t REGION_ALIGNMENT = 64;
+
+    // allocations bigger than this skip the thread chunks, so a large allocation does not waste the rest of a chunk
+    constexpr size_t MAX_CHUNK_ALLOCATION_SIZE = FrameArena::THREAD_CHUNK_SIZE / 4;
+
+    u8* alignPointer(u8* ptr, size_t alignment)
+    {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        return reinterpret_cast<u8*>((address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+    }
+}
+
+FrameArena::FrameArena(size_t frame_capacity, size_t double_buffered_capacity, MemoryTag tag)
+{
+    // NOTE: the memory is zeroed here so its pages are committed before the first frame uses them
+    m_tag = tag;
+    m_memory_size = frame_capacity + double_buffered_capacity * 2 + REGION_ALIGNMENT * 3;
+    m_memory = std::make_unique<u8[]>(m_memory_size);
+    TrackAllocation(m_tag, m_memory_size);
+    u8* base = alignPointer(m_memory.get(), REGION_ALIGNMENT);
+    m_frame_region.base = base;
+    m_frame_region.capacity = frame_capacity;
+    base = alignPointer(base + frame_capacity, REGION_ALIGNMENT);
+    for (Region& region : m_double_buffered_regions)
+    {
+        region.base = base;
+        region.capacity = double_buffered_capacity;
+        base = alignPointer(base + double_buffered_capacity, REGION_ALIGNMENT);
+    }
+}
+
+FrameArena::~FrameArena()
+{
+    TrackFree(m_tag, m_memory_size);
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    return allocate(REGION_KIND_FRAME, m_frame_region, size, alignment);
+}
+
+void* FrameArena::AllocateDoubleBuffered(size_t size, size_t alignment)
+{
+    return allocate(REGION_KIND_DOUBLE_BUFFERED, m_double_buffered_regions[m_frame & 1], size, alignment);
+}
+
+void FrameArena::EndFrame()
+{
+    const size_t used = GetFrameUsed();
+    m_frame_peak_used = used > m_frame_peak_used ? used : m_frame_peak_used;
+    m_frame_region.used.store(0, std::memory_order_relaxed);
+
+    // the double buffered region of the frame that just ended stays untouched for one more frame,
+    // the one before it is released and reused
+    // NOTE: the chunks in the thread caches are dropped because their frame no longer matches
+    m_frame++;
+    m_double_buffered_regions[m_frame & 1].used.store(0, std::memory_order_relaxed);
+}
+
+size_t FrameArena::GetFrameUsed() const
+{
+    const size_t used = m_frame_region.used.load(std::memory_order_relaxed);
+    return used < m_frame_region.capacity ? used : m_frame_region.capacity;
+}
+
+size_t FrameArena::GetFramePeakUsed() const
+{
+    const size_t used = GetFrameUsed();
+    return used > m_frame_peak_used ? used : m_frame_peak_used;
+}
+
+size_t FrameArena::GetFailedAllocationCount() const
+{
+    return m_failed_allocations.load(std::memory_order_relaxed);
+}
+
+void* FrameArena::allocate(RegionKind kind, Region& region, size_t size, size_t alignment)
+{
+    // NOTE: checked before the sums below, which would wrap around for a huge size
+    if (size > region.capacity || alignment > region.capacity - size)
+    {
+        // error, the allocation can never fit in the region
+        m_failed_allocations.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    const u32 slot = GetThreadIndex();
+    if (slot >= MAX_THREAD_CACHES || size + alignment > MAX_CHUNK_ALLOCATION_SIZE)
+    {
+        return allocateShared(region, size, alignment);
+    }
+
+    // the common case, the allocation fits in the chunk of the thread
+    ThreadCache& cache = m_caches[slot][kind];
+    if (cache.frame == m_frame)
+    {
+        u8* ptr = alignPointer(cache.cursor, alignment);
+        if (ptr + size <= cache.end)
+        {
+            cache.cursor = ptr + size;
+            return ptr;
+        }
+    }
+
+    // take a new chunk, the last one of the region can be shorter
+    const size_t offset = region.used.fetch_add(THREAD_CHUNK_SIZE, std::memory_order_relaxed);
+    if (offset >= region.capacity)
+    {
+        // error, the arena is full for this frame
+        m_failed_allocations.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    const size_t chunk_size = region.capacity - offset < THREAD_CHUNK_SIZE ? region.capacity - offset : THREAD_CHUNK_SIZE;
+    cache.cursor = region.base + offset;
+    cache.end = cache.cursor + chunk_size;
+    cache.frame = m_frame;
+
+    u8* ptr = alignPointer(cache.cursor, alignment);
+    if (ptr + size > cache.end)
+    {
+        // error, the arena is full for this frame
+        m_failed_allocations.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    cache.cursor = ptr + size;
+    return ptr;
+}
+
+void* FrameArena::allocateShared(Region& region, size_t size, size_t alignment)
+{
+    // NOTE: reserves enough for the worst case alignment so the range can be aligned without another atomic
+    const size_t reserved = size + alignment - 1;
+    if (region.used.load(std::memory_order_relaxed) + reserved > region.capacity)
+    {
+        // error, the arena is full for this frame
+        // NOTE: checked before the add so a request that does not fit leaves the rest of the region to the others
+        m_failed_allocations.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    const size_t offset = region.used.fetch_add(reserved, std::memory_order_relaxed);
+    if (offset + reserved > region.capacity)
+    {
+        // error, the arena is full for this frame
+        m_failed_allocations.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return alignPointer(region.base + offset, alignment);
+}
+
+FrameArena& deadrop::memory::GetFrameArena()
+{
+    // created on the first call
+    static FrameArena s_frame_arena;
+    return s_frame_arena;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "engine/core/types.h"
+#include "memory.h"
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace deadrop
+{
+    namespace memory
+    {
+        // a linear (bump) allocator for the data that only lives for a frame or two, the memory is reserved
+        // once and every allocation moves a pointer forward, nothing is freed individually, all the allocations
+        // of a frame are released at once by EndFrame()
+        // each thread allocates from its own chunk of the arena, so the allocations from the worker threads
+        // of ParallelFor() do not contend, a thread only touches the shared atomic counter to take a new chunk
+        // NOTE: nothing is destructed, only store types that are trivially destructible
+        class FrameArena
+        {
+        public:
+            // the default sizes of the global arena returned by GetFrameArena()
+            static constexpr size_t DEFAULT_FRAME_CAPACITY = 4 * 1024 * 1024;
+            static constexpr size_t DEFAULT_DOUBLE_BUFFERED_CAPACITY = 1 * 1024 * 1024;
+            // the alignment of Allocate() when none is given, enough for any scalar and sse type
+            static constexpr size_t DEFAULT_ALIGNMENT = 16;
+            // the size of the chunks that the threads take from the arena
+            static constexpr size_t THREAD_CHUNK_SIZE = 64 * 1024;
+            // the number of threads that get their own chunks, the ones above it allocate
+            // directly with the shared atomic counter
+            static constexpr u32 MAX_THREAD_CACHES = 64;
+
+            // reserves 'frame_capacity' bytes for the allocations that are released at the end of the frame
+            // and twice 'double_buffered_capacity' bytes for the ones that must survive the next frame too
+            // NOTE: the reserved memory is recorded under 'tag' by the memory tracker
+            explicit FrameArena(size_t frame_capacity = DEFAULT_FRAME_CAPACITY, size_t double_buffered_capacity = DEFAULT_DOUBLE_BUFFERED_CAPACITY,
+                MemoryTag tag = MEMORY_TAG_CORE);
+            ~FrameArena();
+
+            // delete the copy constructor and the copy assignment operator
+            FrameArena(const FrameArena&) = delete;
+            FrameArena& operator=(const FrameArena&) = delete;
+
+            // returns 'size' bytes that stay valid until the next call to EndFrame()
+            // NOTE: 'alignment' must be a power of two
+            // returns nullptr when the arena has no room left for this frame
+            [[nodiscard]]
+            void* Allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+            // returns 'size' bytes that stay valid until the second call to EndFrame(), which lets the data
+            // of a frame be read while the next frame is built (for example by the gpu, or by a job that
+            // runs a frame behind)
+            // returns nullptr when the arena has no room left for this frame
+            [[nodiscard]]
+            void* AllocateDoubleBuffered(size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+            // returns an uninitialized array of 'count' items that stays valid until the next call to EndFrame()
+            template<typename T>
+            [[nodiscard]]
+            T* AllocateArray(size_t count)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "FrameArena does not call destructors!");
+                return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T) > DEFAULT_ALIGNMENT ? alignof(T) : DEFAULT_ALIGNMENT));
+            }
+
+            // releases the allocations of the frame and the double buffered allocations of the previous frame
+            // NOTE: must be called once per frame while no other thread allocates from the arena
+            void EndFrame();
+
+            // returns the bytes used by the frame allocations of the current frame, including the unused
+            // ends of the thread chunks
+            size_t GetFrameUsed() const;
+
+            // returns the most bytes that the frame allocations used in a frame since the arena was created,
+            // use it to choose the capacity
+            size_t GetFramePeakUsed() const;
+
+            // returns the number of allocations that failed because the arena was full since it was created
+            size_t GetFailedAllocationCount() const;
+
+        private:
+            // a range of the reserved memory that the threads take chunks from
+            struct Region
+            {
+                u8* base = nullptr;
+                size_t capacity = 0;
+                std::atomic<size_t> used{ 0 };
+            };
+
+            // the chunk that a thread currently allocates from
+            // NOTE: aligned to a cache line so the threads do not write to the same line
+            struct alignas(64) ThreadCache
+            {
+                u8* cursor = nullptr;
+                u8* end = nullptr;
+                // the frame the chunk was taken in, a chunk from an older frame was released
+                u64 frame = ~0ull;
+            };
+
+            enum RegionKind : u32
+            {
+                REGION_KIND_FRAME = 0,
+                REGION_KIND_DOUBLE_BUFFERED,
+                REGION_KIND_COUNT
+            };
+
+            void* allocate(RegionKind kind, Region& region, size_t size, size_t alignment);
+
+            // allocates directly from the region with the atomic counter
+            void* allocateShared(Region& region, size_t size, size_t alignment);
+
+            uptr<u8[]> m_memory;
+            size_t m_memory_size = 0;
+            MemoryTag m_tag = MEMORY_TAG_CORE;
+            // the frame region and the two double buffered regions that are used on alternate frames
+            Region m_frame_region;
+            Region m_double_buffered_regions[2];
+            u64 m_frame = 0;
+            size_t m_frame_peak_used = 0;
+            std::atomic<size_t> m_failed_allocations{ 0 };
+            ThreadCache m_caches[MAX_THREAD_CACHES][REGION_KIND_COUNT];
+        };
+
+        // returns the global frame arena of the engine, created with the default capacities on the first call
+        // NOTE: the main loop calls EndFrame() on it at the end of each frame
+        FrameArena& GetFrameArena();
+    }
+}
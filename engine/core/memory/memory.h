@@ -1,12 +1,67 @@
 #pragma once
+#include "memory_tracker.h"
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace deadrop
 {
-    // alias to std::unique_ptr
+    namespace memory
+    {
+        // the deleter of uptr, it deletes the object like std::default_delete and records the free
+        // when the object was created by MakeUnique()
+        // NOTE: it converts from std::default_delete so std::make_unique() still works with uptr, the
+        // objects created that way are not tracked
+        template<typename T>
+        struct TaggedDelete
+        {
+            // MEMORY_TAG_COUNT when the object is not tracked
+            MemoryTag tag = MEMORY_TAG_COUNT;
+            // the size of the type that was created, which can be bigger than T
+            u32 size = 0;
+
+            constexpr TaggedDelete() noexcept = default;
+            constexpr TaggedDelete(MemoryTag tag_, u32 size_) noexcept : tag(tag_), size(size_) {}
+
+            template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+            TaggedDelete(const TaggedDelete<U>& other) noexcept : tag(other.tag), size(other.size) {}
+
+            template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+            TaggedDelete(const std::default_delete<U>&) noexcept {}
+
+            void operator()(T* ptr) const
+            {
+                static_assert(sizeof(T) > 0, "can't delete an incomplete type");
+                delete ptr;
+                if (tag != MEMORY_TAG_COUNT)
+                {
+                    TrackFree(tag, size);
+                }
+            }
+        };
+
+        // the array version of the deleter, arrays are not tracked
+        template<typename T>
+        struct TaggedDelete<T[]>
+        {
+            constexpr TaggedDelete() noexcept = default;
+
+            template<typename U, typename = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>::value>>
+            TaggedDelete(const std::default_delete<U[]>&) noexcept {}
+
+            void operator()(T* ptr) const
+            {
+                static_assert(sizeof(T) > 0, "can't delete an incomplete type");
+                delete[] ptr;
+            }
+        };
+    }
+
+    // alias to std::unique_ptr, it records the free of the objects created by memory::MakeUnique()
     template<typename T>
-    using uptr = std::unique_ptr<T>;
+    using uptr = std::unique_ptr<T, memory::TaggedDelete<T>>;
 
     // alias to std::shared_ptr
     template<typename T>
@@ -22,6 +77,104 @@ namespace deadrop
             void* ptr;
         };
 
+        // an allocator for the standard containers (and for std::allocate_shared) that records the allocations
+        // of the container under its tag:
+        //
+        //     tagged_vector<Vertex> vertices{ TaggedAllocator<Vertex>(MEMORY_TAG_ASSETS) };
+        template<typename T>
+        class TaggedAllocator
+        {
+        public:
+            using value_type = T;
+
+            TaggedAllocator(MemoryTag tag) noexcept : m_tag(tag) {}
+
+            template<typename U>
+            TaggedAllocator(const TaggedAllocator<U>& other) noexcept : m_tag(other.GetTag()) {}
+
+            T* allocate(size_t count)
+            {
+                const size_t size = count * sizeof(T);
+                void* ptr = alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ?
+                    ::operator new(size, std::align_val_t(alignof(T))) : ::operator new(size);
+                TrackAllocation(m_tag, size);
+                return static_cast<T*>(ptr);
+            }
+
+            void deallocate(T* ptr, size_t count) noexcept
+            {
+                TrackFree(m_tag, count * sizeof(T));
+                if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                {
+                    ::operator delete(ptr, std::align_val_t(alignof(T)));
+                }
+                else
+                {
+                    ::operator delete(ptr);
+                }
+            }
+
+            MemoryTag GetTag() const { return m_tag; }
+
+            template<typename U>
+            bool operator==(const TaggedAllocator<U>& other) const { return m_tag == other.GetTag(); }
+
+            template<typename U>
+            bool operator!=(const TaggedAllocator<U>& other) const { return m_tag != other.GetTag(); }
+
+        private:
+            MemoryTag m_tag;
+        };
+
+        // alias to std::vector with a TaggedAllocator
+        template<typename T>
+        using tagged_vector = std::vector<T, TaggedAllocator<T>>;
+
+        // whether 'new T' takes a block from the pool of a PoolAllocated class, which records its pages itself
+        template<typename T, typename = void>
+        struct is_pool_allocated : std::false_type {};
+
+        template<typename T>
+        struct is_pool_allocated<T, std::void_t<typename T::pool_allocated_type>> :
+            std::bool_constant<sizeof(T) == sizeof(typename T::pool_allocated_type)> {};
+
+        // creates an object like std::make_unique() and records it under 'tag' until the uptr deletes it
+        // NOTE: the objects of PoolAllocated classes are not recorded, their pool already records its pages
+        template<typename T, typename... Args>
+        uptr<T> MakeUnique(MemoryTag tag, Args&&... args)
+        {
+            static_assert(!std::is_array<T>::value, "use std::make_unique() for arrays");
+            if constexpr (is_pool_allocated<T>::value)
+            {
+                return uptr<T>(new T(std::forward<Args>(args)...));
+            }
+            else
+            {
+                uptr<T> ptr(new T(std::forward<Args>(args)...), TaggedDelete<T>(tag, static_cast<u32>(sizeof(T))));
+                TrackAllocation(tag, sizeof(T));
+                return ptr;
+            }
+        }
+
+        // creates an object like std::make_shared() and records it (and its reference counts) under 'tag'
+        template<typename T, typename... Args>
+        sptr<T> MakeShared(MemoryTag tag, Args&&... args)
+        {
+            return std::allocate_shared<T>(TaggedAllocator<T>(tag), std::forward<Args>(args)...);
+        }
+
+        // allocates 'size' bytes that are shared like a sptr and records them under 'tag'
+        inline sptr<void> MakeSharedBytes(MemoryTag tag, size_t size)
+        {
+            void* ptr = ::operator new(size);
+            TrackAllocation(tag, size);
+            return sptr<void>(ptr, [tag, size](void* p)
+            {
+                ::operator delete(p);
+                TrackFree(tag, size);
+            }, TaggedAllocator<u8>(tag));
+        }
+
         // a function to clear the content of the vector and clears its allocated memory
         template<typename T>
         inline void deallocate(std::vector<T>& vec)
@@ -33,4 +186,3 @@ namespace deadrop
         }
     }
 }
-
@@ -0,0 +1,194 @@
+#include "memory_tracker.h"
+#include <atomic>
+#include <fstream>
+#include <mutex>
+using namespace deadrop;
+using namespace deadrop::memory;
+
+namespace
+{
+    const char* const TAG_NAMES[MEMORY_TAG_COUNT] =
+    {
+        "render",
+        "input",
+        "window",
+        "core",
+        "assets",
+        "user",
+    };
+
+    // NOTE: aligned to a cache line so the threads that allocate for different tags do not write to the same line
+    struct alignas(64) TagCounters
+    {
+        std::atomic<u64> live_bytes{ 0 };
+        std::atomic<u64> peak_live_bytes{ 0 };
+        std::atomic<u64> live_allocations{ 0 };
+        std::atomic<u64> total_allocations{ 0 };
+        std::atomic<u64> total_allocated_bytes{ 0 };
+        std::atomic<u64> size_histogram[MEMORY_HISTOGRAM_BUCKET_COUNT] = {};
+        // the allocations of the current frame
+        std::atomic<u64> frame_allocations{ 0 };
+        std::atomic<u64> frame_bytes{ 0 };
+    };
+
+    // the per-frame data, only changed by EndMemoryTrackingFrame()
+    struct TagHistory
+    {
+        u64 rate_histogram[MEMORY_HISTOGRAM_BUCKET_COUNT] = {};
+        u64 frame_allocations[MEMORY_RATE_HISTORY_SIZE] = {};
+        u64 frame_bytes[MEMORY_RATE_HISTORY_SIZE] = {};
+    };
+
+    struct Tracker
+    {
+        TagCounters counters[MEMORY_TAG_COUNT];
+        std::mutex history_mutex;
+        TagHistory history[MEMORY_TAG_COUNT];
+        // the index of the oldest frame in the history rings
+        u32 history_start = 0;
+    };
+
+    Tracker& getTracker()
+    {
+        // NOTE: never destroyed on purpose, objects owned by other statics are still freed while the program exits
+        static Tracker* s_tracker = new Tracker();
+        return *s_tracker;
+    }
+
+    u32 getBucket(u64 size)
+    {
+        u32 bucket = 0;
+        while (size > 1 && bucket + 1 < MEMORY_HISTOGRAM_BUCKET_COUNT)
+        {
+            size >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+}
+
+const char* deadrop::memory::GetMemoryTagName(MemoryTag tag)
+{
+    return tag < MEMORY_TAG_COUNT ? TAG_NAMES[tag] : "unknown";
+}
+
+void deadrop::memory::TrackAllocation(MemoryTag tag, size_t size)
+{
+    TagCounters& counters = getTracker().counters[tag];
+    const u64 live_bytes = counters.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    u64 peak = counters.peak_live_bytes.load(std::memory_order_relaxed);
+    while (live_bytes > peak && !counters.peak_live_bytes.compare_exchange_weak(peak, live_bytes, std::memory_order_relaxed))
+    {
+    }
+    counters.live_allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.total_allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.total_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    counters.size_histogram[getBucket(size)].fetch_add(1, std::memory_order_relaxed);
+    counters.frame_allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.frame_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void deadrop::memory::TrackFree(MemoryTag tag, size_t size)
+{
+    TagCounters& counters = getTracker().counters[tag];
+    counters.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+    counters.live_allocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void deadrop::memory::EndMemoryTrackingFrame()
+{
+    Tracker& tracker = getTracker();
+    std::lock_guard<std::mutex> lock(tracker.history_mutex);
+    for (u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+    {
+        const u64 allocations = tracker.counters[tag].frame_allocations.exchange(0, std::memory_order_relaxed);
+        const u64 bytes = tracker.counters[tag].frame_bytes.exchange(0, std::memory_order_relaxed);
+        TagHistory& history = tracker.history[tag];
+        // the oldest frame is overwritten by the newest one
+        history.frame_allocations[tracker.history_start] = allocations;
+        history.frame_bytes[tracker.history_start] = bytes;
+        if (allocations > 0)
+        {
+            history.rate_histogram[getBucket(bytes)]++;
+        }
+    }
+    tracker.history_start = (tracker.history_start + 1) % MEMORY_RATE_HISTORY_SIZE;
+}
+
+MemoryTagStats deadrop::memory::GetMemoryTagStats(MemoryTag tag)
+{
+    Tracker& tracker = getTracker();
+    const TagCounters& counters = tracker.counters[tag];
+    MemoryTagStats stats;
+    stats.live_bytes = counters.live_bytes.load(std::memory_order_relaxed);
+    stats.peak_live_bytes = counters.peak_live_bytes.load(std::memory_order_relaxed);
+    stats.live_allocations = counters.live_allocations.load(std::memory_order_relaxed);
+    stats.total_allocations = counters.total_allocations.load(std::memory_order_relaxed);
+    stats.total_allocated_bytes = counters.total_allocated_bytes.load(std::memory_order_relaxed);
+    for (u32 i = 0; i < MEMORY_HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        stats.size_histogram[i] = counters.size_histogram[i].load(std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(tracker.history_mutex);
+    const TagHistory& history = tracker.history[tag];
+    for (u32 i = 0; i < MEMORY_HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        stats.rate_histogram[i] = history.rate_histogram[i];
+    }
+    for (u32 i = 0; i < MEMORY_RATE_HISTORY_SIZE; i++)
+    {
+        const u32 frame = (tracker.history_start + i) % MEMORY_RATE_HISTORY_SIZE;
+        stats.frame_allocations[i] = history.frame_allocations[frame];
+        stats.frame_bytes[i] = history.frame_bytes[frame];
+    }
+    return stats;
+}
+
+bool deadrop::memory::DumpMemoryReport(const std::string& file)
+{
+    std::ofstream stream(file, std::ofstream::out | std::ofstream::trunc);
+    if (!stream.is_open())
+    {
+        // error, failed to open the file
+        return false;
+    }
+
+    stream << "tag, live bytes, peak bytes, live allocations, total allocations, total bytes\n";
+    for (u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+    {
+        const MemoryTagStats stats = GetMemoryTagStats(static_cast<MemoryTag>(tag));
+        stream << TAG_NAMES[tag] << ", " << stats.live_bytes << ", " << stats.peak_live_bytes << ", "
+            << stats.live_allocations << ", " << stats.total_allocations << ", " << stats.total_allocated_bytes << "\n";
+    }
+
+    for (u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+    {
+        const MemoryTagStats stats = GetMemoryTagStats(static_cast<MemoryTag>(tag));
+        stream << "\n[" << TAG_NAMES[tag] << "]\n";
+        // only the non-empty buckets, as '[min size, max size): count'
+        stream << "allocations by size:\n";
+        for (u32 i = 0; i < MEMORY_HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            if (stats.size_histogram[i] > 0)
+            {
+                stream << "  [" << (1ull << i) << ", " << (2ull << i) << "): " << stats.size_histogram[i] << "\n";
+            }
+        }
+        stream << "frames by bytes allocated:\n";
+        for (u32 i = 0; i < MEMORY_HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            if (stats.rate_histogram[i] > 0)
+            {
+                stream << "  [" << (1ull << i) << ", " << (2ull << i) << "): " << stats.rate_histogram[i] << "\n";
+            }
+        }
+        stream << "bytes allocated in the last " << MEMORY_RATE_HISTORY_SIZE << " frames:\n ";
+        for (u32 i = 0; i < MEMORY_RATE_HISTORY_SIZE; i++)
+        {
+            stream << " " << stats.frame_bytes[i];
+        }
+        stream << "\n";
+    }
+    return stream.good();
+}
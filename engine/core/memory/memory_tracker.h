@@ -0,0 +1,63 @@
+#pragma once
+#include "engine/core/types.h"
+#include <cstddef>
+#include <string>
+
+namespace deadrop
+{
+    namespace memory
+    {
+        // the subsystem that an allocation belongs to
+        enum MemoryTag : u32
+        {
+            MEMORY_TAG_RENDER = 0,
+            MEMORY_TAG_INPUT,
+            MEMORY_TAG_WINDOW,
+            MEMORY_TAG_CORE,
+            MEMORY_TAG_ASSETS,
+            MEMORY_TAG_USER,
+            MEMORY_TAG_COUNT
+        };
+
+        // the size histograms have a bucket per power of two, bucket i counts the sizes in [2^i, 2^(i + 1))
+        constexpr u32 MEMORY_HISTOGRAM_BUCKET_COUNT = 40;
+        // the number of frames kept in the allocation rate history
+        constexpr u32 MEMORY_RATE_HISTORY_SIZE = 128;
+
+        struct MemoryTagStats
+        {
+            u64 live_bytes = 0;
+            // the most live bytes since the program started
+            u64 peak_live_bytes = 0;
+            u64 live_allocations = 0;
+            u64 total_allocations = 0;
+            u64 total_allocated_bytes = 0;
+            // the number of allocations by size
+            u64 size_histogram[MEMORY_HISTOGRAM_BUCKET_COUNT] = {};
+            // the number of frames by the bytes allocated during the frame, frames without allocations are not counted
+            u64 rate_histogram[MEMORY_HISTOGRAM_BUCKET_COUNT] = {};
+            // the allocations and the bytes allocated during each of the last frames, the oldest first
+            u64 frame_allocations[MEMORY_RATE_HISTORY_SIZE] = {};
+            u64 frame_bytes[MEMORY_RATE_HISTORY_SIZE] = {};
+        };
+
+        // returns the name of the tag, like "render"
+        const char* GetMemoryTagName(MemoryTag tag);
+
+        // records an allocation or a free of 'size' bytes, called by the tagged allocation helpers of memory.h
+        // NOTE: thread-safe, the counters are updated with relaxed atomics
+        void TrackAllocation(MemoryTag tag, size_t size);
+        void TrackFree(MemoryTag tag, size_t size);
+
+        // moves the allocations made since the previous call into the rate history and the rate histograms
+        // NOTE: the main loop calls it once per frame
+        void EndMemoryTrackingFrame();
+
+        // returns the counters of the tag
+        MemoryTagStats GetMemoryTagStats(MemoryTag tag);
+
+        // writes the counters and histograms of all the tags to a text file
+        // returns false when the file could not be opened
+        bool DumpMemoryReport(const std::string& file);
+    }
+}
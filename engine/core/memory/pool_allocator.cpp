@@ -0,0 +1,170 @@
+#include "pool_allocator.h"
+#include "engine/core/parallel.h"
+using namespace deadrop;
+using namespace deadrop::memory;
+
+PoolAllocator::PoolAllocator(size_t block_size, size_t block_alignment, size_t blocks_per_page, bool use_thread_caches,
+    MemoryTag tag)
+{
+    m_tag = tag;
+    // a free block must fit the pointer to the next free block
+    m_block_alignment = block_alignment > alignof(FreeBlock) ? block_alignment : alignof(FreeBlock);
+    m_block_size = block_size > sizeof(FreeBlock) ? block_size : sizeof(FreeBlock);
+    m_block_size = (m_block_size + m_block_alignment - 1) & ~(m_block_alignment - 1);
+    m_blocks_per_page = blocks_per_page > 0 ? blocks_per_page : 1;
+    if (use_thread_caches)
+    {
+        m_thread_caches = std::make_unique<ThreadCache[]>(MAX_THREAD_CACHES);
+    }
+}
+
+PoolAllocator::~PoolAllocator()
+{
+    for (void* page : m_pages)
+    {
+        ::operator delete(page, std::align_val_t(m_block_alignment));
+        TrackFree(m_tag, m_block_size * m_blocks_per_page);
+    }
+}
+
+void* PoolAllocator::Allocate()
+{
+    const u32 slot = m_thread_caches ? GetThreadIndex() : MAX_THREAD_CACHES;
+    if (slot < MAX_THREAD_CACHES)
+    {
+        ThreadCache& cache = m_thread_caches[slot];
+        if (cache.head == nullptr)
+        {
+            // refill half of the cache from the shared list
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (cache.count < THREAD_CACHE_SIZE / 2)
+            {
+                if (m_free == nullptr && !allocatePage())
+                {
+                    break;
+                }
+                FreeBlock* block = m_free;
+                m_free = block->next;
+                block->next = cache.head;
+                cache.head = block;
+                cache.count++;
+            }
+            if (cache.head == nullptr)
+            {
+                // error, out of memory
+                return nullptr;
+            }
+        }
+        FreeBlock* block = cache.head;
+        cache.head = block->next;
+        cache.count--;
+        cache.live_count.store(cache.live_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return block;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_free == nullptr && !allocatePage())
+    {
+        // error, out of memory
+        return nullptr;
+    }
+    FreeBlock* block = m_free;
+    m_free = block->next;
+    m_shared_live_count++;
+    return block;
+}
+
+void PoolAllocator::Free(void* ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+
+    const u32 slot = m_thread_caches ? GetThreadIndex() : MAX_THREAD_CACHES;
+    if (slot < MAX_THREAD_CACHES)
+    {
+        ThreadCache& cache = m_thread_caches[slot];
+        cache.live_count.store(cache.live_count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        block->next = cache.head;
+        cache.head = block;
+        cache.count++;
+        if (cache.count <= THREAD_CACHE_SIZE)
+        {
+            return;
+        }
+
+        // the cache is full, give half of it back to the shared list
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (cache.count > THREAD_CACHE_SIZE / 2)
+        {
+            FreeBlock* returned = cache.head;
+            cache.head = returned->next;
+            cache.count--;
+            returned->next = m_free;
+            m_free = returned;
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    block->next = m_free;
+    m_free = block;
+    m_shared_live_count--;
+}
+
+bool PoolAllocator::Reserve(size_t block_count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (m_pages.size() * m_blocks_per_page < block_count)
+    {
+        if (!allocatePage())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t PoolAllocator::GetLiveCount() const
+{
+    // NOTE: a block can be allocated on one thread and freed on another, so only the sum is meaningful
+    std::lock_guard<std::mutex> lock(m_mutex);
+    i64 live_count = m_shared_live_count;
+    if (m_thread_caches)
+    {
+        for (u32 i = 0; i < MAX_THREAD_CACHES; i++)
+        {
+            live_count += m_thread_caches[i].live_count.load(std::memory_order_relaxed);
+        }
+    }
+    return static_cast<size_t>(live_count);
+}
+
+size_t PoolAllocator::GetCapacity() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pages.size() * m_blocks_per_page;
+}
+
+bool PoolAllocator::allocatePage()
+{
+    u8* page = static_cast<u8*>(::operator new(m_block_size * m_blocks_per_page, std::align_val_t(m_block_alignment), std::nothrow));
+    if (page == nullptr)
+    {
+        // error, out of memory
+        return false;
+    }
+    TrackAllocation(m_tag, m_block_size * m_blocks_per_page);
+    m_pages.push_back(page);
+
+    // link the blocks backwards so they are handed out in address order
+    for (size_t i = m_blocks_per_page; i-- > 0;)
+    {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(page + i * m_block_size);
+        block->next = m_free;
+        m_free = block;
+    }
+    return true;
+}
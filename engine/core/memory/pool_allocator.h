@@ -0,0 +1,210 @@
+#pragma once
+#include "engine/core/types.h"
+#include "memory.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace deadrop
+{
+    namespace memory
+    {
+        // an allocator of fixed-size blocks, the blocks are carved from pages of 'blocks_per_page' blocks that
+        // are only released when the pool is destroyed, so creating and destroying objects of the same type
+        // reuses the same memory instead of fragmenting the heap
+        // allocating and freeing pop and push a free list, the shared list is protected by a mutex and the
+        // optional thread caches keep a few free blocks per thread so most calls do not take the lock
+        // NOTE: blocks cached by a thread that exited stay in its cache until the pool is destroyed
+        class PoolAllocator
+        {
+        public:
+            // the number of threads that get their own cache, the ones above it always use the shared list
+            static constexpr u32 MAX_THREAD_CACHES = 64;
+            // the most free blocks a thread cache keeps, half of them go back to the shared list when it is full
+            static constexpr u32 THREAD_CACHE_SIZE = 32;
+
+            // 'block_alignment' must be a power of two
+            // NOTE: the pages are recorded under 'tag' by the memory tracker
+            PoolAllocator(size_t block_size, size_t block_alignment, size_t blocks_per_page, bool use_thread_caches,
+                MemoryTag tag = MEMORY_TAG_CORE);
+            // releases the pages, the blocks that were not freed become invalid
+            ~PoolAllocator();
+
+            // delete the copy constructor and the copy assignment operator
+            PoolAllocator(const PoolAllocator&) = delete;
+            PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+            // returns an uninitialized block
+            // returns nullptr when a new page could not be allocated
+            [[nodiscard]]
+            void* Allocate();
+
+            // returns the block to the pool
+            // NOTE: 'ptr' must have been returned by Allocate() of this pool
+            void Free(void* ptr);
+
+            // allocates pages until the pool can hold 'block_count' blocks without allocating
+            // returns false when a page could not be allocated
+            bool Reserve(size_t block_count);
+
+            // returns the number of blocks that are allocated
+            size_t GetLiveCount() const;
+
+            // returns the number of blocks in all the pages
+            size_t GetCapacity() const;
+
+            // returns the size of a block, the requested size rounded up to the alignment
+            size_t GetBlockSize() const { return m_block_size; }
+
+        private:
+            // a free block stores the next free block in its first bytes
+            struct FreeBlock
+            {
+                FreeBlock* next;
+            };
+
+            // NOTE: aligned to a cache line so the threads do not write to the same line
+            struct alignas(64) ThreadCache
+            {
+                FreeBlock* head = nullptr;
+                u32 count = 0;
+                // the blocks allocated minus the blocks freed by the thread, only written by the thread
+                // so it is updated without a locked instruction
+                std::atomic<i64> live_count{ 0 };
+            };
+
+            // adds a page to the shared free list, must be called with the mutex locked
+            bool allocatePage();
+
+            size_t m_block_size = 0;
+            size_t m_block_alignment = 0;
+            size_t m_blocks_per_page = 0;
+            MemoryTag m_tag = MEMORY_TAG_CORE;
+
+            mutable std::mutex m_mutex;
+            FreeBlock* m_free = nullptr;
+            std::vector<void*> m_pages;
+            // the blocks allocated minus the blocks freed through the shared list, protected by the mutex
+            i64 m_shared_live_count = 0;
+            uptr<ThreadCache[]> m_thread_caches;
+        };
+
+        // a pool of objects of type T
+        template<typename T>
+        class TypedPool
+        {
+        public:
+            explicit TypedPool(size_t objects_per_page = 64, bool use_thread_caches = false, MemoryTag tag = MEMORY_TAG_CORE) :
+                m_allocator(sizeof(T), alignof(T), objects_per_page, use_thread_caches, tag) {}
+
+            // constructs an object in a block of the pool
+            // returns nullptr when a new page could not be allocated
+            template<typename... Args>
+            [[nodiscard]]
+            T* Create(Args&&... args)
+            {
+                void* ptr = m_allocator.Allocate();
+                if (ptr == nullptr)
+                {
+                    // error, out of memory
+                    return nullptr;
+                }
+                return new (ptr) T(std::forward<Args>(args)...);
+            }
+
+            // destructs the object and returns its block to the pool
+            void Destroy(T* object)
+            {
+                if (object)
+                {
+                    object->~T();
+                    m_allocator.Free(object);
+                }
+            }
+
+            PoolAllocator& GetAllocator() { return m_allocator; }
+
+        private:
+            PoolAllocator m_allocator;
+        };
+
+        // a deleter for std::unique_ptr that returns the object to the pool it was created from
+        template<typename T>
+        struct PoolDeleter
+        {
+            TypedPool<T>* pool = nullptr;
+
+            void operator()(T* object) const
+            {
+                pool->Destroy(object);
+            }
+        };
+
+        // alias to std::unique_ptr with a PoolDeleter
+        template<typename T>
+        using pool_uptr = std::unique_ptr<T, PoolDeleter<T>>;
+
+        // constructs an object in the pool and returns it in a pool_uptr
+        template<typename T, typename... Args>
+        pool_uptr<T> MakePooled(TypedPool<T>& pool, Args&&... args)
+        {
+            return pool_uptr<T>(pool.Create(std::forward<Args>(args)...), PoolDeleter<T>{ &pool });
+        }
+
+        // inheriting from PoolAllocated<T> makes 'new T' and 'delete' use a pool of T that is shared by the
+        // whole program, so std::make_unique<T>() and the default deleter of uptr (also through a pointer
+        // to a base class with a virtual destructor) allocate from it without changing their types:
+        //
+        //     class D3D11Buffer : public IBuffer, public memory::PoolAllocated<D3D11Buffer, memory::MEMORY_TAG_RENDER>
+        //
+        // NOTE: classes that derive from T and are bigger use the global heap instead
+        // NOTE: the pages of the pool are recorded under 'Tag', MakeUnique() does not record the objects again
+        template<typename T, MemoryTag Tag = MEMORY_TAG_CORE>
+        class PoolAllocated
+        {
+        public:
+            // the type the pool was made for, see is_pool_allocated
+            using pool_allocated_type = T;
+
+            // the number of objects in each page of the pool
+            static constexpr size_t OBJECTS_PER_PAGE = 32;
+
+            static void* operator new(size_t size)
+            {
+                if (size != sizeof(T))
+                {
+                    return ::operator new(size);
+                }
+                void* ptr = GetPool().Allocate();
+                if (ptr == nullptr)
+                {
+                    // error, out of memory
+                    throw std::bad_alloc();
+                }
+                return ptr;
+            }
+
+            static void operator delete(void* ptr, size_t size)
+            {
+                if (size != sizeof(T))
+                {
+                    ::operator delete(ptr);
+                    return;
+                }
+                GetPool().Free(ptr);
+            }
+
+            // returns the pool that the objects of type T are allocated from
+            static PoolAllocator& GetPool()
+            {
+                // NOTE: the pool is never destroyed on purpose, objects owned by other statics
+                // (like the systems of CoreSystem) can still be deleted while the program exits
+                static PoolAllocator* s_pool = new PoolAllocator(sizeof(T), alignof(T), OBJECTS_PER_PAGE, true, Tag);
+                return *s_pool;
+            }
+        };
+    }
+}
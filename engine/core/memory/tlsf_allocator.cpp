@@ -0,0 +1,433 @@
+#include "tlsf_allocator.h"
+#include <new>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+using namespace deadrop;
+using namespace deadrop::memory;
+
+namespace
+{
+    // returns the index of the highest set bit, 'value' must not be 0
+    u32 findLastSet(u64 value)
+    {
+#ifdef _MSC_VER
+        // NOTE: split in two 32-bit scans so it also builds for x32
+        unsigned long index;
+        if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+        {
+            return index + 32;
+        }
+        _BitScanReverse(&index, static_cast<unsigned long>(value));
+        return index;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    // returns the index of the lowest set bit, 'value' must not be 0
+    u32 findFirstSet(u32 value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return index;
+#else
+        return __builtin_ctz(value);
+#endif
+    }
+
+    // the alignment of the memory of a TlsfHeap, the offsets are aligned relative to it
+    constexpr size_t HEAP_ALIGNMENT = 4096;
+
+    u64 alignUp(u64 value, u64 alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+TlsfAllocator::TlsfAllocator(u64 capacity, u32 max_allocations)
+{
+    // NOTE: the size classes end at MAX_CAPACITY, a bigger range would map to a first level that does not exist
+    m_capacity = (capacity < MAX_CAPACITY ? capacity : MAX_CAPACITY) & ~(GRANULARITY - 1);
+    m_max_allocations = max_allocations;
+    // NOTE: two free blocks are never next to each other, so there are at most one more free blocks
+    // than allocations, plus one for the alignment padding that is split off during an allocation
+    m_nodes.reserve(static_cast<size_t>(max_allocations) * 2 + 2);
+    Reset();
+}
+
+bool TlsfAllocator::Allocate(u64 size, u64 alignment, TlsfAllocation& allocation)
+{
+    allocation = TlsfAllocation{};
+    if (m_live_allocations == m_max_allocations)
+    {
+        // error, too many live allocations
+        return false;
+    }
+
+    if (size > m_capacity || alignment > m_capacity)
+    {
+        // error, no free block can be big enough
+        // NOTE: checked before the sums below, which would wrap around for a huge size
+        return false;
+    }
+
+    size = alignUp(size > 0 ? size : 1, GRANULARITY);
+    alignment = alignment > GRANULARITY ? alignment : GRANULARITY;
+    // NOTE: the padding needed to align an offset is at most 'alignment - GRANULARITY'
+    const u64 search_size = size + alignment - GRANULARITY;
+    const u32 node = findFreeBlock(search_size);
+    if (node == NONE)
+    {
+        // error, no free block is big enough
+        return false;
+    }
+    removeFreeBlock(node);
+
+    // split the padding off the front as a free block of its own
+    const u64 padding = alignUp(m_nodes[node].offset, alignment) - m_nodes[node].offset;
+    if (padding > 0)
+    {
+        const u32 padding_node = createNode();
+        Block& block = m_nodes[node];
+        Block& front = m_nodes[padding_node];
+        front.offset = block.offset;
+        front.size = padding;
+        front.prev_physical = block.prev_physical;
+        front.next_physical = node;
+        if (block.prev_physical != NONE)
+        {
+            m_nodes[block.prev_physical].next_physical = padding_node;
+        }
+        block.prev_physical = padding_node;
+        block.offset += padding;
+        block.size -= padding;
+        insertFreeBlock(padding_node);
+    }
+
+    splitBlock(node, size);
+
+    Block& block = m_nodes[node];
+    block.free = false;
+    m_live_bytes += block.size;
+    m_peak_live_bytes = m_live_bytes > m_peak_live_bytes ? m_live_bytes : m_peak_live_bytes;
+    m_live_allocations++;
+
+    allocation.offset = block.offset;
+    allocation.size = block.size;
+    allocation.node = node;
+    return true;
+}
+
+void TlsfAllocator::Free(const TlsfAllocation& allocation)
+{
+    if (!allocation.IsValid())
+    {
+        return;
+    }
+    u32 node = allocation.node;
+    m_live_bytes -= m_nodes[node].size;
+    m_live_allocations--;
+
+    // merge with the previous block
+    const u32 prev = m_nodes[node].prev_physical;
+    if (prev != NONE && m_nodes[prev].free)
+    {
+        removeFreeBlock(prev);
+        Block& previous = m_nodes[prev];
+        previous.size += m_nodes[node].size;
+        previous.next_physical = m_nodes[node].next_physical;
+        if (previous.next_physical != NONE)
+        {
+            m_nodes[previous.next_physical].prev_physical = prev;
+        }
+        releaseNode(node);
+        node = prev;
+    }
+
+    // merge with the next block
+    const u32 next = m_nodes[node].next_physical;
+    if (next != NONE && m_nodes[next].free)
+    {
+        removeFreeBlock(next);
+        Block& block = m_nodes[node];
+        block.size += m_nodes[next].size;
+        block.next_physical = m_nodes[next].next_physical;
+        if (block.next_physical != NONE)
+        {
+            m_nodes[block.next_physical].prev_physical = node;
+        }
+        releaseNode(next);
+    }
+
+    insertFreeBlock(node);
+}
+
+void TlsfAllocator::Reset()
+{
+    m_nodes.clear();
+    m_unused_nodes = NONE;
+    m_fl_bitmap = 0;
+    for (u32 fl = 0; fl < FL_COUNT; fl++)
+    {
+        m_sl_bitmaps[fl] = 0;
+        for (u32 sl = 0; sl < SL_COUNT; sl++)
+        {
+            m_free_lists[fl][sl] = NONE;
+        }
+    }
+    m_live_bytes = 0;
+    m_peak_live_bytes = 0;
+    m_live_allocations = 0;
+    m_free_blocks = 0;
+
+    if (m_capacity > 0)
+    {
+        const u32 node = createNode();
+        m_nodes[node].offset = 0;
+        m_nodes[node].size = m_capacity;
+        insertFreeBlock(node);
+    }
+}
+
+TlsfStats TlsfAllocator::GetStats() const
+{
+    TlsfStats stats;
+    stats.capacity = m_capacity;
+    stats.live_bytes = m_live_bytes;
+    stats.peak_live_bytes = m_peak_live_bytes;
+    stats.free_bytes = m_capacity - m_live_bytes;
+    stats.live_allocations = m_live_allocations;
+    stats.free_blocks = m_free_blocks;
+
+    // the largest free block is in the highest non-empty size class
+    if (m_fl_bitmap != 0)
+    {
+        const u32 fl = findLastSet(m_fl_bitmap);
+        const u32 sl = findLastSet(m_sl_bitmaps[fl]);
+        for (u32 node = m_free_lists[fl][sl]; node != NONE; node = m_nodes[node].next_free)
+        {
+            stats.largest_free_block = m_nodes[node].size > stats.largest_free_block ? m_nodes[node].size : stats.largest_free_block;
+        }
+    }
+    if (stats.free_bytes > 0)
+    {
+        stats.fragmentation = 1.0f - static_cast<float>(static_cast<double>(stats.largest_free_block) / static_cast<double>(stats.free_bytes));
+    }
+    return stats;
+}
+
+u32 TlsfAllocator::createNode()
+{
+    if (m_unused_nodes != NONE)
+    {
+        const u32 node = m_unused_nodes;
+        m_unused_nodes = m_nodes[node].next_free;
+        m_nodes[node] = Block{};
+        return node;
+    }
+    // NOTE: never grows past the capacity reserved by the constructor
+    m_nodes.emplace_back();
+    return static_cast<u32>(m_nodes.size() - 1);
+}
+
+void TlsfAllocator::releaseNode(u32 node)
+{
+    m_nodes[node].free = false;
+    m_nodes[node].next_free = m_unused_nodes;
+    m_unused_nodes = node;
+}
+
+void TlsfAllocator::mapSize(u64 size, u32& fl, u32& sl)
+{
+    if (size < SMALL_BLOCK_SIZE)
+    {
+        fl = 0;
+        sl = static_cast<u32>(size / GRANULARITY);
+        return;
+    }
+    const u32 last = findLastSet(size);
+    sl = static_cast<u32>(size >> (last - SL_COUNT_LOG2)) ^ SL_COUNT;
+    fl = last - FL_SHIFT + 1;
+}
+
+void TlsfAllocator::insertFreeBlock(u32 node)
+{
+    u32 fl, sl;
+    mapSize(m_nodes[node].size, fl, sl);
+
+    Block& block = m_nodes[node];
+    block.free = true;
+    block.prev_free = NONE;
+    block.next_free = m_free_lists[fl][sl];
+    if (block.next_free != NONE)
+    {
+        m_nodes[block.next_free].prev_free = node;
+    }
+    m_free_lists[fl][sl] = node;
+    m_fl_bitmap |= 1u << fl;
+    m_sl_bitmaps[fl] |= 1u << sl;
+    m_free_blocks++;
+}
+
+void TlsfAllocator::removeFreeBlock(u32 node)
+{
+    u32 fl, sl;
+    mapSize(m_nodes[node].size, fl, sl);
+
+    Block& block = m_nodes[node];
+    if (block.prev_free != NONE)
+    {
+        m_nodes[block.prev_free].next_free = block.next_free;
+    }
+    else
+    {
+        m_free_lists[fl][sl] = block.next_free;
+        if (block.next_free == NONE)
+        {
+            // the list is empty now
+            m_sl_bitmaps[fl] &= ~(1u << sl);
+            if (m_sl_bitmaps[fl] == 0)
+            {
+                m_fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+    if (block.next_free != NONE)
+    {
+        m_nodes[block.next_free].prev_free = block.prev_free;
+    }
+    block.free = false;
+    block.prev_free = NONE;
+    block.next_free = NONE;
+    m_free_blocks--;
+}
+
+u32 TlsfAllocator::findFreeBlock(u64 size) const
+{
+    // round the size up to the next size class, so any block of the class found is big enough
+    u64 rounded_size = size;
+    if (size >= SMALL_BLOCK_SIZE)
+    {
+        rounded_size += (1ull << (findLastSet(size) - SL_COUNT_LOG2)) - 1;
+    }
+    u32 fl, sl;
+    mapSize(rounded_size, fl, sl);
+    if (fl < FL_COUNT)
+    {
+        // a class of the same first level that is at least as big, or the smallest class of a bigger first level
+        u32 sl_map = m_sl_bitmaps[fl] & (~0u << sl);
+        if (sl_map == 0)
+        {
+            const u32 fl_map = fl + 1 < 32 ? m_fl_bitmap & (~0u << (fl + 1)) : 0;
+            sl_map = fl_map != 0 ? m_sl_bitmaps[findFirstSet(fl_map)] : 0;
+            fl = fl_map != 0 ? findFirstSet(fl_map) : fl;
+        }
+        if (sl_map != 0)
+        {
+            return m_free_lists[fl][findFirstSet(sl_map)];
+        }
+    }
+
+    // the bigger classes are empty, but the class of the size itself can still hold a block that is big
+    // enough, like the single block of a new allocator
+    // NOTE: only the first blocks of the list are checked so the search stays bounded
+    mapSize(size, fl, sl);
+    if (fl >= FL_COUNT)
+    {
+        return NONE;
+    }
+    u32 node = m_free_lists[fl][sl];
+    for (u32 i = 0; i < MAX_FALLBACK_BLOCKS && node != NONE; i++, node = m_nodes[node].next_free)
+    {
+        if (m_nodes[node].size >= size)
+        {
+            return node;
+        }
+    }
+    return NONE;
+}
+
+void TlsfAllocator::splitBlock(u32 node, u64 size)
+{
+    if (m_nodes[node].size - size < GRANULARITY)
+    {
+        return;
+    }
+    const u32 rest_node = createNode();
+    Block& block = m_nodes[node];
+    Block& rest = m_nodes[rest_node];
+    rest.offset = block.offset + size;
+    rest.size = block.size - size;
+    rest.prev_physical = node;
+    rest.next_physical = block.next_physical;
+    if (block.next_physical != NONE)
+    {
+        m_nodes[block.next_physical].prev_physical = rest_node;
+    }
+    block.next_physical = rest_node;
+    block.size = size;
+
+    // NOTE: the block after the split one was not free, free blocks are always merged
+    insertFreeBlock(rest_node);
+}
+
+TlsfHeap::TlsfHeap(size_t capacity, u32 max_allocations, MemoryTag tag) :
+    m_allocator(capacity, max_allocations), m_tag(tag)
+{
+    m_memory = static_cast<u8*>(::operator new(capacity, std::align_val_t(HEAP_ALIGNMENT), std::nothrow));
+    if (m_memory == nullptr)
+    {
+        // error, out of memory, every allocation will fail
+        m_allocator = TlsfAllocator(0, 0);
+        return;
+    }
+    m_capacity = capacity;
+    TrackAllocation(m_tag, m_capacity);
+}
+
+TlsfHeap::~TlsfHeap()
+{
+    if (m_memory)
+    {
+        ::operator delete(m_memory, std::align_val_t(HEAP_ALIGNMENT));
+        TrackFree(m_tag, m_capacity);
+    }
+}
+
+MemoryBlock TlsfHeap::Allocate(size_t size, size_t alignment)
+{
+    // the header in front of the block is as big as the alignment so the block stays aligned
+    if (alignment > HEAP_ALIGNMENT)
+    {
+        // error, the offsets are only aligned relative to the memory of the heap
+        return MemoryBlock{ 0, nullptr };
+    }
+    const size_t header_size = alignment > TlsfAllocator::GRANULARITY ? alignment : TlsfAllocator::GRANULARITY;
+    if (header_size > m_capacity || size > m_capacity - header_size)
+    {
+        // error, the heap is too small
+        return MemoryBlock{ 0, nullptr };
+    }
+    TlsfAllocation allocation;
+    if (!m_allocator.Allocate(size + header_size, header_size, allocation))
+    {
+        // error, the heap is full
+        return MemoryBlock{ 0, nullptr };
+    }
+    u8* ptr = m_memory + allocation.offset + header_size;
+    reinterpret_cast<u32*>(ptr)[-1] = allocation.node;
+    return MemoryBlock{ size, ptr };
+}
+
+void TlsfHeap::Free(const MemoryBlock& block)
+{
+    if (block.ptr == nullptr)
+    {
+        return;
+    }
+    TlsfAllocation allocation;
+    allocation.node = reinterpret_cast<const u32*>(block.ptr)[-1];
+    m_allocator.Free(allocation);
+}
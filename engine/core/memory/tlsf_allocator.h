@@ -0,0 +1,172 @@
+#pragma once
+#include "engine/core/types.h"
+#include "memory.h"
+#include <cstddef>
+#include <vector>
+
+namespace deadrop
+{
+    namespace memory
+    {
+        // an allocation made by TlsfAllocator, 'node' identifies it when it is freed
+        struct TlsfAllocation
+        {
+            static constexpr u32 INVALID_NODE = ~0u;
+
+            u64 offset = 0;
+            u64 size = 0;
+            u32 node = INVALID_NODE;
+
+            bool IsValid() const { return node != INVALID_NODE; }
+        };
+
+        // the state of a TLSF allocator or heap
+        struct TlsfStats
+        {
+            // the size of the managed range
+            u64 capacity = 0;
+            // the bytes of the allocations, rounded up to the granularity and including alignment padding
+            u64 live_bytes = 0;
+            // the most live bytes since the allocator was created or reset
+            u64 peak_live_bytes = 0;
+            u64 free_bytes = 0;
+            // the size of the biggest allocation that can succeed without alignment padding
+            u64 largest_free_block = 0;
+            u32 live_allocations = 0;
+            u32 free_blocks = 0;
+            // 0 when all the free bytes are in a single block, close to 1 when they are split in many small blocks
+            float fragmentation = 0.0f;
+        };
+
+        // a two-level segregated fit (TLSF) allocator of ranges of offsets, the free blocks are kept in lists
+        // by size class (a power of two split in 32 linear steps) and two levels of bitmaps find a list that
+        // is big enough with two bit scans, so allocating and freeing take a bounded time that does not depend
+        // on the number of allocations
+        // the blocks are described outside of the managed range, which lets it suballocate memory that the
+        // cpu cannot or should not write to, like a gpu buffer that is suballocated by offset
+        // NOTE: a request is served from a bigger size class than its own, so every block found fits, when
+        // none of them has a block only the first few blocks of its own class are checked, so a request can
+        // fail while its class holds a block that is big enough further down the list
+        // NOTE: the descriptions of the blocks are reserved up front for 'max_allocations', allocating never
+        // allocates memory itself
+        // NOTE: not thread-safe, use one allocator per thread or lock around it
+        class TlsfAllocator
+        {
+        public:
+            // the sizes and offsets are multiples of this
+            static constexpr u64 GRANULARITY = 16;
+            static constexpr u32 DEFAULT_MAX_ALLOCATIONS = 16 * 1024;
+            // the biggest range an allocator can manage, 512 gigabytes
+            static constexpr u64 MAX_CAPACITY = 1ull << 39;
+
+            // manages the offsets [0, capacity)
+            // NOTE: 'capacity' is clamped to MAX_CAPACITY and rounded down to the granularity
+            explicit TlsfAllocator(u64 capacity, u32 max_allocations = DEFAULT_MAX_ALLOCATIONS);
+
+            // finds a free range of at least 'size' bytes whose offset is a multiple of 'alignment'
+            // NOTE: 'alignment' must be a power of two
+            // returns false when there is no free range big enough or 'max_allocations' are live
+            bool Allocate(u64 size, u64 alignment, TlsfAllocation& allocation);
+
+            // releases the range and merges it with the free ranges next to it
+            // NOTE: 'allocation' must be live and have been returned by this allocator
+            void Free(const TlsfAllocation& allocation);
+
+            // frees all the allocations at once
+            void Reset();
+
+            // returns the statistics of the allocator
+            // NOTE: walks the biggest size class to find the largest free block, do not call it in hot loops
+            TlsfStats GetStats() const;
+
+        private:
+            static constexpr u32 SL_COUNT_LOG2 = 5;
+            static constexpr u32 SL_COUNT = 1u << SL_COUNT_LOG2;
+            static constexpr u32 GRANULARITY_LOG2 = 4;
+            // the sizes below SMALL_BLOCK_SIZE all go in the first level, in linear steps of GRANULARITY
+            static constexpr u32 FL_SHIFT = SL_COUNT_LOG2 + GRANULARITY_LOG2;
+            static constexpr u64 SMALL_BLOCK_SIZE = 1ull << FL_SHIFT;
+            static constexpr u32 FL_MAX = 39;
+            static_assert(MAX_CAPACITY == 1ull << FL_MAX, "the biggest range must map to the last first level!");
+            static constexpr u32 FL_COUNT = FL_MAX - FL_SHIFT + 2;
+            static constexpr u32 NONE = ~0u;
+            // the most blocks checked in the list of the size class of a request, see findFreeBlock()
+            static constexpr u32 MAX_FALLBACK_BLOCKS = 4;
+
+            struct Block
+            {
+                u64 offset = 0;
+                u64 size = 0;
+                // the blocks before and after this one in the range
+                u32 prev_physical = NONE;
+                u32 next_physical = NONE;
+                // the free blocks of the same size class, or the next unused node when the node is unused
+                u32 prev_free = NONE;
+                u32 next_free = NONE;
+                bool free = false;
+            };
+
+            // returns the size class (first and second level) of a block of 'size' bytes
+            static void mapSize(u64 size, u32& fl, u32& sl);
+
+            u32 createNode();
+            void releaseNode(u32 node);
+
+            void insertFreeBlock(u32 node);
+            void removeFreeBlock(u32 node);
+
+            // returns a free block of at least 'size' bytes, or NONE
+            u32 findFreeBlock(u64 size) const;
+
+            // splits the end of the block off as a new free block when it is bigger than 'size'
+            void splitBlock(u32 node, u64 size);
+
+            u64 m_capacity = 0;
+            u32 m_max_allocations = 0;
+
+            std::vector<Block> m_nodes;
+            u32 m_unused_nodes = NONE;
+
+            u32 m_fl_bitmap = 0;
+            u32 m_sl_bitmaps[FL_COUNT] = {};
+            u32 m_free_lists[FL_COUNT][SL_COUNT];
+
+            u64 m_live_bytes = 0;
+            u64 m_peak_live_bytes = 0;
+            u32 m_live_allocations = 0;
+            u32 m_free_blocks = 0;
+        };
+
+        // a general-purpose heap on a block of cpu memory, managed by a TlsfAllocator
+        // NOTE: each allocation has a header of at least 16 bytes in front of it that stores its node
+        // NOTE: not thread-safe, use one heap per thread or lock around it
+        class TlsfHeap
+        {
+        public:
+            // reserves 'capacity' bytes from the global heap once, they are recorded under 'tag' by the memory tracker
+            explicit TlsfHeap(size_t capacity, u32 max_allocations = TlsfAllocator::DEFAULT_MAX_ALLOCATIONS,
+                MemoryTag tag = MEMORY_TAG_CORE);
+            ~TlsfHeap();
+
+            // delete the copy constructor and the copy assignment operator
+            TlsfHeap(const TlsfHeap&) = delete;
+            TlsfHeap& operator=(const TlsfHeap&) = delete;
+
+            // returns 'size' bytes aligned to 'alignment', a power of two up to 4096
+            // returns { 0, nullptr } when the heap has no free block big enough or the alignment is bigger than 4096
+            MemoryBlock Allocate(size_t size, size_t alignment = TlsfAllocator::GRANULARITY);
+
+            // releases a block returned by Allocate(), ignores { 0, nullptr }
+            void Free(const MemoryBlock& block);
+
+            // returns the statistics of the heap, the headers count as live bytes
+            TlsfStats GetStats() const { return m_allocator.GetStats(); }
+
+        private:
+            TlsfAllocator m_allocator;
+            u8* m_memory = nullptr;
+            size_t m_capacity = 0;
+            MemoryTag m_tag = MEMORY_TAG_CORE;
+        };
+    }
+}
@@ -0,0 +1,575 @@
+#include "mesh_codec.h"
+#include "engine/core/simd.h"
+#include <cstring>
+using namespace deadrop;
+using namespace deadrop::mesh;
+
+namespace
+{
+    // the first byte of the encoded buffers, the low bits are the version of the format
+    constexpr u8 VERTEX_HEADER = 0xA0;
+    constexpr u8 INDEX_HEADER = 0xE0;
+
+    // the number of vertices in a block, the byte planes of a block are encoded together
+    constexpr size_t BLOCK_SIZE = 256;
+    // the number of bytes that share a bit width inside a byte plane
+    constexpr size_t GROUP_SIZE = 16;
+    constexpr size_t MAX_VERTEX_SIZE = 256;
+
+    // the bit widths of the groups, stored as 2 bits per group before the data of a byte plane
+    enum GroupMode : u32
+    {
+        GROUP_MODE_ZERO = 0,
+        GROUP_MODE_2BITS,
+        GROUP_MODE_4BITS,
+        GROUP_MODE_8BITS
+    };
+
+    constexpr size_t GROUP_DATA_SIZE[4] = { 0, 4, 8, 16 };
+
+    // the zigzag encoding maps small negative and positive differences to small unsigned values
+    inline u32 zigzagEncode(u32 value)
+    {
+        return (value << 1) ^ static_cast<u32>(static_cast<i32>(value) >> 31);
+    }
+
+    inline u32 zigzagDecode(u32 value)
+    {
+        return (value >> 1) ^ (0u - (value & 1));
+    }
+
+    // vertex encoding
+
+    void encodeGroup(std::vector<u8>& dst, const u8* values, GroupMode mode)
+    {
+        switch (mode)
+        {
+        case GROUP_MODE_2BITS:
+            for (size_t i = 0; i < GROUP_SIZE; i += 4)
+            {
+                dst.push_back(static_cast<u8>(values[i] | (values[i + 1] << 2) | (values[i + 2] << 4) | (values[i + 3] << 6)));
+            }
+            break;
+        case GROUP_MODE_4BITS:
+            for (size_t i = 0; i < GROUP_SIZE; i += 2)
+            {
+                dst.push_back(static_cast<u8>(values[i] | (values[i + 1] << 4)));
+            }
+            break;
+        case GROUP_MODE_8BITS:
+            dst.insert(dst.end(), values, values + GROUP_SIZE);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void encodePlane(std::vector<u8>& dst, const u8* plane, size_t group_count)
+    {
+        // the modes of 4 groups are packed in each header byte
+        const size_t header = dst.size();
+        dst.resize(dst.size() + (group_count + 3) / 4, 0);
+        for (size_t g = 0; g < group_count; g++)
+        {
+            const u8* values = plane + g * GROUP_SIZE;
+            u8 max_value = 0;
+            for (size_t i = 0; i < GROUP_SIZE; i++)
+            {
+                max_value = values[i] > max_value ? values[i] : max_value;
+            }
+            const GroupMode mode = max_value == 0 ? GROUP_MODE_ZERO : (max_value < 4 ? GROUP_MODE_2BITS : (max_value < 16 ? GROUP_MODE_4BITS : GROUP_MODE_8BITS));
+            dst[header + g / 4] |= static_cast<u8>(mode << ((g % 4) * 2));
+            encodeGroup(dst, values, mode);
+        }
+    }
+
+    // vertex decoding
+
+    // decodes the 16 values of a group
+    inline __m128i decodeGroup(const u8* src, GroupMode mode)
+    {
+        switch (mode)
+        {
+        case GROUP_MODE_2BITS:
+        {
+            // spread the 4 values of each byte over 4 registers and interleave them back in order
+            i32 packed;
+            memcpy(&packed, src, sizeof(packed));
+            const __m128i x = _mm_cvtsi32_si128(packed);
+            const __m128i mask = _mm_set1_epi8(0x03);
+            const __m128i a = _mm_and_si128(x, mask);
+            const __m128i b = _mm_and_si128(_mm_srli_epi16(x, 2), mask);
+            const __m128i c = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+            const __m128i d = _mm_and_si128(_mm_srli_epi16(x, 6), mask);
+            return _mm_unpacklo_epi16(_mm_unpacklo_epi8(a, b), _mm_unpacklo_epi8(c, d));
+        }
+        case GROUP_MODE_4BITS:
+        {
+            const __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+            const __m128i mask = _mm_set1_epi8(0x0F);
+            return _mm_unpacklo_epi8(_mm_and_si128(x, mask), _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+        }
+        case GROUP_MODE_8BITS:
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        default:
+            return _mm_setzero_si128();
+        }
+    }
+
+    // decodes a byte plane of 'group_count' groups into 'plane', returns the position after it or nullptr
+    // when the data ends before the plane does
+    const u8* decodePlane(u8* plane, size_t group_count, const u8* src, const u8* src_end)
+    {
+        const size_t header_size = (group_count + 3) / 4;
+        if (static_cast<size_t>(src_end - src) < header_size)
+        {
+            return nullptr;
+        }
+        const u8* header = src;
+        const u8* data = src + header_size;
+
+        // check that all the groups fit before decoding any of them
+        size_t data_size = 0;
+        for (size_t g = 0; g < group_count; g++)
+        {
+            data_size += GROUP_DATA_SIZE[(header[g / 4] >> ((g % 4) * 2)) & 3];
+        }
+        if (static_cast<size_t>(src_end - data) < data_size)
+        {
+            return nullptr;
+        }
+
+        for (size_t g = 0; g < group_count; g++)
+        {
+            const GroupMode mode = static_cast<GroupMode>((header[g / 4] >> ((g % 4) * 2)) & 3);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(plane + g * GROUP_SIZE), decodeGroup(data, mode));
+            data += GROUP_DATA_SIZE[mode];
+        }
+        return data;
+    }
+
+    // adds the zigzag decoded differences of 4 consecutive vertices to the previous value of the word
+    inline __m128i decodeDeltas4(__m128i zigzag, __m128i& previous)
+    {
+        const __m128i one = _mm_set1_epi32(1);
+        __m128i x = _mm_xor_si128(_mm_srli_epi32(zigzag, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(zigzag, one)));
+        // prefix sum over the 4 lanes
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, previous);
+        previous = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        return x;
+    }
+
+    // index encoding
+
+    // the edges of the last triangles, stored in the direction the next triangle that shares them sees them
+    constexpr u32 EDGE_FIFO_SIZE = 16;
+    // the edge index of a triangle that does not share an edge with the fifo
+    constexpr u32 NO_EDGE = 15;
+
+    struct EdgeFifo
+    {
+        u32 a[EDGE_FIFO_SIZE];
+        u32 b[EDGE_FIFO_SIZE];
+        u32 head = 0;
+
+        EdgeFifo()
+        {
+            memset(a, 0xFF, sizeof(a));
+            memset(b, 0xFF, sizeof(b));
+        }
+
+        void push(u32 from, u32 to)
+        {
+            a[head] = from;
+            b[head] = to;
+            head = (head + 1) % EDGE_FIFO_SIZE;
+        }
+
+        // the position of an entry counting from the newest, 0 is the newest
+        u32 slot(u32 age) const { return (head + EDGE_FIFO_SIZE - 1 - age) % EDGE_FIFO_SIZE; }
+
+        // pushes the edges of a triangle, reversed
+        void pushTriangle(u32 i0, u32 i1, u32 i2)
+        {
+            push(i1, i0);
+            push(i2, i1);
+            push(i0, i2);
+        }
+    };
+
+    // the last distinct vertices that were used, the third vertex of a triangle that shares an edge is
+    // often one of them, the newest one rarely is since it is usually on the shared edge
+    constexpr u32 VERTEX_FIFO_SIZE = 8;
+
+    struct VertexFifo
+    {
+        u32 vertices[VERTEX_FIFO_SIZE];
+        u32 head = 0;
+
+        VertexFifo()
+        {
+            memset(vertices, 0xFF, sizeof(vertices));
+        }
+
+        // returns the age of the vertex, 0 is the newest, or VERTEX_FIFO_SIZE when it is not in the fifo
+        u32 find(u32 vertex) const
+        {
+            for (u32 age = 0; age < VERTEX_FIFO_SIZE; age++)
+            {
+                if (vertices[(head + VERTEX_FIFO_SIZE - 1 - age) % VERTEX_FIFO_SIZE] == vertex)
+                {
+                    return age;
+                }
+            }
+            return VERTEX_FIFO_SIZE;
+        }
+
+        u32 get(u32 age) const { return vertices[(head + VERTEX_FIFO_SIZE - 1 - age) % VERTEX_FIFO_SIZE]; }
+
+        void push(u32 vertex)
+        {
+            if (find(vertex) == VERTEX_FIFO_SIZE)
+            {
+                vertices[head] = vertex;
+                head = (head + 1) % VERTEX_FIFO_SIZE;
+            }
+        }
+
+        void pushTriangle(u32 i0, u32 i1, u32 i2)
+        {
+            push(i0);
+            push(i1);
+            push(i2);
+        }
+    };
+
+    // how the third vertex of a triangle that shares an edge is stored, the high 4 bits of its code byte
+    // are 'rotation * THIRD_MODE_COUNT + mode'
+    enum ThirdMode : u32
+    {
+        // it is 'next', the vertex that is expected to be used for the first time
+        THIRD_MODE_NEXT = 0,
+        // it is in the vertex fifo at age 1, 2 or 3
+        THIRD_MODE_FIFO_1,
+        THIRD_MODE_FIFO_2,
+        THIRD_MODE_FIFO_3,
+        // it is a varint after the code byte
+        THIRD_MODE_VARINT,
+        THIRD_MODE_COUNT
+    };
+
+    void writeVarint(std::vector<u8>& dst, u32 value)
+    {
+        while (value >= 0x80)
+        {
+            dst.push_back(static_cast<u8>(value | 0x80));
+            value >>= 7;
+        }
+        dst.push_back(static_cast<u8>(value));
+    }
+
+    // returns false when the data ends in the middle of the varint
+    bool readVarint(const u8*& src, const u8* src_end, u32& value)
+    {
+        value = 0;
+        for (u32 shift = 0; shift < 35; shift += 7)
+        {
+            if (src == src_end)
+            {
+                return false;
+            }
+            const u8 byte = *src++;
+            value |= static_cast<u32>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+bool deadrop::mesh::EncodeVertexBuffer(std::vector<u8>& dst, const void* vertices, size_t vertex_count, size_t vertex_size)
+{
+    if (vertex_size == 0 || vertex_size % 4 != 0 || vertex_size > MAX_VERTEX_SIZE)
+    {
+        // error, unsupported vertex size
+        return false;
+    }
+
+    dst.clear();
+    dst.push_back(VERTEX_HEADER);
+
+    const size_t word_count = vertex_size / 4;
+    u32 previous[MAX_VERTEX_SIZE / 4] = {};
+    u32 deltas[BLOCK_SIZE];
+    u8 plane[BLOCK_SIZE];
+    for (size_t first = 0; first < vertex_count; first += BLOCK_SIZE)
+    {
+        const size_t block_size = vertex_count - first < BLOCK_SIZE ? vertex_count - first : BLOCK_SIZE;
+        const size_t group_count = (block_size + GROUP_SIZE - 1) / GROUP_SIZE;
+        const u8* block = static_cast<const u8*>(vertices) + first * vertex_size;
+        for (size_t w = 0; w < word_count; w++)
+        {
+            for (size_t i = 0; i < block_size; i++)
+            {
+                u32 word;
+                memcpy(&word, block + i * vertex_size + w * 4, sizeof(word));
+                deltas[i] = zigzagEncode(word - previous[w]);
+                previous[w] = word;
+            }
+
+            // the planes of the 4 bytes of the word, the padding of the last group is zero
+            for (u32 byte = 0; byte < 4; byte++)
+            {
+                memset(plane, 0, group_count * GROUP_SIZE);
+                for (size_t i = 0; i < block_size; i++)
+                {
+                    plane[i] = static_cast<u8>(deltas[i] >> (byte * 8));
+                }
+                encodePlane(dst, plane, group_count);
+            }
+        }
+    }
+    return true;
+}
+
+bool deadrop::mesh::DecodeVertexBuffer(void* dst, size_t vertex_count, size_t vertex_size, const u8* src, size_t src_size)
+{
+    if (vertex_size == 0 || vertex_size % 4 != 0 || vertex_size > MAX_VERTEX_SIZE || src_size == 0 || src[0] != VERTEX_HEADER)
+    {
+        // error, unsupported vertex size or not an encoded vertex buffer
+        return false;
+    }
+
+    const u8* data = src + 1;
+    const u8* src_end = src + src_size;
+    const size_t word_count = vertex_size / 4;
+    __m128i previous[MAX_VERTEX_SIZE / 4];
+    for (size_t w = 0; w < word_count; w++)
+    {
+        previous[w] = _mm_setzero_si128();
+    }
+
+    // the words of a block are decoded a word at a time for all the vertices (columns), then transposed back to vertices
+    alignas(16) u8 planes[4][BLOCK_SIZE];
+    std::vector<u32> columns(word_count * BLOCK_SIZE);
+    for (size_t first = 0; first < vertex_count; first += BLOCK_SIZE)
+    {
+        const size_t block_size = vertex_count - first < BLOCK_SIZE ? vertex_count - first : BLOCK_SIZE;
+        const size_t group_count = (block_size + GROUP_SIZE - 1) / GROUP_SIZE;
+        for (size_t w = 0; w < word_count; w++)
+        {
+            for (u32 byte = 0; byte < 4; byte++)
+            {
+                data = decodePlane(planes[byte], group_count, data, src_end);
+                if (!data)
+                {
+                    // error, the data ends too early
+                    return false;
+                }
+            }
+
+            // interleave the 4 planes back into words, 16 vertices at a time
+            // NOTE: the padding of the last group decodes to zero differences, so it leaves 'previous'
+            // at the value of the last vertex
+            u32* words = &columns[w * BLOCK_SIZE];
+            for (size_t i = 0; i < group_count * GROUP_SIZE; i += GROUP_SIZE)
+            {
+                const __m128i b0 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[0] + i));
+                const __m128i b1 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[1] + i));
+                const __m128i b2 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[2] + i));
+                const __m128i b3 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[3] + i));
+                const __m128i b01_lo = _mm_unpacklo_epi8(b0, b1);
+                const __m128i b01_hi = _mm_unpackhi_epi8(b0, b1);
+                const __m128i b23_lo = _mm_unpacklo_epi8(b2, b3);
+                const __m128i b23_hi = _mm_unpackhi_epi8(b2, b3);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(words + i), decodeDeltas4(_mm_unpacklo_epi16(b01_lo, b23_lo), previous[w]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(words + i + 4), decodeDeltas4(_mm_unpackhi_epi16(b01_lo, b23_lo), previous[w]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(words + i + 8), decodeDeltas4(_mm_unpacklo_epi16(b01_hi, b23_hi), previous[w]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(words + i + 12), decodeDeltas4(_mm_unpackhi_epi16(b01_hi, b23_hi), previous[w]));
+            }
+        }
+
+        // transpose 4 words of 4 vertices at a time, the words left at the end of the vertices are copied one by one
+        u8* block = static_cast<u8*>(dst) + first * vertex_size;
+        const size_t transposed_words = word_count & ~size_t(3);
+        for (size_t i = 0; i < block_size; i += 4)
+        {
+            const size_t vertices = block_size - i < 4 ? block_size - i : 4;
+            size_t w = 0;
+            if (vertices == 4)
+            {
+                for (; w < transposed_words; w += 4)
+                {
+                    __m128 r0 = _mm_loadu_ps(reinterpret_cast<const float*>(&columns[w * BLOCK_SIZE + i]));
+                    __m128 r1 = _mm_loadu_ps(reinterpret_cast<const float*>(&columns[(w + 1) * BLOCK_SIZE + i]));
+                    __m128 r2 = _mm_loadu_ps(reinterpret_cast<const float*>(&columns[(w + 2) * BLOCK_SIZE + i]));
+                    __m128 r3 = _mm_loadu_ps(reinterpret_cast<const float*>(&columns[(w + 3) * BLOCK_SIZE + i]));
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    u8* out = block + i * vertex_size + w * 4;
+                    _mm_storeu_ps(reinterpret_cast<float*>(out), r0);
+                    _mm_storeu_ps(reinterpret_cast<float*>(out + vertex_size), r1);
+                    _mm_storeu_ps(reinterpret_cast<float*>(out + vertex_size * 2), r2);
+                    _mm_storeu_ps(reinterpret_cast<float*>(out + vertex_size * 3), r3);
+                }
+            }
+            for (; w < word_count; w++)
+            {
+                for (size_t v = 0; v < vertices; v++)
+                {
+                    memcpy(block + (i + v) * vertex_size + w * 4, &columns[w * BLOCK_SIZE + i + v], sizeof(u32));
+                }
+            }
+        }
+    }
+    return data == src_end;
+}
+
+bool deadrop::mesh::EncodeIndexBuffer(std::vector<u8>& dst, const u32* indices, size_t index_count)
+{
+    if (index_count % 3 != 0)
+    {
+        // error, not a triangle list
+        return false;
+    }
+
+    dst.clear();
+    dst.push_back(INDEX_HEADER);
+
+    // 'next' is the vertex that is expected to be used for the first time next,
+    // the vertices are stored relative to it
+    EdgeFifo edges;
+    VertexFifo recent;
+    u32 next = 0;
+    for (size_t i = 0; i < index_count; i += 3)
+    {
+        const u32* triangle = indices + i;
+
+        // look for an edge of the triangle in the fifo, in all 3 rotations of the triangle
+        u32 edge = NO_EDGE;
+        u32 rotation = 0;
+        for (u32 age = 0; age < NO_EDGE && edge == NO_EDGE; age++)
+        {
+            const u32 slot = edges.slot(age);
+            for (u32 r = 0; r < 3; r++)
+            {
+                if (edges.a[slot] == triangle[r] && edges.b[slot] == triangle[(r + 1) % 3])
+                {
+                    edge = age;
+                    rotation = r;
+                    break;
+                }
+            }
+        }
+
+        if (edge != NO_EDGE)
+        {
+            // code byte: the age of the edge, the rotation and how the third vertex is stored
+            const u32 third = triangle[(rotation + 2) % 3];
+            const u32 age = recent.find(third);
+            ThirdMode mode = THIRD_MODE_VARINT;
+            if (third == next)
+            {
+                mode = THIRD_MODE_NEXT;
+            }
+            else if (age >= 1 && age <= 3)
+            {
+                mode = static_cast<ThirdMode>(THIRD_MODE_FIFO_1 + age - 1);
+            }
+            dst.push_back(static_cast<u8>(edge | ((rotation * THIRD_MODE_COUNT + mode) << 4)));
+            if (mode == THIRD_MODE_VARINT)
+            {
+                writeVarint(dst, zigzagEncode(third - next));
+            }
+            next = third >= next ? third + 1 : next;
+        }
+        else
+        {
+            dst.push_back(static_cast<u8>(NO_EDGE));
+            for (u32 corner = 0; corner < 3; corner++)
+            {
+                writeVarint(dst, zigzagEncode(triangle[corner] - next));
+                next = triangle[corner] >= next ? triangle[corner] + 1 : next;
+            }
+        }
+        edges.pushTriangle(triangle[0], triangle[1], triangle[2]);
+        recent.pushTriangle(triangle[0], triangle[1], triangle[2]);
+    }
+    return true;
+}
+
+bool deadrop::mesh::DecodeIndexBuffer(u32* dst, size_t index_count, const u8* src, size_t src_size)
+{
+    if (index_count % 3 != 0 || src_size == 0 || src[0] != INDEX_HEADER)
+    {
+        // error, not a triangle list or not an encoded index buffer
+        return false;
+    }
+
+    const u8* data = src + 1;
+    const u8* src_end = src + src_size;
+    EdgeFifo edges;
+    VertexFifo recent;
+    u32 next = 0;
+    for (size_t i = 0; i < index_count; i += 3)
+    {
+        if (data == src_end)
+        {
+            // error, the data ends too early
+            return false;
+        }
+        const u8 code = *data++;
+        u32* triangle = dst + i;
+        const u32 edge = code & 0x0F;
+        if (edge != NO_EDGE)
+        {
+            const u32 rotation = (code >> 4) / THIRD_MODE_COUNT;
+            const u32 mode = (code >> 4) % THIRD_MODE_COUNT;
+            if (rotation > 2)
+            {
+                // error, corrupted data
+                return false;
+            }
+            u32 third = next;
+            if (mode >= THIRD_MODE_FIFO_1 && mode <= THIRD_MODE_FIFO_3)
+            {
+                third = recent.get(mode - THIRD_MODE_FIFO_1 + 1);
+            }
+            else if (mode == THIRD_MODE_VARINT)
+            {
+                u32 delta;
+                if (!readVarint(data, src_end, delta))
+                {
+                    // error, the data ends too early
+                    return false;
+                }
+                third = next + zigzagDecode(delta);
+            }
+            const u32 slot = edges.slot(edge);
+            triangle[rotation] = edges.a[slot];
+            triangle[(rotation + 1) % 3] = edges.b[slot];
+            triangle[(rotation + 2) % 3] = third;
+            next = third >= next ? third + 1 : next;
+        }
+        else
+        {
+            for (u32 corner = 0; corner < 3; corner++)
+            {
+                u32 delta;
+                if (!readVarint(data, src_end, delta))
+                {
+                    // error, the data ends too early
+                    return false;
+                }
+                triangle[corner] = next + zigzagDecode(delta);
+                next = triangle[corner] >= next ? triangle[corner] + 1 : next;
+            }
+        }
+        edges.pushTriangle(triangle[0], triangle[1], triangle[2]);
+        recent.pushTriangle(triangle[0], triangle[1], triangle[2]);
+    }
+    return data == src_end;
+}
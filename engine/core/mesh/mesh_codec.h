@@ -0,0 +1,39 @@
+#pragma once
+#include "engine/core/types.h"
+#include <cstddef>
+#include <vector>
+
+// lossless compression of vertex and index buffers for storing meshes on disk, the decoded buffers
+// are identical to the encoded ones, byte for byte
+// NOTE: the encoded data does not store the counts or the vertex size, store them next to it:
+//
+//     std::vector<u8> encoded;
+//     EncodeVertexBuffer(encoded, vertices.data(), vertex_count, vertex_size);
+//     file.Write(vertex_count); file.Write(vertex_size); file.Write(encoded_size); file.Write(encoded);
+namespace deadrop::mesh
+{
+    // vertex buffers are split into blocks of vertices, each 32-bit word of a vertex is stored as the zigzag
+    // encoded difference to the same word of the previous vertex, and the bytes of those differences are
+    // regrouped by their position in the vertex (byte planes), so similar bytes are next to each other and
+    // the small ones are stored with 0, 2 or 4 bits each
+    // NOTE: 'vertex_size' must be a multiple of 4 and at most 256 bytes, the compression works best on
+    // vertices that were ordered with OptimizeVertexFetchRemap()
+    // returns false when the vertex size is not supported
+    bool EncodeVertexBuffer(std::vector<u8>& dst, const void* vertices, size_t vertex_count, size_t vertex_size);
+
+    // decodes a buffer made by EncodeVertexBuffer() into 'dst', which must have room for 'vertex_count * vertex_size' bytes
+    // NOTE: decodes using sse2 instructions, at a few gigabytes per second
+    // returns false when the data is corrupted or was encoded with other counts
+    bool DecodeVertexBuffer(void* dst, size_t vertex_count, size_t vertex_size, const u8* src, size_t src_size);
+
+    // index buffers are encoded a triangle at a time, a triangle that shares an edge with one of the last
+    // triangles and whose third vertex is new (the common case after OptimizeVertexCache() and
+    // OptimizeVertexFetchRemap()) takes a single byte, the others store their vertices as small varints
+    // NOTE: the order of the triangles and of the indices inside them is kept exactly
+    // returns false when the index count is not a multiple of 3
+    bool EncodeIndexBuffer(std::vector<u8>& dst, const u32* indices, size_t index_count);
+
+    // decodes a buffer made by EncodeIndexBuffer() into 'dst', which must have room for 'index_count' indices
+    // returns false when the data is corrupted or was encoded with another count
+    bool DecodeIndexBuffer(u32* dst, size_t index_count, const u8* src, size_t src_size);
+}
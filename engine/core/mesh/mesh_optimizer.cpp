@@ -0,0 +1,388 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+using namespace deadrop;
+using namespace deadrop::mesh;
+
+namespace
+{
+    // the size of the lru cache that OptimizeVertexCache() simulates, the scores favor the most recent
+    // entries so the result is good for any real cache size below this
+    constexpr u32 OPTIMIZER_CACHE_SIZE = 32;
+
+    // the scoring constants of forsyth's algorithm
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    // the score of a vertex from its position in the cache and the number of triangles that still use it
+    float vertexScore(i32 cache_position, u32 remaining_triangles)
+    {
+        // a vertex that no triangle needs anymore does not add anything
+        if (remaining_triangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cache_position >= 0)
+        {
+            // the vertices of the last triangle get a fixed score so the next triangle does not
+            // just walk back along the strip
+            if (cache_position < 3)
+            {
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                const float scale = 1.0f / static_cast<float>(OPTIMIZER_CACHE_SIZE - 3);
+                score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scale, CACHE_DECAY_POWER);
+            }
+        }
+
+        // vertices that few triangles still use are boosted so they get finished and no lonely triangles remain
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangles), -VALENCE_BOOST_POWER);
+    }
+
+    // loads the position of a vertex
+    inline void loadPosition(const void* positions, size_t stride, u32 vertex, float (&position)[3])
+    {
+        memcpy(position, static_cast<const u8*>(positions) + vertex * stride, sizeof(position));
+    }
+}
+
+VertexCacheStats deadrop::mesh::AnalyzeVertexCache(const u32* indices, size_t index_count, size_t vertex_count, u32 cache_size)
+{
+    // a fifo cache, a vertex is in the cache when it was added in the last 'cache_size' misses
+    std::vector<u32> timestamps(vertex_count, 0);
+    std::vector<bool> referenced(vertex_count, false);
+    u32 time = cache_size + 1;
+    u32 unique_vertices = 0;
+    for (size_t i = 0; i < index_count; i++)
+    {
+        const u32 vertex = indices[i];
+        if (time - timestamps[vertex] > cache_size)
+        {
+            timestamps[vertex] = time++;
+        }
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            unique_vertices++;
+        }
+    }
+
+    VertexCacheStats stats;
+    stats.vertices_shaded = time - (cache_size + 1);
+    stats.acmr = index_count ? static_cast<float>(stats.vertices_shaded) / static_cast<float>(index_count / 3) : 0.0f;
+    stats.atvr = unique_vertices ? static_cast<float>(stats.vertices_shaded) / static_cast<float>(unique_vertices) : 0.0f;
+    return stats;
+}
+
+void deadrop::mesh::OptimizeVertexCache(u32* dst, const u32* indices, size_t index_count, size_t vertex_count)
+{
+    const size_t triangle_count = index_count / 3;
+
+    // copy the indices so 'dst' can be the same array
+    const std::vector<u32> source(indices, indices + triangle_count * 3);
+
+    // the triangles that use each vertex, the first 'remaining' of them are not emitted yet
+    std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+    for (u32 index : source)
+    {
+        adjacency_offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        adjacency_offsets[v + 1] += adjacency_offsets[v];
+    }
+    std::vector<u32> adjacency(source.size());
+    std::vector<u32> remaining(vertex_count, 0);
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        for (u32 corner = 0; corner < 3; corner++)
+        {
+            const u32 vertex = source[t * 3 + corner];
+            adjacency[adjacency_offsets[vertex] + remaining[vertex]++] = static_cast<u32>(t);
+        }
+    }
+
+    std::vector<float> vertex_scores(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        vertex_scores[v] = vertexScore(-1, remaining[v]);
+    }
+    std::vector<bool> emitted(triangle_count, false);
+
+    // the cache has room for the 3 vertices of the new triangle before the old entries are pushed out
+    u32 cache[OPTIMIZER_CACHE_SIZE + 3];
+    u32 cache_size = 0;
+    size_t next_unemitted = 0;
+    u32 best_triangle = triangle_count ? 0 : ~0u;
+    for (size_t output = 0; output < triangle_count; output++)
+    {
+        // when no triangle around the cache is left continue with the next triangle in input order,
+        // searching for the best one of the whole mesh would make this quadratic
+        if (best_triangle == ~0u)
+        {
+            while (emitted[next_unemitted])
+            {
+                next_unemitted++;
+            }
+            best_triangle = static_cast<u32>(next_unemitted);
+        }
+
+        const u32* triangle = &source[static_cast<size_t>(best_triangle) * 3];
+        memcpy(dst + output * 3, triangle, sizeof(u32) * 3);
+        emitted[best_triangle] = true;
+
+        // remove the triangle from its vertices and move them to the front of the cache
+        u32 new_cache[OPTIMIZER_CACHE_SIZE + 3];
+        u32 new_cache_size = 0;
+        for (u32 corner = 0; corner < 3; corner++)
+        {
+            const u32 vertex = triangle[corner];
+            u32* triangles = &adjacency[adjacency_offsets[vertex]];
+            u32* last = triangles + remaining[vertex] - 1;
+            *std::find(triangles, last, best_triangle) = *last;
+            remaining[vertex]--;
+
+            // NOTE: degenerate triangles use a vertex more than once, it is only cached once
+            if (std::find(new_cache, new_cache + new_cache_size, vertex) == new_cache + new_cache_size)
+            {
+                new_cache[new_cache_size++] = vertex;
+            }
+        }
+        for (u32 i = 0; i < cache_size; i++)
+        {
+            const u32 vertex = cache[i];
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+            {
+                new_cache[new_cache_size++] = vertex;
+            }
+        }
+        memcpy(cache, new_cache, sizeof(u32) * new_cache_size);
+        cache_size = new_cache_size;
+
+        // update the scores of the vertices in the cache, including the ones that were just pushed out
+        for (u32 i = 0; i < cache_size; i++)
+        {
+            const u32 vertex = cache[i];
+            vertex_scores[vertex] = vertexScore(i < OPTIMIZER_CACHE_SIZE ? static_cast<i32>(i) : -1, remaining[vertex]);
+        }
+
+        // update the triangles of the cached vertices and pick the best one as the next triangle
+        best_triangle = ~0u;
+        float best_score = 0.0f;
+        for (u32 i = 0; i < cache_size; i++)
+        {
+            const u32 vertex = cache[i];
+            const u32* triangles = &adjacency[adjacency_offsets[vertex]];
+            for (u32 j = 0; j < remaining[vertex]; j++)
+            {
+                const u32 t = triangles[j];
+                const u32* corners = &source[static_cast<size_t>(t) * 3];
+                const float score = vertex_scores[corners[0]] + vertex_scores[corners[1]] + vertex_scores[corners[2]];
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best_triangle = t;
+                }
+            }
+        }
+        cache_size = std::min(cache_size, OPTIMIZER_CACHE_SIZE);
+    }
+}
+
+void deadrop::mesh::OptimizeOverdraw(u32* dst, const u32* indices, size_t index_count, const void* positions, size_t vertex_count, size_t position_stride)
+{
+    const size_t triangle_count = index_count / 3;
+    const std::vector<u32> source(indices, indices + triangle_count * 3);
+
+    // the clusters start at the triangles whose 3 vertices all miss the cache, those are the points where the
+    // cache optimization had to restart, so drawing the clusters in a different order adds few misses
+    std::vector<u32> cluster_starts;
+    std::vector<u32> timestamps(vertex_count, 0);
+    u32 time = DEFAULT_VERTEX_CACHE_SIZE + 1;
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        u32 misses = 0;
+        for (u32 corner = 0; corner < 3; corner++)
+        {
+            const u32 vertex = source[t * 3 + corner];
+            if (time - timestamps[vertex] > DEFAULT_VERTEX_CACHE_SIZE)
+            {
+                timestamps[vertex] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3)
+        {
+            cluster_starts.push_back(static_cast<u32>(t));
+        }
+    }
+    cluster_starts.push_back(static_cast<u32>(triangle_count));
+    const size_t cluster_count = cluster_starts.size() - 1;
+
+    // the centroid of the mesh, weighted by the area of the triangles
+    std::vector<float> cluster_data(cluster_count * 6, 0.0f);
+    float mesh_centroid[3] = {};
+    float mesh_area = 0.0f;
+    for (size_t cluster = 0; cluster < cluster_count; cluster++)
+    {
+        float* centroid = &cluster_data[cluster * 6];
+        float* normal = centroid + 3;
+        float cluster_area = 0.0f;
+        for (u32 t = cluster_starts[cluster]; t < cluster_starts[cluster + 1]; t++)
+        {
+            float p0[3], p1[3], p2[3];
+            loadPosition(positions, position_stride, source[t * 3], p0);
+            loadPosition(positions, position_stride, source[t * 3 + 1], p1);
+            loadPosition(positions, position_stride, source[t * 3 + 2], p2);
+            const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+            // the length of the cross product is twice the area, so summing it weights the normals by area
+            const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (u32 c = 0; c < 3; c++)
+            {
+                centroid[c] += (p0[c] + p1[c] + p2[c]) * area;
+                normal[c] += n[c];
+            }
+            cluster_area += area;
+        }
+
+        for (u32 c = 0; c < 3; c++)
+        {
+            mesh_centroid[c] += centroid[c];
+            centroid[c] = cluster_area > 0.0f ? centroid[c] / (cluster_area * 3.0f) : 0.0f;
+        }
+        mesh_area += cluster_area;
+    }
+    for (u32 c = 0; c < 3; c++)
+    {
+        mesh_centroid[c] = mesh_area > 0.0f ? mesh_centroid[c] / (mesh_area * 3.0f) : 0.0f;
+    }
+
+    // clusters that are far out from the center and face outwards are likely to occlude the others,
+    // so they are drawn first
+    std::vector<float> sort_keys(cluster_count);
+    std::vector<u32> order(cluster_count);
+    for (size_t cluster = 0; cluster < cluster_count; cluster++)
+    {
+        const float* centroid = &cluster_data[cluster * 6];
+        const float* normal = centroid + 3;
+        const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float key = 0.0f;
+        for (u32 c = 0; c < 3; c++)
+        {
+            key += (centroid[c] - mesh_centroid[c]) * normal[c];
+        }
+        sort_keys[cluster] = length > 0.0f ? key / length : 0.0f;
+        order[cluster] = static_cast<u32>(cluster);
+    }
+    std::stable_sort(order.begin(), order.end(), [&sort_keys](u32 a, u32 b) { return sort_keys[a] > sort_keys[b]; });
+
+    u32* output = dst;
+    for (u32 cluster : order)
+    {
+        const size_t first = cluster_starts[cluster] * size_t(3);
+        const size_t count = (cluster_starts[cluster + 1] - cluster_starts[cluster]) * size_t(3);
+        memcpy(output, &source[first], sizeof(u32) * count);
+        output += count;
+    }
+}
+
+size_t deadrop::mesh::OptimizeVertexFetchRemap(u32* remap, const u32* indices, size_t index_count, size_t vertex_count)
+{
+    std::fill(remap, remap + vertex_count, ~0u);
+    u32 next_vertex = 0;
+    for (size_t i = 0; i < index_count; i++)
+    {
+        if (remap[indices[i]] == ~0u)
+        {
+            remap[indices[i]] = next_vertex++;
+        }
+    }
+    return next_vertex;
+}
+
+void deadrop::mesh::RemapIndices(u32* dst, const u32* indices, size_t index_count, const u32* remap)
+{
+    for (size_t i = 0; i < index_count; i++)
+    {
+        dst[i] = remap[indices[i]];
+    }
+}
+
+void deadrop::mesh::RemapVertices(void* dst, const void* vertices, size_t vertex_count, size_t vertex_stride, const u32* remap)
+{
+    const u8* src = static_cast<const u8*>(vertices);
+    u8* out = static_cast<u8*>(dst);
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        if (remap[v] != ~0u)
+        {
+            memcpy(out + remap[v] * vertex_stride, src + v * vertex_stride, vertex_stride);
+        }
+    }
+}
+
+void deadrop::mesh::ConvertIndicesTo16Bit(u16* dst, const u32* indices, size_t index_count)
+{
+    for (size_t i = 0; i < index_count; i++)
+    {
+        dst[i] = static_cast<u16>(indices[i]);
+    }
+}
+
+bool deadrop::mesh::OptimizeMesh(
+    const void* vertices, size_t vertex_count, size_t vertex_stride, size_t position_offset,
+    const u32* indices, size_t index_count, OptimizedMesh& mesh)
+{
+    // error, not a triangle list
+    if (index_count % 3 != 0)
+    {
+        return false;
+    }
+
+    // error, an index points past the vertices
+    for (size_t i = 0; i < index_count; i++)
+    {
+        if (indices[i] >= vertex_count)
+        {
+            return false;
+        }
+    }
+
+    std::vector<u32> optimized(index_count);
+    OptimizeVertexCache(optimized.data(), indices, index_count, vertex_count);
+    OptimizeOverdraw(optimized.data(), optimized.data(), index_count,
+        static_cast<const u8*>(vertices) + position_offset, vertex_count, vertex_stride);
+
+    std::vector<u32> remap(vertex_count);
+    const size_t used_vertex_count = OptimizeVertexFetchRemap(remap.data(), optimized.data(), index_count, vertex_count);
+    RemapIndices(optimized.data(), optimized.data(), index_count, remap.data());
+    mesh.vertices.resize(used_vertex_count * vertex_stride);
+    RemapVertices(mesh.vertices.data(), vertices, vertex_count, vertex_stride, remap.data());
+    mesh.vertex_count = static_cast<u32>(used_vertex_count);
+    mesh.vertex_stride = static_cast<u32>(vertex_stride);
+
+    mesh.index_count = static_cast<u32>(index_count);
+    if (CanUse16BitIndices(used_vertex_count))
+    {
+        mesh.index_stride = sizeof(u16);
+        mesh.indices.resize(index_count * sizeof(u16));
+        ConvertIndicesTo16Bit(reinterpret_cast<u16*>(mesh.indices.data()), optimized.data(), index_count);
+    }
+    else
+    {
+        mesh.index_stride = sizeof(u32);
+        mesh.indices.resize(index_count * sizeof(u32));
+        memcpy(mesh.indices.data(), optimized.data(), index_count * sizeof(u32));
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "engine/core/types.h"
+#include <cstddef>
+#include <vector>
+
+// functions that reorder the triangles and the vertices of indexed triangle lists so the gpu
+// shades fewer vertices and pixels, they work on plain arrays and can run at load time or offline
+namespace deadrop::mesh
+{
+    // the number of entries of the vertex cache that AnalyzeVertexCache() simulates by default,
+    // a conservative size for the post-transform caches of current gpus
+    constexpr u32 DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+    // how well an index buffer uses the post-transform vertex cache
+    struct VertexCacheStats
+    {
+        // the number of vertices that were shaded (cache misses)
+        u32 vertices_shaded;
+        // the average number of vertices shaded per triangle, between 0.5 and 3, lower is better
+        float acmr;
+        // the average number of times each referenced vertex is shaded, 1 is the best possible
+        float atvr;
+    };
+
+    // simulates a fifo vertex cache of 'cache_size' entries over an index buffer
+    VertexCacheStats AnalyzeVertexCache(const u32* indices, size_t index_count, size_t vertex_count, u32 cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+    // reorders the triangles so that consecutive triangles share vertices that are still in the
+    // post-transform cache, this uses tom forsyth's linear-speed vertex cache optimization
+    // NOTE: 'dst' can be the same array as 'indices'
+    void OptimizeVertexCache(u32* dst, const u32* indices, size_t index_count, size_t vertex_count);
+
+    // reorders clusters of triangles so that the ones that are likely to occlude others are drawn first,
+    // the clusters are the runs of triangles that OptimizeVertexCache() produced, so the vertex cache
+    // efficiency stays the same (sander et al, fast triangle reordering for vertex locality and reduced overdraw)
+    // NOTE: call it on indices that were optimized with OptimizeVertexCache(), the position of a vertex is
+    // 3 floats at the start of each 'position_stride' bytes of 'positions'
+    // NOTE: 'dst' can be the same array as 'indices'
+    void OptimizeOverdraw(u32* dst, const u32* indices, size_t index_count, const void* positions, size_t vertex_count, size_t position_stride);
+
+    // computes a remap table that orders the vertices by their first use in the index buffer, so the vertices
+    // are fetched from memory in order, remap[old vertex] = new vertex, returns the number of vertices
+    // that are referenced, the ones that are not get ~0u and are dropped by RemapVertices()
+    size_t OptimizeVertexFetchRemap(u32* remap, const u32* indices, size_t index_count, size_t vertex_count);
+
+    // applies a remap table to an index buffer, dst[i] = remap[indices[i]]
+    // NOTE: 'dst' can be the same array as 'indices'
+    void RemapIndices(u32* dst, const u32* indices, size_t index_count, const u32* remap);
+
+    // applies a remap table to the vertices, each vertex is 'vertex_stride' bytes and is copied to its new position
+    // NOTE: 'dst' must not overlap 'vertices' and must have room for the count returned by OptimizeVertexFetchRemap()
+    void RemapVertices(void* dst, const void* vertices, size_t vertex_count, size_t vertex_stride, const u32* remap);
+
+    // returns true when all the indices of a mesh with 'vertex_count' vertices fit in 16 bits
+    constexpr bool CanUse16BitIndices(size_t vertex_count) { return vertex_count <= 0x10000; }
+
+    // converts 32-bit indices to 16-bit ones, every index must be smaller than 65536
+    void ConvertIndicesTo16Bit(u16* dst, const u32* indices, size_t index_count);
+
+    // a mesh ready to be uploaded, the buffers can be passed to IBuffer::Create() with
+    // BufferDesc::count and BufferDesc::stride set to the counts and the strides
+    struct OptimizedMesh
+    {
+        std::vector<u8> vertices;
+        u32 vertex_count = 0;
+        u32 vertex_stride = 0;
+        std::vector<u8> indices;
+        u32 index_count = 0;
+        // 2 when the indices are 16-bit, 4 when they are 32-bit
+        u32 index_stride = 0;
+    };
+
+    // runs all the optimizations on an indexed triangle list: vertex cache, overdraw and vertex fetch,
+    // and stores the result with 16-bit indices when there are few enough vertices
+    // NOTE: the position of a vertex is 3 floats at 'position_offset' bytes from the start of the vertex
+    // returns false when the mesh is not a triangle list or an index is out of range
+    bool OptimizeMesh(
+        const void* vertices, size_t vertex_count, size_t vertex_stride, size_t position_offset,
+        const u32* indices, size_t index_count, OptimizedMesh& mesh);
+}
@@ -0,0 +1,438 @@
+#include "mesh_simplifier.h"
+#include "engine/core/parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+using namespace deadrop;
+using namespace deadrop::mesh;
+
+namespace
+{
+    // the sum of the squared distances to a set of planes, weighted by the areas of the triangles
+    // they came from, error(p) = p * A * p + 2 * b * p + c
+    // NOTE: doubles are used since the terms cancel out and floats lose too much precision
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        // adds the plane with unit normal 'n' through the point 'p'
+        void addPlane(const double (&n)[3], const double (&p)[3], double w)
+        {
+            const double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]);
+            a00 += w * n[0] * n[0];
+            a01 += w * n[0] * n[1];
+            a02 += w * n[0] * n[2];
+            a11 += w * n[1] * n[1];
+            a12 += w * n[1] * n[2];
+            a22 += w * n[2] * n[2];
+            b0 += w * n[0] * d;
+            b1 += w * n[1] * d;
+            b2 += w * n[2] * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        void add(const Quadric& q)
+        {
+            a00 += q.a00;
+            a01 += q.a01;
+            a02 += q.a02;
+            a11 += q.a11;
+            a12 += q.a12;
+            a22 += q.a22;
+            b0 += q.b0;
+            b1 += q.b1;
+            b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+        }
+
+        // returns the sum of the weighted squared distances from 'p' to the planes
+        double evaluate(const float* p) const
+        {
+            const double x = p[0], y = p[1], z = p[2];
+            const double error =
+                x * (a00 * x + a01 * y + a02 * z) +
+                y * (a01 * x + a11 * y + a12 * z) +
+                z * (a02 * x + a12 * y + a22 * z) +
+                2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return error > 0.0 ? error : 0.0;
+        }
+    };
+
+    // the smallest cosine of the angle a triangle can turn by in a collapse (about 75 degrees)
+    constexpr double MIN_NORMAL_COSINE = 0.25;
+
+    // a candidate edge collapse, 'from' moves onto 'to' and is removed
+    struct Collapse
+    {
+        u32 from;
+        u32 to;
+        // the squared error in world units
+        float cost;
+    };
+
+    class Simplifier
+    {
+    public:
+        explicit Simplifier(const SimplifyMeshView& mesh) :
+            m_mesh(mesh),
+            m_indices(mesh.indices, mesh.indices + mesh.index_count / 3 * 3),
+            m_positions(mesh.vertex_count * 3),
+            m_quadrics(mesh.vertex_count),
+            m_locked(mesh.vertex_count, false)
+        {
+            for (size_t v = 0; v < mesh.vertex_count; v++)
+            {
+                memcpy(&m_positions[v * 3], static_cast<const u8*>(mesh.positions) + v * mesh.position_stride, sizeof(float) * 3);
+            }
+            lockBordersAndSeams();
+            computeQuadrics();
+        }
+
+        // collapses edges until there are at most 'target_index_count' indices or every collapse costs more than 'max_error'
+        void simplify(size_t target_index_count, float max_error)
+        {
+            const double max_cost = static_cast<double>(max_error) * max_error;
+            while (m_indices.size() > target_index_count)
+            {
+                if (!collapsePass(target_index_count, max_cost))
+                {
+                    break;
+                }
+            }
+        }
+
+        const std::vector<u32>& getIndices() const { return m_indices; }
+
+        // returns the error of the simplified mesh in world units
+        float getError() const { return static_cast<float>(std::sqrt(m_max_cost)); }
+
+    private:
+        const float* getPosition(u32 vertex) const { return &m_positions[static_cast<size_t>(vertex) * 3]; }
+
+        // vertices at the same position as another vertex are on an attribute seam, and vertices on an edge
+        // that is used by a single triangle (or more than two) are on a border, moving either would open holes
+        void lockBordersAndSeams()
+        {
+            // group the vertices by position
+            std::vector<u32> order(m_mesh.vertex_count);
+            for (size_t v = 0; v < order.size(); v++)
+            {
+                order[v] = static_cast<u32>(v);
+            }
+            std::sort(order.begin(), order.end(), [this](u32 a, u32 b)
+            {
+                return memcmp(getPosition(a), getPosition(b), sizeof(float) * 3) < 0;
+            });
+            std::vector<u32> welded(m_mesh.vertex_count);
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                const bool same_as_previous = i > 0 && memcmp(getPosition(order[i]), getPosition(order[i - 1]), sizeof(float) * 3) == 0;
+                welded[order[i]] = same_as_previous ? welded[order[i - 1]] : order[i];
+                if (same_as_previous)
+                {
+                    m_locked[order[i]] = true;
+                    m_locked[order[i - 1]] = true;
+                }
+            }
+
+            // count how many triangles use each edge of the welded mesh
+            std::vector<std::pair<u32, u32>> edges;
+            edges.reserve(m_indices.size());
+            for (size_t i = 0; i < m_indices.size(); i += 3)
+            {
+                for (u32 corner = 0; corner < 3; corner++)
+                {
+                    const u32 a = welded[m_indices[i + corner]];
+                    const u32 b = welded[m_indices[i + (corner + 1) % 3]];
+                    edges.emplace_back(std::min(a, b), std::max(a, b));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            std::vector<bool> border(m_mesh.vertex_count, false);
+            for (size_t i = 0; i < edges.size();)
+            {
+                size_t end = i + 1;
+                while (end < edges.size() && edges[end] == edges[i])
+                {
+                    end++;
+                }
+                if (end - i != 2)
+                {
+                    border[edges[i].first] = true;
+                    border[edges[i].second] = true;
+                }
+                i = end;
+            }
+            for (size_t v = 0; v < m_mesh.vertex_count; v++)
+            {
+                if (border[welded[v]])
+                {
+                    m_locked[v] = true;
+                }
+            }
+        }
+
+        void computeQuadrics()
+        {
+            for (size_t i = 0; i < m_indices.size(); i += 3)
+            {
+                const float* p0 = getPosition(m_indices[i]);
+                const float* p1 = getPosition(m_indices[i + 1]);
+                const float* p2 = getPosition(m_indices[i + 2]);
+                const double e1[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+                const double e2[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+                double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+                const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length <= 0.0)
+                {
+                    continue;
+                }
+                n[0] /= length;
+                n[1] /= length;
+                n[2] /= length;
+
+                // the length of the cross product is twice the area
+                const double area = length * 0.5;
+                const double p[3] = { p0[0], p0[1], p0[2] };
+                for (u32 corner = 0; corner < 3; corner++)
+                {
+                    m_quadrics[m_indices[i + corner]].addPlane(n, p, area);
+                }
+            }
+        }
+
+        // the cost of moving 'from' onto 'to', the mean squared distance to the planes of both vertices
+        // plus the squared weighted difference of the attributes that 'from' loses
+        double collapseCost(u32 from, u32 to) const
+        {
+            Quadric q = m_quadrics[from];
+            q.add(m_quadrics[to]);
+            double cost = q.weight > 0.0 ? q.evaluate(getPosition(to)) / q.weight : 0.0;
+
+            if (m_mesh.attributes)
+            {
+                const float* a = reinterpret_cast<const float*>(static_cast<const u8*>(m_mesh.attributes) + from * m_mesh.attribute_stride);
+                const float* b = reinterpret_cast<const float*>(static_cast<const u8*>(m_mesh.attributes) + to * m_mesh.attribute_stride);
+                for (u32 i = 0; i < m_mesh.attribute_count; i++)
+                {
+                    const double difference = (double(a[i]) - b[i]) * m_mesh.attribute_weights[i];
+                    cost += difference * difference;
+                }
+            }
+            return cost;
+        }
+
+        // returns true when moving 'from' onto 'to' flips a triangle that stays, or turns it so much
+        // that it is close to flipping, which leaves slivers behind
+        bool flipsTriangle(u32 from, u32 to) const
+        {
+            const float* target = getPosition(to);
+            for (u32 i = m_adjacency_offsets[from]; i < m_adjacency_offsets[from + 1]; i++)
+            {
+                const u32* triangle = &m_indices[static_cast<size_t>(m_adjacency[i]) * 3];
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                {
+                    continue;
+                }
+
+                // rotate the triangle so 'from' is the first corner
+                const u32 corner = triangle[0] == from ? 0 : (triangle[1] == from ? 1 : 2);
+                const float* p0 = getPosition(from);
+                const float* p1 = getPosition(triangle[(corner + 1) % 3]);
+                const float* p2 = getPosition(triangle[(corner + 2) % 3]);
+
+                double old_normal[3], new_normal[3];
+                triangleNormal(p0, p1, p2, old_normal);
+                triangleNormal(target, p1, p2, new_normal);
+                const double dot = old_normal[0] * new_normal[0] + old_normal[1] * new_normal[1] + old_normal[2] * new_normal[2];
+                const double old_length = old_normal[0] * old_normal[0] + old_normal[1] * old_normal[1] + old_normal[2] * old_normal[2];
+                const double new_length = new_normal[0] * new_normal[0] + new_normal[1] * new_normal[1] + new_normal[2] * new_normal[2];
+                if (dot <= MIN_NORMAL_COSINE * std::sqrt(old_length * new_length))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static void triangleNormal(const float* p0, const float* p1, const float* p2, double (&n)[3])
+        {
+            const double e1[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+            const double e2[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+            n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        }
+
+        // builds the list of the triangles that use each vertex
+        void buildAdjacency()
+        {
+            m_adjacency_offsets.assign(m_mesh.vertex_count + 1, 0);
+            for (u32 index : m_indices)
+            {
+                m_adjacency_offsets[index + 1]++;
+            }
+            for (size_t v = 0; v < m_mesh.vertex_count; v++)
+            {
+                m_adjacency_offsets[v + 1] += m_adjacency_offsets[v];
+            }
+            m_adjacency.resize(m_indices.size());
+            std::vector<u32> cursors(m_adjacency_offsets.begin(), m_adjacency_offsets.end() - 1);
+            for (size_t i = 0; i < m_indices.size(); i++)
+            {
+                m_adjacency[cursors[m_indices[i]]++] = static_cast<u32>(i / 3);
+            }
+        }
+
+        // collapses the cheapest edges whose neighborhoods do not overlap, returns false when nothing was collapsed
+        bool collapsePass(size_t target_index_count, double max_cost)
+        {
+            buildAdjacency();
+
+            // each edge is a candidate in the cheaper of its two directions
+            m_collapses.clear();
+            for (size_t i = 0; i < m_indices.size(); i += 3)
+            {
+                for (u32 corner = 0; corner < 3; corner++)
+                {
+                    const u32 a = m_indices[i + corner];
+                    const u32 b = m_indices[i + (corner + 1) % 3];
+                    // NOTE: an edge inside the mesh is seen from both of its triangles in opposite directions,
+                    // one of them is enough, the edges on the borders only join locked vertices
+                    if (a >= b)
+                    {
+                        continue;
+                    }
+                    const double cost_ab = m_locked[a] ? HUGE_VAL : collapseCost(a, b);
+                    const double cost_ba = m_locked[b] ? HUGE_VAL : collapseCost(b, a);
+                    if (cost_ab == HUGE_VAL && cost_ba == HUGE_VAL)
+                    {
+                        continue;
+                    }
+                    if (cost_ab <= cost_ba)
+                    {
+                        m_collapses.push_back(Collapse{ a, b, static_cast<float>(cost_ab) });
+                    }
+                    else
+                    {
+                        m_collapses.push_back(Collapse{ b, a, static_cast<float>(cost_ba) });
+                    }
+                }
+            }
+            std::sort(m_collapses.begin(), m_collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+            // a collapse usually removes 2 triangles
+            const size_t triangles_to_remove = (m_indices.size() - target_index_count + 2) / 3;
+            size_t triangles_removed = 0;
+            bool collapsed = false;
+            m_remap.resize(m_mesh.vertex_count);
+            for (size_t v = 0; v < m_remap.size(); v++)
+            {
+                m_remap[v] = static_cast<u32>(v);
+            }
+            m_touched.assign(m_mesh.vertex_count, false);
+            for (const Collapse& collapse : m_collapses)
+            {
+                if (collapse.cost > max_cost || triangles_removed >= triangles_to_remove)
+                {
+                    break;
+                }
+                if (m_touched[collapse.from] || m_touched[collapse.to] || flipsTriangle(collapse.from, collapse.to))
+                {
+                    continue;
+                }
+
+                // the whole neighborhood of the removed vertex is left alone for the rest of the pass,
+                // so the flip test above stays valid
+                for (u32 i = m_adjacency_offsets[collapse.from]; i < m_adjacency_offsets[collapse.from + 1]; i++)
+                {
+                    const u32* triangle = &m_indices[static_cast<size_t>(m_adjacency[i]) * 3];
+                    m_touched[triangle[0]] = true;
+                    m_touched[triangle[1]] = true;
+                    m_touched[triangle[2]] = true;
+                    if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    {
+                        triangles_removed++;
+                    }
+                }
+                m_remap[collapse.from] = collapse.to;
+                m_quadrics[collapse.to].add(m_quadrics[collapse.from]);
+                m_max_cost = std::max(m_max_cost, static_cast<double>(collapse.cost));
+                collapsed = true;
+            }
+
+            // move the indices of the collapsed vertices and drop the triangles that became degenerate
+            size_t write = 0;
+            for (size_t i = 0; i < m_indices.size(); i += 3)
+            {
+                const u32 a = m_remap[m_indices[i]];
+                const u32 b = m_remap[m_indices[i + 1]];
+                const u32 c = m_remap[m_indices[i + 2]];
+                if (a != b && b != c && a != c)
+                {
+                    m_indices[write++] = a;
+                    m_indices[write++] = b;
+                    m_indices[write++] = c;
+                }
+            }
+            m_indices.resize(write);
+            return collapsed;
+        }
+
+        const SimplifyMeshView& m_mesh;
+        std::vector<u32> m_indices;
+        std::vector<float> m_positions;
+        std::vector<Quadric> m_quadrics;
+        std::vector<bool> m_locked;
+        double m_max_cost = 0.0;
+
+        // scratch memory of the passes
+        std::vector<u32> m_adjacency_offsets;
+        std::vector<u32> m_adjacency;
+        std::vector<Collapse> m_collapses;
+        std::vector<u32> m_remap;
+        std::vector<bool> m_touched;
+    };
+}
+
+size_t deadrop::mesh::SimplifyMesh(u32* dst, const SimplifyMeshView& mesh, size_t target_index_count, float max_error, float* result_error)
+{
+    Simplifier simplifier(mesh);
+    simplifier.simplify(target_index_count, max_error);
+    const std::vector<u32>& indices = simplifier.getIndices();
+    memcpy(dst, indices.data(), indices.size() * sizeof(u32));
+    if (result_error)
+    {
+        *result_error = simplifier.getError();
+    }
+    return indices.size();
+}
+
+void deadrop::mesh::GenerateLods(const SimplifyMeshView& mesh, const LodTarget* targets, size_t target_count, std::vector<MeshLod>& lods)
+{
+    Simplifier simplifier(mesh);
+    lods.resize(target_count);
+    for (size_t i = 0; i < target_count; i++)
+    {
+        const size_t target_triangles = static_cast<size_t>(static_cast<double>(mesh.index_count / 3) * targets[i].triangle_ratio);
+        simplifier.simplify(target_triangles * 3, targets[i].max_error);
+        lods[i].indices = simplifier.getIndices();
+        lods[i].error = simplifier.getError();
+    }
+}
+
+void deadrop::mesh::GenerateLodsMany(const SimplifyMeshView* meshes, size_t mesh_count, const LodTarget* targets, size_t target_count, std::vector<MeshLod>* lods)
+{
+    ParallelFor(mesh_count, 1, [=](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            GenerateLods(meshes[i], targets, target_count, lods[i]);
+        }
+    });
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "engine/core/types.h"
+#include <cstddef>
+#include <vector>
+
+// simplification of indexed triangle lists with quadric error metrics (garland and heckbert),
+// used to generate the levels of detail of a mesh
+namespace deadrop::mesh
+{
+    // a view over the vertices and the indices of a triangle list to simplify
+    // NOTE: the position of a vertex is 3 floats at the start of each 'position_stride' bytes of 'positions',
+    // the optional attributes are 'attribute_count' floats at the start of each 'attribute_stride' bytes
+    // of 'attributes' (like normals or texture coordinates) and each one has a weight in 'attribute_weights'
+    // that says how many world units a difference of one in the attribute is worth
+    struct SimplifyMeshView
+    {
+        const void* positions = nullptr;
+        size_t position_stride = sizeof(float) * 3;
+        size_t vertex_count = 0;
+        const void* attributes = nullptr;
+        size_t attribute_stride = 0;
+        u32 attribute_count = 0;
+        const float* attribute_weights = nullptr;
+        const u32* indices = nullptr;
+        size_t index_count = 0;
+    };
+
+    // when a level of detail is done, it stops at whichever of the two is reached first
+    struct LodTarget
+    {
+        // the number of triangles of the level relative to the original mesh
+        float triangle_ratio = 0.5f;
+        // the largest error allowed, in world units
+        float max_error = 1e30f;
+    };
+
+    // a level of detail, an index buffer over the vertices of the original mesh
+    struct MeshLod
+    {
+        std::vector<u32> indices;
+        // how far the simplified surface is from the original one, in world units, which can be projected
+        // to the screen to select the level of detail to draw
+        float error = 0.0f;
+    };
+
+    // simplifies a mesh by collapsing edges until it has at most 'target_index_count' indices or no collapse
+    // stays under 'max_error' world units, writes the indices to 'dst' and returns how many there are
+    // NOTE: the vertices are not moved or changed, the result only uses a subset of them, the vertices on the
+    // borders of the mesh and on attribute seams (vertices at the same position) are never removed
+    // NOTE: 'dst' must have room for 'index_count' indices, 'result_error' receives the error in world units
+    size_t SimplifyMesh(u32* dst, const SimplifyMeshView& mesh, size_t target_index_count, float max_error, float* result_error = nullptr);
+
+    // generates a chain of levels of detail, lods[i] is the mesh simplified to targets[i], each level continues
+    // from the previous one so the errors grow and the levels are nested
+    // NOTE: the targets should have decreasing ratios, run OptimizeVertexCache() on each level afterwards
+    void GenerateLods(const SimplifyMeshView& mesh, const LodTarget* targets, size_t target_count, std::vector<MeshLod>& lods);
+
+    // generates the levels of detail of 'mesh_count' meshes, lods[i] are the levels of meshes[i],
+    // the meshes are split between the worker threads, see ParallelFor()
+    void GenerateLodsMany(const SimplifyMeshView* meshes, size_t mesh_count, const LodTarget* targets, size_t target_count, std::vector<MeshLod>* lods);
+}
@@ -0,0 +1,520 @@
+#include "meshlet.h"
+#include "engine/core/math/scalar.h"
+#include "engine/core/cpu.h"
+#include "engine/core/simd.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+using namespace deadrop;
+using namespace deadrop::math;
+using namespace deadrop::mesh;
+
+namespace
+{
+    // the smallest cosine between the normal of a triangle and the axis of the cone for the cone to be usable,
+    // above it the cone opens by more than about 84 degrees and almost nothing is culled with it
+    constexpr float MIN_CONE_COSINE = 0.1f;
+
+    const vec3f& getPosition(const void* positions, size_t position_stride, u32 vertex)
+    {
+        return *reinterpret_cast<const vec3f*>(static_cast<const u8*>(positions) + vertex * position_stride);
+    }
+
+    // returns the normal of the front face of a triangle, not normalized
+    vec3f frontNormal(const vec3f& p0, const vec3f& p1, const vec3f& p2, bool front_face_is_clockwise)
+    {
+        // NOTE: with left-handed coordinates the cross product of the edges points
+        // to the side the triangle is seen as clockwise from
+        const vec3f normal = Cross(p1 - p0, p2 - p0);
+        return front_face_is_clockwise ? normal : Negate(normal);
+    }
+
+    // the adjacency of the triangles over the vertices welded by position, so the meshlets
+    // can grow across attribute seams
+    struct Adjacency
+    {
+        // welded[vertex] is the first vertex at the same position
+        std::vector<u32> welded;
+        // the triangles that use each welded vertex and were not emitted yet, in [offsets[v], offsets[v] + counts[v])
+        std::vector<u32> offsets;
+        std::vector<u32> counts;
+        std::vector<u32> triangles;
+
+        // removes an emitted triangle from the lists of its vertices, so the searches only see the triangles left
+        void removeTriangle(const u32* indices, u32 triangle)
+        {
+            for (u32 corner = 0; corner < 3; corner++)
+            {
+                const u32 vertex = welded[indices[triangle * 3 + corner]];
+                u32* list = &triangles[offsets[vertex]];
+                for (u32 i = 0; i < counts[vertex]; i++)
+                {
+                    if (list[i] == triangle)
+                    {
+                        list[i] = list[--counts[vertex]];
+                        break;
+                    }
+                }
+            }
+        }
+    };
+
+    void buildAdjacency(const void* positions, size_t vertex_count, size_t position_stride, const u32* indices, size_t index_count, Adjacency& adjacency)
+    {
+        std::vector<u32> order(vertex_count);
+        for (size_t v = 0; v < vertex_count; v++)
+        {
+            order[v] = static_cast<u32>(v);
+        }
+        std::sort(order.begin(), order.end(), [&](u32 a, u32 b)
+        {
+            return memcmp(&getPosition(positions, position_stride, a), &getPosition(positions, position_stride, b), sizeof(vec3f)) < 0;
+        });
+        adjacency.welded.resize(vertex_count);
+        for (size_t i = 0; i < vertex_count; i++)
+        {
+            const bool same_as_previous = i > 0 &&
+                memcmp(&getPosition(positions, position_stride, order[i]), &getPosition(positions, position_stride, order[i - 1]), sizeof(vec3f)) == 0;
+            adjacency.welded[order[i]] = same_as_previous ? adjacency.welded[order[i - 1]] : order[i];
+        }
+
+        adjacency.offsets.assign(vertex_count + 1, 0);
+        for (size_t i = 0; i < index_count; i++)
+        {
+            adjacency.offsets[adjacency.welded[indices[i]] + 1]++;
+        }
+        for (size_t v = 0; v < vertex_count; v++)
+        {
+            adjacency.offsets[v + 1] += adjacency.offsets[v];
+        }
+        adjacency.counts.resize(vertex_count);
+        for (size_t v = 0; v < vertex_count; v++)
+        {
+            adjacency.counts[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+        }
+        adjacency.triangles.resize(index_count);
+        std::vector<u32> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        for (size_t i = 0; i < index_count; i++)
+        {
+            adjacency.triangles[cursors[adjacency.welded[indices[i]]]++] = static_cast<u32>(i / 3);
+        }
+    }
+
+    static_assert(offsetof(MeshletBounds, radius) == sizeof(float) * 3 && offsetof(MeshletBounds, cone_cutoff) == offsetof(MeshletBounds, cone_axis) + sizeof(float) * 3,
+        "the culling functions load the sphere and the cone of MeshletBounds as two groups of 4 floats");
+
+    // the 8 floats at the start of MeshletBounds (center, radius, cone axis, cone cutoff) of 4 meshlets, transposed
+    struct Bounds4
+    {
+        __m128 center_x, center_y, center_z, radius;
+        __m128 axis_x, axis_y, axis_z, cutoff;
+    };
+
+    inline Bounds4 loadBounds4(const MeshletBounds* bounds)
+    {
+        Bounds4 b;
+        b.center_x = _mm_loadu_ps(&bounds[0].center.x);
+        b.center_y = _mm_loadu_ps(&bounds[1].center.x);
+        b.center_z = _mm_loadu_ps(&bounds[2].center.x);
+        b.radius = _mm_loadu_ps(&bounds[3].center.x);
+        _MM_TRANSPOSE4_PS(b.center_x, b.center_y, b.center_z, b.radius);
+        b.axis_x = _mm_loadu_ps(&bounds[0].cone_axis.x);
+        b.axis_y = _mm_loadu_ps(&bounds[1].cone_axis.x);
+        b.axis_z = _mm_loadu_ps(&bounds[2].cone_axis.x);
+        b.cutoff = _mm_loadu_ps(&bounds[3].cone_axis.x);
+        _MM_TRANSPOSE4_PS(b.axis_x, b.axis_y, b.axis_z, b.cutoff);
+        return b;
+    }
+
+    // returns a bit mask of the meshlets that are visible, one bit per lane
+    // NOTE: the operations are in the same order as IsMeshletCulled() so the results are identical
+    inline u32 testBounds4SSE2(const Bounds4& b, const vec4f* planes, const vec3f& camera_position)
+    {
+        // outside the frustum when the sphere is fully behind any of the planes
+        const __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), b.radius);
+        __m128 culled = _mm_setzero_ps();
+        for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), b.center_x), _mm_set1_ps(planes[p].w));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes[p].y), b.center_y));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes[p].z), b.center_z));
+            culled = _mm_or_ps(culled, _mm_cmplt_ps(d, negative_radius));
+        }
+
+        // facing away when the direction from the camera to the sphere is inside the normal cone grown by the sphere
+        const __m128 dx = _mm_sub_ps(b.center_x, _mm_set1_ps(camera_position.x));
+        const __m128 dy = _mm_sub_ps(b.center_y, _mm_set1_ps(camera_position.y));
+        const __m128 dz = _mm_sub_ps(b.center_z, _mm_set1_ps(camera_position.z));
+        const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        const __m128 projection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, b.axis_x), _mm_mul_ps(dy, b.axis_y)), _mm_mul_ps(dz, b.axis_z));
+        culled = _mm_or_ps(culled, _mm_cmpge_ps(projection, _mm_add_ps(_mm_mul_ps(b.cutoff, length), b.radius)));
+        return ~static_cast<u32>(_mm_movemask_ps(culled)) & 0xF;
+    }
+
+    size_t cullScalar(const MeshletBounds* bounds, size_t begin, size_t end, const Frustum& frustum, const vec3f& camera_position, u32* visible_indices)
+    {
+        size_t visible = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            visible_indices[visible] = static_cast<u32>(i);
+            visible += IsMeshletCulled(bounds[i], frustum, camera_position) ? 0 : 1;
+        }
+        return visible;
+    }
+
+    size_t cullSSE2(const MeshletBounds* bounds, size_t count, const Frustum& frustum, const vec3f& camera_position, u32* visible_indices)
+    {
+        vec4f planes[Frustum::PLANE_COUNT];
+        for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            planes[p] = frustum.GetPlane(static_cast<Frustum::Plane>(p));
+        }
+
+        size_t visible = 0;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const u32 mask =
+                testBounds4SSE2(loadBounds4(bounds + i), planes, camera_position) |
+                (testBounds4SSE2(loadBounds4(bounds + i + 4), planes, camera_position) << 4);
+            visible += simd::CompactIndices(mask, 8, static_cast<u32>(i), visible_indices + visible);
+        }
+        return visible + cullScalar(bounds, i, count, frustum, camera_position, visible_indices + visible);
+    }
+
+    SIMD_TARGET_AVX
+    inline __m256 combine(__m128 lo, __m128 hi)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+
+    SIMD_TARGET_AVX
+    size_t cullAVX(const MeshletBounds* bounds, size_t count, const Frustum& frustum, const vec3f& camera_position, u32* visible_indices)
+    {
+        __m256 plane_x[Frustum::PLANE_COUNT], plane_y[Frustum::PLANE_COUNT], plane_z[Frustum::PLANE_COUNT], plane_w[Frustum::PLANE_COUNT];
+        for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            const vec4f& plane = frustum.GetPlane(static_cast<Frustum::Plane>(p));
+            plane_x[p] = _mm256_set1_ps(plane.x);
+            plane_y[p] = _mm256_set1_ps(plane.y);
+            plane_z[p] = _mm256_set1_ps(plane.z);
+            plane_w[p] = _mm256_set1_ps(plane.w);
+        }
+        const __m256 camera_x = _mm256_set1_ps(camera_position.x);
+        const __m256 camera_y = _mm256_set1_ps(camera_position.y);
+        const __m256 camera_z = _mm256_set1_ps(camera_position.z);
+
+        size_t visible = 0;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const Bounds4 lo = loadBounds4(bounds + i);
+            const Bounds4 hi = loadBounds4(bounds + i + 4);
+            const __m256 center_x = combine(lo.center_x, hi.center_x);
+            const __m256 center_y = combine(lo.center_y, hi.center_y);
+            const __m256 center_z = combine(lo.center_z, hi.center_z);
+            const __m256 radius = combine(lo.radius, hi.radius);
+
+            const __m256 negative_radius = _mm256_sub_ps(_mm256_setzero_ps(), radius);
+            __m256 culled = _mm256_setzero_ps();
+            for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+            {
+                __m256 d = _mm256_add_ps(_mm256_mul_ps(plane_x[p], center_x), plane_w[p]);
+                d = _mm256_add_ps(d, _mm256_mul_ps(plane_y[p], center_y));
+                d = _mm256_add_ps(d, _mm256_mul_ps(plane_z[p], center_z));
+                culled = _mm256_or_ps(culled, _mm256_cmp_ps(d, negative_radius, _CMP_LT_OQ));
+            }
+
+            const __m256 dx = _mm256_sub_ps(center_x, camera_x);
+            const __m256 dy = _mm256_sub_ps(center_y, camera_y);
+            const __m256 dz = _mm256_sub_ps(center_z, camera_z);
+            const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+            const __m256 projection = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(dx, combine(lo.axis_x, hi.axis_x)), _mm256_mul_ps(dy, combine(lo.axis_y, hi.axis_y))),
+                _mm256_mul_ps(dz, combine(lo.axis_z, hi.axis_z)));
+            const __m256 limit = _mm256_add_ps(_mm256_mul_ps(combine(lo.cutoff, hi.cutoff), length), radius);
+            culled = _mm256_or_ps(culled, _mm256_cmp_ps(projection, limit, _CMP_GE_OQ));
+
+            const u32 mask = ~static_cast<u32>(_mm256_movemask_ps(culled)) & 0xFF;
+            visible += simd::CompactIndices(mask, 8, static_cast<u32>(i), visible_indices + visible);
+        }
+        return visible + cullScalar(bounds, i, count, frustum, camera_position, visible_indices + visible);
+    }
+}
+
+bool deadrop::mesh::BuildMeshlets(
+    const void* positions, size_t vertex_count, size_t position_stride,
+    const u32* indices, size_t index_count, const MeshletSettings& settings, MeshletMesh& mesh)
+{
+    if (index_count % 3 != 0 || settings.max_vertices < 3 || settings.max_triangles == 0)
+    {
+        // error, not a triangle list or a meshlet can not hold a triangle
+        return false;
+    }
+    for (size_t i = 0; i < index_count; i++)
+    {
+        if (indices[i] >= vertex_count)
+        {
+            // error, index out of range
+            return false;
+        }
+    }
+
+    mesh.meshlets.clear();
+    mesh.bounds.clear();
+    mesh.indices.clear();
+    mesh.indices.reserve(index_count);
+
+    const size_t triangle_count = index_count / 3;
+    std::vector<vec3f> normals(triangle_count);
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        const vec3f normal = frontNormal(
+            getPosition(positions, position_stride, indices[t * 3]),
+            getPosition(positions, position_stride, indices[t * 3 + 1]),
+            getPosition(positions, position_stride, indices[t * 3 + 2]),
+            settings.front_face_is_clockwise);
+        const float length = Sqrt(Dot(normal, normal));
+        normals[t] = length > 0.0f ? normal / length : vec3f(0.0f);
+    }
+
+    Adjacency adjacency;
+    buildAdjacency(positions, vertex_count, position_stride, indices, index_count, adjacency);
+
+    // vertex_meshlet[v] is the number of the meshlet that last used the vertex plus one,
+    // so the vertices of the current meshlet are found without clearing anything
+    std::vector<u32> vertex_meshlet(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<u32> meshlet_vertices;
+    meshlet_vertices.reserve(settings.max_vertices);
+    size_t scan_cursor = 0;
+    size_t emitted_count = 0;
+    u32 previous_seed = ~0u;
+
+    while (emitted_count < triangle_count)
+    {
+        const u32 stamp = static_cast<u32>(mesh.meshlets.size() + 1);
+        Meshlet meshlet{ static_cast<u32>(mesh.indices.size()), 0, 0 };
+        vec3f normal_sum(0.0f);
+        meshlet_vertices.clear();
+
+        // the seed is a triangle next to the previous meshlet so the meshlets stay compact,
+        // otherwise the next triangle that was not emitted in the index buffer
+        u32 triangle = previous_seed;
+        if (triangle == ~0u)
+        {
+            while (emitted[scan_cursor])
+            {
+                scan_cursor++;
+            }
+            triangle = static_cast<u32>(scan_cursor);
+        }
+
+        while (triangle != ~0u)
+        {
+            // add the triangle
+            emitted[triangle] = true;
+            emitted_count++;
+            adjacency.removeTriangle(indices, triangle);
+            for (u32 corner = 0; corner < 3; corner++)
+            {
+                const u32 vertex = indices[triangle * 3 + corner];
+                mesh.indices.push_back(vertex);
+                if (vertex_meshlet[vertex] != stamp)
+                {
+                    vertex_meshlet[vertex] = stamp;
+                    meshlet_vertices.push_back(vertex);
+                }
+            }
+            meshlet.triangle_count++;
+            normal_sum = normal_sum + normals[triangle];
+            if (meshlet.triangle_count == settings.max_triangles)
+            {
+                break;
+            }
+
+            // find the connected triangle that adds the fewest vertices and faces the most like the meshlet
+            const float normal_length = Sqrt(Dot(normal_sum, normal_sum));
+            const vec3f average_normal = normal_length > 0.0f ? normal_sum / normal_length : vec3f(0.0f);
+            triangle = ~0u;
+            float best_score = 0.0f;
+            for (u32 vertex : meshlet_vertices)
+            {
+                const u32 welded = adjacency.welded[vertex];
+                for (u32 i = adjacency.offsets[welded]; i < adjacency.offsets[welded] + adjacency.counts[welded]; i++)
+                {
+                    const u32 candidate = adjacency.triangles[i];
+                    u32 extra_vertices = 0;
+                    for (u32 corner = 0; corner < 3; corner++)
+                    {
+                        extra_vertices += vertex_meshlet[indices[candidate * 3 + corner]] != stamp ? 1 : 0;
+                    }
+                    if (meshlet_vertices.size() + extra_vertices > settings.max_vertices)
+                    {
+                        continue;
+                    }
+                    const float score = static_cast<float>(extra_vertices) + settings.cone_weight * (1.0f - Dot(normals[candidate], average_normal));
+                    if (triangle == ~0u || score < best_score)
+                    {
+                        triangle = candidate;
+                        best_score = score;
+                    }
+                }
+            }
+        }
+
+        meshlet.vertex_count = static_cast<u32>(meshlet_vertices.size());
+        mesh.meshlets.push_back(meshlet);
+        mesh.bounds.push_back(ComputeMeshletBounds(
+            positions, position_stride, mesh.indices.data() + meshlet.index_offset, meshlet.triangle_count, settings.front_face_is_clockwise));
+
+        // the next seed, the first triangle that was not emitted next to the vertices of this meshlet
+        previous_seed = ~0u;
+        for (size_t v = 0; v < meshlet_vertices.size() && previous_seed == ~0u; v++)
+        {
+            const u32 welded = adjacency.welded[meshlet_vertices[v]];
+            if (adjacency.counts[welded] > 0)
+            {
+                previous_seed = adjacency.triangles[adjacency.offsets[welded]];
+            }
+        }
+    }
+    return true;
+}
+
+MeshletBounds deadrop::mesh::ComputeMeshletBounds(
+    const void* positions, size_t position_stride, const u32* indices, size_t triangle_count, bool front_face_is_clockwise)
+{
+    MeshletBounds bounds{};
+    if (triangle_count == 0)
+    {
+        bounds.cone_cutoff = 1.0f;
+        return bounds;
+    }
+
+    // the sphere is centered on the box, which is cheap and close to the smallest sphere for the flat clusters of a meshlet
+    vec3f min = getPosition(positions, position_stride, indices[0]);
+    vec3f max = min;
+    for (size_t i = 1; i < triangle_count * 3; i++)
+    {
+        const vec3f& p = getPosition(positions, position_stride, indices[i]);
+        min = vec3f{ std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+        max = vec3f{ std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+    }
+    bounds.aabb = AABB(min, max);
+    bounds.center = bounds.aabb.getCenter();
+    float radius_squared = 0.0f;
+    for (size_t i = 0; i < triangle_count * 3; i++)
+    {
+        const vec3f offset = getPosition(positions, position_stride, indices[i]) - bounds.center;
+        radius_squared = std::max(radius_squared, Dot(offset, offset));
+    }
+    bounds.radius = Sqrt(radius_squared);
+
+    // the cone axis is the average of the unit normals, the cone has to contain the normal furthest from it
+    vec3f normal_sum(0.0f);
+    std::vector<vec3f> normals(triangle_count);
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        const vec3f normal = frontNormal(
+            getPosition(positions, position_stride, indices[t * 3]),
+            getPosition(positions, position_stride, indices[t * 3 + 1]),
+            getPosition(positions, position_stride, indices[t * 3 + 2]),
+            front_face_is_clockwise);
+        const float length = Sqrt(Dot(normal, normal));
+        normals[t] = length > 0.0f ? normal / length : vec3f(0.0f);
+        normal_sum = normal_sum + normals[t];
+    }
+    const float axis_length = Sqrt(Dot(normal_sum, normal_sum));
+    bounds.cone_apex = bounds.center;
+    bounds.cone_cutoff = 1.0f;
+    if (axis_length <= 0.0f)
+    {
+        bounds.cone_axis = vec3f{ 0.0f, 0.0f, 1.0f };
+        return bounds;
+    }
+    bounds.cone_axis = normal_sum / axis_length;
+
+    float min_cosine = 1.0f;
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        // NOTE: degenerate triangles are never drawn so they do not widen the cone
+        if (Dot(normals[t], normals[t]) > 0.0f)
+        {
+            min_cosine = std::min(min_cosine, Dot(normals[t], bounds.cone_axis));
+        }
+    }
+    if (min_cosine <= MIN_CONE_COSINE)
+    {
+        return bounds;
+    }
+
+    // the triangles face away from every direction inside the normal cone widened by 90 degrees, so the cutoff
+    // compared against the view direction is -cos(angle + 90) = sin(angle)
+    bounds.cone_cutoff = Sqrt(1.0f - min_cosine * min_cosine);
+
+    // the apex is moved back along the axis until the plane of every triangle is in front of it
+    float max_distance = 0.0f;
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        const float cosine = Dot(normals[t], bounds.cone_axis);
+        if (cosine <= 0.0f)
+        {
+            continue;
+        }
+        for (u32 corner = 0; corner < 3; corner++)
+        {
+            const vec3f offset = bounds.center - getPosition(positions, position_stride, indices[t * 3 + corner]);
+            max_distance = std::max(max_distance, Dot(offset, normals[t]) / cosine);
+        }
+    }
+    bounds.cone_apex = bounds.center - bounds.cone_axis * max_distance;
+    return bounds;
+}
+
+bool deadrop::mesh::IsMeshletCulled(const MeshletBounds& bounds, const Frustum& frustum, const vec3f& camera_position)
+{
+    const vec3f& c = bounds.center;
+    for (u32 p = 0; p < Frustum::PLANE_COUNT; p++)
+    {
+        const vec4f& plane = frustum.GetPlane(static_cast<Frustum::Plane>(p));
+        const float distance = plane.x * c.x + plane.w + plane.y * c.y + plane.z * c.z;
+        if (distance < -bounds.radius)
+        {
+            return true;
+        }
+    }
+
+    const vec3f d = c - camera_position;
+    const float length = Sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+    const float projection = d.x * bounds.cone_axis.x + d.y * bounds.cone_axis.y + d.z * bounds.cone_axis.z;
+    return projection >= bounds.cone_cutoff * length + bounds.radius;
+}
+
+size_t deadrop::mesh::CullMeshlets(
+    const MeshletBounds* bounds, size_t count, const Frustum& frustum, const vec3f& camera_position, u32* visible_indices)
+{
+    if (GetCpuFeatures().avx)
+    {
+        return cullAVX(bounds, count, frustum, camera_position, visible_indices);
+    }
+    return cullSSE2(bounds, count, frustum, camera_position, visible_indices);
+}
+
+size_t deadrop::mesh::BuildMeshletDrawRanges(const Meshlet* meshlets, const u32* visible_indices, size_t visible_count, DrawRange* ranges)
+{
+    size_t range_count = 0;
+    for (size_t i = 0; i < visible_count; i++)
+    {
+        const Meshlet& meshlet = meshlets[visible_indices[i]];
+        if (range_count > 0 && ranges[range_count - 1].index_offset + ranges[range_count - 1].index_count == meshlet.index_offset)
+        {
+            ranges[range_count - 1].index_count += meshlet.triangle_count * 3;
+        }
+        else
+        {
+            ranges[range_count++] = DrawRange{ meshlet.index_offset, meshlet.triangle_count * 3 };
+        }
+    }
+    return range_count;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "engine/core/types.h"
+#include "engine/core/math/aabb.h"
+#include "engine/core/math/frustum.h"
+#include "engine/core/math/vec3.h"
+#include <cstddef>
+#include <vector>
+
+// splitting of indexed triangle lists into small clusters of triangles (meshlets) with bounds that
+// are culled on the cpu, so the triangles that face away from the camera or are out of view
+// are never submitted
+namespace deadrop::mesh
+{
+    // the default limits of a meshlet, small enough for the clusters to be flat, so their normal cones
+    // are narrow, and large enough for the draw ranges that survive culling to stay long
+    constexpr u32 DEFAULT_MESHLET_MAX_VERTICES = 64;
+    constexpr u32 DEFAULT_MESHLET_MAX_TRIANGLES = 124;
+
+    struct MeshletSettings
+    {
+        u32 max_vertices = DEFAULT_MESHLET_MAX_VERTICES;
+        u32 max_triangles = DEFAULT_MESHLET_MAX_TRIANGLES;
+        // how much a triangle that faces the same way as the rest of the meshlet is preferred over a
+        // triangle that adds fewer vertices, higher values give narrower cones and more meshlets
+        float cone_weight = 0.5f;
+        // the winding of the front faces, the same as RasterizerStateDesc::FrontFaceIsClockwise,
+        // used to know which way the triangles face
+        bool front_face_is_clockwise = false;
+    };
+
+    // a meshlet is a range of the index buffer built by BuildMeshlets(), drawn with
+    // DrawIndexed(triangle_count * 3, index_offset)
+    struct Meshlet
+    {
+        u32 index_offset;
+        u32 triangle_count;
+        u32 vertex_count;
+    };
+
+    // the bounds of a meshlet, in the space of the positions
+    struct MeshletBounds
+    {
+        // a sphere that contains all the vertices
+        math::vec3f center;
+        float radius;
+        // the cone that contains the normals of all the triangles, the meshlet faces away from any point
+        // inside the cone with its apex at 'cone_apex' that opens in the direction of 'cone_axis'
+        // NOTE: 'cone_cutoff' is the sine of the half angle of the normal cone, 1 when the normals are
+        // too spread for the meshlet to ever face away
+        math::vec3f cone_axis;
+        float cone_cutoff;
+        math::vec3f cone_apex;
+        math::AABB aabb;
+    };
+
+    struct MeshletMesh
+    {
+        std::vector<Meshlet> meshlets;
+        std::vector<MeshletBounds> bounds;
+        // the triangles of the mesh reordered so that the triangles of each meshlet are contiguous
+        std::vector<u32> indices;
+    };
+
+    // splits a triangle list into meshlets of at most 'max_vertices' unique vertices and 'max_triangles' triangles,
+    // the meshlets grow over the connected triangles that add the fewest vertices and face the same way
+    // NOTE: the position of a vertex is 3 floats at the start of each 'position_stride' bytes of 'positions'
+    // returns false when the mesh is not a triangle list, an index is out of range or the limits are below 3 vertices
+    bool BuildMeshlets(
+        const void* positions, size_t vertex_count, size_t position_stride,
+        const u32* indices, size_t index_count, const MeshletSettings& settings, MeshletMesh& mesh);
+
+    // computes the bounds of a range of triangles, used by BuildMeshlets()
+    MeshletBounds ComputeMeshletBounds(
+        const void* positions, size_t position_stride, const u32* indices, size_t triangle_count, bool front_face_is_clockwise);
+
+    // returns true when a meshlet faces away from the camera or is outside the frustum
+    // NOTE: the camera position and the frustum must be in the space of the bounds, usually the object space
+    // of the mesh, see Frustum(view_projection) with the world matrix of the object folded in
+    bool IsMeshletCulled(const MeshletBounds& bounds, const math::Frustum& frustum, const math::vec3f& camera_position);
+
+    // tests 'count' meshlets and writes the indices of the ones that are not culled to 'visible_indices',
+    // in increasing order, returns the number of visible meshlets, the result is the same as IsMeshletCulled()
+    // NOTE: 'visible_indices' must have room for 'count' indices
+    // NOTE: the meshlets are tested 8 at a time using simd instructions
+    size_t CullMeshlets(
+        const MeshletBounds* bounds, size_t count, const math::Frustum& frustum, const math::vec3f& camera_position, u32* visible_indices);
+
+    // a range of the index buffer, drawn with DrawIndexed(index_count, index_offset)
+    struct DrawRange
+    {
+        u32 index_offset;
+        u32 index_count;
+    };
+
+    // merges the visible meshlets that are next to each other in the index buffer into draw ranges,
+    // returns the number of ranges
+    // NOTE: 'ranges' must have room for 'visible_count' ranges
+    size_t BuildMeshletDrawRanges(const Meshlet* meshlets, const u32* visible_indices, size_t visible_count, DrawRange* ranges);
+}
@@ -0,0 +1,339 @@
+#include "tangent_space.h"
+#include "engine/core/math/vec3.h"
+#include "engine/core/parallel.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+using namespace deadrop;
+using namespace deadrop::math;
+using namespace deadrop::mesh;
+
+namespace
+{
+    // the triangles are split between the worker threads in ranges of this size
+    constexpr size_t TRIANGLE_RANGE_SIZE = 4096;
+    // the groups of welded vertices are split in ranges of this size
+    constexpr size_t GROUP_RANGE_SIZE = 8192;
+
+    // the most floats a welding key has, a position, a normal and texture coordinates
+    constexpr u32 MAX_KEY_SIZE = 8;
+
+    const float* getAttribute(const void* data, size_t stride, u32 vertex)
+    {
+        return reinterpret_cast<const float*>(static_cast<const u8*>(data) + vertex * stride);
+    }
+
+    vec3f loadVec3(const void* data, size_t stride, u32 vertex)
+    {
+        const float* value = getAttribute(data, stride, vertex);
+        return vec3f{ value[0], value[1], value[2] };
+    }
+
+    // the bits of the attributes a vertex is welded by, -0 is stored as 0 so both weld together
+    struct WeldKey
+    {
+        u32 bits[MAX_KEY_SIZE];
+        u32 size;
+
+        void append(const float* values, u32 count)
+        {
+            for (u32 i = 0; i < count; i++)
+            {
+                u32 value;
+                memcpy(&value, &values[i], sizeof(value));
+                bits[size++] = value == 0x80000000u ? 0 : value;
+            }
+        }
+
+        bool operator==(const WeldKey& other) const { return memcmp(bits, other.bits, size * sizeof(u32)) == 0; }
+
+        u32 hash() const
+        {
+            // murmur2 mixing of each word
+            u32 h = 0;
+            for (u32 i = 0; i < size; i++)
+            {
+                u32 k = bits[i] * 0x5bd1e995u;
+                k ^= k >> 24;
+                h = (h * 0x5bd1e995u) ^ (k * 0x5bd1e995u);
+            }
+            return h ^ (h >> 13);
+        }
+    };
+
+    WeldKey makeKey(const TangentSpaceMeshView& mesh, u32 vertex, bool with_attributes)
+    {
+        WeldKey key;
+        key.size = 0;
+        key.append(getAttribute(mesh.positions, mesh.position_stride, vertex), 3);
+        if (with_attributes)
+        {
+            key.append(getAttribute(mesh.normals, mesh.normal_stride, vertex), 3);
+            key.append(getAttribute(mesh.texcoords, mesh.texcoord_stride, vertex), 2);
+        }
+        return key;
+    }
+
+    // finds the vertices that have identical positions (and normals and texture coordinates when 'with_attributes'
+    // is true) using a hash table with linear probing, welded[v] is the first vertex that has the same values
+    void weldVertices(const TangentSpaceMeshView& mesh, bool with_attributes, std::vector<u32>& welded)
+    {
+        size_t table_size = 1;
+        while (table_size < mesh.vertex_count * 2)
+        {
+            table_size *= 2;
+        }
+        std::vector<u32> table(table_size, ~0u);
+        welded.resize(mesh.vertex_count);
+        for (u32 v = 0; v < mesh.vertex_count; v++)
+        {
+            const WeldKey key = makeKey(mesh, v, with_attributes);
+            size_t slot = key.hash() & (table_size - 1);
+            while (table[slot] != ~0u && !(makeKey(mesh, table[slot], with_attributes) == key))
+            {
+                slot = (slot + 1) & (table_size - 1);
+            }
+            if (table[slot] == ~0u)
+            {
+                table[slot] = v;
+            }
+            welded[v] = table[slot];
+        }
+    }
+
+    // sorts the corners of the triangles by group, the corners of group g are corners[offsets[g]] to corners[offsets[g + 1] - 1]
+    void groupCorners(const u32* corner_groups, size_t corner_count, size_t group_count, std::vector<u32>& offsets, std::vector<u32>& corners)
+    {
+        offsets.assign(group_count + 1, 0);
+        for (size_t c = 0; c < corner_count; c++)
+        {
+            offsets[corner_groups[c] + 1]++;
+        }
+        for (size_t g = 0; g < group_count; g++)
+        {
+            offsets[g + 1] += offsets[g];
+        }
+        corners.resize(corner_count);
+        std::vector<u32> cursors(offsets.begin(), offsets.end() - 1);
+        for (size_t c = 0; c < corner_count; c++)
+        {
+            corners[cursors[corner_groups[c]]++] = static_cast<u32>(c);
+        }
+    }
+
+    // returns the angle between two vectors, 0 when either is zero
+    float angleBetween(vec3f a, vec3f b)
+    {
+        const float lengths = std::sqrt(Dot(a, a) * Dot(b, b));
+        if (lengths <= 0.0f)
+        {
+            return 0.0f;
+        }
+        const float cosine = Dot(a, b) / lengths;
+        return std::acos(cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine));
+    }
+
+    // returns 'v' without its component along the unit vector 'n'
+    vec3f projectOnPlane(vec3f v, vec3f n)
+    {
+        return v - n * Dot(n, v);
+    }
+
+    // returns the normalized vector, or zero when it is too short to normalize
+    vec3f normalizeOrZero(vec3f v)
+    {
+        const float length = std::sqrt(Dot(v, v));
+        return length > 1e-20f ? v / length : vec3f(0.0f);
+    }
+
+    bool validateIndices(const TangentSpaceMeshView& mesh)
+    {
+        if (mesh.index_count % 3 != 0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < mesh.index_count; i++)
+        {
+            if (mesh.indices[i] >= mesh.vertex_count)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool deadrop::mesh::GenerateNormals(void* normals, size_t normal_stride, const TangentSpaceMeshView& mesh, NormalWeighting weighting)
+{
+    if (!mesh.positions || !validateIndices(mesh))
+    {
+        // error, not a triangle list or an index is out of range
+        return false;
+    }
+
+    std::vector<u32> welded;
+    weldVertices(mesh, false, welded);
+
+    // the weighted face normal of each corner
+    const size_t triangle_count = mesh.index_count / 3;
+    std::vector<vec3f> contributions(mesh.index_count);
+    ParallelFor(triangle_count, TRIANGLE_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; t++)
+        {
+            const u32* triangle = mesh.indices + t * 3;
+            const vec3f p[3] =
+            {
+                loadVec3(mesh.positions, mesh.position_stride, triangle[0]),
+                loadVec3(mesh.positions, mesh.position_stride, triangle[1]),
+                loadVec3(mesh.positions, mesh.position_stride, triangle[2])
+            };
+            // NOTE: the length of the cross product is twice the area of the triangle
+            const vec3f cross = Cross(p[1] - p[0], p[2] - p[0]);
+            const vec3f unit = normalizeOrZero(cross);
+            for (u32 corner = 0; corner < 3; corner++)
+            {
+                const vec3f& origin = p[corner];
+                const float angle = weighting == NORMAL_WEIGHTING_AREA ? 1.0f :
+                    angleBetween(p[(corner + 1) % 3] - origin, p[(corner + 2) % 3] - origin);
+                contributions[t * 3 + corner] = (weighting == NORMAL_WEIGHTING_ANGLE ? unit : cross) * angle;
+            }
+        }
+    });
+
+    std::vector<u32> corner_groups(mesh.index_count);
+    for (size_t c = 0; c < mesh.index_count; c++)
+    {
+        corner_groups[c] = welded[mesh.indices[c]];
+    }
+    std::vector<u32> offsets, corners;
+    groupCorners(corner_groups.data(), mesh.index_count, mesh.vertex_count, offsets, corners);
+
+    // sum the corners of each group, then copy the normal of the group to its vertices
+    std::vector<vec3f> group_normals(mesh.vertex_count);
+    ParallelFor(mesh.vertex_count, GROUP_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for (size_t g = begin; g < end; g++)
+        {
+            vec3f sum(0.0f);
+            for (u32 i = offsets[g]; i < offsets[g + 1]; i++)
+            {
+                sum = sum + contributions[corners[i]];
+            }
+            const vec3f normal = normalizeOrZero(sum);
+            group_normals[g] = Dot(normal, normal) > 0.0f ? normal : vec3f{ 0.0f, 0.0f, 1.0f };
+        }
+    });
+    ParallelFor(mesh.vertex_count, GROUP_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for (size_t v = begin; v < end; v++)
+        {
+            memcpy(static_cast<u8*>(normals) + v * normal_stride, &group_normals[welded[v]], sizeof(float) * 3);
+        }
+    });
+    return true;
+}
+
+bool deadrop::mesh::GenerateTangents(void* tangents, size_t tangent_stride, const TangentSpaceMeshView& mesh)
+{
+    if (!mesh.positions || !mesh.normals || !mesh.texcoords || !validateIndices(mesh))
+    {
+        // error, missing streams, not a triangle list or an index is out of range
+        return false;
+    }
+
+    // the corners are averaged per vertex with the same position, normal and texture coordinates,
+    // and the ones with mirrored texture coordinates are kept apart
+    std::vector<u32> welded;
+    weldVertices(mesh, true, welded);
+
+    // the same steps as mikktspace: the tangent of the triangle is the direction in which the u texture
+    // coordinate grows, it is projected on the plane of the normal of each corner and weighted by the angle
+    // of the corner in that plane
+    const size_t triangle_count = mesh.index_count / 3;
+    std::vector<vec3f> contributions(mesh.index_count);
+    std::vector<u32> corner_groups(mesh.index_count);
+    ParallelFor(triangle_count, TRIANGLE_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; t++)
+        {
+            const u32* triangle = mesh.indices + t * 3;
+            vec3f p[3], n[3];
+            float uv[3][2];
+            for (u32 corner = 0; corner < 3; corner++)
+            {
+                p[corner] = loadVec3(mesh.positions, mesh.position_stride, triangle[corner]);
+                n[corner] = normalizeOrZero(loadVec3(mesh.normals, mesh.normal_stride, triangle[corner]));
+                memcpy(uv[corner], getAttribute(mesh.texcoords, mesh.texcoord_stride, triangle[corner]), sizeof(float) * 2);
+            }
+
+            const vec3f d1 = p[1] - p[0];
+            const vec3f d2 = p[2] - p[0];
+            const float t21x = uv[1][0] - uv[0][0];
+            const float t21y = uv[1][1] - uv[0][1];
+            const float t31x = uv[2][0] - uv[0][0];
+            const float t31y = uv[2][1] - uv[0][1];
+            const float signed_area = t21x * t31y - t21y * t31x;
+            const bool preserves_orientation = signed_area > 0.0f;
+            vec3f tangent = d1 * t31y - d2 * t21y;
+            tangent = signed_area != 0.0f ? normalizeOrZero(preserves_orientation ? tangent : Negate(tangent)) : vec3f(0.0f);
+
+            for (u32 corner = 0; corner < 3; corner++)
+            {
+                const vec3f& origin = p[corner];
+                const vec3f edge1 = normalizeOrZero(projectOnPlane(p[(corner + 1) % 3] - origin, n[corner]));
+                const vec3f edge2 = normalizeOrZero(projectOnPlane(p[(corner + 2) % 3] - origin, n[corner]));
+                const float angle = angleBetween(edge1, edge2);
+                contributions[t * 3 + corner] = normalizeOrZero(projectOnPlane(tangent, n[corner])) * angle;
+                corner_groups[t * 3 + corner] = welded[triangle[corner]] * 2 + (preserves_orientation ? 1 : 0);
+            }
+        }
+    });
+
+    std::vector<u32> offsets, corners;
+    groupCorners(corner_groups.data(), mesh.index_count, mesh.vertex_count * 2, offsets, corners);
+
+    std::vector<vec3f> group_tangents(mesh.vertex_count * 2);
+    ParallelFor(mesh.vertex_count * 2, GROUP_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for (size_t g = begin; g < end; g++)
+        {
+            vec3f sum(0.0f);
+            for (u32 i = offsets[g]; i < offsets[g + 1]; i++)
+            {
+                sum = sum + contributions[corners[i]];
+            }
+            group_tangents[g] = normalizeOrZero(sum);
+        }
+    });
+
+    // a vertex takes the orientation of most of its corners, which are all the same unless the mirrored
+    // texture coordinates share vertices
+    std::vector<i32> orientation_votes(mesh.vertex_count, 0);
+    for (size_t c = 0; c < mesh.index_count; c++)
+    {
+        orientation_votes[mesh.indices[c]] += (corner_groups[c] & 1) ? 1 : -1;
+    }
+    ParallelFor(mesh.vertex_count, GROUP_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for (size_t v = begin; v < end; v++)
+        {
+            const bool preserves_orientation = orientation_votes[v] >= 0;
+            vec3f tangent = group_tangents[welded[v] * 2 + (preserves_orientation ? 1 : 0)];
+            if (Dot(tangent, tangent) == 0.0f)
+            {
+                // no usable texture coordinates, any direction perpendicular to the normal will do
+                const vec3f normal = normalizeOrZero(loadVec3(mesh.normals, mesh.normal_stride, static_cast<u32>(v)));
+                const vec3f axis = std::fabs(normal.x) < 0.9f ? vec3f{ 1.0f, 0.0f, 0.0f } : vec3f{ 0.0f, 1.0f, 0.0f };
+                tangent = normalizeOrZero(projectOnPlane(axis, normal));
+                if (Dot(tangent, tangent) == 0.0f)
+                {
+                    tangent = axis;
+                }
+            }
+            const float result[4] = { tangent.x, tangent.y, tangent.z, preserves_orientation ? 1.0f : -1.0f };
+            memcpy(static_cast<u8*>(tangents) + v * tangent_stride, result, sizeof(result));
+        }
+    });
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "engine/core/types.h"
+#include <cstddef>
+
+// generation of the vertex normals and of the tangents of normal mapping for meshes that were imported
+// without them, the work is split between the worker threads by ranges of triangles
+namespace deadrop::mesh
+{
+    // the streams of a triangle list, each attribute is read at the start of each 'stride' bytes
+    struct TangentSpaceMeshView
+    {
+        // 3 floats per vertex
+        const void* positions = nullptr;
+        size_t position_stride = sizeof(float) * 3;
+        // 3 floats per vertex, only read by GenerateTangents()
+        const void* normals = nullptr;
+        size_t normal_stride = sizeof(float) * 3;
+        // 2 floats per vertex, only read by GenerateTangents()
+        const void* texcoords = nullptr;
+        size_t texcoord_stride = sizeof(float) * 2;
+        size_t vertex_count = 0;
+        const u32* indices = nullptr;
+        size_t index_count = 0;
+    };
+
+    // how much each triangle contributes to the normals of its vertices
+    enum NormalWeighting : u32
+    {
+        // by its area, large triangles dominate
+        NORMAL_WEIGHTING_AREA = 0,
+        // by the angle of the triangle at the vertex, the result does not depend on how the surface is triangulated
+        NORMAL_WEIGHTING_ANGLE,
+        // by both, the default of most content tools
+        NORMAL_WEIGHTING_AREA_ANGLE
+    };
+
+    // computes smooth vertex normals and writes them as 3 floats at the start of each 'normal_stride' bytes of 'normals',
+    // the vertices at the same position are welded (found with a spatial hash) so the normals stay smooth across
+    // attribute seams
+    // NOTE: vertices that no triangle uses, or that are only used by degenerate triangles, get (0, 0, 1)
+    // returns false when the mesh is not a triangle list or an index is out of range
+    bool GenerateNormals(void* normals, size_t normal_stride, const TangentSpaceMeshView& mesh, NormalWeighting weighting = NORMAL_WEIGHTING_AREA_ANGLE);
+
+    // computes tangents that match the ones of mikktspace (the tangent space of most bakers) and writes them as
+    // 4 floats at the start of each 'tangent_stride' bytes of 'tangents', xyz is the unit tangent and w is the sign
+    // of the bitangent, which the shader rebuilds as cross(normal, tangent.xyz) * tangent.w
+    // NOTE: the corners of the vertices that have the same position, normal and texture coordinates (found with
+    // a spatial hash) and the same texture orientation are averaged like mikktspace does, the results can differ
+    // from mikktspace where it splits a vertex that is shared by unconnected triangles
+    // returns false when the mesh is not a triangle list, an index is out of range or the normals or texcoords are missing
+    bool GenerateTangents(void* tangents, size_t tangent_stride, const TangentSpaceMeshView& mesh);
+}
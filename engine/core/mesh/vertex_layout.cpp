@@ -0,0 +1,224 @@
+#include "vertex_layout.h"
+#include "engine/core/format_conversion.h"
+#include "engine/core/parallel.h"
+#include <cstring>
+using namespace deadrop;
+using namespace deadrop::mesh;
+
+namespace
+{
+    // the values are converted through small contiguous buffers so the array conversions of
+    // format_conversion.h can be used on the strided streams
+    constexpr size_t CHUNK_SIZE = 256;
+
+    // the vertices are packed on the worker threads in ranges of this size
+    constexpr size_t PARALLEL_RANGE_SIZE = 16 * 1024;
+
+    struct FormatInfo
+    {
+        // the size in bytes
+        u32 size;
+        // the number of stored values
+        u32 values;
+        // the number of floats it is packed from
+        u32 components;
+    };
+
+    constexpr FormatInfo FORMAT_INFOS[VERTEX_FORMAT_COUNT] =
+    {
+        { 4, 1, 1 },  // VERTEX_FORMAT_FLOAT1
+        { 8, 2, 2 },  // VERTEX_FORMAT_FLOAT2
+        { 12, 3, 3 }, // VERTEX_FORMAT_FLOAT3
+        { 16, 4, 4 }, // VERTEX_FORMAT_FLOAT4
+        { 4, 2, 2 },  // VERTEX_FORMAT_HALF2
+        { 8, 4, 4 },  // VERTEX_FORMAT_HALF4
+        { 4, 4, 4 },  // VERTEX_FORMAT_UNORM8_4
+        { 4, 4, 4 },  // VERTEX_FORMAT_SNORM8_4
+        { 4, 4, 4 },  // VERTEX_FORMAT_UINT8_4
+        { 4, 2, 2 },  // VERTEX_FORMAT_UNORM16_2
+        { 8, 4, 4 },  // VERTEX_FORMAT_UNORM16_4
+        { 4, 2, 2 },  // VERTEX_FORMAT_SNORM16_2
+        { 8, 4, 4 },  // VERTEX_FORMAT_SNORM16_4
+        { 4, 2, 3 },  // VERTEX_FORMAT_OCTAHEDRAL_SNORM16
+    };
+
+    // converts 'count' floats to the storage type of 'format', 'dst' is tightly packed
+    void convertValues(VertexFormat format, const float* src, void* dst, size_t count)
+    {
+        switch (format)
+        {
+        case VERTEX_FORMAT_HALF2:
+        case VERTEX_FORMAT_HALF4:
+            FloatToHalfMany(src, static_cast<u16*>(dst), count);
+            break;
+        case VERTEX_FORMAT_UNORM8_4:
+            FloatToUnorm8Many(src, static_cast<u8*>(dst), count);
+            break;
+        case VERTEX_FORMAT_SNORM8_4:
+            FloatToSnorm8Many(src, static_cast<i8*>(dst), count);
+            break;
+        case VERTEX_FORMAT_UINT8_4:
+            for (size_t i = 0; i < count; i++)
+            {
+                const float value = src[i] > 0.0f ? (src[i] < 255.0f ? src[i] : 255.0f) : 0.0f;
+                static_cast<u8*>(dst)[i] = static_cast<u8>(std::lrint(value));
+            }
+            break;
+        case VERTEX_FORMAT_UNORM16_2:
+        case VERTEX_FORMAT_UNORM16_4:
+            FloatToUnorm16Many(src, static_cast<u16*>(dst), count);
+            break;
+        case VERTEX_FORMAT_SNORM16_2:
+        case VERTEX_FORMAT_SNORM16_4:
+        case VERTEX_FORMAT_OCTAHEDRAL_SNORM16:
+            FloatToSnorm16Many(src, static_cast<i16*>(dst), count);
+            break;
+        default:
+            memcpy(dst, src, count * sizeof(float));
+            break;
+        }
+    }
+
+    // the inverse of convertValues()
+    void unconvertValues(VertexFormat format, const void* src, float* dst, size_t count)
+    {
+        switch (format)
+        {
+        case VERTEX_FORMAT_HALF2:
+        case VERTEX_FORMAT_HALF4:
+            HalfToFloatMany(static_cast<const u16*>(src), dst, count);
+            break;
+        case VERTEX_FORMAT_UNORM8_4:
+            Unorm8ToFloatMany(static_cast<const u8*>(src), dst, count);
+            break;
+        case VERTEX_FORMAT_SNORM8_4:
+            Snorm8ToFloatMany(static_cast<const i8*>(src), dst, count);
+            break;
+        case VERTEX_FORMAT_UINT8_4:
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<float>(static_cast<const u8*>(src)[i]);
+            }
+            break;
+        case VERTEX_FORMAT_UNORM16_2:
+        case VERTEX_FORMAT_UNORM16_4:
+            Unorm16ToFloatMany(static_cast<const u16*>(src), dst, count);
+            break;
+        case VERTEX_FORMAT_SNORM16_2:
+        case VERTEX_FORMAT_SNORM16_4:
+        case VERTEX_FORMAT_OCTAHEDRAL_SNORM16:
+            Snorm16ToFloatMany(static_cast<const i16*>(src), dst, count);
+            break;
+        default:
+            memcpy(dst, src, count * sizeof(float));
+            break;
+        }
+    }
+}
+
+u32 deadrop::mesh::GetVertexFormatSize(VertexFormat format)
+{
+    return FORMAT_INFOS[format].size;
+}
+
+u32 deadrop::mesh::GetVertexFormatComponentCount(VertexFormat format)
+{
+    return FORMAT_INFOS[format].components;
+}
+
+bool VertexLayout::Add(VertexSemantic semantic, u32 semantic_index, VertexFormat format)
+{
+    if (m_attribute_count == MAX_ATTRIBUTES)
+    {
+        // error, the layout is full
+        return false;
+    }
+    m_attributes[m_attribute_count++] = VertexAttribute{ semantic, static_cast<u8>(semantic_index), format, static_cast<u16>(m_stride) };
+    m_stride += GetVertexFormatSize(format);
+    return true;
+}
+
+void deadrop::mesh::PackVertexAttribute(
+    void* dst, size_t dst_stride, VertexFormat format,
+    const float* src, size_t src_stride, u32 src_components, size_t count)
+{
+    const FormatInfo& info = FORMAT_INFOS[format];
+    const float fill[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    const u32 copied = src_components < info.components ? src_components : info.components;
+
+    float values[CHUNK_SIZE * 4];
+    u8 packed[CHUNK_SIZE * 16];
+    for (size_t first = 0; first < count; first += CHUNK_SIZE)
+    {
+        const size_t chunk = count - first < CHUNK_SIZE ? count - first : CHUNK_SIZE;
+
+        // gather the floats of the chunk
+        for (size_t v = 0; v < chunk; v++)
+        {
+            const float* value = reinterpret_cast<const float*>(reinterpret_cast<const u8*>(src) + (first + v) * src_stride);
+            float* out = &values[v * info.values];
+            if (format == VERTEX_FORMAT_OCTAHEDRAL_SNORM16)
+            {
+                float normal[3] = { fill[0], fill[1], fill[2] };
+                memcpy(normal, value, copied * sizeof(float));
+                EncodeOctahedral(normal, out);
+                continue;
+            }
+            memcpy(out, value, copied * sizeof(float));
+            memcpy(out + copied, fill + copied, (info.values - copied) * sizeof(float));
+        }
+
+        // convert and scatter them to the vertices
+        convertValues(format, values, packed, chunk * info.values);
+        for (size_t v = 0; v < chunk; v++)
+        {
+            memcpy(static_cast<u8*>(dst) + (first + v) * dst_stride, &packed[v * info.size], info.size);
+        }
+    }
+}
+
+void deadrop::mesh::UnpackVertexAttribute(
+    float* dst, size_t dst_stride, VertexFormat format,
+    const void* src, size_t src_stride, size_t count)
+{
+    const FormatInfo& info = FORMAT_INFOS[format];
+
+    float values[CHUNK_SIZE * 4];
+    u8 packed[CHUNK_SIZE * 16];
+    for (size_t first = 0; first < count; first += CHUNK_SIZE)
+    {
+        const size_t chunk = count - first < CHUNK_SIZE ? count - first : CHUNK_SIZE;
+        for (size_t v = 0; v < chunk; v++)
+        {
+            memcpy(&packed[v * info.size], static_cast<const u8*>(src) + (first + v) * src_stride, info.size);
+        }
+        unconvertValues(format, packed, values, chunk * info.values);
+        for (size_t v = 0; v < chunk; v++)
+        {
+            float* out = reinterpret_cast<float*>(reinterpret_cast<u8*>(dst) + (first + v) * dst_stride);
+            if (format == VERTEX_FORMAT_OCTAHEDRAL_SNORM16)
+            {
+                DecodeOctahedral(&values[v * info.values], out);
+                continue;
+            }
+            memcpy(out, &values[v * info.values], info.values * sizeof(float));
+        }
+    }
+}
+
+void deadrop::mesh::PackVertices(void* dst, const VertexLayout& layout, const VertexStream* streams, size_t vertex_count)
+{
+    const size_t stride = layout.GetStride();
+    ParallelFor(vertex_count, PARALLEL_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for (u32 a = 0; a < layout.GetAttributeCount(); a++)
+        {
+            const VertexAttribute& attribute = layout.GetAttribute(a);
+            const VertexStream& stream = streams[a];
+            PackVertexAttribute(
+                static_cast<u8*>(dst) + begin * stride + attribute.offset, stride, attribute.format,
+                reinterpret_cast<const float*>(reinterpret_cast<const u8*>(stream.data) + begin * stream.stride), stream.stride, stream.components,
+                end - begin);
+        }
+    });
+}
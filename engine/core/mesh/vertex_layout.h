@@ -0,0 +1,154 @@
+#pragma once
+#include "engine/core/types.h"
+#include <cmath>
+#include <cstddef>
+
+// a description of how the attributes of a vertex are stored in a vertex buffer, so they can use formats
+// smaller than 32-bit floats, and the functions that pack float streams into that layout
+namespace deadrop::mesh
+{
+    // what an attribute is, the render backends turn it into a semantic name (POSITION, NORMAL...)
+    enum VertexSemantic : u8
+    {
+        VERTEX_SEMANTIC_POSITION = 0,
+        VERTEX_SEMANTIC_NORMAL,
+        VERTEX_SEMANTIC_TANGENT,
+        VERTEX_SEMANTIC_TEXCOORD,
+        VERTEX_SEMANTIC_COLOR,
+        VERTEX_SEMANTIC_BLEND_INDICES,
+        VERTEX_SEMANTIC_BLEND_WEIGHT,
+        VERTEX_SEMANTIC_COUNT
+    };
+
+    // the formats an attribute can be stored in, the shader reads all of them as floats except the uint ones
+    // NOTE: the sizes are all multiples of 4 bytes, so every attribute stays aligned
+    enum VertexFormat : u8
+    {
+        VERTEX_FORMAT_FLOAT1 = 0,
+        VERTEX_FORMAT_FLOAT2,
+        VERTEX_FORMAT_FLOAT3,
+        VERTEX_FORMAT_FLOAT4,
+        VERTEX_FORMAT_HALF2,
+        VERTEX_FORMAT_HALF4,
+        VERTEX_FORMAT_UNORM8_4,
+        VERTEX_FORMAT_SNORM8_4,
+        VERTEX_FORMAT_UINT8_4,
+        VERTEX_FORMAT_UNORM16_2,
+        VERTEX_FORMAT_UNORM16_4,
+        VERTEX_FORMAT_SNORM16_2,
+        VERTEX_FORMAT_SNORM16_4,
+        // a unit vector (3 floats) stored as 2 snorm16 values with the octahedral mapping,
+        // the shader reads a float2 and decodes it with DecodeOctahedral()
+        VERTEX_FORMAT_OCTAHEDRAL_SNORM16,
+        VERTEX_FORMAT_COUNT
+    };
+
+    // returns the size of an attribute in bytes
+    u32 GetVertexFormatSize(VertexFormat format);
+
+    // returns the number of floats an attribute is packed from, 3 for the octahedral formats
+    u32 GetVertexFormatComponentCount(VertexFormat format);
+
+    // one attribute of a vertex, 'offset' is the byte offset from the start of the vertex
+    struct VertexAttribute
+    {
+        VertexSemantic semantic;
+        u8 semantic_index;
+        VertexFormat format;
+        u16 offset;
+    };
+
+    // the attributes of a vertex in the order they are stored in the vertex buffer, with no padding between them
+    // NOTE: it is a fixed size value type so descriptors holding it can be copied freely
+    class VertexLayout
+    {
+    public:
+        static constexpr u32 MAX_ATTRIBUTES = 16;
+
+        // adds an attribute after the previous ones, returns false when the layout is full
+        bool Add(VertexSemantic semantic, u32 semantic_index, VertexFormat format);
+
+        // returns one of the attributes
+        const VertexAttribute& GetAttribute(u32 index) const { return m_attributes[index]; }
+
+        // returns the number of attributes, 0 for an empty layout
+        u32 GetAttributeCount() const { return m_attribute_count; }
+
+        // returns the size of a vertex in bytes, the stride of the vertex buffer
+        u32 GetStride() const { return m_stride; }
+
+    private:
+        VertexAttribute m_attributes[MAX_ATTRIBUTES]{};
+        u32 m_attribute_count = 0;
+        u32 m_stride = 0;
+    };
+
+    // maps a unit vector to a point of the [-1, 1] square by projecting it on an octahedron and unfolding
+    // the lower half over the corners, 2 values keep the precision of 3 evenly over the sphere
+    inline void EncodeOctahedral(const float* normal, float* out)
+    {
+        const float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+        if (length <= 0.0f)
+        {
+            out[0] = 0.0f;
+            out[1] = 0.0f;
+            return;
+        }
+        const float x = normal[0] / length;
+        const float y = normal[1] / length;
+        if (normal[2] >= 0.0f)
+        {
+            out[0] = x;
+            out[1] = y;
+        }
+        else
+        {
+            out[0] = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            out[1] = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        }
+    }
+
+    // the inverse of EncodeOctahedral(), the shaders run the same steps:
+    // n = float3(e.x, e.y, 1 - |e.x| - |e.y|), t = saturate(-n.z), n.xy += (n.xy >= 0 ? -t : t), normalize(n)
+    inline void DecodeOctahedral(const float* encoded, float* normal)
+    {
+        float x = encoded[0];
+        float y = encoded[1];
+        const float z = 1.0f - std::fabs(x) - std::fabs(y);
+        const float t = z < 0.0f ? -z : 0.0f;
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+        const float length = std::sqrt(x * x + y * y + z * z);
+        normal[0] = x / length;
+        normal[1] = y / length;
+        normal[2] = z / length;
+    }
+
+    // packs 'count' values of an attribute from floats, each value is 'src_components' floats at the start of
+    // each 'src_stride' bytes of 'src' and is written at the start of each 'dst_stride' bytes of 'dst'
+    // NOTE: missing components are filled like the gpu does, with (0, 0, 0, 1), and extra ones are ignored
+    // NOTE: the conversions are the ones of format_conversion.h, unorm/snorm values are clamped, uint values
+    // are rounded and clamped to [0, 255]
+    void PackVertexAttribute(
+        void* dst, size_t dst_stride, VertexFormat format,
+        const float* src, size_t src_stride, u32 src_components, size_t count);
+
+    // unpacks 'count' values of an attribute to GetVertexFormatComponentCount() floats each, used by tools
+    // and to check the precision that a layout keeps
+    void UnpackVertexAttribute(
+        float* dst, size_t dst_stride, VertexFormat format,
+        const void* src, size_t src_stride, size_t count);
+
+    // a float stream that an attribute is packed from, see PackVertexAttribute()
+    struct VertexStream
+    {
+        const float* data = nullptr;
+        size_t stride = 0;
+        u32 components = 0;
+    };
+
+    // packs whole vertices into 'dst', streams[i] is the source of layout.GetAttribute(i),
+    // 'dst' must have room for 'vertex_count * layout.GetStride()' bytes
+    // NOTE: large meshes are split between the worker threads, see ParallelFor()
+    void PackVertices(void* dst, const VertexLayout& layout, const VertexStream* streams, size_t vertex_count);
+}
@@ -0,0 +1,202 @@
+#include "parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace deadrop;
+
+namespace
+{
+    // set while a thread is running ranges, used to detect nested calls
+    thread_local bool t_in_parallel_for = false;
+
+    // the index returned by GetThreadIndex(), ~0u until the first call
+    std::atomic<u32> s_next_thread_index{ 0 };
+    thread_local u32 t_thread_index = ~0u;
+
+    // a pool of threads that sleep until ParallelFor() hands them a job
+    class WorkerPool
+    {
+    public:
+        WorkerPool()
+        {
+            // the calling thread also works, so one thread less than the cpu has
+            const u32 hardware_threads = std::thread::hardware_concurrency();
+            const u32 worker_count = hardware_threads > 1 ? hardware_threads - 1 : 0;
+            m_threads.reserve(worker_count);
+            for (u32 i = 0; i < worker_count; i++)
+            {
+                m_threads.emplace_back([this]() { workerLoop(); });
+            }
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (std::thread& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        u32 getThreadCount() const
+        {
+            return static_cast<u32>(m_threads.size()) + 1;
+        }
+
+        // runs the job on the pool, returns false when the pool is busy with another job
+        bool tryRun(size_t count, size_t batch_size, const ParallelRangeFunc& func)
+        {
+            std::unique_lock<std::mutex> run_lock(m_run_mutex, std::try_to_lock);
+            if (!run_lock.owns_lock())
+            {
+                return false;
+            }
+
+            {
+                // NOTE: workers that woke up late for the previous job may still be
+                // leaving processBatches(), wait for them before changing the job
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done.wait(lock, [this]() { return m_active_workers == 0; });
+                m_func = &func;
+                m_count = count;
+                m_batch_size = batch_size;
+                m_batch_count = (count + batch_size - 1) / batch_size;
+                m_next_batch.store(0);
+                m_remaining_batches.store(m_batch_count);
+                m_generation++;
+            }
+            m_wake.notify_all();
+
+            processBatches();
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this]() { return m_remaining_batches.load() == 0; });
+            return true;
+        }
+
+    private:
+        // takes batches until there are none left
+        void processBatches()
+        {
+            t_in_parallel_for = true;
+            for (;;)
+            {
+                const size_t batch = m_next_batch.fetch_add(1);
+                if (batch >= m_batch_count)
+                {
+                    break;
+                }
+
+                const size_t begin = batch * m_batch_size;
+                const size_t end = begin + m_batch_size < m_count ? begin + m_batch_size : m_count;
+                (*m_func)(begin, end);
+
+                if (m_remaining_batches.fetch_sub(1) == 1)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done.notify_all();
+                }
+            }
+            t_in_parallel_for = false;
+        }
+
+        void workerLoop()
+        {
+            u64 seen_generation = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [&]() { return m_stop || m_generation != seen_generation; });
+                    if (m_stop)
+                    {
+                        return;
+                    }
+                    seen_generation = m_generation;
+                    m_active_workers++;
+                }
+
+                processBatches();
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_active_workers--;
+                    if (m_active_workers == 0)
+                    {
+                        m_done.notify_all();
+                    }
+                }
+            }
+        }
+
+        std::vector<std::thread> m_threads;
+
+        // only one job runs on the pool at a time
+        std::mutex m_run_mutex;
+
+        // protects the job description, the generation and the worker states
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        u64 m_generation = 0;
+        u32 m_active_workers = 0;
+        bool m_stop = false;
+
+        // the current job
+        const ParallelRangeFunc* m_func = nullptr;
+        size_t m_count = 0;
+        size_t m_batch_size = 0;
+        size_t m_batch_count = 0;
+        std::atomic<size_t> m_next_batch{ 0 };
+        std::atomic<size_t> m_remaining_batches{ 0 };
+    };
+
+    WorkerPool& getPool()
+    {
+        // create the threads once, on the first call
+        static WorkerPool s_pool;
+        return s_pool;
+    }
+}
+
+u32 deadrop::GetParallelThreadCount()
+{
+    return getPool().getThreadCount();
+}
+
+void deadrop::ParallelFor(size_t count, size_t batch_size, const ParallelRangeFunc& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (batch_size == 0)
+    {
+        batch_size = 1;
+    }
+
+    // a single batch or a nested call does not need the workers
+    if (count <= batch_size || t_in_parallel_for || !getPool().tryRun(count, batch_size, func))
+    {
+        for (size_t begin = 0; begin < count; begin += batch_size)
+        {
+            const size_t end = begin + batch_size < count ? begin + batch_size : count;
+            func(begin, end);
+        }
+    }
+}
+
+u32 deadrop::GetThreadIndex()
+{
+    if (t_thread_index == ~0u)
+    {
+        t_thread_index = s_next_thread_index.fetch_add(1, std::memory_order_relaxed);
+    }
+    return t_thread_index;
+}
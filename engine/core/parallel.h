@@ -0,0 +1,27 @@
+#pragma once
+#include "types.h"
+#include <functional>
+
+namespace deadrop
+{
+    // a function that processes the items in the range [begin, end)
+    using ParallelRangeFunc = std::function<void(size_t begin, size_t end)>;
+
+    // returns the number of threads that ParallelFor() runs on, including the calling thread
+    // NOTE: the worker threads are created once on the first call of either function
+    [[nodiscard]]
+    u32 GetParallelThreadCount();
+
+    // splits [0, count) into ranges of 'batch_size' items and runs 'func' on them using the worker threads,
+    // the calling thread processes ranges too and the function only returns after all the ranges are done
+    // NOTE: 'func' is called concurrently, it must only write to memory that belongs to its range
+    // NOTE: calls made from inside 'func', or while another thread is inside ParallelFor(),
+    // run all the ranges on the calling thread instead of waiting for the workers
+    void ParallelFor(size_t count, size_t batch_size, const ParallelRangeFunc& func);
+
+    // returns a small index that is unique to the calling thread, assigned in order on the first call of each thread,
+    // used to give each thread its own slot in per-thread arrays
+    // NOTE: the indices are never reused, a thread that exits keeps its index
+    [[nodiscard]]
+    u32 GetThreadIndex();
+}
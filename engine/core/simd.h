@@ -0,0 +1,39 @@
+#pragma once
+// x86 SIMD intrinsics, SSE2 is the baseline for both x32 and x64 platforms
+#include "types.h"
+#include <cstddef>
+#include <immintrin.h>
+
+// functions that use instructions above the SSE2 baseline must be marked
+// with the matching SIMD_TARGET_* macro, MSVC allows using any intrinsic without it
+// so the macros are empty there, but GCC and Clang need the target enabled per-function
+// NOTE: never call such functions without checking GetCpuFeatures() first!
+#ifdef _MSC_VER
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_F16C
+#else
+#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+
+namespace deadrop::simd
+{
+    // writes 'first_index + lane' for each set bit of 'mask' (like the result of _mm_movemask_ps()) to 'out',
+    // returns how many were written, the culling functions use it to turn a mask of visible lanes into indices
+    // NOTE: branchless, each lane is always written but the position only advances for the set bits, so 'out'
+    // must have room for 'lanes' indices, which is safe when writing to the indices being tested
+    inline size_t CompactIndices(u32 mask, u32 lanes, u32 first_index, u32* out)
+    {
+        size_t written = 0;
+        for (u32 lane = 0; lane < lanes; lane++)
+        {
+            out[written] = first_index + lane;
+            written += (mask >> lane) & 1;
+        }
+        return written;
+    }
+}
@@ -0,0 +1,197 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace deadrop
+{
+    // a reference to a value in a SlotMap<T>, it stores the index of a slot and the generation the slot had
+    // when the value was inserted, the generation of a slot changes every time its value is erased so the
+    // handles of erased values (stale handles) no longer find anything
+    // 'Int' is u32 (20 bits of index and 12 of generation) or u64 (32 bits of each)
+    // NOTE: the default handle is invalid, generations start at 1
+    template<typename T, typename Int = u32>
+    class Handle
+    {
+    public:
+        static_assert(std::is_same<Int, u32>::value || std::is_same<Int, u64>::value, "handles are either 32 or 64 bits!");
+
+        using int_type = Int;
+
+        static constexpr u32 INDEX_BITS = sizeof(Int) == 4 ? 20 : 32;
+        static constexpr u32 GENERATION_BITS = sizeof(Int) * 8 - INDEX_BITS;
+        static constexpr Int MAX_INDEX = (Int(1) << INDEX_BITS) - 1;
+        static constexpr Int MAX_GENERATION = (Int(1) << GENERATION_BITS) - 1;
+
+        constexpr Handle() = default;
+        constexpr Handle(Int index, Int generation) : m_value((generation << INDEX_BITS) | index) {}
+
+        constexpr Int GetIndex() const { return m_value & MAX_INDEX; }
+        constexpr Int GetGeneration() const { return m_value >> INDEX_BITS; }
+
+        // returns whether the handle was returned by SlotMap::Insert(), not whether its value still exists
+        constexpr bool IsValid() const { return m_value != 0; }
+
+        // returns the handle as a single integer, for example to store it in a draw packet
+        constexpr Int GetValue() const { return m_value; }
+
+        constexpr bool operator==(const Handle& other) const { return m_value == other.m_value; }
+        constexpr bool operator!=(const Handle& other) const { return m_value != other.m_value; }
+
+    private:
+        Int m_value = 0;
+    };
+
+    // a container that stores its values in a dense array and gives out handles to them, inserting, erasing
+    // and looking a value up by its handle are O(1), and iterating visits only the live values, contiguously
+    // NOTE: erasing moves the last value into the hole, so the order of the values changes and pointers
+    // to the values are only valid until the next Insert() or Erase()
+    // NOTE: a slot whose generation reached Handle::MAX_GENERATION is not reused, so a stale handle can
+    // never find a newer value
+    // 'HandleType' is Handle<T, u64> for 64-bit handles, or a handle of another type when the values are
+    // owning pointers, like SlotMap<uptr<IBuffer>, Handle<IBuffer>>
+    template<typename T, typename HandleType = Handle<T>>
+    class SlotMap
+    {
+    public:
+        using handle_type = HandleType;
+        using iterator = typename std::vector<T>::iterator;
+        using const_iterator = typename std::vector<T>::const_iterator;
+
+        // moves the value into the map and returns its handle
+        // returns an invalid handle when all the indices of the handle are used
+        template<typename... Args>
+        handle_type Insert(Args&&... args)
+        {
+            u32 slot_index;
+            if (m_free_slots != NONE)
+            {
+                slot_index = m_free_slots;
+                m_free_slots = m_slots[slot_index].dense_index;
+            }
+            else
+            {
+                if (m_slots.size() > handle_type::MAX_INDEX)
+                {
+                    // error, no handle index left
+                    return handle_type{};
+                }
+                slot_index = static_cast<u32>(m_slots.size());
+                m_slots.push_back(Slot{ NONE, 1 });
+            }
+
+            Slot& slot = m_slots[slot_index];
+            slot.dense_index = static_cast<u32>(m_values.size());
+            m_values.emplace_back(std::forward<Args>(args)...);
+            m_dense_to_slot.push_back(slot_index);
+            return handle_type(slot_index, slot.generation);
+        }
+
+        // destroys the value of the handle
+        // returns false when the handle is stale or invalid
+        bool Erase(handle_type handle)
+        {
+            if (!Contains(handle))
+            {
+                return false;
+            }
+            const u32 slot_index = static_cast<u32>(handle.GetIndex());
+            Slot& slot = m_slots[slot_index];
+
+            // move the last value into the hole
+            const u32 last = static_cast<u32>(m_values.size() - 1);
+            if (slot.dense_index != last)
+            {
+                m_values[slot.dense_index] = std::move(m_values[last]);
+                m_dense_to_slot[slot.dense_index] = m_dense_to_slot[last];
+                m_slots[m_dense_to_slot[last]].dense_index = slot.dense_index;
+            }
+            m_values.pop_back();
+            m_dense_to_slot.pop_back();
+
+            // a new generation makes the handles of the slot stale, a slot that has no generation left is retired
+            // NOTE: compared before the increment, the last generation of a 64-bit handle does not fit after it
+            if (slot.generation < handle_type::MAX_GENERATION)
+            {
+                slot.generation++;
+                slot.dense_index = m_free_slots;
+                m_free_slots = slot_index;
+            }
+            else
+            {
+                slot.dense_index = NONE;
+            }
+            return true;
+        }
+
+        // returns whether the handle refers to a live value
+        bool Contains(handle_type handle) const
+        {
+            const auto index = handle.GetIndex();
+            return handle.IsValid() && index < m_slots.size() &&
+                m_slots[static_cast<size_t>(index)].generation == handle.GetGeneration() &&
+                m_slots[static_cast<size_t>(index)].dense_index != NONE;
+        }
+
+        // returns the value of the handle, or nullptr when the handle is stale or invalid
+        T* Get(handle_type handle)
+        {
+            return Contains(handle) ? &m_values[m_slots[static_cast<size_t>(handle.GetIndex())].dense_index] : nullptr;
+        }
+
+        const T* Get(handle_type handle) const
+        {
+            return Contains(handle) ? &m_values[m_slots[static_cast<size_t>(handle.GetIndex())].dense_index] : nullptr;
+        }
+
+        // returns the handle of the value at 'dense_index' of the iteration order
+        handle_type GetHandle(size_t dense_index) const
+        {
+            const u32 slot_index = m_dense_to_slot[dense_index];
+            return handle_type(slot_index, m_slots[slot_index].generation);
+        }
+
+        // destroys all the values, the handles given out so far become stale
+        void Clear()
+        {
+            while (!m_values.empty())
+            {
+                Erase(GetHandle(m_values.size() - 1));
+            }
+        }
+
+        void Reserve(size_t count)
+        {
+            m_values.reserve(count);
+            m_dense_to_slot.reserve(count);
+            m_slots.reserve(count);
+        }
+
+        size_t Size() const { return m_values.size(); }
+        bool Empty() const { return m_values.empty(); }
+
+        // iteration over the live values, in the dense order
+        iterator begin() { return m_values.begin(); }
+        iterator end() { return m_values.end(); }
+        const_iterator begin() const { return m_values.begin(); }
+        const_iterator end() const { return m_values.end(); }
+
+    private:
+        static constexpr u32 NONE = ~0u;
+
+        struct Slot
+        {
+            // the index of the value in the dense array, or the next free slot while the slot is free
+            u32 dense_index;
+            u32 generation;
+        };
+
+        std::vector<T> m_values;
+        std::vector<u32> m_dense_to_slot;
+        std::vector<Slot> m_slots;
+        // the head of the list of free slots
+        u32 m_free_slots = NONE;
+    };
+}
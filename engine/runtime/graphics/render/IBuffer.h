@@ -22,6 +22,7 @@ namespace deadrop
             unsigned int count = 0;
             USAGE usage{};
             CPU_ACCESS access{};
+            // NOTE: for index buffers this is the size of an index, 2 for 16-bit indices and 4 for 32-bit ones
             unsigned int stride = 1;
         };
 
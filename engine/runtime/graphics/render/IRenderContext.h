@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/core/memory/memory.h"
+#include "engine/core/slot_map.h"
 #include "ITexture2D.h"
 #include "IRenderTarget.h"
 #include "IViewport.h"
@@ -72,6 +73,18 @@ namespace deadrop
             void* windowHandle;
         };
 
+        // handles to the resources owned by a render context, they are 4 bytes instead of the 8 of a pointer
+        // (16 of a uptr) which keeps draw packets small, and a handle to a destroyed resource is detected
+        // instead of being dereferenced
+        using TextureHandle             = Handle<ITexture2D>;
+        using BufferHandle              = Handle<IBuffer>;
+        using ShaderHandle              = Handle<IShader>;
+        using ViewportHandle            = Handle<IViewport>;
+        using RenderTargetHandle        = Handle<IRenderTarget>;
+        using PipelineStateHandle       = Handle<IPipelineState>;
+        using RasterizerStateHandle     = Handle<IRasterizerState>;
+        using DepthStencilStateHandle   = Handle<IDepthStencilState>;
+
         // an interface to expose the functionality of the gpu pipeline
         class IRenderContext
         {
@@ -95,6 +108,44 @@ namespace deadrop
             virtual uptr<IRasterizerState>      CreateRasterizerState(const RasterizerStateDesc& desc) = 0;
             virtual uptr<IDepthStencilState>    CreateDepthStencilState(const DepthStencilStateDesc& desc) = 0;
 
+            // graphics pipleline object creation functions that keep the object in the context and return a handle to it,
+            // the object lives until Destroy() is called with the handle or the context is destroyed
+            // returns false and an invalid handle when the object could not be created
+            virtual bool CreateTexture2D(TextureHandle& handle, const Texture2DDesc& desc,
+                const memory::MemoryBlock& data = { 0, nullptr },
+                const std::vector<memory::MemoryBlock>& dataArray = std::vector<memory::MemoryBlock>{}) = 0;
+
+            virtual bool CreateBuffer(BufferHandle& handle, BufferDesc& desc,
+                const memory::MemoryBlock& data = memory::MemoryBlock{ 0, nullptr }) = 0;
+            virtual bool CreateShaderFromFile(ShaderHandle& handle, const ShaderDesc& desc, const std::wstring& filePath) = 0;
+            virtual bool CreateDepth2D(TextureHandle& handle, const Texture2DDesc& desc) = 0;
+            virtual bool CreateViewport(ViewportHandle& handle, const ViewportDesc& desc) = 0;
+            virtual bool CreateRenderTarget(RenderTargetHandle& handle, TextureHandle texture) = 0;
+            virtual bool CreatePipelineState(PipelineStateHandle& handle, const PipelineStateDesc& pipelineState) = 0;
+            virtual bool CreateRasterizerState(RasterizerStateHandle& handle, const RasterizerStateDesc& desc) = 0;
+            virtual bool CreateDepthStencilState(DepthStencilStateHandle& handle, const DepthStencilStateDesc& desc) = 0;
+
+            // destroys the object of the handle, the handle and its copies become stale
+            // returns false when the handle is stale or invalid
+            virtual bool Destroy(TextureHandle handle) = 0;
+            virtual bool Destroy(BufferHandle handle) = 0;
+            virtual bool Destroy(ShaderHandle handle) = 0;
+            virtual bool Destroy(ViewportHandle handle) = 0;
+            virtual bool Destroy(RenderTargetHandle handle) = 0;
+            virtual bool Destroy(PipelineStateHandle handle) = 0;
+            virtual bool Destroy(RasterizerStateHandle handle) = 0;
+            virtual bool Destroy(DepthStencilStateHandle handle) = 0;
+
+            // returns the object of the handle, or nullptr when the handle is stale or invalid
+            virtual ITexture2D*         Get(TextureHandle handle) = 0;
+            virtual IBuffer*            Get(BufferHandle handle) = 0;
+            virtual IShader*            Get(ShaderHandle handle) = 0;
+            virtual IViewport*          Get(ViewportHandle handle) = 0;
+            virtual IRenderTarget*      Get(RenderTargetHandle handle) = 0;
+            virtual IPipelineState*     Get(PipelineStateHandle handle) = 0;
+            virtual IRasterizerState*   Get(RasterizerStateHandle handle) = 0;
+            virtual IDepthStencilState* Get(DepthStencilStateHandle handle) = 0;
+
             // graphics pipeline changing functions
             virtual void BindShader(IShader* shader) = 0;
             virtual void BindState(IRasterizerState* state) = 0;
@@ -114,6 +165,20 @@ namespace deadrop
             virtual void SetViewport(IViewport* viewport) = 0;
             virtual void SetScissor(const Rect& rect)  = 0;
 
+            // graphics pipeline changing functions that take handles, a stale handle binds nothing
+            // NOTE: an invalid (default) texture handle unbinds the texture slot, and an invalid depth stencil
+            // handle binds the render target without depth stencil, like nullptr does
+            virtual void BindShader(ShaderHandle shader) = 0;
+            virtual void BindState(RasterizerStateHandle state) = 0;
+            virtual void BindState(DepthStencilStateHandle state) = 0;
+            virtual void BindState(PipelineStateHandle pipelineState) = 0;
+            virtual void BindTexture(unsigned int slot, TextureHandle texture) = 0;
+            virtual void BindBuffer(BufferHandle buffer, unsigned int slot, const BIND_STAGE& stage) = 0;
+            virtual void BindRenderTarget(RenderTargetHandle renderTarget, TextureHandle depthStencil) = 0;
+            virtual void Clear(RenderTargetHandle renderTarget, const float color[4] = defaultClearColor) = 0;
+            virtual void Clear(TextureHandle depthTexture) = 0;
+            virtual void SetViewport(ViewportHandle viewport) = 0;
+
             virtual const DeviceDesc& GetDeviceDesc() = 0;
         };
     }
@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/core/memory/memory.h"
+#include "engine/core/mesh/vertex_layout.h"
 #include "IUniformBuffer.h"
 #include <string>
 
@@ -22,6 +23,10 @@ namespace deadrop
             SHADER_TYPE	type;
             std::string entry;
             std::string model;
+            // the layout of the vertices a vertex shader reads, when it is empty the layout is created
+            // from the inputs of the shader with every attribute as 32-bit values
+            // NOTE: the attributes must match the inputs of the shader by semantic and index
+            mesh::VertexLayout layout;
         };
 
         // an interface to expose the shader functionality
@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/runtime/graphics/render/IBuffer.h"
+#include "engine/core/memory/pool_allocator.h"
 #include "D3D11Common.h"
 #include <stdint.h>
 
@@ -7,7 +8,7 @@ namespace deadrop
 {
     namespace render
     {
-        class D3D11Buffer : public IBuffer
+        class D3D11Buffer : public IBuffer, public memory::PoolAllocated<D3D11Buffer, memory::MEMORY_TAG_RENDER>
         {
         public:
             D3D11Buffer() = default;
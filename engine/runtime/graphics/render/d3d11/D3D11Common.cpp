@@ -197,3 +197,49 @@ UNIFORM_BUFFER_TYPE D3D11Common::ResolveType(const D3D_CBUFFER_TYPE & type)
     }
     }
 }
+
+DXGI_FORMAT D3D11Common::ResolveType(const mesh::VertexFormat& format)
+{
+    switch (format)
+    {
+    case mesh::VERTEX_FORMAT_FLOAT1: return DXGI_FORMAT_R32_FLOAT;
+    case mesh::VERTEX_FORMAT_FLOAT2: return DXGI_FORMAT_R32G32_FLOAT;
+    case mesh::VERTEX_FORMAT_FLOAT3: return DXGI_FORMAT_R32G32B32_FLOAT;
+    case mesh::VERTEX_FORMAT_FLOAT4: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case mesh::VERTEX_FORMAT_HALF2: return DXGI_FORMAT_R16G16_FLOAT;
+    case mesh::VERTEX_FORMAT_HALF4: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case mesh::VERTEX_FORMAT_UNORM8_4: return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case mesh::VERTEX_FORMAT_SNORM8_4: return DXGI_FORMAT_R8G8B8A8_SNORM;
+    case mesh::VERTEX_FORMAT_UINT8_4: return DXGI_FORMAT_R8G8B8A8_UINT;
+    case mesh::VERTEX_FORMAT_UNORM16_2: return DXGI_FORMAT_R16G16_UNORM;
+    case mesh::VERTEX_FORMAT_UNORM16_4: return DXGI_FORMAT_R16G16B16A16_UNORM;
+    case mesh::VERTEX_FORMAT_SNORM16_2: return DXGI_FORMAT_R16G16_SNORM;
+    case mesh::VERTEX_FORMAT_SNORM16_4: return DXGI_FORMAT_R16G16B16A16_SNORM;
+    // NOTE: the shader reads the 2 encoded values and decodes the vector itself
+    case mesh::VERTEX_FORMAT_OCTAHEDRAL_SNORM16: return DXGI_FORMAT_R16G16_SNORM;
+    default:
+    {
+        // error, invalid vertex format, returning DXGI_FORMAT_UNKNOWN!
+        return DXGI_FORMAT_UNKNOWN;
+    }
+    }
+}
+
+LPCSTR D3D11Common::ResolveType(const mesh::VertexSemantic& semantic)
+{
+    switch (semantic)
+    {
+    case mesh::VERTEX_SEMANTIC_POSITION: return "POSITION";
+    case mesh::VERTEX_SEMANTIC_NORMAL: return "NORMAL";
+    case mesh::VERTEX_SEMANTIC_TANGENT: return "TANGENT";
+    case mesh::VERTEX_SEMANTIC_TEXCOORD: return "TEXCOORD";
+    case mesh::VERTEX_SEMANTIC_COLOR: return "COLOR";
+    case mesh::VERTEX_SEMANTIC_BLEND_INDICES: return "BLENDINDICES";
+    case mesh::VERTEX_SEMANTIC_BLEND_WEIGHT: return "BLENDWEIGHT";
+    default:
+    {
+        // error, invalid vertex semantic, returning an empty name!
+        return "";
+    }
+    }
+}
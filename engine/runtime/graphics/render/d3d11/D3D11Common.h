@@ -3,6 +3,7 @@
 #include "engine/runtime/graphics/render/IRasterizerState.h"
 #include "engine/runtime/graphics/render/IBuffer.h"
 #include "engine/runtime/graphics/render/IUniformBuffer.h"
+#include "engine/core/mesh/vertex_layout.h"
 #include <d3d11.h>
 
 #include <wrl.h>
@@ -22,6 +23,9 @@ namespace deadrop
             static D3D11_BIND_FLAG ResolveType(const BIND_FLAG& bindFlag);
             static D3D11_SRV_DIMENSION ResolveType(const TEXTURE2D_TYPE& type);
             static UNIFORM_BUFFER_TYPE ResolveType(const D3D_CBUFFER_TYPE& type);
+            static DXGI_FORMAT ResolveType(const mesh::VertexFormat& format);
+            // returns the hlsl semantic name
+            static LPCSTR ResolveType(const mesh::VertexSemantic& semantic);
             static unsigned int SizeOf(const TEXTURE2D_FORMAT& format);
 
             // https://msdn.microsoft.com/en-us/library/windows/desktop/ff476259(v=vs.85).aspx
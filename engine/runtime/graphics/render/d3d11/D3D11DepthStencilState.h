@@ -1,12 +1,13 @@
 #pragma once
 #include "engine/runtime/graphics/render/IDepthStencilState.h"
+#include "engine/core/memory/pool_allocator.h"
 #include "D3D11Common.h"
 
 namespace deadrop
 {
     namespace render
     {
-        class D3D11DepthStencilState : public IDepthStencilState
+        class D3D11DepthStencilState : public IDepthStencilState, public memory::PoolAllocated<D3D11DepthStencilState, memory::MEMORY_TAG_RENDER>
         {
         public:
             D3D11DepthStencilState() = default;
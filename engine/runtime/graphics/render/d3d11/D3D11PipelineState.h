@@ -1,11 +1,12 @@
 #pragma once
 #include "engine/runtime/graphics/render/IPipelineState.h"
+#include "engine/core/memory/pool_allocator.h"
 
 namespace deadrop
 {
     namespace render
     {
-        class D3D11PipelineState : public IPipelineState
+        class D3D11PipelineState : public IPipelineState, public memory::PoolAllocated<D3D11PipelineState, memory::MEMORY_TAG_RENDER>
         {
         public:
             D3D11PipelineState(const PipelineStateDesc& desc) : m_desc(desc) {}
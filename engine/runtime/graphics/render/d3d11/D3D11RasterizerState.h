@@ -1,12 +1,13 @@
 #pragma once
 #include "engine/runtime/graphics/render/IRasterizerState.h"
+#include "engine/core/memory/pool_allocator.h"
 #include "D3D11Common.h"
 
 namespace deadrop 
 {
     namespace render 
     {
-        class D3D11RasterizerState : public IRasterizerState
+        class D3D11RasterizerState : public IRasterizerState, public memory::PoolAllocated<D3D11RasterizerState, memory::MEMORY_TAG_RENDER>
         {
         public:
             D3D11RasterizerState() = default;
@@ -22,6 +22,31 @@ using namespace deadrop::memory;
 #include <d3d11sdklayers.h>
 #endif
 
+namespace
+{
+    // moves a created object into the slot map and returns its handle
+    template<typename T, typename HandleType>
+    bool insertResource(SlotMap<uptr<T>, HandleType>& resources, uptr<T> resource, HandleType& handle)
+    {
+        handle = HandleType{};
+        if (resource == nullptr)
+        {
+            // error, failed to create the object
+            return false;
+        }
+        handle = resources.Insert(std::move(resource));
+        return handle.IsValid();
+    }
+
+    // returns the object of the handle, or nullptr when the handle is stale or invalid
+    template<typename T, typename HandleType>
+    T* getResource(SlotMap<uptr<T>, HandleType>& resources, HandleType handle)
+    {
+        uptr<T>* resource = resources.Get(handle);
+        return resource != nullptr ? resource->get() : nullptr;
+    }
+}
+
 bool D3D11RenderContext::CreateDevice(const DeviceDesc& deviceDesc)
 {
     m_device_desc = deviceDesc;
@@ -139,7 +164,7 @@ bool D3D11RenderContext::CreateSwapchain(const SwapchainDesc& swapchainDesc)
     }
 
     // create an ITexture object from the actual back buffer texture
-    auto tempTexture = std::make_shared<D3D11Texture2D>();
+    auto tempTexture = MakeShared<D3D11Texture2D>(MEMORY_TAG_RENDER);
     Texture2DDesc backBufferTextureDesc;
     backBufferTextureDesc.width = swapchainDesc.width;
     backBufferTextureDesc.height = swapchainDesc.height;
@@ -158,21 +183,21 @@ uptr<ITexture2D> D3D11RenderContext::CreateTexture2D(const Texture2DDesc& desc,
     const std::vector<MemoryBlock>& dataArray)
 {
     // forward the call to the appropriate object
-    auto ptr = std::make_unique<D3D11Texture2D>();
+    auto ptr = MakeUnique<D3D11Texture2D>(MEMORY_TAG_RENDER);
     return ptr->Create(desc, data, dataArray) ? std::move(ptr) : nullptr;
 }
 
 uptr<IBuffer> D3D11RenderContext::CreateBuffer(BufferDesc& desc, const MemoryBlock& data)
 {
     // forward the call to the appropriate object
-    auto ptr = std::make_unique<D3D11Buffer>();
+    auto ptr = MakeUnique<D3D11Buffer>(MEMORY_TAG_RENDER);
     return ptr->Create(desc, data) ? std::move(ptr) : nullptr;
 }
 
 uptr<IShader> D3D11RenderContext::CreateShaderFromFile(const ShaderDesc& desc, const std::wstring& filePath)
 {
     // forward the call to the appropriate object
-    auto ptr = std::make_unique<D3D11Shader>(desc);
+    auto ptr = MakeUnique<D3D11Shader>(MEMORY_TAG_RENDER, desc);
     // compile the shader
     bool compiled = ptr->Compile(filePath);
     if (compiled)
@@ -190,42 +215,114 @@ uptr<IShader> D3D11RenderContext::CreateShaderFromFile(const ShaderDesc& desc, c
 uptr<ITexture2D> D3D11RenderContext::CreateDepth2D(const Texture2DDesc& desc)
 {
     // forward the call to the appropriate object
-    auto ptr = std::make_unique<D3D11Depth2D>();
+    auto ptr = MakeUnique<D3D11Depth2D>(MEMORY_TAG_RENDER);
     return ptr->Create(desc) ? std::move(ptr) : nullptr;
 }
 
 uptr<IViewport> D3D11RenderContext::CreateViewport(const ViewportDesc& desc)
 {
     // forward the call to the appropriate object
-    return std::make_unique<D3D11Viewport>(desc);
+    return MakeUnique<D3D11Viewport>(MEMORY_TAG_RENDER, desc);
 }
 
 uptr<IRenderTarget> D3D11RenderContext::CreateRenderTarget(ITexture2D* texture)
 {
     // forward the call to the appropriate object
-    auto ptr = std::make_unique<D3D11RenderTarget>();
+    auto ptr = MakeUnique<D3D11RenderTarget>(MEMORY_TAG_RENDER);
     return ptr->Create(texture) ? std::move(ptr) : nullptr;
 }
 uptr<IPipelineState> D3D11RenderContext::CreatePipelineState(const PipelineStateDesc& pipelineState)
 {
     // forward the call to the appropriate object
-    return std::make_unique<D3D11PipelineState>(pipelineState);
+    return MakeUnique<D3D11PipelineState>(MEMORY_TAG_RENDER, pipelineState);
 }
 
 uptr<IRasterizerState> D3D11RenderContext::CreateRasterizerState(const RasterizerStateDesc& desc)
 {
     // forward the call to the appropriate object
-    auto ptr = std::make_unique<D3D11RasterizerState>();
+    auto ptr = MakeUnique<D3D11RasterizerState>(MEMORY_TAG_RENDER);
     return ptr->Create(desc) ? std::move(ptr) : nullptr;
 }
 
 uptr<IDepthStencilState> D3D11RenderContext::CreateDepthStencilState(const DepthStencilStateDesc& desc)
 {
     // forward the call to the appropriate object
-    auto ptr = std::make_unique<D3D11DepthStencilState>();
+    auto ptr = MakeUnique<D3D11DepthStencilState>(MEMORY_TAG_RENDER);
     return ptr->Create(desc) ? std::move(ptr) : nullptr;
 }
 
+bool D3D11RenderContext::CreateTexture2D(TextureHandle& handle, const Texture2DDesc& desc,
+    const MemoryBlock& data,
+    const std::vector<MemoryBlock>& dataArray)
+{
+    return insertResource(m_textures, CreateTexture2D(desc, data, dataArray), handle);
+}
+
+bool D3D11RenderContext::CreateBuffer(BufferHandle& handle, BufferDesc& desc, const MemoryBlock& data)
+{
+    return insertResource(m_buffers, CreateBuffer(desc, data), handle);
+}
+
+bool D3D11RenderContext::CreateShaderFromFile(ShaderHandle& handle, const ShaderDesc& desc, const std::wstring& filePath)
+{
+    return insertResource(m_shaders, CreateShaderFromFile(desc, filePath), handle);
+}
+
+bool D3D11RenderContext::CreateDepth2D(TextureHandle& handle, const Texture2DDesc& desc)
+{
+    return insertResource(m_textures, CreateDepth2D(desc), handle);
+}
+
+bool D3D11RenderContext::CreateViewport(ViewportHandle& handle, const ViewportDesc& desc)
+{
+    return insertResource(m_viewports, CreateViewport(desc), handle);
+}
+
+bool D3D11RenderContext::CreateRenderTarget(RenderTargetHandle& handle, TextureHandle texture)
+{
+    ITexture2D* pTexture = Get(texture);
+    if (pTexture == nullptr)
+    {
+        // error, the texture handle is stale
+        handle = RenderTargetHandle{};
+        return false;
+    }
+    return insertResource(m_renderTargets, CreateRenderTarget(pTexture), handle);
+}
+
+bool D3D11RenderContext::CreatePipelineState(PipelineStateHandle& handle, const PipelineStateDesc& pipelineState)
+{
+    return insertResource(m_pipelineStates, CreatePipelineState(pipelineState), handle);
+}
+
+bool D3D11RenderContext::CreateRasterizerState(RasterizerStateHandle& handle, const RasterizerStateDesc& desc)
+{
+    return insertResource(m_rasterizerStates, CreateRasterizerState(desc), handle);
+}
+
+bool D3D11RenderContext::CreateDepthStencilState(DepthStencilStateHandle& handle, const DepthStencilStateDesc& desc)
+{
+    return insertResource(m_depthStencilStates, CreateDepthStencilState(desc), handle);
+}
+
+bool D3D11RenderContext::Destroy(TextureHandle handle) { return m_textures.Erase(handle); }
+bool D3D11RenderContext::Destroy(BufferHandle handle) { return m_buffers.Erase(handle); }
+bool D3D11RenderContext::Destroy(ShaderHandle handle) { return m_shaders.Erase(handle); }
+bool D3D11RenderContext::Destroy(ViewportHandle handle) { return m_viewports.Erase(handle); }
+bool D3D11RenderContext::Destroy(RenderTargetHandle handle) { return m_renderTargets.Erase(handle); }
+bool D3D11RenderContext::Destroy(PipelineStateHandle handle) { return m_pipelineStates.Erase(handle); }
+bool D3D11RenderContext::Destroy(RasterizerStateHandle handle) { return m_rasterizerStates.Erase(handle); }
+bool D3D11RenderContext::Destroy(DepthStencilStateHandle handle) { return m_depthStencilStates.Erase(handle); }
+
+ITexture2D* D3D11RenderContext::Get(TextureHandle handle) { return getResource(m_textures, handle); }
+IBuffer* D3D11RenderContext::Get(BufferHandle handle) { return getResource(m_buffers, handle); }
+IShader* D3D11RenderContext::Get(ShaderHandle handle) { return getResource(m_shaders, handle); }
+IViewport* D3D11RenderContext::Get(ViewportHandle handle) { return getResource(m_viewports, handle); }
+IRenderTarget* D3D11RenderContext::Get(RenderTargetHandle handle) { return getResource(m_renderTargets, handle); }
+IPipelineState* D3D11RenderContext::Get(PipelineStateHandle handle) { return getResource(m_pipelineStates, handle); }
+IRasterizerState* D3D11RenderContext::Get(RasterizerStateHandle handle) { return getResource(m_rasterizerStates, handle); }
+IDepthStencilState* D3D11RenderContext::Get(DepthStencilStateHandle handle) { return getResource(m_depthStencilStates, handle); }
+
 void D3D11RenderContext::BindShader(IShader* shader)
 {
     // retrieve the actual d3d11 implementation object
@@ -319,7 +416,9 @@ void D3D11RenderContext::BindBuffer(IBuffer* buffer, unsigned int slot, const BI
     }
     case BUFFER_TYPE::BUFFER_TYPE_INDEX:
     {
-        context->IASetIndexBuffer(pBuffer->m_buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+        // the stride of an index buffer is the size of an index, see mesh::OptimizeMesh()
+        const DXGI_FORMAT format = pBuffer->m_desc.stride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+        context->IASetIndexBuffer(pBuffer->m_buffer.Get(), format, 0);
         break;
     }
     default:
@@ -430,6 +529,119 @@ void D3D11RenderContext::SetScissor(const Rect& rect)
     m_deviceContext->RSSetScissorRects(1, &d3dRect);
 }
 
+void D3D11RenderContext::BindShader(ShaderHandle shader)
+{
+    IShader* pShader = Get(shader);
+    if (pShader == nullptr)
+    {
+        // error, the handle is stale
+        return;
+    }
+    BindShader(pShader);
+}
+
+void D3D11RenderContext::BindState(RasterizerStateHandle state)
+{
+    IRasterizerState* pState = Get(state);
+    if (pState == nullptr)
+    {
+        // error, the handle is stale
+        return;
+    }
+    BindState(pState);
+}
+
+void D3D11RenderContext::BindState(DepthStencilStateHandle state)
+{
+    IDepthStencilState* pState = Get(state);
+    if (pState == nullptr)
+    {
+        // error, the handle is stale
+        return;
+    }
+    BindState(pState);
+}
+
+void D3D11RenderContext::BindState(PipelineStateHandle pipelineState)
+{
+    IPipelineState* pState = Get(pipelineState);
+    if (pState == nullptr)
+    {
+        // error, the handle is stale
+        return;
+    }
+    BindState(pState);
+}
+
+void D3D11RenderContext::BindTexture(unsigned int slot, TextureHandle texture)
+{
+    // an invalid handle unbinds the slot
+    ITexture2D* pTexture = Get(texture);
+    if (pTexture == nullptr && texture.IsValid())
+    {
+        // error, the handle is stale
+        return;
+    }
+    BindTexture(slot, pTexture);
+}
+
+void D3D11RenderContext::BindBuffer(BufferHandle buffer, unsigned int slot, const BIND_STAGE& stage)
+{
+    IBuffer* pBuffer = Get(buffer);
+    if (pBuffer == nullptr)
+    {
+        // error, the handle is stale
+        return;
+    }
+    BindBuffer(pBuffer, slot, stage);
+}
+
+void D3D11RenderContext::BindRenderTarget(RenderTargetHandle renderTarget, TextureHandle depthStencil)
+{
+    IRenderTarget* pRenderTarget = Get(renderTarget);
+    // an invalid depth stencil handle binds the render target alone
+    ITexture2D* pDepthStencil = Get(depthStencil);
+    if (pRenderTarget == nullptr || (pDepthStencil == nullptr && depthStencil.IsValid()))
+    {
+        // error, a handle is stale
+        return;
+    }
+    BindRenderTarget(pRenderTarget, pDepthStencil);
+}
+
+void D3D11RenderContext::Clear(RenderTargetHandle renderTarget, const float color[4])
+{
+    IRenderTarget* pRenderTarget = Get(renderTarget);
+    if (pRenderTarget == nullptr)
+    {
+        // error, the handle is stale
+        return;
+    }
+    Clear(pRenderTarget, color);
+}
+
+void D3D11RenderContext::Clear(TextureHandle depthTexture)
+{
+    ITexture2D* pDepthTexture = Get(depthTexture);
+    if (pDepthTexture == nullptr)
+    {
+        // error, the handle is stale
+        return;
+    }
+    Clear(pDepthTexture);
+}
+
+void D3D11RenderContext::SetViewport(ViewportHandle viewport)
+{
+    IViewport* pViewport = Get(viewport);
+    if (pViewport == nullptr)
+    {
+        // error, the handle is stale
+        return;
+    }
+    SetViewport(pViewport);
+}
+
 const DeviceDesc& D3D11RenderContext::GetDeviceDesc()
 {
     return m_device_desc;
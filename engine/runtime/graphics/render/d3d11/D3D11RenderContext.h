@@ -33,6 +33,38 @@ namespace deadrop
             virtual uptr<IRasterizerState> CreateRasterizerState(const RasterizerStateDesc& desc) override;
             virtual uptr<IDepthStencilState> CreateDepthStencilState(const DepthStencilStateDesc& desc) override;
 
+            // graphics pipleline object creation functions that return handles
+            virtual bool CreateTexture2D(TextureHandle& handle, const Texture2DDesc& desc,
+                const memory::MemoryBlock& data,
+                const std::vector<memory::MemoryBlock>& dataArray) override;
+
+            virtual bool CreateBuffer(BufferHandle& handle, BufferDesc& desc, const memory::MemoryBlock& data) override;
+            virtual bool CreateShaderFromFile(ShaderHandle& handle, const ShaderDesc& desc, const std::wstring& filePath) override;
+            virtual bool CreateDepth2D(TextureHandle& handle, const Texture2DDesc& desc) override;
+            virtual bool CreateViewport(ViewportHandle& handle, const ViewportDesc& desc) override;
+            virtual bool CreateRenderTarget(RenderTargetHandle& handle, TextureHandle texture) override;
+            virtual bool CreatePipelineState(PipelineStateHandle& handle, const PipelineStateDesc& pipelineState) override;
+            virtual bool CreateRasterizerState(RasterizerStateHandle& handle, const RasterizerStateDesc& desc) override;
+            virtual bool CreateDepthStencilState(DepthStencilStateHandle& handle, const DepthStencilStateDesc& desc) override;
+
+            virtual bool Destroy(TextureHandle handle) override;
+            virtual bool Destroy(BufferHandle handle) override;
+            virtual bool Destroy(ShaderHandle handle) override;
+            virtual bool Destroy(ViewportHandle handle) override;
+            virtual bool Destroy(RenderTargetHandle handle) override;
+            virtual bool Destroy(PipelineStateHandle handle) override;
+            virtual bool Destroy(RasterizerStateHandle handle) override;
+            virtual bool Destroy(DepthStencilStateHandle handle) override;
+
+            virtual ITexture2D* Get(TextureHandle handle) override;
+            virtual IBuffer* Get(BufferHandle handle) override;
+            virtual IShader* Get(ShaderHandle handle) override;
+            virtual IViewport* Get(ViewportHandle handle) override;
+            virtual IRenderTarget* Get(RenderTargetHandle handle) override;
+            virtual IPipelineState* Get(PipelineStateHandle handle) override;
+            virtual IRasterizerState* Get(RasterizerStateHandle handle) override;
+            virtual IDepthStencilState* Get(DepthStencilStateHandle handle) override;
+
             // graphics pipeline changing functions
             virtual sptr<ITexture2D> GetBackBuffer() override;
             virtual void BindShader(IShader* shader) override;
@@ -52,6 +84,17 @@ namespace deadrop
             virtual void SetViewport(IViewport* viewport) override;
             virtual void SetScissor(const Rect& rect) override;
 
+            virtual void BindShader(ShaderHandle shader) override;
+            virtual void BindState(RasterizerStateHandle state) override;
+            virtual void BindState(DepthStencilStateHandle state) override;
+            virtual void BindState(PipelineStateHandle pipelineState) override;
+            virtual void BindTexture(unsigned int slot, TextureHandle texture) override;
+            virtual void BindBuffer(BufferHandle buffer, unsigned int slot, const BIND_STAGE& stage) override;
+            virtual void BindRenderTarget(RenderTargetHandle renderTarget, TextureHandle depthStencil) override;
+            virtual void Clear(RenderTargetHandle renderTarget, const float color[4]) override;
+            virtual void Clear(TextureHandle depthTexture) override;
+            virtual void SetViewport(ViewportHandle viewport) override;
+
             const DeviceDesc& GetDeviceDesc() override;
 
         private:
@@ -66,6 +109,17 @@ namespace deadrop
             bool m_initialized = false;
             sptr<ITexture2D> m_backBufferTexture = nullptr;
 
+            // the objects created through the functions that return handles
+            // NOTE: the textures and the depth textures share a slot map since both are ITexture2D
+            SlotMap<uptr<ITexture2D>, TextureHandle> m_textures;
+            SlotMap<uptr<IBuffer>, BufferHandle> m_buffers;
+            SlotMap<uptr<IShader>, ShaderHandle> m_shaders;
+            SlotMap<uptr<IViewport>, ViewportHandle> m_viewports;
+            SlotMap<uptr<IRenderTarget>, RenderTargetHandle> m_renderTargets;
+            SlotMap<uptr<IPipelineState>, PipelineStateHandle> m_pipelineStates;
+            SlotMap<uptr<IRasterizerState>, RasterizerStateHandle> m_rasterizerStates;
+            SlotMap<uptr<IDepthStencilState>, DepthStencilStateHandle> m_depthStencilStates;
+
             D3D_FEATURE_LEVEL m_featureLevel = D3D_FEATURE_LEVEL_11_0;
             const unsigned int D3D11FeatureLevelsNum = 6;
             D3D_FEATURE_LEVEL D3D11FeatureLevels[6] =
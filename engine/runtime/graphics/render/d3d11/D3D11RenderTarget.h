@@ -1,6 +1,7 @@
 #pragma once
 #include "engine/runtime/graphics/render/IRenderTarget.h"
 #include "engine/runtime/graphics/render/ITexture2D.h"
+#include "engine/core/memory/pool_allocator.h"
 #include "D3D11Common.h"
 
 namespace deadrop
@@ -8,7 +9,7 @@ namespace deadrop
     namespace render
     {
         // an interface to expose the render target functionality
-        class D3D11RenderTarget : public IRenderTarget
+        class D3D11RenderTarget : public IRenderTarget, public memory::PoolAllocated<D3D11RenderTarget, memory::MEMORY_TAG_RENDER>
         {
         public:
             // default constructor
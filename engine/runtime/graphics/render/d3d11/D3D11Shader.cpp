@@ -44,7 +44,10 @@ bool D3D11Shader::Compile(const std::wstring& filePath)
         hrCreate = device->CreateVertexShader(m_shaderBlob->GetBufferPointer(), m_shaderBlob->GetBufferSize(), nullptr, m_vertexShader.GetAddressOf());
         if (SUCCEEDED(hrCreate))
         {
-            HRESULT hrInputLayout = CreateInputLayoutFromBlob(m_shaderBlob.Get(), m_inputLayout.GetAddressOf());
+            // use the engine-side layout when there is one, so the attributes can be stored in compact formats
+            HRESULT hrInputLayout = m_desc.layout.GetAttributeCount() > 0
+                ? CreateInputLayoutFromDesc(m_shaderBlob.Get(), m_desc.layout, m_inputLayout.GetAddressOf())
+                : CreateInputLayoutFromBlob(m_shaderBlob.Get(), m_inputLayout.GetAddressOf());
             if (FAILED(hrInputLayout))
             {
                 // error, failed to create the shader input layout
@@ -167,7 +170,7 @@ bool D3D11Shader::Compile(const std::wstring& filePath)
             uniformVariableNames.push_back(varDesc.Name);
         }
 
-        auto temp = std::make_shared<D3D11UniformBuffer>();
+        auto temp = memory::MakeShared<D3D11UniformBuffer>(memory::MEMORY_TAG_RENDER);
         if (temp->Create(tempDesc, uniformVariableNames))
         {
             m_uniformBuffers.insert({ constantBufferDesc.Name,
@@ -256,6 +259,37 @@ HRESULT D3D11Shader::CreateInputLayoutFromBlob(ID3DBlob* shaderBlob, ID3D11Input
     return hrCreateInputLayout;
 }
 
+HRESULT D3D11Shader::CreateInputLayoutFromDesc(ID3DBlob* shaderBlob, const mesh::VertexLayout& layout, ID3D11InputLayout** inputLayout)
+{
+    std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
+    for (unsigned int i = 0; i < layout.GetAttributeCount(); i++)
+    {
+        const mesh::VertexAttribute& attribute = layout.GetAttribute(i);
+        DXGI_FORMAT format = D3D11Common::ResolveType(attribute.format);
+        if (format == DXGI_FORMAT_UNKNOWN)
+        {
+            // error, the layout has an invalid vertex format
+            return E_INVALIDARG;
+        }
+
+        D3D11_INPUT_ELEMENT_DESC elementDesc =
+        {
+            D3D11Common::ResolveType(attribute.semantic),
+            attribute.semantic_index,
+            format,
+            0, // InputSlot
+            attribute.offset, // AlignedByOffset
+            D3D11_INPUT_PER_VERTEX_DATA, // InputSlotClass
+            0, // InstanceDataStepRate
+        };
+        inputLayoutDesc.push_back(elementDesc);
+    }
+
+    // NOTE: the device validates the layout against the input signature of the shader
+    return D3D11Device::GetDevice()->CreateInputLayout(&inputLayoutDesc[0], (UINT)inputLayoutDesc.size(),
+        shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), inputLayout);
+}
+
 
 DXGI_FORMAT D3D11Shader::GetFormatFromComponetType(D3D_REGISTER_COMPONENT_TYPE componentType, unsigned int componentsCount)
 {
@@ -2,6 +2,7 @@
 #include "engine/core/debug.h"
 #include "engine/core/memory/memory.h"
 #include "engine/runtime/graphics/render/IShader.h"
+#include "engine/core/memory/pool_allocator.h"
 #include "D3D11Common.h"
 #include <d3d11shader.h>
 #include <unordered_map>
@@ -11,7 +12,7 @@ namespace deadrop
 {
     namespace render
     {
-        class D3D11Shader : public IShader
+        class D3D11Shader : public IShader, public memory::PoolAllocated<D3D11Shader, memory::MEMORY_TAG_RENDER>
         {
         public:
             D3D11Shader(const ShaderDesc& desc) : m_desc(desc) {}
@@ -42,6 +43,7 @@ namespace deadrop
 
             // for internal use
             HRESULT CreateInputLayoutFromBlob(ID3DBlob* shaderBlob, ID3D11InputLayout** inputLayout);
+            HRESULT CreateInputLayoutFromDesc(ID3DBlob* shaderBlob, const mesh::VertexLayout& layout, ID3D11InputLayout** inputLayout);
             HRESULT CompileShaderFromFile(const WCHAR * filename, LPCSTR entryPoint, LPCSTR shaderModel);
             DXGI_FORMAT GetFormatFromComponetType(D3D_REGISTER_COMPONENT_TYPE componentType, unsigned int componentsCount);
             bool Compile(const std::wstring& filePath);
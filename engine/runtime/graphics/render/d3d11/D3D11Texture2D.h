@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/runtime/graphics/render/ITexture2D.h"
+#include "engine/core/memory/pool_allocator.h"
 #include "D3D11Common.h"
 #include <vector>
 
@@ -7,7 +8,7 @@ namespace deadrop
 {
     namespace render
     {
-        class D3D11Texture2D : public ITexture2D
+        class D3D11Texture2D : public ITexture2D, public memory::PoolAllocated<D3D11Texture2D, memory::MEMORY_TAG_RENDER>
         {
         public:
             D3D11Texture2D() = default;
@@ -35,7 +36,7 @@ namespace deadrop
             ComPtr<ID3D11ShaderResourceView> m_shaderResourceView = nullptr;
         };
 
-        class D3D11Depth2D : public ITexture2D
+        class D3D11Depth2D : public ITexture2D, public memory::PoolAllocated<D3D11Depth2D, memory::MEMORY_TAG_RENDER>
         {
         public:
             D3D11Depth2D() = default;
@@ -8,8 +8,7 @@ bool D3D11UniformBuffer::Create(const UniformBufferDesc& desc, const std::vector
 {
     m_desc = desc;
     m_variableNames = variableNames;
-    // TODO: use a custom allocator
-    data.reset(static_cast<size_t*>(operator new(desc.size)));
+    data = memory::MakeSharedBytes(memory::MEMORY_TAG_RENDER, desc.size);
 
     // Create the constant buffer
     D3D11_BUFFER_DESC bufferDesc{ 0 };
@@ -1,12 +1,13 @@
 #pragma once
 #include "engine/runtime/graphics/render/IViewport.h"
+#include "engine/core/memory/pool_allocator.h"
 #include "D3D11Common.h"
 
 namespace deadrop
 {
     namespace render
     {
-        class D3D11Viewport : public IViewport
+        class D3D11Viewport : public IViewport, public memory::PoolAllocated<D3D11Viewport, memory::MEMORY_TAG_RENDER>
         {
         public:
             D3D11Viewport(const ViewportDesc& viewportDesc);
@@ -23,9 +23,9 @@ namespace deadrop
             // delete the copy assignment operator
             CoreSystem operator=(const CoreSystem&) = delete;
 
-            // register a system
+            // register a system, the system is recorded under 'tag' by the memory tracker
             template<class T>
-            T* Register();
+            T* Register(memory::MemoryTag tag = memory::MEMORY_TAG_CORE);
 
             // check if a system is registered
             template<class T>
@@ -56,7 +56,7 @@ namespace deadrop
 
         // definition of the template functions
         template<class T>
-        T* CoreSystem::Register()
+        T* CoreSystem::Register(memory::MemoryTag tag)
         {
             // enforce that all systems must inherit from the ISystem interface
             static_assert(std::is_base_of<ISystem, T>::value, "All systems must inherit from ISystem!");
@@ -72,7 +72,7 @@ namespace deadrop
                 return static_cast<T*>(result->second.get());
             }
 
-            auto system_ptr = std::make_unique<T>();
+            auto system_ptr = memory::MakeUnique<T>(tag);
             // store the pointer of the system
             m_systems.insert(std::make_pair(type_index, std::move(system_ptr)));
             // return the stored pointer so it can be used by the caller
@@ -151,9 +151,9 @@ namespace deadrop
         // forward calls to these function to the 
         // global instance we created previously
         template<class T>
-        T* Register()
+        T* Register(memory::MemoryTag tag = memory::MEMORY_TAG_CORE)
         {
-            return detail::instance().Register<T>();
+            return detail::instance().Register<T>(tag);
         }
 
         template<class T>
@@ -1,4 +1,5 @@
 #include "WindowSystem.h"
+#include "engine/core/memory/frame_arena.h"
 using namespace deadrop::systems;
 
 #define WIN32_LEAN_AND_MEAN
@@ -527,10 +528,13 @@ void WindowSystem::ProcessRawInput()
     constexpr UINT k_max_message_count_to_process = 16;
     cbSize *= k_max_message_count_to_process;
 
-    // allocate a buffer large enough
-    std::vector<BYTE> buffer(cbSize);
-    PRAWINPUT pRawInput = (PRAWINPUT)buffer.data();
-    if (pRawInput == NULL)
+    // allocate a buffer large enough from the frame arena, it is released at the end of the frame
+    // NOTE: RAWINPUT blocks are aligned to pointers (see NEXTRAWINPUTBLOCK())
+    auto& frame_arena = deadrop::memory::GetFrameArena();
+    PRAWINPUT pRawInput = (PRAWINPUT)frame_arena.Allocate(cbSize, alignof(RAWINPUT));
+    // the pointers to the messages of a batch, a batch has at most k_max_message_count_to_process messages
+    PRAWINPUT* paRawInput = frame_arena.AllocateArray<PRAWINPUT>(k_max_message_count_to_process);
+    if (pRawInput == NULL || paRawInput == NULL)
     {
         // error, failed to allocate enough memory
         return;
@@ -547,7 +551,7 @@ void WindowSystem::ProcessRawInput()
         }
 
         // NOTE: guard against GetRawInputBuffer() returning UINT_MAX when 'cbSize' is not set correctly
-        // in order to avoid accidentally allocating a huge amount of memory
+        // in order to avoid writing past the end of the pointer array
         constexpr UINT k_guard_max = k_max_message_count_to_process;
         if (nInput > k_guard_max)
         {
@@ -555,15 +559,6 @@ void WindowSystem::ProcessRawInput()
             return;
         }
 
-        // allocate a buffer big enough to hold the data
-        // TODO: use an allocator instead!
-        auto buffer_array = std::make_unique<PRAWINPUT[]>(nInput);
-        PRAWINPUT* paRawInput = buffer_array.get();
-        if (paRawInput == NULL)
-        {
-            break;
-        }
-
         // defined for NEXTRAWINPUTBLOCK() to compile
         using QWORD = __int64;
 
@@ -5,11 +5,14 @@ using namespace Sandbox;
 #include "engine/runtime/systems/core/CoreSystem.h"
 // used to create and handle a window and its events
 #include "engine/runtime/systems/window/WindowSystem.h"
+// used to release the per-frame allocations and to track the memory usage
+#include "engine/core/memory/frame_arena.h"
+#include "engine/core/memory/memory_tracker.h"
 
 bool Application::Init()
 {
     // TODO: implement application initialization here, anything that is specific to an app
-    auto window_system = deadrop::systems::Register<deadrop::systems::WindowSystem>();
+    auto window_system = deadrop::systems::Register<deadrop::systems::WindowSystem>(deadrop::memory::MEMORY_TAG_WINDOW);
 
     // prepare a description for the window that we will create
     deadrop::systems::WindowDesc window_desc{};
@@ -75,7 +78,12 @@ bool Application::Init()
         window_system->ProcessRawInput();
 
         // TODO: replace this loop with an actual game loop
-        continue;
+
+        // release everything that was allocated from the frame arena during this frame
+        deadrop::memory::GetFrameArena().EndFrame();
+
+        // record the allocations of this frame in the allocation rate history of each subsystem
+        deadrop::memory::EndMemoryTrackingFrame();
     }
 
     // return success